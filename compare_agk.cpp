@@ -11,6 +11,7 @@
 #include "read_dm.h"
 #include "trig.h"
 #include "misc.h"
+#include "compare_utils.h"
 
 #define MAX_DISTANCE 180.0   // 3 minutos de arco
 #define MAX_DISTANCE_DROP 3600.0 // 1 grado de arco
@@ -60,7 +61,7 @@ void readAGK(
 	    exit(1);
     }
 
-    printf("Reading AGK %c:\n", letter);
+    logPrintf("Reading AGK %c:\n", letter);
     while (fgets(buffer, 1023, stream) != NULL) {
     	/* lee numeracion */
 	    readField(buffer, cell, ref_pos, ref_bytes);
@@ -112,41 +113,42 @@ void readAGK(
         double minDistance = 9999999999;
 	    int declRef = -((int)floor(-Decl1875));
         int declFinal;
-        int i = getDMindex(true, declRef, numRef);
-        while (i != -1) {
+        int count;
+        const struct Designation_struct *d = getDMComponents(true, declRef, numRef, &count);
+        for (int c = 0; c < count; c++) {
+          int i = d[c].index;
           double dist = 3600.0 * calcAngularDistance(x, y, z, CDstar[i].x, CDstar[i].y, CDstar[i].z);
           if (minDistance > dist) {
             cdIndex = i;
             cdIndexWarning = i;
             minDistance = dist;
           }
-          i = CDstar[i].next;
         }
-        i = getDMindex(true, declRef - 1, numRef);
-        while (i != -1) {
+        d = getDMComponents(true, declRef - 1, numRef, &count);
+        for (int c = 0; c < count; c++) {
+          int i = d[c].index;
           double dist = 3600.0 * calcAngularDistance(x, y, z, CDstar[i].x, CDstar[i].y, CDstar[i].z);
           if (minDistance > dist) {
             cdIndex = i;
             minDistance = dist;
           }
-          i = CDstar[i].next;
         }
-        i = getDMindex(true, declRef + 1, numRef);
-        while (i != -1) {
+        d = getDMComponents(true, declRef + 1, numRef, &count);
+        for (int c = 0; c < count; c++) {
+          int i = d[c].index;
           double dist = 3600.0 * calcAngularDistance(x, y, z, CDstar[i].x, CDstar[i].y, CDstar[i].z);
           if (minDistance > dist) {
             cdIndex = i;
             minDistance = dist;
           }
-          i = CDstar[i].next;
         }
 
         if (cdIndex == -1) {
-          printf("Star DM %d not found (corresponding to AGK %d). Discarding star.\n", numRef, agkRef);
+          logPrintf("Star DM %d not found (corresponding to AGK %d). Discarding star.\n", numRef, agkRef);
           continue;
         }    
         if (CDstar[cdIndex].declRef != declRef) {
-            printf("Warning: Decl = %d of AGK %d does not coincide with CD %d°%d\n",
+            logPrintf("Warning: Decl = %d of AGK %d does not coincide with CD %d°%d\n",
                 declRef, agkRef, CDstar[cdIndex].declRef, numRef);
         } else {
             cdIndexWarning = -1;
@@ -174,15 +176,15 @@ void readAGK(
 }
 
 /*
- * main - comienzo de la aplicacion
+ * compareAGK - compara CD contra AGK (ver readCompareCD)
  */
-int main(int argc, char** argv)
+void compareAGK()
 {
-    printf("COMPARE_AGK - Compare CD and AGK catalogs.\n");
-    printf("Made in 2024 by Daniel Severin.\n");
+    logPrintf("COMPARE_AGK - Compare CD and AGK catalogs.\n");
+    logPrintf("Made in 2024 by Daniel Severin.\n");
 
     /* leemos catalogo CD */
-    readDM("cat/cd.txt");
+    readCompareCD("cat/cd.txt");
     struct DMstar_struct *CDstar = getDMStruct();
 
     /* leemos catalogos Cordoba A, B y C */
@@ -190,7 +192,7 @@ int main(int argc, char** argv)
     readAGK("cat/corda.txt", 8, 5, 13, 2, 15, 36, 57, 5, 62, 'A');
     readAGK("cat/cordb.txt", 8, 5, 13, 3, 16, 37, 60, 5, 66, 'B');
     readAGK("cat/cordc.txt", 8, 5, 13, 2, 15, 36, 59, 5, 65, 'C');
-    printf("Stars read from AGK: %d\n", AGKstars);
+    logPrintf("Stars read from AGK: %d\n", AGKstars);
 
     /* revisamos la identificación cruzada */
     int dropDistError = 0;
@@ -207,7 +209,7 @@ int main(int argc, char** argv)
         if (dist > MAX_DISTANCE_DROP) {
             // posiciones demasiado separadas, posiblemente mala identificacion
             dropDistError++;
-            printf("*) CD %d°%d too separated from AGK %c%d in %.1f arcsec.\n",
+            logPrintf("*) CD %d°%d too separated from AGK %c%d in %.1f arcsec.\n",
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
                 AGKstar[i].letter,
@@ -220,7 +222,7 @@ int main(int argc, char** argv)
             // posiciones muy separadas, supera umbral
             maxDistError++;
             indexError++;
-            printf("%d) CD %d°%d separated from AGK %c%d in %.1f arcsec.\n",
+            logPrintf("%d) CD %d°%d separated from AGK %c%d in %.1f arcsec.\n",
                 indexError,
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
@@ -233,7 +235,7 @@ int main(int argc, char** argv)
                 double distWarning = 3600.0 * calcAngularDistance(
                     AGKstar[i].x, AGKstar[i].y, AGKstar[i].z,
                     CDstar[cdIndexWarning].x, CDstar[cdIndexWarning].y, CDstar[cdIndexWarning].z);
-                printf("     Also check CD %d°%d (dist = %.1f arcsec.)\n",
+                logPrintf("     Also check CD %d°%d (dist = %.1f arcsec.)\n",
                     CDstar[cdIndexWarning].declRef,
                     CDstar[cdIndexWarning].numRef,
                     distWarning);
@@ -252,7 +254,7 @@ int main(int argc, char** argv)
             // diferencia en magnitud visual supera umbral
             magDiffError++;
             indexError++;
-            printf("%d) CD %d°%d reports mag=%.1f but it should be mag=%.1f from AGK %c%d: Delta = %.1f.\n",
+            logPrintf("%d) CD %d°%d reports mag=%.1f but it should be mag=%.1f from AGK %c%d: Delta = %.1f.\n",
                 indexError,
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
@@ -267,13 +269,23 @@ int main(int argc, char** argv)
         goodStarsMagnitude++;
         akkuDeltaError += delta * delta;
     }
-    printf("Total errors: %d (position: %d, mag: %d), Drops: %d\n",
+    logPrintf("Total errors: %d (position: %d, mag: %d), Drops: %d\n",
         indexError, maxDistError, magDiffError, dropDistError);
-    printf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
+    logPrintf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
         sqrt(akkuDistError / (double)goodStarsPosition),
         goodStarsPosition);
-    printf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
+    logPrintf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
         sqrt(akkuDeltaError / (double)goodStarsMagnitude),
         goodStarsMagnitude);
+}
+
+#ifndef COMPARE_LIBRARY
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv)
+{
+    compareAGK();
     return 0;
 }
+#endif
@@ -0,0 +1,41 @@
+/*
+ * COMPARE_ALL - Corre todas las comparaciones contra CD leyendo CD una sola vez
+ * Made in 2025 by Daniel E. Severin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "read_dm.h"
+#include "misc.h"
+#include "compare_utils.h"
+
+/*
+ * runComparePPM - compara contra PPM la version actual de CD en Vizier
+ */
+static void runComparePPM()
+{
+    comparePPM("cd.txt", false);
+}
+
+/* comparaciones a correr: para agregar una, basta sumarla aqui */
+static struct Comparison comparisons[] = {
+    {"PPM", "results/log_ppm.log", runComparePPM},
+    {"AGK", "results/log_agk.log", compareAGK},
+    {"CPD", "results/log_cpd.log", compareCPD},
+    {"SD", "results/log_sd.log", compareSD},
+};
+
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv)
+{
+    logPrintf("COMPARE_ALL - Compare CD against PPM, AGK, CPD and SD catalogs.\n");
+    logPrintf("Made in 2025 by Daniel Severin.\n");
+
+    /* leemos catalogo CD, compartido por todas las comparaciones */
+    loadCompareCD("cat/cd.txt");
+
+    runComparisons(comparisons, sizeof(comparisons) / sizeof(comparisons[0]));
+    return 0;
+}
@@ -0,0 +1,344 @@
+/*
+ * COMPARE_CAT - Compara dos versiones de un catálogo de ancho fijo (p.ej. original vs curado)
+ * Made in 2025 by Daniel E. Severin
+ *
+ * Cada registro se identifica por una clave (columnas fijas) y se ubica en una zona
+ * (la zona de declinación, o bloques de 1000 números si el catálogo no tiene zonas).
+ * Las zonas con el mismo hash en ambas versiones se saltean sin comparar registro a
+ * registro; en el resto se informan los registros faltantes y los campos que cambian.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "misc.h"
+
+#define MAX_FIELDS 16
+#define ZONE_BUCKET 1000
+
+/* campo de un registro: columnas "first" a "first + bytes - 1" (desde 1, como readField) */
+struct Field_struct {
+    const char *name;
+    int first, bytes;
+};
+
+/* formato de un catálogo: clave, zona (número en esas columnas dividido por zoneBucket) y campos */
+struct Profile_struct {
+    const char *name;
+    int keyFirst, keyBytes;
+    int zoneFirst, zoneBytes, zoneBucket;
+    struct Field_struct field[MAX_FIELDS]; /* termina con name = NULL */
+};
+
+static const struct Profile_struct profiles[] = {
+    {"cd", 1, 11, 3, 3, 1, {{"mag", 12, 4}, {"RAh", 16, 2}, {"RAm", 18, 2}, {"RAs", 20, 4},
+        {"DE-", 24, 1}, {"DEd", 25, 2}, {"DEm", 27, 4}, {NULL, 0, 0}}},
+    {"bd", 1, 11, 3, 3, 1, {{"mag", 12, 4}, {"RAh", 16, 2}, {"RAm", 18, 2}, {"RAs", 20, 4},
+        {"DE-", 24, 1}, {"DEd", 25, 2}, {"DEm", 27, 4}, {NULL, 0, 0}}},
+    {"sd", 1, 11, 3, 3, 1, {{"mag", 12, 4}, {"RAh", 16, 2}, {"RAm", 18, 2}, {"RAs", 20, 4},
+        {"DE-", 24, 1}, {"DEd", 25, 2}, {"DEm", 27, 6}, {NULL, 0, 0}}},
+    {"cpd", 1, 10, 3, 3, 1, {{"mag", 12, 4}, {"RAh", 16, 2}, {"RAm", 18, 2}, {"RAs", 20, 4},
+        {"DEd", 25, 2}, {"DEm", 27, 6}, {NULL, 0, 0}}},
+    {"gc", 1, 7, 1, 5, ZONE_BUCKET, {{"mag", 8, 3}, {"type", 11, 1}, {"epoch", 12, 4}, {"RAh", 16, 2}, {"RAm", 18, 2},
+        {"RAs", 20, 4}, {"preRA", 24, 7}, {"DEd", 39, 2}, {"DEm", 41, 2}, {"DEs", 43, 3},
+        {"preDE", 46, 6}, {NULL, 0, 0}}},
+};
+
+/* registro: línea del archivo (sin fin de línea ni espacios finales) y su zona */
+struct Record_struct {
+    const char *line;
+    int length;
+    int zone;
+    int order; /* posición en el archivo (desempata claves repetidas) */
+};
+
+/* versión de un catálogo en memoria */
+struct Version_struct {
+    const char *filename;
+    char *data;
+    int records;
+    struct Record_struct *record;
+};
+
+static const struct Profile_struct *profile;
+static struct Profile_struct genericProfile;
+
+/*
+ * byteAt - caracter en la columna "pos" (desde 1) del registro; espacio si la línea es más corta
+ */
+static inline char byteAt(const struct Record_struct *r, int pos)
+{
+    return pos <= r->length ? r->line[pos - 1] : ' ';
+}
+
+/*
+ * compareColumns - compara dos registros en las columnas dadas (como memcmp)
+ */
+static int compareColumns(const struct Record_struct *r1, const struct Record_struct *r2, int first, int bytes)
+{
+    for (int pos = first; pos < first + bytes; pos++) {
+        char c1 = byteAt(r1, pos);
+        char c2 = byteAt(r2, pos);
+        if (c1 != c2) return (unsigned char) c1 < (unsigned char) c2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+ * compareRecord - orden por zona, clave y posición en el archivo
+ */
+static int compareRecord(const void *a, const void *b)
+{
+    const struct Record_struct *r1 = (const struct Record_struct *) a;
+    const struct Record_struct *r2 = (const struct Record_struct *) b;
+    if (r1->zone != r2->zone) return r1->zone < r2->zone ? -1 : 1;
+    int cmp = compareColumns(r1, r2, profile->keyFirst, profile->keyBytes);
+    if (cmp != 0) return cmp;
+    return r1->order - r2->order;
+}
+
+/*
+ * zoneOf - zona del registro: primer número (con signo) en las columnas de zona / zoneBucket
+ */
+static int zoneOf(const struct Record_struct *r)
+{
+    char cell[32];
+    int bytes = profile->zoneBytes < 31 ? profile->zoneBytes : 31;
+    for (int k = 0; k < bytes; k++) cell[k] = byteAt(r, profile->zoneFirst + k);
+    cell[bytes] = 0;
+    const char *ptr = cell;
+    while (*ptr != 0 && *ptr != '-' && (*ptr < '0' || *ptr > '9')) ptr++;
+    return atoi(ptr) / profile->zoneBucket;
+}
+
+/*
+ * hashRecord - hash FNV-1a 64 de la línea, acumulado sobre "hash"
+ */
+static unsigned long long hashRecord(unsigned long long hash, const struct Record_struct *r)
+{
+    for (int k = 0; k < r->length; k++) hash = (hash ^ (unsigned char) r->line[k]) * 1099511628211ULL;
+    return (hash ^ '\n') * 1099511628211ULL;
+}
+
+/*
+ * readVersion - lee el archivo completo y arma sus registros ordenados por zona y clave
+ */
+static void readVersion(struct Version_struct *version, const char *filename)
+{
+    char buffer[1024];
+
+    FILE *stream = openInputFile(filename);
+    if (stream == NULL) {
+        snprintf(buffer, 1024, "Cannot read %s", filename);
+        perror(buffer);
+        exit(1);
+    }
+    size_t size = 0, capacity = 1 << 20;
+    char *data = (char *) malloc(capacity + 1);
+    if (data == NULL) bye("Out of memory!\n");
+    size_t bytes;
+    while ((bytes = fread(data + size, 1, capacity - size, stream)) > 0) {
+        size += bytes;
+        if (size == capacity) {
+            capacity *= 2;
+            data = (char *) realloc(data, capacity + 1);
+            if (data == NULL) bye("Out of memory!\n");
+        }
+    }
+    closeInputFile(stream);
+    data[size] = 0;
+
+    int lines = 0;
+    for (size_t k = 0; k < size; k++) if (data[k] == '\n') lines++;
+    struct Record_struct *record = (struct Record_struct *) malloc((size_t) (lines + 1) * sizeof(struct Record_struct));
+    if (record == NULL) bye("Out of memory!\n");
+
+    int records = 0;
+    char *ptr = data;
+    char *end = data + size;
+    while (ptr < end) {
+        char *eol = (char *) memchr(ptr, '\n', end - ptr);
+        char *next = eol != NULL ? eol + 1 : end;
+        if (eol == NULL) eol = end;
+        while (eol > ptr && (eol[-1] == '\r' || eol[-1] == ' ')) eol--;
+        if (eol > ptr) {
+            record[records].line = ptr;
+            record[records].length = (int) (eol - ptr);
+            record[records].order = records;
+            record[records].zone = zoneOf(&record[records]);
+            records++;
+        }
+        ptr = next;
+    }
+    qsort(record, records, sizeof(struct Record_struct), compareRecord);
+
+    version->filename = filename;
+    version->data = data;
+    version->records = records;
+    version->record = record;
+    printf("Records read from %s: %d\n", filename, records);
+}
+
+/*
+ * writeKey - copia la clave del registro (sin espacios finales) en "key"
+ */
+static void writeKey(const struct Record_struct *r, char *key)
+{
+    int bytes = profile->keyBytes < 63 ? profile->keyBytes : 63;
+    for (int k = 0; k < bytes; k++) key[k] = byteAt(r, profile->keyFirst + k);
+    while (bytes > 0 && key[bytes - 1] == ' ') bytes--;
+    key[bytes] = 0;
+}
+
+/*
+ * reportFields - informa los campos que difieren entre dos registros de misma clave;
+ * en el formato genérico, cada tramo de columnas distintas es un campo.
+ * Devuelve la cantidad de campos distintos.
+ */
+static int reportFields(const struct Record_struct *r1, const struct Record_struct *r2, int *fieldCount)
+{
+    char key[64];
+    int changes = 0;
+    writeKey(r1, key);
+
+    if (profile->field[0].name != NULL) {
+        for (int f = 0; profile->field[f].name != NULL; f++) {
+            const struct Field_struct *field = &profile->field[f];
+            if (compareColumns(r1, r2, field->first, field->bytes) == 0) continue;
+            printf("%s: %s '", key, field->name);
+            for (int k = 0; k < field->bytes; k++) putchar(byteAt(r1, field->first + k));
+            printf("' -> '");
+            for (int k = 0; k < field->bytes; k++) putchar(byteAt(r2, field->first + k));
+            printf("'\n");
+            fieldCount[f]++;
+            changes++;
+        }
+        if (changes > 0) return changes;
+    }
+
+    /* tramos de columnas distintas (formato genérico, o cambios fuera de los campos conocidos) */
+    int length = r1->length > r2->length ? r1->length : r2->length;
+    int pos = 1;
+    while (pos <= length) {
+        if (byteAt(r1, pos) == byteAt(r2, pos)) {
+            pos++;
+            continue;
+        }
+        int first = pos;
+        while (pos <= length && byteAt(r1, pos) != byteAt(r2, pos)) pos++;
+        printf("%s: bytes %d-%d '", key, first, pos - 1);
+        for (int k = first; k < pos; k++) putchar(byteAt(r1, k));
+        printf("' -> '");
+        for (int k = first; k < pos; k++) putchar(byteAt(r2, k));
+        printf("'\n");
+        changes++;
+    }
+    return changes;
+}
+
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv)
+{
+    printf("COMPARE_CAT - Compare two versions of a fixed-width catalog.\n");
+    printf("Made in 2025 by Daniel Severin.\n");
+
+    if (argc < 4) {
+        printf("Usage: compare_cat format file1 file2\n");
+        printf("   or: compare_cat key_first key_bytes file1 file2\n");
+        printf("    where format can be cd, bd, sd, cpd or gc, or the record key is given\n");
+        printf("    by its columns (numbered from 1); e.g.\n");
+        printf("        compare_cat cd cat/cd.txt cat/cd_curated.txt\n");
+        printf("        compare_cat gc cat/original/gc.txt cat/gc.txt\n");
+        printf("        compare_cat 1 6 cat/original/weiss.txt cat/weiss.txt\n");
+        exit(-1);
+    }
+
+    /* formato del catálogo */
+    int arg = 2;
+    profile = NULL;
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        if (strcmp(argv[1], profiles[p].name) == 0) profile = &profiles[p];
+    }
+    if (profile == NULL) {
+        if (argc < 5 || atoi(argv[1]) < 1 || atoi(argv[2]) < 1) bye("Unknown format!\n");
+        genericProfile.name = "generic";
+        genericProfile.keyFirst = atoi(argv[1]);
+        genericProfile.keyBytes = atoi(argv[2]);
+        genericProfile.zoneFirst = genericProfile.keyFirst;
+        genericProfile.zoneBytes = genericProfile.keyBytes;
+        genericProfile.zoneBucket = ZONE_BUCKET;
+        genericProfile.field[0].name = NULL;
+        profile = &genericProfile;
+        arg = 3;
+    }
+
+    struct Version_struct version1, version2;
+    readVersion(&version1, argv[arg]);
+    readVersion(&version2, argv[arg + 1]);
+
+    /* recorre ambas versiones zona por zona */
+    int fieldCount[MAX_FIELDS] = {0};
+    int zones = 0, sameZones = 0;
+    int compared = 0, changedRecords = 0, changedFields = 0;
+    int only1 = 0, only2 = 0;
+    int i1 = 0, i2 = 0;
+    struct Record_struct *rec1 = version1.record;
+    struct Record_struct *rec2 = version2.record;
+    while (i1 < version1.records || i2 < version2.records) {
+        int zone;
+        if (i2 >= version2.records) zone = rec1[i1].zone;
+        else if (i1 >= version1.records) zone = rec2[i2].zone;
+        else zone = rec1[i1].zone < rec2[i2].zone ? rec1[i1].zone : rec2[i2].zone;
+        int end1 = i1, end2 = i2;
+        unsigned long long hash1 = 14695981039346656037ULL, hash2 = hash1;
+        while (end1 < version1.records && rec1[end1].zone == zone) hash1 = hashRecord(hash1, &rec1[end1++]);
+        while (end2 < version2.records && rec2[end2].zone == zone) hash2 = hashRecord(hash2, &rec2[end2++]);
+        zones++;
+
+        /* zona idéntica: no hace falta comparar registro a registro */
+        if (hash1 == hash2 && end1 - i1 == end2 - i2) {
+            sameZones++;
+            compared += end1 - i1;
+            i1 = end1;
+            i2 = end2;
+            continue;
+        }
+
+        /* une ambas zonas por clave (las claves repetidas se aparean en orden de archivo) */
+        while (i1 < end1 || i2 < end2) {
+            int cmp;
+            if (i2 >= end2) cmp = -1;
+            else if (i1 >= end1) cmp = 1;
+            else cmp = compareColumns(&rec1[i1], &rec2[i2], profile->keyFirst, profile->keyBytes);
+            if (cmp < 0) {
+                printf("Only in %s: %.*s\n", version1.filename, rec1[i1].length, rec1[i1].line);
+                only1++;
+                i1++;
+                continue;
+            }
+            if (cmp > 0) {
+                printf("Only in %s: %.*s\n", version2.filename, rec2[i2].length, rec2[i2].line);
+                only2++;
+                i2++;
+                continue;
+            }
+            compared++;
+            if (rec1[i1].length != rec2[i2].length || memcmp(rec1[i1].line, rec2[i2].line, rec1[i1].length) != 0) {
+                changedFields += reportFields(&rec1[i1], &rec2[i2], fieldCount);
+                changedRecords++;
+            }
+            i1++;
+            i2++;
+        }
+    }
+
+    printf("Zones: %d (identical: %d)\n", zones, sameZones);
+    printf("Records compared: %d, changed: %d (fields: %d)\n", compared, changedRecords, changedFields);
+    printf("Only in %s: %d, only in %s: %d\n", version1.filename, only1, version2.filename, only2);
+    for (int f = 0; profile->field[f].name != NULL; f++) {
+        if (fieldCount[f] > 0) printf("   %s: %d\n", profile->field[f].name, fieldCount[f]);
+    }
+    return 0;
+}
@@ -12,9 +12,6 @@
 #include "trig.h"
 #include "misc.h"
 
-
-static struct DMstar_struct CDstar2[MAXDMSTAR];
-
 /*
  * main - comienzo de la aplicacion
  */
@@ -34,19 +31,20 @@ int main(int argc, char** argv)
         exit(-1);
     }
 
-    /* leemos catalogo CD 2 */
+    /* leemos catalogo CD 2 en un almacén propio */
     char buffer[64];
     snprintf(buffer, 64, "cat/%s", argv[2]);
-    readDM(buffer);
-    int stars = getDMStars();
-    struct DMstar_struct *CDstar1 = getDMStruct();
-    for (int i = 0; i < stars; i++) {
-        memcpy(&CDstar2[i], &CDstar1[i], sizeof(DMstar_struct));
-    }
+    struct DMstore_struct *CDstore2 = newDMStore(DM_CD);
+    readDMStore(CDstore2, buffer);
+    int stars = getDMStoreStars(CDstore2);
+    struct DMstar_struct *CDstar2 = getDMStoreStruct(CDstore2);
+    struct DMregister_struct *CDregister2 = getDMStoreRegister(CDstore2);
 
     /* leemos catalogo CD 1 */
     snprintf(buffer, 64, "cat/%s", argv[1]);
     readDM(buffer);
+    struct DMstar_struct *CDstar1 = getDMStruct();
+    struct DMregister_struct *CDregister1 = getDMRegisterStruct();
 
     /* comparamos */
     int diffRA = 0;
@@ -54,19 +52,19 @@ int main(int argc, char** argv)
     int diffMag = 0;
     int sameStar = 0;
     for (int i2 = 0; i2 < stars; i2++) {
-        if (CDstar2[i2].supplRef != ' ') continue;
+        if (CDregister2[i2].supplRef != ' ') continue;
         int declRef = CDstar2[i2].declRef;
         int numRef = CDstar2[i2].numRef;
         int i1 = getDMindex(true, declRef, numRef);
-        if (fabs(CDstar1[i1].rah - CDstar2[i2].rah) > EPS ||
-            fabs(CDstar1[i1].ramin - CDstar2[i2].ramin) > EPS ||
-            fabs(CDstar1[i1].raseg - CDstar2[i2].raseg) > EPS) {
+        if (fabs(CDregister1[i1].rah - CDregister2[i2].rah) > EPS ||
+            fabs(CDregister1[i1].ramin - CDregister2[i2].ramin) > EPS ||
+            fabs(CDregister1[i1].raseg - CDregister2[i2].raseg) > EPS) {
             printf("Difference in RA for CD %d°%d\n", declRef, numRef);
             diffRA++;
             continue;
         }
-        if (fabs(CDstar1[i1].decldeg - CDstar2[i2].decldeg) > EPS ||
-            fabs(CDstar1[i1].declmin - CDstar2[i2].declmin)) {
+        if (fabs(CDregister1[i1].decldeg - CDregister2[i2].decldeg) > EPS ||
+            fabs(CDregister1[i1].declmin - CDregister2[i2].declmin)) {
             printf("Difference in DE for CD %d°%d\n", declRef, numRef);
             diffDE++;
             continue;
@@ -11,21 +11,22 @@
 #include "read_cpd.h"
 #include "trig.h"
 #include "misc.h"
+#include "compare_utils.h"
 
 #define MAX_DISTANCE 180.0   // 3 minutos de arco
 #define MAX_DISTANCE_DROP 3600.0 // 1 grado de arco
 #define CROSS_CATALOG true   // true = 4011, false = 4005
 
 /*
- * main - comienzo de la aplicacion
+ * compareCPD - compara CD contra CPD (ver readCompareCD)
  */
-int main(int argc, char** argv)
+void compareCPD()
 {
-    printf("COMPARE_CPD - Compare CD and CPD catalogs.\n");
-    printf("Made in 2024 by Daniel Severin.\n");
+    logPrintf("COMPARE_CPD - Compare CD and CPD catalogs.\n");
+    logPrintf("Made in 2024 by Daniel Severin.\n");
 
     /* leemos catalogo CD */
-    readDM("cat/cd.txt");
+    readCompareCD("cat/cd.txt");
     struct DMstar_struct *CDstar = getDMStruct();
 
     /* leemos catalogo CPD */
@@ -45,7 +46,7 @@ int main(int argc, char** argv)
         if (dist > MAX_DISTANCE_DROP) {
             // posiciones demasiado separadas, posiblemente mala identificacion
             dropDistError++;
-            printf("*) CD %d°%d too separated from CPD %d°%d in %.1f arcsec.\n",
+            logPrintf("*) CD %d°%d too separated from CPD %d°%d in %.1f arcsec.\n",
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
                 CPDstar[i].declRef,
@@ -57,7 +58,7 @@ int main(int argc, char** argv)
         if (dist > MAX_DISTANCE) {
             // posiciones muy separadas, supera umbral
             indexError++;
-            printf("%d) CD %d°%d separated from CPD %d°%d in %.1f arcsec.\n",
+            logPrintf("%d) CD %d°%d separated from CPD %d°%d in %.1f arcsec.\n",
                 indexError,
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
@@ -65,7 +66,7 @@ int main(int argc, char** argv)
                 CPDstar[i].numRef,
                 dist);
             if (CPDstar[i].declRef2 != -1) {
-                printf("    (also identified as CD %d°%d)\n", CPDstar[i].declRef2, CPDstar[i].numRef2);
+                logPrintf("    (also identified as CD %d°%d)\n", CPDstar[i].declRef2, CPDstar[i].numRef2);
             }
             writeRegister(cdIndex, true);
             continue;
@@ -73,9 +74,19 @@ int main(int argc, char** argv)
         goodStarsPosition++;
         akkuDistError += dist * dist;
     }
-    printf("Total errors: %d, Drops = %d\n", indexError, dropDistError);
-    printf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
+    logPrintf("Total errors: %d, Drops = %d\n", indexError, dropDistError);
+    logPrintf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
         sqrt(akkuDistError / (double)goodStarsPosition),
         goodStarsPosition);
+}
+
+#ifndef COMPARE_LIBRARY
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv)
+{
+    compareCPD();
     return 0;
 }
+#endif
@@ -12,34 +12,140 @@
 #include "read_ppm.h"
 #include "trig.h"
 #include "misc.h"
+#include "compare_utils.h"
+#include "zone_cache.h"
 
 #define MAX_DISTANCE 120.0   // 2 minutos de arco
 #define MAX_MAGNITUDE 1.5
 //#define MAGNITUDE_METHOD
 
+/* cache por zonas de CD (ver zone_cache.h): cada estrella PPM va en la zona de su CD,
+   con estos contadores; los cruzamientos van a un archivo por volumen */
+#define CD_ZONES 90
+#define CD_VOLUMES 5
+#define VALUE_DIST_ERROR 0
+#define VALUE_MAG_ERROR 1
+#define VALUE_NO_WARNING 2
+#define VALUE_PROBLEMATIC 3
+#define VALUE_GOOD_POSITION 4
+#define VALUE_DIST_SQUARED 5
+#define VALUE_GOOD_MAGNITUDE 6
+#define VALUE_DELTA_SQUARED 7
+#define PPM_VALUES 8
+
 /*
- * main - comienzo de la aplicacion
+ * checkPPMStar - compara la estrella PPM "i" con su CD: deja sus contadores en value[]
+ * y, si allSky = true y no hay errores, su cruzamiento en el archivo de su volumen
  */
-int main(int argc, char** argv)
+static void checkPPMStar(int i, bool allSky, struct ZoneCache_struct *cache, double *value)
+{
+    struct DMstar_struct *CDstar = getDMStruct();
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+    int errors = 0; // las advertencias se numeran al cerrar el cache
+
+    bool isProblematic = false;
+    if (PPMstar[i].problem == 1) {
+        // se avisa si la estrella es "problematica"
+        isProblematic = true;
+        value[VALUE_PROBLEMATIC]++;
+    }
+
+    char ppmName[20];
+    snprintf(ppmName, 20, "PPM %d", PPMstar[i].ppmRef);
+
+    int cdIndex = PPMstar[i].dmIndex;
+    char cdString[32];
+    formatDesignation(cdString, PPMstar[i].dmName);
+    float dist = PPMstar[i].dist;
+    if (dist > MAX_DISTANCE) {
+        // posiciones muy separadas, supera umbral
+        value[VALUE_DIST_ERROR]++;
+        logWarning(&errors, "%s separated from %s%s in %.1f arcsec.\n",
+            cdString,
+            ppmName,
+            isProblematic ? " (PROBLEM)" : "",
+            dist);
+        writeRegister(cdIndex, true);
+        if (!revise(i)) value[VALUE_NO_WARNING]++;
+        return;
+    }
+    value[VALUE_GOOD_POSITION]++;
+    value[VALUE_DIST_SQUARED] = dist * dist;
+
+    double ppmVmag = PPMstar[i].vmag;
+    double cdVmag = CDstar[cdIndex].vmag;
+    if (fabs(ppmVmag) < 0.00001 || cdVmag > 29.9) return; // se omiten aquellas estrellas con Vmag=0 o variables
+#ifdef MAGNITUDE_METHOD        
+    double convertedCDmag = compCDmagToVmag(CDstar[cdIndex].declRef, cdVmag);
+    double delta = fabs(ppmVmag - convertedCDmag);
+#else
+    double convertedPPMVmag = compVmagToCDmag(CDstar[cdIndex].declRef, ppmVmag);
+    double delta = fabs(cdVmag - convertedPPMVmag);
+#endif        
+    if (delta >= MAX_MAGNITUDE) {
+        // diferencia en magnitud V y visual supera umbral
+        value[VALUE_MAG_ERROR]++;
+        logWarning(&errors, "%s reports mag=%.1f but %s%s has Vmag=%.1f: Delta = %.1f.\n",
+            cdString,
+            cdVmag,
+            ppmName,
+            isProblematic ? " (PROBLEM)" : "",
+            ppmVmag,
+            delta);
+        writeRegister(cdIndex, false);
+        if (!revise(i)) value[VALUE_NO_WARNING]++;
+        return;
+    }
+
+    if (allSky) {
+        // Las estrellas sin errores se cruzan con PPM y se almacenan según el volumen
+        int decl = -CDstar[cdIndex].declRef;
+        int volume = -1;
+        if (decl >= 22 && decl <= 31) {
+            volume = 0;
+        } else if (decl >= 32 && decl <= 41) {
+            volume = 1;
+        } else if (decl >= 42 && decl <= 51) {
+            volume = 2;
+        } else if (decl >= 52 && decl <= 61) {
+            volume = 3;
+        } else if (decl >= 62 && decl <= 89) {
+            volume = 4;
+        }
+        if (volume >= 0) {
+            writeCrossEntry(zoneStream(cache, volume), cdString, ppmName, cdVmag, dist);
+        }
+    }
+    value[VALUE_GOOD_MAGNITUDE]++;
+    value[VALUE_DELTA_SQUARED] = delta * delta;
+}
+
+/*
+ * comparePPM - compara la version "file" de CD contra PPM (NULL = muestra el uso);
+ * si incremental = true, solo recalcula las zonas de CD que cambiaron desde la
+ * corrida anterior (ver zone_cache.h)
+ */
+void comparePPM(const char *file, bool incremental)
 {
-    printf("COMPARE_PPM - Compare CD and PPM catalogs.\n");
-    printf("Made in 2024 by Daniel Severin.\n");
-
-    if (argc < 2) {
-        printf("Usage: compare_ppm file\n");
-        printf("    where file can be:\n");
-        printf("        cd.txt = Current CD catalog at Vizier\n");
-        printf("        cd_curated.txt = Curated version of cd.txt\n");
-        printf("        1114.txt = NASA-ADC CD catalog (has some errors)\n");
-        printf("        cd_vol1.txt = Same as cd.txt but only 1st. Volume (Resultados XVI)\n");
-        printf("        cd_vol1_curated.txt = Curated version of cd_vol1.txt\n");
-        printf("        I88.txt = 1982 CD catalog version (has some errors)\n");
+    logPrintf("COMPARE_PPM - Compare CD and PPM catalogs.\n");
+    logPrintf("Made in 2024 by Daniel Severin.\n");
+
+    if (file == NULL) {
+        logPrintf("Usage: compare_ppm file [incremental]\n");
+        logPrintf("    where file can be:\n");
+        logPrintf("        cd.txt = Current CD catalog at Vizier\n");
+        logPrintf("        cd_curated.txt = Curated version of cd.txt\n");
+        logPrintf("        1114.txt = NASA-ADC CD catalog (has some errors)\n");
+        logPrintf("        cd_vol1.txt = Same as cd.txt but only 1st. Volume (Resultados XVI)\n");
+        logPrintf("        cd_vol1_curated.txt = Curated version of cd_vol1.txt\n");
+        logPrintf("        I88.txt = 1982 CD catalog version (has some errors)\n");
+        logPrintf("    with incremental, only the CD zones changed since the last incremental run are compared\n");
         exit(-1);
     }
     bool allSky = true;
-    if (strcmp(argv[1], "cd.txt") && strcmp(argv[1], "cd_curated.txt") && strcmp(argv[1], "1114.txt")) {
-        if (strcmp(argv[1], "cd_vol1.txt") && strcmp(argv[1], "cd_vol1_curated.txt") && strcmp(argv[1], "I88.txt")) {
-            printf("Bad file name. See usage.\n");
+    if (strcmp(file, "cd.txt") && strcmp(file, "cd_curated.txt") && strcmp(file, "1114.txt")) {
+        if (strcmp(file, "cd_vol1.txt") && strcmp(file, "cd_vol1_curated.txt") && strcmp(file, "I88.txt")) {
+            logPrintf("Bad file name. See usage.\n");
             exit(-1);
         }
         allSky = false;
@@ -47,8 +153,8 @@ int main(int argc, char** argv)
 
     /* leemos catalogo CD */
     char buffer[64];
-    snprintf(buffer, 64, "cat/%s", argv[1]);
-    readDM(buffer);
+    snprintf(buffer, 64, "cat/%s", file);
+    readCompareCD(buffer);
     struct DMstar_struct *CDstar = getDMStruct();
 
     /* leemos catalogo PPM */
@@ -59,15 +165,40 @@ int main(int argc, char** argv)
     int CDstars = getDMStars();
 
     /* revisamos la identificación cruzada y generamos planillas */
-    FILE *crossPPMStreamV1, *crossPPMStreamV2;
-    FILE *crossPPMStreamV3, *crossPPMStreamV4, *crossPPMStreamV5;
+    FILE *crossPPMStream[CD_VOLUMES] = {NULL, NULL, NULL, NULL, NULL};
     if (allSky) {
         /* si cubrimos todo el cielo, generamos planillas para cada volumen */
-        crossPPMStreamV1 = openCrossFile("results/cross/cross_cd_vol1_ppm.csv");
-        crossPPMStreamV2 = openCrossFile("results/cross/cross_cd_vol2_ppm.csv");
-        crossPPMStreamV3 = openCrossFile("results/cross/cross_cd_vol3_ppm.csv");
-        crossPPMStreamV4 = openCrossFile("results/cross/cross_cd_vol4_ppm.csv");
-        crossPPMStreamV5 = openCrossFile("results/cross/cross_cd_vol5_ppm.csv");
+        crossPPMStream[0] = openCrossFile("results/cross/cross_cd_vol1_ppm.csv");
+        crossPPMStream[1] = openCrossFile("results/cross/cross_cd_vol2_ppm.csv");
+        crossPPMStream[2] = openCrossFile("results/cross/cross_cd_vol3_ppm.csv");
+        crossPPMStream[3] = openCrossFile("results/cross/cross_cd_vol4_ppm.csv");
+        crossPPMStream[4] = openCrossFile("results/cross/cross_cd_vol5_ppm.csv");
+    }
+
+    /* entradas: cada linea de CD en su zona (sus vecinas tambien cuentan, por los
+       registros vecinos que se listan) y PPM completo; la clave es el numero PPM,
+       que sigue el orden del archivo */
+    struct ZoneCache_struct cache;
+    snprintf(buffer, 64, "compare_ppm_%s", file);
+    char *extension = strrchr(buffer, '.');
+    if (extension != NULL) *extension = 0;
+    initZoneCache(&cache, buffer, CD_ZONES, 1, CD_VOLUMES, PPM_VALUES);
+    snprintf(buffer, 64, "cat/%s", file);
+    hashCacheFile(&cache, buffer, zoneOfDMLine);
+    hashCacheFile(&cache, "cat/ppm.txt", NULL);
+    /* las escalas de magnitud en uso (CD_MAG_SCALE_FILE, si existe) cambian las advertencias */
+    size_t scaleBytes;
+    const void *scaleTable = getCDMagScaleTable(&scaleBytes);
+    hashCacheBytes(&cache, -1, scaleTable, scaleBytes);
+    openZoneCache(&cache, incremental);
+    for (int i = 0; i < PPMstars; i++) {
+        if (PPMstar[i].discard == true) continue;
+        int zone = -CDstar[PPMstar[i].dmIndex].declRef;
+        if (isZoneFresh(&cache, zone)) continue;
+        double value[PPM_VALUES] = {0.0};
+        beginZoneEntry(&cache, zone, PPMstar[i].ppmRef);
+        checkPPMStar(i, allSky, &cache, value);
+        endZoneEntry(&cache, value);
     }
 
     int maxDistError = 0;
@@ -79,99 +210,31 @@ int main(int argc, char** argv)
     double akkuDistError = 0.0;
     int goodStarsMagnitude = 0;
     double akkuDeltaError = 0.0;
-    for (int i = 0; i < PPMstars; i++) {
-        if (PPMstar[i].discard == true) continue;
-        bool isProblematic = false;
-        if (PPMstar[i].problem == 1) {
-            // se avisa si la estrella es "problematica"
-            isProblematic = true;
-            problematic++;
-        }
-
-        char ppmName[20];
-        snprintf(ppmName, 20, "PPM %d", PPMstar[i].ppmRef);
-
-        int cdIndex = PPMstar[i].dmIndex;
-        char *cdString = PPMstar[i].dmString;
-        float dist = PPMstar[i].dist;
-        if (dist > MAX_DISTANCE) {
-            // posiciones muy separadas, supera umbral
-            maxDistError++;
-            indexError++;
-            printf("%d) %s separated from %s%s in %.1f arcsec.\n",
-                indexError,
-                cdString,
-                ppmName,
-                isProblematic ? " (PROBLEM)" : "",
-                dist);
-            writeRegister(cdIndex, true);
-            if (!revise(i)) totalErrorsMinusDoubles++;
-            continue;
-        }
-        goodStarsPosition++;
-        akkuDistError += dist * dist;
-
-        double ppmVmag = PPMstar[i].vmag;
-        double cdVmag = CDstar[cdIndex].vmag;
-        if (fabs(ppmVmag) < 0.00001 || cdVmag > 29.9) continue; // se omiten aquellas estrellas con Vmag=0 o variables
-#ifdef MAGNITUDE_METHOD        
-        double convertedCDmag = compCDmagToVmag(CDstar[cdIndex].declRef, cdVmag);
-        double delta = fabs(ppmVmag - convertedCDmag);
-#else
-        double convertedPPMVmag = compVmagToCDmag(CDstar[cdIndex].declRef, ppmVmag);
-        double delta = fabs(cdVmag - convertedPPMVmag);
-#endif        
-        if (delta >= MAX_MAGNITUDE) {
-            // diferencia en magnitud V y visual supera umbral
-            magDiffError++;
-            indexError++;
-            printf("%d) %s reports mag=%.1f but %s%s has Vmag=%.1f: Delta = %.1f.\n",
-                indexError,
-                cdString,
-                cdVmag,
-                ppmName,
-                isProblematic ? " (PROBLEM)" : "",
-                ppmVmag,
-                delta);
-            writeRegister(cdIndex, false);
-            if (!revise(i)) totalErrorsMinusDoubles++;
-            continue;
-        }
-
-        if (allSky) {
-            // Las estrellas sin errores se cruzan con PPM y se almacenan según el volumen
-            int decl = -CDstar[cdIndex].declRef;
-            FILE *targetStream = NULL;
-            if (decl >= 22 && decl <= 31) {
-                targetStream = crossPPMStreamV1;
-            } else if (decl >= 32 && decl <= 41) {
-                targetStream = crossPPMStreamV2;
-            } else if (decl >= 42 && decl <= 51) {
-                targetStream = crossPPMStreamV3;
-            } else if (decl >= 52 && decl <= 61) {
-                targetStream = crossPPMStreamV4;
-            } else if (decl >= 62 && decl <= 89) {
-                targetStream = crossPPMStreamV5;
-            }
-            if (targetStream != NULL) {
-                writeCrossEntry(targetStream, cdString, ppmName, cdVmag, dist);
-            }
-        }
-        goodStarsMagnitude++;
-        akkuDeltaError += delta * delta;
+    closeZoneCache(&cache, crossPPMStream, &indexError, incremental);
+    for (int k = 0; k < getZoneEntries(&cache); k++) {
+        const double *value = getZoneValues(&cache, k, NULL);
+        maxDistError += (int) value[VALUE_DIST_ERROR];
+        magDiffError += (int) value[VALUE_MAG_ERROR];
+        totalErrorsMinusDoubles += (int) value[VALUE_NO_WARNING];
+        problematic += (int) value[VALUE_PROBLEMATIC];
+        goodStarsPosition += (int) value[VALUE_GOOD_POSITION];
+        akkuDistError += value[VALUE_DIST_SQUARED];
+        goodStarsMagnitude += (int) value[VALUE_GOOD_MAGNITUDE];
+        akkuDeltaError += value[VALUE_DELTA_SQUARED];
     }
+    freeZoneCache(&cache);
 
     // Also generate CSV file for CD
     FILE *cdCatStream  = openCatalogFile("likelihood/cat1875/cd.csv");
     char cdName[20];
     for (int i = 0; i < CDstars; i++) {
-        snprintf(cdName, 20, "CD %d°%d", CDstar[i].declRef, CDstar[i].numRef);
+        formatDesignation(cdName, zoneDesignation(DESIG_CD, CDstar[i].declRef, CDstar[i].numRef));
         double vmag = CDstar[i].vmag;
         if (fabs(vmag) < 0.00001) vmag = 0.1; // workaround for stars with Vmag=0 to avoid confusion with variables
         if (vmag > 29.9) vmag = 0.0; // variable stars are considered as having Vmag=0 for the catalog file
         writeCatalogFile(cdCatStream, cdName, CDstar[i].x, CDstar[i].y, CDstar[i].z, vmag);
     }
-    fclose(cdCatStream);
+    closeCatalogFile(cdCatStream);
 
     // Also generate CSV file for PPM (southern stars)
     readPPM(false, true, true, false, 1875.0);
@@ -183,15 +246,29 @@ int main(int argc, char** argv)
         snprintf(ppmCatName, 20, "PPM %d", PPMstar[i].ppmRef);
         writeCatalogFile(ppmCatStream, ppmCatName, PPMstar[i].x, PPMstar[i].y, PPMstar[i].z, PPMstar[i].vmag);
     }
-    fclose(ppmCatStream);
+    closeCatalogFile(ppmCatStream);
+    if (allSky) {
+        for (int v = 0; v < CD_VOLUMES; v++) fclose(crossPPMStream[v]);
+    }
 
-    printf("Total errors: %d (position: %d, mag: %d); errors without warning = %d, PPM with problems = %d\n",
+    logPrintf("Total errors: %d (position: %d, mag: %d); errors without warning = %d, PPM with problems = %d\n",
         indexError, maxDistError, magDiffError, totalErrorsMinusDoubles,  problematic);
-    printf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
+    logPrintf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
         sqrt(akkuDistError / (double)goodStarsPosition),
         goodStarsPosition);
-    printf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
+    logPrintf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
         sqrt(akkuDeltaError / (double)goodStarsMagnitude),
         goodStarsMagnitude);
+}
+
+#ifndef COMPARE_LIBRARY
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv)
+{
+    if (argc > 3 || (argc == 3 && strcmp(argv[2], "incremental"))) comparePPM(NULL, false);
+    comparePPM(argc < 2 ? NULL : argv[1], argc == 3);
     return 0;
 }
+#endif
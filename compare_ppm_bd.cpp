@@ -52,7 +52,8 @@ int main(int argc, char** argv)
             problematic++;
         }
         int bdIndex = PPMstar[i].dmIndex;
-        char *bdString = PPMstar[i].dmString;
+        char bdString[32];
+        formatDesignation(bdString, PPMstar[i].dmName);
         double dist = PPMstar[i].dist;
         if (dist > MAX_DISTANCE) {
             // posiciones muy separadas, supera umbral
@@ -11,21 +11,22 @@
 #include "read_sd.h"
 #include "trig.h"
 #include "misc.h"
+#include "compare_utils.h"
 
 #define MAX_DISTANCE 180.0   // 3 minutos de arco
 #define MAX_DISTANCE_DROP 3600.0 // 1 grado de arco
 #define MAX_MAGNITUDE 0.8
 
 /*
- * main - comienzo de la aplicacion
+ * compareSD - compara CD contra SD (ver readCompareCD)
  */
-int main(int argc, char** argv)
+void compareSD()
 {
-    printf("COMPARE_SD - Compare CD and SD catalogs.\n");
-    printf("Made in 2024 by Daniel Severin.\n");
+    logPrintf("COMPARE_SD - Compare CD and SD catalogs.\n");
+    logPrintf("Made in 2024 by Daniel Severin.\n");
 
     /* leemos catalogo CD */
-    readDM("cat/cd.txt");
+    readCompareCD("cat/cd.txt");
     struct DMstar_struct *CDstar = getDMStruct();
 
     /* leemos catalogo SD */
@@ -49,7 +50,7 @@ int main(int argc, char** argv)
         if (dist > MAX_DISTANCE_DROP) {
             // posiciones demasiado separadas, posiblemente mala identificacion
             dropDistError++;
-            printf("*) CD %d°%d too separated from SD -22°%d in %.1f arcsec.\n",
+            logPrintf("*) CD %d°%d too separated from SD -22°%d in %.1f arcsec.\n",
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
                 SDstar[i].numRef,
@@ -62,7 +63,7 @@ int main(int argc, char** argv)
             // posiciones muy separadas, supera umbral
             maxDistError++;
             indexError++;
-            printf("%d) CD %d°%d separated from SD -22°%d in %.1f arcsec.\n",
+            logPrintf("%d) CD %d°%d separated from SD -22°%d in %.1f arcsec.\n",
                 indexError,
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
@@ -83,7 +84,7 @@ int main(int argc, char** argv)
             // diferencia en magnitud visual supera umbral
             magDiffError++;
             indexError++;
-            printf("%d) CD %d°%d reports mag=%.1f but it should be mag=%.1f from SD -22°%d: Delta = %.1f.\n",
+            logPrintf("%d) CD %d°%d reports mag=%.1f but it should be mag=%.1f from SD -22°%d: Delta = %.1f.\n",
                 indexError,
                 CDstar[cdIndex].declRef,
                 CDstar[cdIndex].numRef,
@@ -98,13 +99,23 @@ int main(int argc, char** argv)
         goodStarsMagnitude++;
         akkuDeltaError += delta * delta;
     }
-    printf("Total errors: %d (position: %d, mag: %d), Drops: %d\n",
+    logPrintf("Total errors: %d (position: %d, mag: %d), Drops: %d\n",
         indexError, maxDistError, magDiffError, dropDistError);
-    printf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
+    logPrintf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
         sqrt(akkuDistError / (double)goodStarsPosition),
         goodStarsPosition);
-    printf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
+    logPrintf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
         sqrt(akkuDeltaError / (double)goodStarsMagnitude),
         goodStarsMagnitude);
+}
+
+#ifndef COMPARE_LIBRARY
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv)
+{
+    compareSD();
     return 0;
 }
+#endif
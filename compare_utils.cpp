@@ -0,0 +1,89 @@
+/*
+ * COMPARE_UTILS - Codigo auxiliar compartido por las comparaciones contra CD
+ * Made in 2025 by Daniel E. Severin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "read_dm.h"
+#include "misc.h"
+#include "parallel.h"
+#include "compare_utils.h"
+
+/* archivo de CD ya cargado (vacio = ninguno) y lo que escribio su lectura */
+static char loadedCD[256] = "";
+static char *loadedCDLog = NULL;
+static size_t loadedCDLogSize = 0;
+
+/*
+ * loadCompareCD - lee CD una sola vez para todas las comparaciones que le sigan
+ */
+void loadCompareCD(const char *filename)
+{
+    beginLogCapture();
+    readDM(filename);
+    free(loadedCDLog);
+    loadedCDLog = endLogCapture(&loadedCDLogSize);
+    snprintf(loadedCD, sizeof(loadedCD), "%s", filename);
+    fwrite(loadedCDLog, 1, loadedCDLogSize, stdout);
+}
+
+/*
+ * readCompareCD - lee CD, o si ya fue cargado con loadCompareCD, repite lo que
+ * escribio su lectura (asi el registro de cada comparacion es el de siempre)
+ */
+void readCompareCD(const char *filename)
+{
+    if (loadedCD[0] == 0) {
+        readDM(filename);
+        return;
+    }
+    if (strcmp(loadedCD, filename)) {
+        char buffer[600];
+        snprintf(buffer, sizeof(buffer), "Comparison needs %s but %s is loaded!\n", filename, loadedCD);
+        bye(buffer);
+    }
+    logPrintf("%.*s", (int) loadedCDLogSize, loadedCDLog);
+}
+
+/*
+ * runComparison - corre una comparacion acumulando su salida y la escribe en su registro
+ */
+static void runComparison(void *context)
+{
+    struct Comparison *comparison = (struct Comparison *) context;
+    FILE *stream = fopen(comparison->logFile, "wt");
+    if (stream == NULL) {
+        perror("Cannot write log file");
+        exit(1);
+    }
+    /* se captura sin diferir: las advertencias de logWarning salen numeradas */
+    beginLogCapture();
+    comparison->run();
+    size_t size;
+    char *log = endLogCapture(&size);
+    fwrite(log, 1, size, stream);
+    fclose(stream);
+    free(log);
+    logPrintf("%s: log written in %s\n", comparison->name, comparison->logFile);
+}
+
+/*
+ * runComparisons - corre las comparaciones en paralelo (no dependen entre si:
+ * cada una lee sus propios catalogos y solo consulta CD)
+ */
+void runComparisons(struct Comparison *comparisons, int count)
+{
+    struct TaskNode *tasks = (struct TaskNode *) calloc(count, sizeof(struct TaskNode));
+    if (tasks == NULL) bye("Out of memory!\n");
+    for (int i = 0; i < count; i++) {
+        tasks[i].name = comparisons[i].name;
+        tasks[i].task = runComparison;
+        tasks[i].context = &comparisons[i];
+        tasks[i].after = NULL;
+    }
+    runTaskGraph(tasks, count);
+    printTaskGraphStats(stderr, tasks, count);
+    free(tasks);
+}
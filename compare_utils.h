@@ -0,0 +1,26 @@
+/*
+ * COMPARE_UTILS - Header
+ * Codigo auxiliar compartido por las comparaciones contra CD (compare_ppm,
+ * compare_agk, compare_cpd y compare_sd) y por compare_all, que las corre juntas
+ */
+
+/* CD se lee una sola vez: loadCompareCD lo deja cargado (y recuerda su salida), y
+   readCompareCD en cada comparacion reutiliza esa lectura si es del mismo archivo */
+void loadCompareCD(const char *filename);
+void readCompareCD(const char *filename);
+
+/* comparacion enchufable a compare_all: su salida (logPrintf) va a logFile; solo
+   debe modificar sus propios catalogos, ya que CD se comparte con las demas */
+struct Comparison {
+    const char *name;
+    const char *logFile;
+    void (*run)();
+};
+
+void runComparisons(struct Comparison *comparisons, int count);
+
+/* comparaciones disponibles (cada una tambien es una herramienta por separado) */
+void comparePPM(const char *file, bool incremental);
+void compareAGK();
+void compareCPD();
+void compareSD();
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include "read_ppm.h"
 #include "read_cpd.h"
 #include "read_dm.h"
@@ -14,11 +15,110 @@
 #include "trig.h"
 #include "misc.h"
 #include "find_gsc.h"
+#include "sky_grid.h"
+#include "cross_match.h"
 #include "cross_utils.h"
+#include "zone_cache.h"
 
 #define CURATED true // true if curated CD catalog should be used
 #define PRINT_WARNINGS false // true if print warnings about stars without CD star near them
 
+/* cache por zonas de declinacion (ver zone_cache.h): cada estrella GC va en la zona de
+   sus grados de declinacion, que es tambien la zona CD/CPD donde se buscan sus vecinas */
+#define GC_ZONES 91
+#define STREAM_CD 0
+#define STREAM_CPD 1
+#define STREAM_PPM 2
+#define STREAM_SAO 3
+#define STREAM_HD 4
+#define STREAM_UNIDENTIFIED 5
+#define GC_STREAMS 6
+#define VALUE_COUNT_DIST 0
+#define VALUE_DIST_ERROR 1
+#define VALUE_COUNT_DELTA 2
+#define VALUE_DELTA_ERROR 3
+#define VALUE_COUNT_GSC 4
+#define VALUE_COUNT_CD 5
+#define VALUE_COUNT_CPD 6
+#define VALUE_GREEDY_PPM 7
+#define GC_VALUES 8
+
+/*
+ * lecturas iniciales: CD, CPD, PPM y GC no se cruzan entre si al leerlos
+ */
+static void loadCD() {
+    readDM(CURATED ? "cat/cd_curated.txt" : "cat/cd.txt");
+}
+
+static void loadCPDOnly() {
+    readCPD(false, false);
+}
+
+static void loadPPM() {
+    /* no es necesario cruzarlo con DM */
+    preparePPM(1875.0, false);
+}
+
+static struct CrossStage loads[] = {
+    {"CD", loadCD, NULL},
+    {"CPD", loadCPDOnly, NULL},
+    {"PPM", loadPPM, NULL},
+    {"GC", readGC, NULL},
+};
+
+/*
+ * zoneOfGCLine - zona de una linea del catalogo GC (grados de declinacion, columnas 39-40)
+ */
+static int zoneOfGCLine(const char *line)
+{
+    if (strlen(line) < 40) return -1;
+    char cell[3] = {line[38], line[39], 0};
+    return atoi(cell);
+}
+
+/*
+ * crossLikelihoodPPM - identificacion inyectiva GC -> PPM por maxima verosimilitud
+ * (sin salir del proceso, ver likelihood/README.md) y comparacion con la voraz
+ */
+static void crossLikelihoodPPM(struct GCstar_struct *GCstar, int GCstars, const int *greedyPPM) {
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+    char catName[20], ppmName[20];
+
+    printf("\n***************************************\n");
+    printf("Perform likelihood cross-identification between GC and PPM...\n");
+
+    struct MatchSide_struct gcSide = {GCstars, &GCstar[0].x, &GCstar[0].vmag,
+        (int) (sizeof(struct GCstar_struct) / sizeof(double))};
+    struct MatchSide_struct ppmSide;
+    ppmMatchSide(&ppmSide);
+    struct MatchResult_struct result;
+    crossMatch(&gcSide, &ppmSide, NULL, &result);
+    printMatchStats("GC", "PPM", GCstars, &result);
+
+    FILE *crossStream = openCrossFile("likelihood/cross/cross_gc_ppm.csv");
+    int greedy = 0, agree = 0, shared = 0;
+    int *claims = (int *) calloc(ppmSide.count > 0 ? ppmSide.count : 1, sizeof(int));
+    if (claims == NULL) bye("Out of memory!\n");
+    for (int gcIndex = 0; gcIndex < GCstars; gcIndex++) {
+        if (greedyPPM[gcIndex] >= 0) {
+            greedy++;
+            if (claims[greedyPPM[gcIndex]]++ == 1) shared++;
+            if (greedyPPM[gcIndex] == result.match[gcIndex]) agree++;
+        }
+        int ppmIndex = result.match[gcIndex];
+        if (ppmIndex < 0) continue;
+        snprintf(catName, 20, "GC %d", GCstar[gcIndex].gcRef);
+        snprintf(ppmName, 20, "PPM %d", PPMstar[ppmIndex].ppmRef);
+        writeCrossEntry(crossStream, catName, ppmName, GCstar[gcIndex].vmag, result.dist[gcIndex]);
+    }
+    fclose(crossStream);
+    free(claims);
+
+    printf("Agreement with nearest PPM = %d of %d (%.1f%%); PPM stars assigned to more than one GC star = %d\n",
+        agree, greedy, greedy > 0 ? 100.0 * agree / greedy : 0.0, shared);
+    freeMatchResult(&result);
+}
+
 /*
  * main - comienzo de la aplicacion
  */
@@ -29,34 +129,61 @@ int main(int argc, char** argv)
     printf("CROSS_GC - Compare GC and PPM/CD catalogs.\n");
     printf("Made in 2025 by Daniel Severin.\n");
 
-    /* leemos catalogo CD */
-    readDM(CURATED ? "cat/cd_curated.txt" : "cat/cd.txt");
-    struct DMstar_struct *CDstar = getDMStruct();
+    /* con "likelihood" tambien se hace la identificacion inyectiva contra PPM;
+       con "incremental" solo se recalculan las zonas cuyas entradas cambiaron */
+    bool likelihood = false, incremental = false;
+    for (int k = 1; k < argc; k++) {
+        if (!strcmp(argv[k], "likelihood")) {
+            likelihood = true;
+        } else if (!strcmp(argv[k], "incremental")) {
+            incremental = true;
+        } else {
+            printf("Usage: %s [likelihood] [incremental]\n", argv[0]);
+            printf("  incremental: reuse zones whose inputs did not change (manifest in %s)\n", ZONE_CACHE_DIR);
+            exit(1);
+        }
+    }
 
-    /** leemos catalogo CPD */
-    readCPD(false, false);
+    /* leemos catalogos CD, CPD, PPM y GC (en paralelo) */
+    runCatalogLoads(loads, sizeof(loads) / sizeof(loads[0]));
+    struct DMstar_struct *CDstar = getDMStruct();
     struct CPDstar_struct *CPDstar = getCPDStruct();
-
-    /* leemos catalogo PPM (pero no es necesario cruzarlo con DM) */
-    struct PPMstar_struct *PPMstar = preparePPM(1875.0, false);
-
-    /* leemos catalogo GC */
-	readGC();
+    struct PPMstar_struct *PPMstar = getPPMStruct();
 	struct GCstar_struct *GCstar = getGCStruct();
 	int GCstars = getGCStars();
+    int *greedyPPM = (int *) malloc((GCstars > 0 ? GCstars : 1) * sizeof(int));
+    if (greedyPPM == NULL) bye("Out of memory!\n");
 
 	printf("\n***************************************\n");
     printf("Perform comparison between GC and PPM/CD/CPD...\n");
 
-	FILE *crossCDStream = openCrossFile("results/cross/cross_gc_cd.csv");
-	FILE *crossCPDStream = openCrossFile("results/cross/cross_gc_cpd.csv");
-    FILE *crossPPMStream, *crossSAOStream, *crossHDStream;
-    openCrossSet("gc", &crossPPMStream, &crossSAOStream, &crossHDStream);
-	FILE *unidentifiedStream = openUnidentifiedFile("results/cross/gc_unidentified.csv");
-    FILE *catalogStream = openCatalogFile("likelihood/cat1875/gc.csv");
+    FILE *output[GC_STREAMS];
+	output[STREAM_CD] = openCrossFile("results/cross/cross_gc_cd.csv");
+	output[STREAM_CPD] = openCrossFile("results/cross/cross_gc_cpd.csv");
+    openCrossSet("gc", &output[STREAM_PPM], &output[STREAM_SAO], &output[STREAM_HD]);
+	output[STREAM_UNIDENTIFIED] = openUnidentifiedFile("results/cross/gc_unidentified.csv");
+
+    /* GSC se consulta afuera (programa gsc) y no entra en los hashes */
+    struct ZoneCache_struct cache;
+    initZoneCache(&cache, "cross_gc", GC_ZONES, 1, GC_STREAMS, GC_VALUES);
+    hashCacheFile(&cache, "cat/gc.txt", zoneOfGCLine);
+    hashCacheFile(&cache, CURATED ? "cat/cd_curated.txt" : "cat/cd.txt", zoneOfDMLine);
+    hashCacheFile(&cache, "cat/cpd.txt", zoneOfDMLine);
+    hashCacheFile(&cache, "cat/ppm.txt", NULL);
+    openZoneCache(&cache, incremental);
 
-    CrossStats stats;
     for (int gcIndex = 0; gcIndex < GCstars; gcIndex++) {
+        int zone = GCstar[gcIndex].Decld < GC_ZONES ? GCstar[gcIndex].Decld : GC_ZONES - 1;
+        if (isZoneFresh(&cache, zone)) continue;
+        beginZoneEntry(&cache, zone, gcIndex);
+        FILE *crossCDStream = zoneStream(&cache, STREAM_CD);
+        FILE *crossCPDStream = zoneStream(&cache, STREAM_CPD);
+        FILE *crossPPMStream = zoneStream(&cache, STREAM_PPM);
+        FILE *crossSAOStream = zoneStream(&cache, STREAM_SAO);
+        FILE *crossHDStream = zoneStream(&cache, STREAM_HD);
+        FILE *unidentifiedStream = zoneStream(&cache, STREAM_UNIDENTIFIED);
+        CrossStats stats;
+
         double ra = GCstar[gcIndex].RA1875;
         double decl = GCstar[gcIndex].Decl1875;
         int gcRef = GCstar[gcIndex].gcRef;
@@ -68,8 +195,7 @@ int main(int argc, char** argv)
             double realPreRA = 3.072245 + 1.33695 * dsin(ra) * dtan(decl);
             double diff = fabs(preRA - realPreRA);
             if (diff > 0.0099) {
-                printf("%d) Warning: GC %d reports %.3f on precession RA but it should be %.3f (diff=%.3f).\n",
-                    ++stats.errors,
+                logWarning(&stats.errors, "Warning: GC %d reports %.3f on precession RA but it should be %.3f (diff=%.3f).\n",
                     gcRef,
                     preRA,
                     realPreRA,
@@ -83,8 +209,7 @@ int main(int argc, char** argv)
             double realPreDecl = 20.05425 * dcos(ra);
             double diff = fabs(preDecl - realPreDecl);
             if (diff > 0.099) {
-                printf("%d) Warning: GC %d reports %.3f on precession DECL but it should be %.3f (diff=%.3f).\n",
-                    ++stats.errors,
+                logWarning(&stats.errors, "Warning: GC %d reports %.3f on precession DECL but it should be %.3f (diff=%.3f).\n",
                     gcRef,
                     preDecl,
                     realPreDecl,
@@ -101,6 +226,7 @@ int main(int argc, char** argv)
         bool ppmFound = false;
 		int ppmIndex = -1;
 		double minDistance = HUGE_NUMBER;
+        int greedyIndex = -1;
 		/* busca la PPM mas cercana y genera el cruzamiento */
 		findPPMByCoordinates(x, y, z, decl, &ppmIndex, &minDistance);
         double nearestPPMDistance = minDistance;
@@ -113,8 +239,7 @@ int main(int argc, char** argv)
                     stats.akkuDeltaError += delta * delta;
                     stats.countDelta++;
                 } else {
-					printf("%d) Warning: GC has a near PPM %d star (vmag = %.1f) with a different magnitude (delta = %.1f).\n",
-                        ++stats.errors,
+					logWarning(&stats.errors, "Warning: GC has a near PPM %d star (vmag = %.1f) with a different magnitude (delta = %.1f).\n",
 						PPMstar[ppmIndex].ppmRef,
 						ppmVmag,
 						delta);
@@ -125,6 +250,7 @@ int main(int argc, char** argv)
             stats.akkuDistError += minDistance * minDistance;
             stats.countDist++;
             ppmFound = true;
+            greedyIndex = ppmIndex;
 
             writePPMCrossEntry(crossPPMStream, crossSAOStream, crossHDStream, catName, &PPMstar[ppmIndex], gcVmag, minDistance);
 		} else {
@@ -147,7 +273,7 @@ int main(int argc, char** argv)
                 stats.countCPD++;
                 cpdFound = true;
 
-			    snprintf(cdName, 20, "CPD %d°%d", CPDstar[cpdIndex].declRef, CPDstar[cpdIndex].numRef);
+			    formatDesignation(cdName, zoneDesignation(DESIG_CPD, CPDstar[cpdIndex].declRef, CPDstar[cpdIndex].numRef));
 			    writeCrossEntry(crossCPDStream, catName, cdName, gcVmag, minDistance);
 			} else {
 				if (PRINT_WARNINGS) {
@@ -168,8 +294,7 @@ int main(int argc, char** argv)
 			    if (gcVmag > __FLT_EPSILON__ && cdVmag < 29.9 && !GCstar[gcIndex].dpl) {
 				    float delta = fabs(gcVmag - cdVmag);
 				    if (delta >= MAX_MAGNITUDE) {
-					    printf("%d) Warning: GC has a near CD with a different magnitude (delta = %.1f).\n",
-                            ++stats.errors,
+					    logWarning(&stats.errors, "Warning: GC has a near CD with a different magnitude (delta = %.1f).\n",
                             delta);
                         writeRegisterGC(gcIndex);
 					    writeRegister(cdIndex, false);
@@ -179,7 +304,7 @@ int main(int argc, char** argv)
                 stats.countCD++;
                 cdFound = true;
 
-			    snprintf(cdName, 20, "CD %d°%d", CDstar[cdIndex].declRef, CDstar[cdIndex].numRef);
+			    formatDesignation(cdName, zoneDesignation(DESIG_CD, CDstar[cdIndex].declRef, CDstar[cdIndex].numRef));
 			    writeCrossEntry(crossCDStream, catName, cdName, gcVmag, minDistance);
 			} else {
 				if (PRINT_WARNINGS) {
@@ -193,7 +318,7 @@ int main(int argc, char** argv)
             if (gscFound) {
                 writeUnidentified(unidentifiedStream, catName, x, y, z);
             } else {
-                printf("%d) Warning: GC %d is ALONE (no PPM / CD / CPD / GSC star near it).\n", ++stats.errors, gcRef);
+                logWarning(&stats.errors, "Warning: GC %d is ALONE (no PPM / CD / CPD / GSC star near it).\n", gcRef);
                 writeRegisterGC(gcIndex);
                 logCauses(catName, true,
                     GCstar[gcIndex].cum, GCstar[gcIndex].neb,
@@ -201,13 +326,40 @@ int main(int argc, char** argv)
                     PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
             }
         }
-        writeCatalogFile(catalogStream, catName, x, y, z, gcVmag);
+
+        double value[GC_VALUES] = {(double) stats.countDist, stats.akkuDistError, (double) stats.countDelta,
+            stats.akkuDeltaError, (double) stats.countGSC, (double) stats.countCD, (double) stats.countCPD,
+            (double) greedyIndex};
+        endZoneEntry(&cache, value);
 	}
-    fclose(unidentifiedStream);
-    fclose(catalogStream);
-    closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
-	fclose(crossCPDStream);
-	fclose(crossCDStream);
+
+    /* vuelca las entradas (recalculadas o del manifiesto) en orden y suma los contadores */
+    CrossStats stats;
+    closeZoneCache(&cache, output, &stats.errors, incremental);
+    for (int k = 0; k < getZoneEntries(&cache); k++) {
+        int gcIndex;
+        const double *value = getZoneValues(&cache, k, &gcIndex);
+        stats.countDist += (int) value[VALUE_COUNT_DIST];
+        stats.akkuDistError += value[VALUE_DIST_ERROR];
+        stats.countDelta += (int) value[VALUE_COUNT_DELTA];
+        stats.akkuDeltaError += value[VALUE_DELTA_ERROR];
+        stats.countGSC += (int) value[VALUE_COUNT_GSC];
+        stats.countCD += (int) value[VALUE_COUNT_CD];
+        stats.countCPD += (int) value[VALUE_COUNT_CPD];
+        greedyPPM[gcIndex] = (int) value[VALUE_GREEDY_PPM];
+    }
+    freeZoneCache(&cache);
+    fclose(output[STREAM_UNIDENTIFIED]);
+    closeCrossSet(output[STREAM_PPM], output[STREAM_SAO], output[STREAM_HD]);
+	fclose(output[STREAM_CPD]);
+	fclose(output[STREAM_CD]);
+
+    FILE *catalogStream = openCatalogFile("likelihood/cat1875/gc.csv");
+    for (int gcIndex = 0; gcIndex < GCstars; gcIndex++) {
+        snprintf(catName, 20, "GC %d", GCstar[gcIndex].gcRef);
+        writeCatalogFile(catalogStream, catName, GCstar[gcIndex].x, GCstar[gcIndex].y, GCstar[gcIndex].z, GCstar[gcIndex].vmag);
+    }
+    closeCatalogFile(catalogStream);
 
     printf("Stars from GC identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n",
         stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
@@ -215,6 +367,9 @@ int main(int argc, char** argv)
     printRSMEMag(&stats);
     printf("Errors logged = %d\n", stats.errors);
 
+    if (likelihood) crossLikelihoodPPM(GCstar, GCstars, greedyPPM);
+    free(greedyPPM);
+
     // Also, generate a file with all GC double stars
     double *gcX   = (double*) malloc(GCstars * sizeof(double));
     double *gcY   = (double*) malloc(GCstars * sizeof(double));
@@ -0,0 +1,472 @@
+/*
+ * CROSS_MATCH - Identificacion cruzada inyectiva por maxima verosimilitud en memoria
+ * Made in 2025 by Daniel E. Severin
+ *
+ * Mismo procedimiento que likelihood/cross_likelihood.py (ver likelihood/README.md):
+ * 1) pares candidatos a menos de MATCH_MAX_THETA, buscados en un indice de B, con
+ *    peso w(a,b) = theta^2 / (2 sigma_pos^2) + dm^2 / (2 sigma_m^2);
+ * 2) componentes conexas del grafo bipartito;
+ * 3) asignacion de costo minimo en cada componente: fuerza bruta si es chica,
+ *    Hungarian (Kuhn-Munkres) si no. Los pares ausentes valen un costo centinela
+ *    (mayor que cualquier peso admisible) y se descartan al final.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "misc.h"
+#include "sky_grid.h"
+#include "parallel.h"
+#include "cross_match.h"
+
+/* estrellas de A por tarea al generar los pares */
+#define MATCH_CHUNK 4096
+/* la fuerza bruta se usa solo si el arbol de búsqueda no supera esta cantidad de hojas */
+#define MATCH_BRUTE_FORCE_LEAVES 100000
+
+#define POS_COST_FACTOR (1.0 / (2.0 * MATCH_SIGMA_POS * MATCH_SIGMA_POS))
+#define MAG_COST_FACTOR (1.0 / (2.0 * MATCH_SIGMA_MAG * MATCH_SIGMA_MAG))
+#define MISSING_MAG_COST (MATCH_MISSING_DMAG * MATCH_MISSING_DMAG * MAG_COST_FACTOR)
+#define SENTINEL_COST (MATCH_MAX_THETA * MATCH_MAX_THETA * POS_COST_FACTOR \
+    + MATCH_MAX_DMAG * MATCH_MAX_DMAG * MAG_COST_FACTOR + 1.0)
+
+struct MatchEdge_struct {
+    int a, b;
+    double cost, theta;
+};
+
+/* pares generados por una tarea (estrellas de A consecutivas) */
+struct EdgeChunk_struct {
+    struct MatchEdge_struct *edge;
+    int count, capacity;
+};
+
+struct EdgeContext_struct {
+    const struct MatchSide_struct *a, *b;
+    const struct SkyGrid_struct *grid;
+    struct EdgeChunk_struct *chunk;
+};
+
+/* componente: sus pares y sus vertices de A y B (indices ascendentes) */
+struct Component_struct {
+    int firstEdge, edges;
+    int firstA, countA;
+    int firstB, countB;
+    bool hungarian;
+};
+
+struct SolveContext_struct {
+    const struct MatchEdge_struct *edge; /* agrupados por componente */
+    const int *vertexA, *vertexB;
+    struct Component_struct *component;
+    struct MatchResult_struct *result;
+};
+
+/*
+ * sideMag - magnitud de la estrella i de un lado (0 si no hay magnitudes)
+ */
+static double sideMag(const struct MatchSide_struct *side, int i)
+{
+    if (side->mag == NULL) return 0.0;
+    return side->mag[(size_t) i * side->stride];
+}
+
+/*
+ * buildEdgeChunk - pares candidatos de un tramo de estrellas de A
+ */
+static void buildEdgeChunk(int index, void *context)
+{
+    struct EdgeContext_struct *ctx = (struct EdgeContext_struct *) context;
+    struct EdgeChunk_struct *chunk = &ctx->chunk[index];
+    struct SkyHits_struct hits;
+    memset(&hits, 0, sizeof(hits));
+
+    int last = (index + 1) * MATCH_CHUNK;
+    if (last > ctx->a->count) last = ctx->a->count;
+    for (int i = index * MATCH_CHUNK; i < last; i++) {
+        const double *s = ctx->a->exact + (size_t) i * ctx->a->stride;
+        double magA = sideMag(ctx->a, i);
+        querySkyGrid(ctx->grid, s[0], s[1], s[2], MATCH_MAX_THETA, &hits);
+        for (int h = 0; h < hits.count; h++) {
+            int j = hits.index[h];
+            double theta = hits.dist[h];
+            double magB = sideMag(ctx->b, j);
+            bool bothKnown = magKnown(magA) && magKnown(magB);
+            if (bothKnown && fabs(magA - magB) > MATCH_MAX_DMAG) continue;
+            double cost = theta * theta * POS_COST_FACTOR;
+            if (bothKnown) {
+                cost += (magA - magB) * (magA - magB) * MAG_COST_FACTOR;
+            } else {
+                cost += MISSING_MAG_COST;
+            }
+
+            if (chunk->count == chunk->capacity) {
+                chunk->capacity = chunk->capacity == 0 ? 1024 : 2 * chunk->capacity;
+                chunk->edge = (struct MatchEdge_struct *) realloc(chunk->edge,
+                    (size_t) chunk->capacity * sizeof(struct MatchEdge_struct));
+                if (chunk->edge == NULL) bye("Out of memory!\n");
+            }
+            struct MatchEdge_struct *e = &chunk->edge[chunk->count++];
+            e->a = i;
+            e->b = j;
+            e->cost = cost;
+            e->theta = theta;
+        }
+    }
+    freeSkyHits(&hits);
+}
+
+/*
+ * findRoot - raíz de un vertice en el bosque de union-find (con compresión a medias)
+ */
+static int findRoot(int *parent, int v)
+{
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+/*
+ * bruteForce - recorre las asignaciones de las filas [row, rows) a columnas libres
+ * (o a ninguna, con costo centinela) guardando la de menor costo
+ */
+static void bruteForce(const double *cost, int rows, int cols, int row, double partial,
+        int *assign, bool *used, int *best, double *bestCost)
+{
+    if (partial >= *bestCost) return;
+    if (row == rows) {
+        *bestCost = partial;
+        memcpy(best, assign, (size_t) rows * sizeof(int));
+        return;
+    }
+    for (int j = 0; j < cols; j++) {
+        double c = cost[(size_t) row * cols + j];
+        if (used[j] || c >= SENTINEL_COST) continue;
+        used[j] = true;
+        assign[row] = j;
+        bruteForce(cost, rows, cols, row + 1, partial + c, assign, used, best, bestCost);
+        used[j] = false;
+    }
+    assign[row] = -1;
+    bruteForce(cost, rows, cols, row + 1, partial + SENTINEL_COST, assign, used, best, bestCost);
+}
+
+/*
+ * hungarian - asignación de costo mínimo de rows filas a cols >= rows columnas
+ * (Kuhn-Munkres con potenciales, O(rows^2 cols)); deja en assign la columna de cada fila
+ */
+static void hungarian(const double *cost, int rows, int cols, int *assign)
+{
+    double *u = (double *) calloc(rows + 1, sizeof(double));
+    double *v = (double *) calloc(cols + 1, sizeof(double));
+    double *minv = (double *) malloc((cols + 1) * sizeof(double));
+    int *p = (int *) calloc(cols + 1, sizeof(int));
+    int *way = (int *) calloc(cols + 1, sizeof(int));
+    bool *used = (bool *) malloc((cols + 1) * sizeof(bool));
+    if (u == NULL || v == NULL || minv == NULL || p == NULL || way == NULL || used == NULL) {
+        bye("Out of memory!\n");
+    }
+
+    for (int i = 1; i <= rows; i++) {
+        p[0] = i;
+        int j0 = 0;
+        for (int j = 0; j <= cols; j++) {
+            minv[j] = HUGE_VAL;
+            used[j] = false;
+        }
+        do {
+            used[j0] = true;
+            int i0 = p[j0], j1 = 0;
+            double delta = HUGE_VAL;
+            for (int j = 1; j <= cols; j++) {
+                if (used[j]) continue;
+                double cur = cost[(size_t) (i0 - 1) * cols + (j - 1)] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= cols; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+    for (int j = 1; j <= cols; j++) {
+        if (p[j] != 0) assign[p[j] - 1] = j - 1;
+    }
+
+    free(u);
+    free(v);
+    free(minv);
+    free(p);
+    free(way);
+    free(used);
+}
+
+/*
+ * solveComponent - asignación de costo mínimo de una componente (escribe solo sus estrellas de A)
+ */
+static void solveComponent(int index, void *context)
+{
+    struct SolveContext_struct *ctx = (struct SolveContext_struct *) context;
+    struct Component_struct *comp = &ctx->component[index];
+    const int *vertexA = ctx->vertexA + comp->firstA;
+    const int *vertexB = ctx->vertexB + comp->firstB;
+    int countA = comp->countA, countB = comp->countB;
+
+    /* matriz de costos con el lado más chico como filas */
+    bool rowsAreA = countA <= countB;
+    int rows = rowsAreA ? countA : countB;
+    int cols = rowsAreA ? countB : countA;
+    double *cost = (double *) malloc((size_t) rows * cols * sizeof(double));
+    double *theta = (double *) malloc((size_t) rows * cols * sizeof(double));
+    int *degree = (int *) calloc(rows, sizeof(int));
+    int *assign = (int *) malloc(rows * sizeof(int));
+    if (cost == NULL || theta == NULL || degree == NULL || assign == NULL) bye("Out of memory!\n");
+    for (size_t k = 0; k < (size_t) rows * cols; k++) cost[k] = SENTINEL_COST;
+
+    for (int k = 0; k < comp->edges; k++) {
+        const struct MatchEdge_struct *e = &ctx->edge[comp->firstEdge + k];
+        /* posiciones locales por búsqueda binaria (los vertices están ordenados) */
+        int lo = 0, hi = countA - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (vertexA[mid] < e->a) lo = mid + 1; else hi = mid;
+        }
+        int localA = lo;
+        lo = 0;
+        hi = countB - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (vertexB[mid] < e->b) lo = mid + 1; else hi = mid;
+        }
+        int localB = lo;
+        int row = rowsAreA ? localA : localB;
+        int col = rowsAreA ? localB : localA;
+        cost[(size_t) row * cols + col] = e->cost;
+        theta[(size_t) row * cols + col] = e->theta;
+        degree[row]++;
+    }
+
+    /* fuerza bruta para componentes chicas (si el arbol no es enorme), sino Hungarian */
+    double leaves = 1.0;
+    for (int i = 0; i < rows; i++) leaves *= degree[i] + 1;
+    comp->hungarian = rows > MATCH_BRUTE_FORCE_LIMIT || leaves > MATCH_BRUTE_FORCE_LEAVES;
+    if (comp->hungarian) {
+        hungarian(cost, rows, cols, assign);
+    } else {
+        int *current = (int *) malloc(rows * sizeof(int));
+        bool *used = (bool *) calloc(cols, sizeof(bool));
+        if (current == NULL || used == NULL) bye("Out of memory!\n");
+        double bestCost = HUGE_VAL;
+        bruteForce(cost, rows, cols, 0, 0.0, current, used, assign, &bestCost);
+        free(current);
+        free(used);
+    }
+
+    for (int i = 0; i < rows; i++) {
+        int j = assign[i];
+        if (j < 0 || cost[(size_t) i * cols + j] >= SENTINEL_COST) continue;
+        int a = rowsAreA ? vertexA[i] : vertexA[j];
+        int b = rowsAreA ? vertexB[j] : vertexB[i];
+        ctx->result->match[a] = b;
+        ctx->result->dist[a] = theta[(size_t) i * cols + j];
+    }
+    free(cost);
+    free(theta);
+    free(degree);
+    free(assign);
+}
+
+/*
+ * compareInt - para qsort de enteros ascendentes
+ */
+static int compareInt(const void *x, const void *y)
+{
+    int a = *(const int *) x, b = *(const int *) y;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/*
+ * crossMatch - identificación inyectiva de A en B que minimiza la suma de pesos
+ * (gridB: indice de B ya armado con buildSkyGrid, o NULL para armar uno temporal)
+ */
+void crossMatch(const struct MatchSide_struct *a, const struct MatchSide_struct *b,
+        const struct SkyGrid_struct *gridB, struct MatchResult_struct *result)
+{
+    memset(result, 0, sizeof(struct MatchResult_struct));
+    result->match = (int *) malloc((size_t) (a->count > 0 ? a->count : 1) * sizeof(int));
+    result->dist = (double *) malloc((size_t) (a->count > 0 ? a->count : 1) * sizeof(double));
+    if (result->match == NULL || result->dist == NULL) bye("Out of memory!\n");
+    for (int i = 0; i < a->count; i++) {
+        result->match[i] = -1;
+        result->dist[i] = 0.0;
+    }
+
+    struct SkyGrid_struct ownGrid;
+    if (gridB == NULL) {
+        memset(&ownGrid, 0, sizeof(ownGrid));
+        buildSkyGrid(&ownGrid, b->exact, b->stride, b->count, MATCH_GRID_CELL);
+        gridB = &ownGrid;
+    }
+
+    /* 1) pares candidatos, en paralelo por tramos de A (quedan ordenados por a y b) */
+    int chunks = (a->count + MATCH_CHUNK - 1) / MATCH_CHUNK;
+    struct EdgeChunk_struct *chunk = (struct EdgeChunk_struct *) calloc(chunks > 0 ? chunks : 1, sizeof(struct EdgeChunk_struct));
+    if (chunk == NULL) bye("Out of memory!\n");
+    struct EdgeContext_struct edgeContext = {a, b, gridB, chunk};
+    parallelFor(chunks, buildEdgeChunk, &edgeContext);
+    int edges = 0;
+    for (int c = 0; c < chunks; c++) edges += chunk[c].count;
+    struct MatchEdge_struct *edge = (struct MatchEdge_struct *) malloc((size_t) (edges > 0 ? edges : 1) * sizeof(struct MatchEdge_struct));
+    if (edge == NULL) bye("Out of memory!\n");
+    edges = 0;
+    for (int c = 0; c < chunks; c++) {
+        memcpy(&edge[edges], chunk[c].edge, (size_t) chunk[c].count * sizeof(struct MatchEdge_struct));
+        edges += chunk[c].count;
+        free(chunk[c].edge);
+    }
+    free(chunk);
+    result->edges = edges;
+
+    /* 2) componentes conexas (vertices de A primero, luego los de B) */
+    int vertices = a->count + b->count;
+    int *parent = (int *) malloc((size_t) (vertices > 0 ? vertices : 1) * sizeof(int));
+    int *label = (int *) malloc((size_t) (vertices > 0 ? vertices : 1) * sizeof(int));
+    if (parent == NULL || label == NULL) bye("Out of memory!\n");
+    for (int v = 0; v < vertices; v++) {
+        parent[v] = v;
+        label[v] = -1;
+    }
+    for (int k = 0; k < edges; k++) {
+        int ra = findRoot(parent, edge[k].a);
+        int rb = findRoot(parent, a->count + edge[k].b);
+        if (ra != rb) {
+            if (ra < rb) parent[rb] = ra; else parent[ra] = rb;
+        }
+    }
+
+    /* numera las componentes en el orden en que aparecen sus pares */
+    int components = 0;
+    int *edgeComp = (int *) malloc((size_t) (edges > 0 ? edges : 1) * sizeof(int));
+    if (edgeComp == NULL) bye("Out of memory!\n");
+    for (int k = 0; k < edges; k++) {
+        int root = findRoot(parent, edge[k].a);
+        if (label[root] == -1) label[root] = components++;
+        edgeComp[k] = label[root];
+    }
+    struct Component_struct *component = (struct Component_struct *) calloc(components > 0 ? components : 1, sizeof(struct Component_struct));
+    if (component == NULL) bye("Out of memory!\n");
+
+    /* agrupa pares y vertices por componente (ordenamiento por conteo, estable) */
+    for (int k = 0; k < edges; k++) component[edgeComp[k]].edges++;
+    for (int c = 1; c < components; c++) component[c].firstEdge = component[c - 1].firstEdge + component[c - 1].edges;
+    struct MatchEdge_struct *grouped = (struct MatchEdge_struct *) malloc((size_t) (edges > 0 ? edges : 1) * sizeof(struct MatchEdge_struct));
+    int *fill = (int *) calloc(components > 0 ? components : 1, sizeof(int));
+    bool *seen = (bool *) calloc(vertices > 0 ? vertices : 1, sizeof(bool));
+    if (grouped == NULL || fill == NULL || seen == NULL) bye("Out of memory!\n");
+    for (int k = 0; k < edges; k++) {
+        int c = edgeComp[k];
+        grouped[component[c].firstEdge + fill[c]++] = edge[k];
+        if (!seen[edge[k].a]) {
+            seen[edge[k].a] = true;
+            component[c].countA++;
+        }
+        if (!seen[a->count + edge[k].b]) {
+            seen[a->count + edge[k].b] = true;
+            component[c].countB++;
+        }
+    }
+    for (int c = 1; c < components; c++) {
+        component[c].firstA = component[c - 1].firstA + component[c - 1].countA;
+        component[c].firstB = component[c - 1].firstB + component[c - 1].countB;
+    }
+    int totalA = components > 0 ? component[components - 1].firstA + component[components - 1].countA : 0;
+    int totalB = components > 0 ? component[components - 1].firstB + component[components - 1].countB : 0;
+    int *vertexA = (int *) malloc((size_t) (totalA > 0 ? totalA : 1) * sizeof(int));
+    int *vertexB = (int *) malloc((size_t) (totalB > 0 ? totalB : 1) * sizeof(int));
+    if (vertexA == NULL || vertexB == NULL) bye("Out of memory!\n");
+    memset(fill, 0, (size_t) (components > 0 ? components : 1) * sizeof(int));
+    int *fillB = (int *) calloc(components > 0 ? components : 1, sizeof(int));
+    if (fillB == NULL) bye("Out of memory!\n");
+    memset(seen, 0, (size_t) (vertices > 0 ? vertices : 1) * sizeof(bool));
+    for (int k = 0; k < edges; k++) {
+        int c = edgeComp[k];
+        if (!seen[edge[k].a]) {
+            seen[edge[k].a] = true;
+            vertexA[component[c].firstA + fill[c]++] = edge[k].a;
+        }
+        if (!seen[a->count + edge[k].b]) {
+            seen[a->count + edge[k].b] = true;
+            vertexB[component[c].firstB + fillB[c]++] = edge[k].b;
+        }
+    }
+    /* los de A ya quedan ascendentes (los pares vienen ordenados por a); los de B no */
+    for (int c = 0; c < components; c++) {
+        if (component[c].countB > 1) {
+            qsort(&vertexB[component[c].firstB], component[c].countB, sizeof(int), compareInt);
+        }
+    }
+    free(fill);
+    free(fillB);
+    free(seen);
+    free(edgeComp);
+    free(label);
+    free(parent);
+    free(edge);
+
+    /* 3) asignación en cada componente (en paralelo: no comparten estrellas) */
+    struct SolveContext_struct solveContext = {grouped, vertexA, vertexB, component, result};
+    parallelFor(components, solveComponent, &solveContext);
+
+    result->components = components;
+    for (int c = 0; c < components; c++) {
+        if (component[c].hungarian) {
+            result->hungarian++;
+            if (component[c].countA + component[c].countB > result->largestA + result->largestB) {
+                result->largestA = component[c].countA;
+                result->largestB = component[c].countB;
+            }
+        } else {
+            result->brute++;
+        }
+    }
+    for (int i = 0; i < a->count; i++) {
+        if (result->match[i] >= 0) result->pairs++;
+    }
+
+    free(grouped);
+    free(vertexA);
+    free(vertexB);
+    free(component);
+    if (gridB == &ownGrid) freeSkyGrid(&ownGrid);
+}
+
+/*
+ * freeMatchResult - libera el resultado de crossMatch
+ */
+void freeMatchResult(struct MatchResult_struct *result)
+{
+    free(result->match);
+    free(result->dist);
+    result->match = NULL;
+    result->dist = NULL;
+}
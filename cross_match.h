@@ -0,0 +1,40 @@
+/*
+ * CROSS_MATCH - Header
+ * Identificacion cruzada inyectiva por maxima verosimilitud entre dos catalogos en
+ * memoria (el mismo modelo que likelihood/cross_likelihood.py, ver likelihood/README.md)
+ * (incluir despues de misc.h y sky_grid.h)
+ */
+
+/* constantes del modelo (Tabla 1 de likelihood/README.md) */
+#define MATCH_SIGMA_POS 30.0 /* arcsec */
+#define MATCH_SIGMA_MAG 0.5
+#define MATCH_MAX_THETA 300.0 /* arcsec */
+#define MATCH_MAX_DMAG 3.0
+#define MATCH_MISSING_DMAG 2.0
+#define MATCH_BRUTE_FORCE_LIMIT 5 /* componentes con min(|A|, |B|) hasta este valor */
+#define MATCH_GRID_CELL 0.25 /* lado de las celdas del indice de B, en grados */
+
+/* un lado de la identificacion: "exact" apunta al campo x de la estrella 0 y "mag" a
+   su magnitud, ambos con "stride" doubles entre estrellas (como en buildUnitCopy);
+   mag = NULL si no hay magnitudes. Una magnitud es desconocida si vale 0 o supera
+   29.9 (variables en DM) */
+struct MatchSide_struct {
+    int count;
+    const double *exact;
+    const double *mag;
+    int stride;
+};
+
+/* resultado: para cada estrella de A, su par en B (o -1) y la distancia en arcsec */
+struct MatchResult_struct {
+    int *match;
+    double *dist;
+    int pairs; /* pares elegidos */
+    int edges; /* pares candidatos que pasan los cortes */
+    int components, brute, hungarian; /* componentes no triviales y cómo se resolvieron */
+    int largestA, largestB; /* componente más grande resuelta por Hungarian */
+};
+
+void crossMatch(const struct MatchSide_struct *a, const struct MatchSide_struct *b,
+    const struct SkyGrid_struct *gridB, struct MatchResult_struct *result);
+void freeMatchResult(struct MatchResult_struct *result);
@@ -52,8 +52,8 @@ StarList bacList = {&countBAC, bacRef, bacX, bacY, bacZ};
 void readWB() {
     char buffer[1024], cell[256], catName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Weisse catalog and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Weisse catalog and PPM...\n");
 
     CrossStats stats;
 
@@ -92,7 +92,7 @@ void readWB() {
 		        } else if (magFrac == magInt - 1) {
 		            vmag -= 0.3;
 		        } else {
-		            printf("Error: line %d has unexpected value %d in magnitude columns 12-13 (expected %d, %d or blank). Using integer magnitude.\n",
+		            logPrintf("Error: line %d has unexpected value %d in magnitude columns 12-13 (expected %d, %d or blank). Using integer magnitude.\n",
 		                lineNum, magFrac, magInt - 1, magInt + 1);
 		        }
 		    }
@@ -125,10 +125,10 @@ void readWB() {
 	fclose(stream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Available WB stars = %d\n", countWB);
-    printf("Stars from WB identified with PPM = %d\n", stats.countDist);
+    logPrintf("Available WB stars = %d\n", countWB);
+    logPrintf("Stars from WB identified with PPM = %d\n", stats.countDist);
     printRSMEDist(&stats);
-    printf("Stars not identified with PPM nor GSC = %d\n", stats.errors);
+    logPrintf("Stars not identified with PPM nor GSC = %d\n", stats.errors);
 }
 
 /*
@@ -137,8 +137,8 @@ void readWB() {
 void readOARN() {
     char buffer[1024], cell[256], catName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Oeltzen-Argelander North catalog and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Oeltzen-Argelander North catalog and PPM...\n");
 
     CrossStats stats;
 
@@ -171,7 +171,7 @@ void readOARN() {
 		    } else if (magFrac == magInt - 1) {
 		        vmag -= 0.2;
 		    } else {
-		        printf("Error: OA %d has unexpected value %d in magnitude columns 8-9 (expected %d, %d or blank).\n",
+		        logPrintf("Error: OA %d has unexpected value %d in magnitude columns 8-9 (expected %d, %d or blank).\n",
 		            oeltzenRef, magFrac, magInt - 1, magInt + 1);
 		        exit(1);
 		    }
@@ -201,10 +201,10 @@ void readOARN() {
 	fclose(stream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Available OA stars = %d\n", countOA);
-    printf("Stars from OA identified with PPM = %d\n", stats.countDist);
+    logPrintf("Available OA stars = %d\n", countOA);
+    logPrintf("Stars from OA identified with PPM = %d\n", stats.countDist);
     printRSMEDist(&stats);
-    printf("Stars not identified with PPM nor GSC = %d\n", stats.errors);
+    logPrintf("Stars not identified with PPM nor GSC = %d\n", stats.errors);
 }
 
 /*
@@ -213,8 +213,8 @@ void readOARN() {
 void readBAC() {
     char buffer[1024], cell[256], catName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between BAC catalog and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between BAC catalog and PPM...\n");
 
     CrossStats stats;
 
@@ -263,10 +263,10 @@ void readBAC() {
 	fclose(stream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Available BAC stars = %d\n", countBAC);
-    printf("Stars from BAC identified with PPM = %d\n", stats.countDist);
+    logPrintf("Available BAC stars = %d\n", countBAC);
+    logPrintf("Stars from BAC identified with PPM = %d\n", stats.countDist);
     printRSMEDist(&stats);
-    printf("Stars not identified with PPM nor GSC = %d\n", stats.errors);
+    logPrintf("Stars not identified with PPM nor GSC = %d\n", stats.errors);
 }
 
 /*
@@ -277,8 +277,8 @@ void readUSNO() {
     char buffer[1024], cell[256], srcName[20];
     char catLine[64];
 
-    printf("\n***************************************\n");
-    printf("Check references between USNO and BD/BAC/OA...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Check references between USNO and BD/BAC/OA...\n");
 
     int checkDM = 0;
     int checkBAC = 0;
@@ -384,25 +384,25 @@ void readUSNO() {
         }
     }
 	fclose(stream);
-    printf("USNO properly identified with BD = %d\n", checkDM);
-    printf("USNO properly identified with WB = %d\n", checkWB);
-    printf("USNO properly identified with BAC = %d\n", checkBAC);
-    printf("USNO properly identified with OA = %d\n", checkOA);
-    printf("Errors logged = %d\n", errors);
+    logPrintf("USNO properly identified with BD = %d\n", checkDM);
+    logPrintf("USNO properly identified with WB = %d\n", checkWB);
+    logPrintf("USNO properly identified with BAC = %d\n", checkBAC);
+    logPrintf("USNO properly identified with OA = %d\n", checkOA);
+    logPrintf("Errors logged = %d\n", errors);
 }
 
 /*
  * readGCScanned - revisa referencias cruzadas de las páginas escaneadas de GC
  * (ya se deben haber leidos los catálogos WB)
- * Lee todos los archivos scans/rnao14_page*.csv y, para cada estrella (una fila),
+ * Lee las filas de scans/rnao14_page*.csv (via loadGCScans) y, para cada estrella (una fila),
  * calcula la distancia entre la estrella GC (1a columna; la 2a columna -magnitud-
  * se ignora) y la estrella de referencia (3a columna)
  */
 void readGCScanned() {
-    char buffer[1024], ref[64], catgName[20];
+    char catgName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform cross-checking of scanned GC pages...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform cross-checking of scanned GC pages...\n");
 
     int errors = 0;
     int checkWB = 0;
@@ -411,47 +411,40 @@ void readGCScanned() {
     /* coordenadas (1875.0) de las estrellas GC ya leídas */
     struct GCstar_struct *GCstar = getGCStruct();
 
-    /* recorremos las páginas escaneadas */
-    for (int page = 1; page <= 616; page++) {
-        char filename[64];
-        snprintf(filename, 64, "scans/rnao14_page%d.csv", page);
-        FILE *stream = fopen(filename, "rt");
-        if (stream == NULL) continue;
+    /* recorremos las filas de las páginas escaneadas (ya parseadas) */
+    int scans = 0;
+    const struct GCScan_struct *scan = loadGCScans(&scans);
+    for (int k = 0; k < scans; k++) {
+        int gcRef = scan[k].gcRef;
 
-        while (fgets(buffer, 1023, stream) != NULL) {
-            int gcRef;
-            if (!parseGCScanLine(buffer, &gcRef, ref)) continue;
+        snprintf(catgName, 20, "GC %d", gcRef);
 
-            snprintf(catgName, 20, "GC %d", gcRef);
-
-            /* coordenadas (1875.0) de la estrella GC */
-            double x, y, z;
-            int gcIndex = -1;
-            if (!getGCStarData(gcRef, &gcIndex, &x, &y, &z)) continue;
-            countStars++;
+        /* coordenadas (1875.0) de la estrella GC */
+        double x, y, z;
+        int gcIndex = -1;
+        if (!getGCStarData(gcRef, &gcIndex, &x, &y, &z)) continue;
+        countStars++;
 
-            /* despachamos según el catálogo referido en la 3a columna */
-            if (!strncmp(ref, "WB.", 3)) {
-                countRefs++;
-                int numRefCat = atoi(&ref[3]);
+        /* despachamos según el catálogo referido en la 3a columna */
+        if (!strcmp(scan[k].tag, "WB.")) {
+            countRefs++;
+            int numRefCat = scan[k].numRef;
 
-        	    /* convierte coordenadas a la de WB y calcula rectangulares */
-                double newRA = GCstar[gcIndex].RA1875;
-                double newDecl = GCstar[gcIndex].Decl1875;
-                transform(EPOCH_GC, EPOCH_WB, &newRA, &newDecl);
-                sph2rec(newRA, newDecl, &x, &y, &z);
+    	    /* convierte coordenadas a la de WB y calcula rectangulares */
+            double newRA = GCstar[gcIndex].RA1875;
+            double newDecl = GCstar[gcIndex].Decl1875;
+            transform(EPOCH_GC, EPOCH_WB, &newRA, &newDecl);
+            sph2rec(newRA, newDecl, &x, &y, &z);
 
-                int RARef = (int) floor(newRA / 15.0);
-                checkCrossRefWB(catgName, NULL, true, x, y, z, RARef, numRefCat, &wbList, wbRARef, gcIndex, &checkWB, &errors);
-            }
+            int RARef = (int) floor(newRA / 15.0);
+            checkCrossRefWB(catgName, NULL, true, x, y, z, RARef, numRefCat, &wbList, wbRARef, gcIndex, &checkWB, &errors);
         }
-        fclose(stream);
     }
 
-    printf("Scanned GC rows with a reference = %d; references to checked catalogs (WB) = %d\n",
+    logPrintf("Scanned GC rows with a reference = %d; references to checked catalogs (WB) = %d\n",
         countStars, countRefs);
-    printf("GC properly identified with WB = %d\n", checkWB);
-    printf("Errors logged = %d\n", errors);
+    logPrintf("GC properly identified with WB = %d\n", checkWB);
+    logPrintf("Errors logged = %d\n", errors);
 }
 
 /*
@@ -461,8 +454,8 @@ void readGCScanned() {
 void readUA() {
     char buffer[1024];
 
-    printf("\n***************************************\n");
-    printf("Check references between UA and BD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Check references between UA and BD...\n");
 
     int checkDM = 0;
     int checkWB = 0;
@@ -515,9 +508,9 @@ void readUA() {
         }
     }
 	fclose(stream);
-    printf("UA stars properly identified with BD = %d\n", checkDM);
-    printf("UA stars properly identified with WB = %d\n", checkWB);
-    printf("Errors logged = %d\n", errors);
+    logPrintf("UA stars properly identified with BD = %d\n", checkDM);
+    logPrintf("UA stars properly identified with WB = %d\n", checkWB);
+    logPrintf("Errors logged = %d\n", errors);
 }
 
 /*
@@ -532,8 +525,8 @@ void readSOM() {
     /* usamos catalogo BD */
     struct DMstar_struct *BDstar = getDMStruct();
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between UA Standards of Magnitude and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between UA Standards of Magnitude and PPM...\n");
 
     CrossStats stats;
     int checkDM = 0;
@@ -568,8 +561,7 @@ void readSOM() {
 
         /* estrellas brillantes: no hace falta consultar GSC, con PPM alcanza */
         if (!ppmFound) {
-            printf("%d) Warning: %s is ALONE (nearest PPM star at %.1f arcsec).\n",
-                ++stats.errors,
+            logWarning(&stats.errors, "Warning: %s is ALONE (nearest PPM star at %.1f arcsec).\n",
                 catName,
                 minDistance);
         }
@@ -586,31 +578,28 @@ void readSOM() {
         int declRef = (int) fabs(newDecl);
         int index = getDMindex(signRef, declRef, numRefCat);
         if (index == -1) {
-            printf("%d) Warning: %s refers to BD %c%d°%d but it does not exist.\n",
-                ++stats.errors,
+            logWarning(&stats.errors, "Warning: %s refers to BD %c%d°%d but it does not exist.\n",
                 catName,
                 signRef ? '-' : '+',
                 declRef,
                 numRefCat);
-            printf("     Register %s: %s\n", catName, catLine);
+            logPrintf("     Register %s: %s\n", catName, catLine);
         } else {
             double dist = 3600.0 * calcAngularDistance(x, y, z, BDstar[index].x, BDstar[index].y, BDstar[index].z);
             if (dist > MAX_DIST_CROSS) {
-                printf("%d) Warning: %s is FAR from BD %c%d°%d star (dist = %.1f arcsec).\n",
-                    ++stats.errors,
+                logWarning(&stats.errors, "Warning: %s is FAR from BD %c%d°%d star (dist = %.1f arcsec).\n",
                     catName,
                     signRef ? '-' : '+',
                     declRef,
                     numRefCat,
                     dist);
-                printf("     Register %s: %s\n", catName, catLine);
+                logPrintf("     Register %s: %s\n", catName, catLine);
                 writeRegister(index, false);
             } else checkDM++;
 
             double bdMag = atof(field[9]);
             if (fabs(bdMag - BDstar[index].vmag) > 0.1) {
-                printf("%d) Warning: %s reports BD mag %.1f but BD %c%d°%d has mag %.1f.\n",
-                    ++stats.errors,
+                logWarning(&stats.errors, "Warning: %s reports BD mag %.1f but BD %c%d°%d has mag %.1f.\n",
                     catName,
                     bdMag,
                     signRef ? '-' : '+',
@@ -643,44 +632,45 @@ void readSOM() {
 	fclose(stream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Stars from SOM identified with PPM = %d\n", stats.countDist);
+    logPrintf("Stars from SOM identified with PPM = %d\n", stats.countDist);
     printRSMEDist(&stats);
-    printf("SOM stars properly identified with BD = %d\n", checkDM);
-    printf("SOM stars properly identified with WB = %d\n", checkWB);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("SOM stars properly identified with BD = %d\n", checkDM);
+    logPrintf("SOM stars properly identified with WB = %d\n", checkWB);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
  * main - comienzo de la aplicacion
  */
+/* Etapas en el orden de la ejecucion serial; cada una depende de las etapas que
+ * llenan las listas que consulta */
+static struct CrossStage stages[] = {
+    /* WB */
+    {"WB", readWB, NULL},
+    /* Standards of Magnitude de la UA */
+    {"SOM", readSOM, "WB"},
+    /* OA */
+    {"OA", readOARN, NULL},
+    /* BAC */
+    {"BAC", readBAC, NULL},
+    /* identificaciones de Yarnall */
+    {"USNO", readUSNO, "WB OA BAC"},
+    /* Uranometria Argentina */
+    {"UA", readUA, "WB"},
+    /* GC y sus paginas escaneadas */
+    {"GC", readGC, NULL},
+    {"GCScanned", readGCScanned, "WB GC"},
+};
+
 int main(int argc, char** argv)
 {
-    printf("CROSS_NORTH - Compare several catalogs.\n");
-    printf("Made in 2025 by Daniel Severin.\n");
+    logPrintf("CROSS_NORTH - Compare several catalogs.\n");
+    logPrintf("Made in 2025 by Daniel Severin.\n");
 
-    /* leemos catalogo CD */
+    /* leemos catalogo BD */
     readDM(CURATED ? "cat/bd_curated.txt" : "cat/bd.txt");
 
-    /* leemos y cruzamos WB */
-    readWB();
-
-    /* leemos, cruzamos y revisamos Standards of Magnitude de la UA */
-    readSOM();
-
-    /* leemos y cruzamos OA */
-    readOARN();
-
-    /* leemos y cruzamos BAC */
-    readBAC();
-
-    /* leemos y revisamos identificaciones de Yarnall */
-    readUSNO();
-
-    /* leemos, cruzamos y revisamos Uranometria Argentina */
-    readUA();
-
-    /* leemos, cruzamos y revisamos GC */
-    readGC();
-    readGCScanned();
+    /* leemos, cruzamos y revisamos el resto de los catalogos (BD ya no se modifica) */
+    runCrossStages(stages, sizeof(stages) / sizeof(stages[0]));
     return 0;
 }
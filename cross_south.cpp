@@ -5,6 +5,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include "read_ppm.h"
@@ -14,6 +15,7 @@
 #include "trig.h"
 #include "misc.h"
 #include "find_gsc.h"
+#include "parallel.h"
 #include "cross_utils.h"
 
 #define MAXOASTAR 19000
@@ -141,7 +143,7 @@ void saveZC(int RAh, int RAs, int Decls,
         if (zcNum[i] != numRef || zcHour[i] != RAh) continue;
         double dist = 3600.0 * calcAngularDistance(x, y, z, zcX[i], zcY[i], zcZ[i]);
         if (dist > MAX_DIST_ZC_ZC) {
-            printf("**) Warning: ZC %dh %d is FAR from previous registration (dist = %.1f arcsec).\n",
+            logPrintf("**) Warning: ZC %dh %d is FAR from previous registration (dist = %.1f arcsec).\n",
                 RAh,
                 numRef,
                 dist);
@@ -164,13 +166,13 @@ void saveZC(int RAh, int RAs, int Decls,
     if (cdFound) {
         countCDZC++;
         struct DMstar_struct *CDstar = getDMStruct();
-        snprintf(catName, 20, "CD %d°%d", CDstar[cdIndex].declRef, CDstar[cdIndex].numRef);
+        formatDesignation(catName, zoneDesignation(DESIG_CD, CDstar[cdIndex].declRef, CDstar[cdIndex].numRef));
         writeCrossEntry(crossCDZCStream, zcName, catName, 0.0, minCDDistance);
     }
     if (cpdFound) {
         countCPDZC++;
         struct CPDstar_struct *CPDstar = getCPDStruct();
-        snprintf(catName, 20, "CPD %d°%d", CPDstar[cpdIndex].declRef, CPDstar[cpdIndex].numRef);
+        formatDesignation(catName, zoneDesignation(DESIG_CPD, CPDstar[cpdIndex].declRef, CPDstar[cpdIndex].numRef));
         writeCrossEntry(crossCPDZCStream, zcName, catName, 0.0, minCPDDistance);
     }
 
@@ -178,7 +180,7 @@ void saveZC(int RAh, int RAs, int Decls,
         if (gscFound) {
             writeUnidentified(unidentifiedZCStream, zcName, x, y, z);
         } else {
-            printf("**) %s is also ALONE.\n", zcName);
+            logPrintf("**) %s is also ALONE.\n", zcName);
             logCauses(zcName, true,
                 false, false, RAs, -50.0, Decls, -1, 0.0);
         }
@@ -196,8 +198,8 @@ void saveZC(int RAh, int RAs, int Decls,
 void readGC2() {
     char buffer[1024], cell[256], catName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between GC2 and PPM/CD/CPD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between GC2 and PPM/CD/CPD...\n");
 
 	FILE *crossCDStream = openCrossFile("results/cross/cross_gc2_cd.csv");
 	FILE *crossCPDStream = openCrossFile("results/cross/cross_gc2_cpd.csv");
@@ -230,7 +232,7 @@ void readGC2() {
         /* descarta declinacion positiva */
 		readField(buffer, cell, 44, 1);
         if (cell[0] != '-') {
-            printf("Note: %s discarded due to positive declination.\n", catName);
+            logPrintf("Note: %s discarded due to positive declination.\n", catName);
             continue;
         }
 
@@ -277,7 +279,7 @@ void readGC2() {
         if (!ppmFound && !cdFound && !cpdFound && !gscFound) {
             warnAlone(&stats.errors, catName, NULL, NULL,
                 catName, RAs, Decl1875, Decls,
-                PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
         }
         countGC++;
     }
@@ -286,11 +288,11 @@ void readGC2() {
 	fclose(crossCPDStream);
 	fclose(crossCDStream);
 
-    printf("Available G2 stars = %d\n", countGC);
-    printf("Stars from G2 identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
+    logPrintf("Available G2 stars = %d\n", countGC);
+    logPrintf("Stars from G2 identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
     printRSMEDist(&stats);
     printRSMEMag(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -301,8 +303,8 @@ void readWeiss() {
     char buffer[1024], cell[256], catName[20], warnName[20], aloneName[32];
     char catLine[64];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Weiss and PPM/CD/CPD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Weiss and PPM/CD/CPD...\n");
 
 	FILE *crossCDStream = openCrossFile("results/cross/cross_oa_cd.csv");
 	FILE *crossCPDStream = openCrossFile("results/cross/cross_oa_cpd.csv");
@@ -355,7 +357,7 @@ void readWeiss() {
 		if (cell[0] != ' ') {
 		    int magFrac = atoi(cell);
 		    if (magFrac != magInt + 1) {
-		        printf("Error: Weiss %d has unexpected value %d in magnitude columns 10-11 (expected %d or blank).\n",
+		        logPrintf("Error: Weiss %d has unexpected value %d in magnitude columns 10-11 (expected %d or blank).\n",
 		            weissRef, magFrac, magInt + 1);
 		        exit(1);
 		    }
@@ -395,7 +397,7 @@ void readWeiss() {
                 snprintf(aloneName, 32, "W %d (OA %d)", weissRef, oeltzenRef);
                 warnAlone(&stats.errors, aloneName, warnName, catLine,
                     catName, RAs, Decl1875, Decls,
-                    PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                    ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
             }
         }
 
@@ -405,34 +407,152 @@ void readWeiss() {
     }
     fclose(stream);
     fclose(unidentifiedStream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 	fclose(crossCPDStream);
 	fclose(crossCDStream);
 
-    printf("Available OA stars = %d\n", countOA);
-    printf("Stars from OA identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
+    logPrintf("Available OA stars = %d\n", countOA);
+    logPrintf("Stars from OA identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
     printRSMEDist(&stats);
     printRSMEMag(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
+}
+
+/* filas de Lalande por parte (las partes se cruzan en paralelo) */
+#define LALANDE_CHUNK 512
+
+/* fila de Lalande ya cruzada, a almacenar en orden */
+struct LalandeRow_struct {
+    bool valid; /* false si no hay RA o declinación */
+    int catRef;
+    float vmag;
+    double x, y, z; /* coordenadas rectangulares 1875.0 */
+    struct CrossStats stats; /* aporte de la fila a las estadisticas */
+};
+
+/* parte de Lalande: su log y sus cruzamientos, que se vuelcan en orden */
+struct LalandeChunk_struct {
+    struct LogSink_struct sink;
+    char *cross[3];
+    size_t crossSize[3];
+};
+
+struct LalandeJob_struct {
+    char **line;
+    int lines;
+    struct LalandeRow_struct *row;
+    struct LalandeChunk_struct *chunk;
+    struct PPMstore_struct *ppm;
+};
+
+/*
+ * crossLalandeRow - cruza una fila de Lalande con PPM (o GSC) y advierte si esta sola
+ */
+static void crossLalandeRow(char *buffer, struct LalandeRow_struct *row,
+        FILE *crossPPMStream, FILE *crossSAOStream, FILE *crossHDStream) {
+    char cell[256], catName[20];
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+
+    /* descarta la estrella si no hay RA o declinación */
+    row->valid = false;
+    readField(buffer, cell, 19, 1);
+    if (cell[0] == ' ') return;
+    readField(buffer, cell, 32, 1);
+    if (cell[0] == ' ') return;
+    row->valid = true;
+
+    /* lee numeración */
+    readField(buffer, cell, 1, 5);
+    int catRef = atoi(cell);
+    snprintf(catName, 20, "Lal %d", catRef);
+
+    /* lee magnitud */
+    float vmag = readMagIntHalf(buffer, 15, 2, 17);
+
+    /* lee ascension recta B1800.0 (si existiese) */
+    int RAh, RAm, RAs;
+    double RA = readRAField(buffer, 19, &RAh, &RAm, &RAs);
+
+    /* lee declinacion B1800.0 (en realidad NPD) */
+    int Decld, Declm, Decls;
+    double Decl = 90.0 - readDeclField(buffer, 32, 3, 35, 37, 3, 10.0, &Decld, &Declm, &Decls);
+
+    /* busca la PPM mas cercana y genera el cruzamiento */
+    double x, y, z, minDistance;
+    int ppmIndex;
+    sph2rec(RA, Decl, &x, &y, &z);
+    bool ppmFound = crossWithPPM(x, y, z, Decl, vmag, MAX_DIST_LAL_PPM, NULL,
+        catRef > 0 ? catName : NULL,
+        crossPPMStream, crossSAOStream, crossHDStream, &ppmIndex, &minDistance, &row->stats);
+    double nearestPPMDistance = minDistance;
+
+    /* si no encuentra una PPM cercana, prueba con GSC */
+    bool gscFound = tryGSC(ppmFound, RA, Decl, EPOCH_LAL,
+        catRef > 0 ? crossPPMStream : NULL, catName, vmag, &row->stats);
+
+    /* convierte coordenadas a 1875.0 y calcula rectangulares */
+    double RA1875 = RA;
+    double Decl1875 = Decl;
+    transform(EPOCH_LAL, 1875.0, &RA1875, &Decl1875);
+    sph2rec(RA1875, Decl1875, &x, &y, &z);
+
+    if (!ppmFound && !gscFound && nearestPPMDistance > MAX_DIST_PPM_FAR) {
+        warnAlonePPMGSC(&row->stats.errors, catName, catName,
+            RAs, Decl1875, Decls, ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
+    }
+
+    row->catRef = catRef;
+    row->vmag = vmag;
+    row->x = x;
+    row->y = y;
+    row->z = z;
+}
+
+/*
+ * crossLalandeChunk - cruza una parte de las filas, acumulando su log y sus cruzamientos
+ */
+static void crossLalandeChunk(int index, void *context) {
+    struct LalandeJob_struct *job = (struct LalandeJob_struct *) context;
+    struct LalandeChunk_struct *chunk = &job->chunk[index];
+    usePPMStore(job->ppm);
+
+    FILE *cross[3];
+    for (int k = 0; k < 3; k++) {
+        cross[k] = open_memstream(&chunk->cross[k], &chunk->crossSize[k]);
+        if (cross[k] == NULL) {
+            perror("Cannot buffer Lalande cross-identifications");
+            exit(1);
+        }
+    }
+    beginLogSink(&chunk->sink);
+    int last = (index + 1) * LALANDE_CHUNK;
+    if (last > job->lines) last = job->lines;
+    for (int i = index * LALANDE_CHUNK; i < last; i++) {
+        crossLalandeRow(job->line[i], &job->row[i], cross[0], cross[1], cross[2]);
+    }
+    endLogSink(&chunk->sink);
+    for (int k = 0; k < 3; k++) fclose(cross[k]);
 }
 
 /*
  * readLalande - lee catalogo de Lalande
+ * Las filas se cruzan por partes en paralelo; el log, los cruzamientos y las
+ * estrellas almacenadas se vuelcan luego en el orden del catálogo.
  */
 void readLalande() {
-    char buffer[1024], cell[256], catName[20];
+    char buffer[1024];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Lalande and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Lalande and PPM...\n");
 
-    FILE *crossPPMStream, *crossSAOStream, *crossHDStream;
-    openCrossSet("lalande", &crossPPMStream, &crossSAOStream, &crossHDStream);
+    FILE *crossStream[3];
+    openCrossSet("lalande", &crossStream[0], &crossStream[1], &crossStream[2]);
 
     CrossStats stats;
 
     /* leemos catalogo PPM (pero no es necesario cruzarlo con DM) */
-    struct PPMstar_struct *PPMstar = preparePPM(EPOCH_LAL, false);
+    preparePPM(EPOCH_LAL, false);
 
     /* leemos catalogo Lalande */
     FILE *stream = fopen("cat/lalande.txt", "rt");
@@ -440,66 +560,58 @@ void readLalande() {
         perror("Cannot read lalande.txt");
 		exit(1);
     }
-
+    struct LalandeJob_struct job;
+    int capacity = 0;
+    job.line = NULL;
+    job.lines = 0;
     while (fgets(buffer, 1023, stream) != NULL) {
-        /* descarta la estrella si no hay RA o declinación */
-        readField(buffer, cell, 19, 1);
-        if (cell[0] == ' ') continue;
-        readField(buffer, cell, 32, 1);
-        if (cell[0] == ' ') continue;
-
-		/* lee numeración */
-		readField(buffer, cell, 1, 5);
-		int catRef = atoi(cell);
-        if (catRef > 0) snprintf(catName, 20, "Lal %d", catRef);
-
-		/* lee magnitud */
-		float vmag = readMagIntHalf(buffer, 15, 2, 17);
-
-		/* lee ascension recta B1800.0 (si existiese) */
-        int RAh, RAm, RAs;
-        double RA = readRAField(buffer, 19, &RAh, &RAm, &RAs);
-
-		/* lee declinacion B1800.0 (en realidad NPD) */
-        int Decld, Declm, Decls;
-        double Decl = 90.0 - readDeclField(buffer, 32, 3, 35, 37, 3, 10.0, &Decld, &Declm, &Decls);
-
-		/* busca la PPM mas cercana y genera el cruzamiento */
-		double x, y, z, minDistance;
-		int ppmIndex;
-		sph2rec(RA, Decl, &x, &y, &z);
-        bool ppmFound = crossWithPPM(x, y, z, Decl, vmag, MAX_DIST_LAL_PPM, NULL,
-            catRef > 0 ? catName : NULL,
-            crossPPMStream, crossSAOStream, crossHDStream, &ppmIndex, &minDistance, &stats);
-        double nearestPPMDistance = minDistance;
-
-        /* si no encuentra una PPM cercana, prueba con GSC */
-        bool gscFound = tryGSC(ppmFound, RA, Decl, EPOCH_LAL,
-            catRef > 0 ? crossPPMStream : NULL, catName, vmag, &stats);
-
-	    /* convierte coordenadas a 1875.0 y calcula rectangulares */
-        double RA1875 = RA;
-        double Decl1875 = Decl;
-        transform(EPOCH_LAL, 1875.0, &RA1875, &Decl1875);
-        sph2rec(RA1875, Decl1875, &x, &y, &z);
-
-        if (!ppmFound && !gscFound && nearestPPMDistance > MAX_DIST_PPM_FAR) {
-            char aloneName[20];
-            snprintf(aloneName, 20, "Lal %d", catRef);
-            warnAlonePPMGSC(&stats.errors, aloneName, aloneName,
-                RAs, Decl1875, Decls, PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+        if (job.lines == capacity) {
+            capacity = capacity == 0 ? 4096 : 2 * capacity;
+            job.line = (char **) realloc(job.line, capacity * sizeof(char *));
+            if (job.line == NULL) bye("Out of memory!\n");
         }
-
-        /* la almacenamos para futuras identificaciones */
-        storeStar(&countLal, MAXLALSTAR, "Lalande", lalRef, lalX, lalY, lalZ, lalMag, catRef, x, y, z, vmag);
+        job.line[job.lines] = strdup(buffer);
+        if (job.line[job.lines] == NULL) bye("Out of memory!\n");
+        job.lines++;
     }
     fclose(stream);
-    closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Available Lalande stars = %d\n", countLal);
-    printf("Stars from Lalande identified with PPM = %d, GSC-PPM = %d\n", stats.countDist, stats.countGSC);
+    /* cruzamos por partes */
+    int chunks = (job.lines + LALANDE_CHUNK - 1) / LALANDE_CHUNK;
+    job.row = (struct LalandeRow_struct *) calloc(job.lines > 0 ? job.lines : 1, sizeof(struct LalandeRow_struct));
+    job.chunk = (struct LalandeChunk_struct *) calloc(chunks > 0 ? chunks : 1, sizeof(struct LalandeChunk_struct));
+    if (job.row == NULL || job.chunk == NULL) bye("Out of memory!\n");
+    job.ppm = getPPMStore();
+    parallelFor(chunks, crossLalandeChunk, &job);
+
+    /* volcamos en orden y almacenamos las estrellas para futuras identificaciones */
+    for (int c = 0; c < chunks; c++) {
+        struct LalandeChunk_struct *chunk = &job.chunk[c];
+        flushLogSink(&chunk->sink, &stats.errors);
+        for (int k = 0; k < 3; k++) {
+            fwrite(chunk->cross[k], 1, chunk->crossSize[k], crossStream[k]);
+            free(chunk->cross[k]);
+        }
+        int last = (c + 1) * LALANDE_CHUNK;
+        if (last > job.lines) last = job.lines;
+        for (int i = c * LALANDE_CHUNK; i < last; i++) {
+            struct LalandeRow_struct *row = &job.row[i];
+            free(job.line[i]);
+            if (!row->valid) continue;
+            addCrossStats(&stats, &row->stats);
+            storeStar(&countLal, MAXLALSTAR, "Lalande", lalRef, lalX, lalY, lalZ, lalMag,
+                row->catRef, row->x, row->y, row->z, row->vmag);
+        }
+    }
+    free(job.line);
+    free(job.row);
+    free(job.chunk);
+    closeCrossSet(crossStream[0], crossStream[1], crossStream[2]);
+
+    logPrintf("Available Lalande stars = %d\n", countLal);
+    logPrintf("Stars from Lalande identified with PPM = %d, GSC-PPM = %d\n", stats.countDist, stats.countGSC);
     printRSMEDist(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -513,8 +625,8 @@ void readSOM() {
     char buffer[1024], catName[20];
     char catLine[64];
 
-    printf("\n***************************************\n");
-    printf("Check references between UA Standards of Magnitude and Lalande...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Check references between UA Standards of Magnitude and Lalande...\n");
 
     int checkLal = 0;
     int errors = 0;
@@ -543,20 +655,18 @@ void readSOM() {
             if (lalRef[i] != numRefCat) continue;
             double dist = 3600.0 * calcAngularDistance(x, y, z, lalX[i], lalY[i], lalZ[i]);
             if (dist > MAX_DIST_CROSS) {
-                printf("%d) Warning: %s is FAR from Lal %d (dist = %.1f arcsec).\n",
-                    ++errors,
+                logWarning(&errors, "Warning: %s is FAR from Lal %d (dist = %.1f arcsec).\n",
                     catName,
                     numRefCat,
                     dist);
-                printf("     Register %s: %s\n", catName, catLine);
+                logPrintf("     Register %s: %s\n", catName, catLine);
             } else checkLal++;
 
             /* revisa la magnitud, si ambas estan disponibles */
             if (field[11][0] != 0 && lalMag[i] > 0.0) {
                 double somMag = atof(field[11]);
                 if (fabs(somMag - lalMag[i]) > 0.5) {
-                    printf("%d) Warning: %s reports Lal mag %.1f but Lal %d has mag %.1f.\n",
-                        ++errors,
+                    logWarning(&errors, "Warning: %s reports Lal mag %.1f but Lal %d has mag %.1f.\n",
                         catName,
                         somMag,
                         numRefCat,
@@ -567,8 +677,8 @@ void readSOM() {
     }
 	fclose(stream);
 
-    printf("SOM stars properly identified with Lalande = %d\n", checkLal);
-    printf("Errors logged = %d\n", errors);
+    logPrintf("SOM stars properly identified with Lalande = %d\n", checkLal);
+    logPrintf("Errors logged = %d\n", errors);
 }
 
 /*
@@ -581,8 +691,8 @@ void readStone() {
     /* usamos catalogo CD */
     struct DMstar_struct *CDstar = getDMStruct();
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Stone and PPM/CD/CPD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Stone and PPM/CD/CPD...\n");
 
 	FILE *crossCDStream = openCrossFile("results/cross/cross_lacaille_cd.csv");
 	FILE *crossCPDStream = openCrossFile("results/cross/cross_lacaille_cpd.csv");
@@ -676,7 +786,7 @@ void readStone() {
             double cdDist;
             cdFound = crossWithCD(x, y, z, Decl1875, vmag, warnName, NULL, NULL, &stats, &cdIndex, &cdDist);
             if (cdFound && lacailleRef > 0) {
-	    	    snprintf(cdName, 20, "CD %d°%d", CDstar[cdIndex].declRef, CDstar[cdIndex].numRef);
+	    	    formatDesignation(cdName, zoneDesignation(DESIG_CD, CDstar[cdIndex].declRef, CDstar[cdIndex].numRef));
 		        writeCrossEntry(crossCDStream, lacName, cdName, 0.0, cdDist);
             }
 		}
@@ -687,7 +797,7 @@ void readStone() {
             else snprintf(aloneName, 32, "St %d", stoneRef);
             warnAlone(&stats.errors, aloneName, NULL, NULL,
                 catName, RAs, Decl1875, Decls,
-                PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
         }
 
         /* revisa identificacion cruzada con Brisbane */
@@ -715,18 +825,18 @@ void readStone() {
     }
     fclose(stream2);
     fclose(stream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossStonePPMStream, crossStoneSAOStream, crossStoneHDStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 	fclose(crossCPDStream);
 	fclose(crossCDStream);
 
-    printf("Available Stone stars = %d, and Lacaille = %d\n", countSt, countLac);
-    printf("Stone stars properly identified with Brisbane = %d\n", checkBri);
-    printf("Stars from Stone identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
+    logPrintf("Available Stone stars = %d, and Lacaille = %d\n", countSt, countLac);
+    logPrintf("Stone stars properly identified with Brisbane = %d\n", checkBri);
+    logPrintf("Stars from Stone identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
     printRSMEDist(&stats);
     printRSMEMag(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -735,8 +845,8 @@ void readStone() {
 void readBrisbane() {
     char buffer[1024], cell[256], catName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Brisbane and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Brisbane and PPM...\n");
 
     FILE *crossPPMStream, *crossSAOStream, *crossHDStream;
     openCrossSet("bri", &crossPPMStream, &crossSAOStream, &crossHDStream);
@@ -781,7 +891,7 @@ void readBrisbane() {
                 if (magFrac == magInt + 1) {
                     vmag += 0.5;
                 } else {
-                    printf("Warning: B %d has unexpected value %d in magnitude columns 23-24 (expected %d or blank).\n",
+                    logPrintf("Warning: B %d has unexpected value %d in magnitude columns 23-24 (expected %d or blank).\n",
                         brisRef, magFrac, magInt + 1);
                 }
             }
@@ -814,7 +924,7 @@ void readBrisbane() {
 
         if (!ppmFound && !gscFound && nearestPPMDistance > MAX_DIST_PPM_FAR) {
             warnAlonePPMGSC(&stats.errors, catName, catName,
-                RAs, Decl1875, Decls, PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                RAs, Decl1875, Decls, ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
         }
 
         /* la almacenamos para futuras identificaciones */
@@ -822,13 +932,13 @@ void readBrisbane() {
         writeCatalogFile(catalogStream, catName, x, y, z, vmag);
     }
     fclose(stream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Available Brisbane stars = %d\n", countBri);
-    printf("Stars from Brisbane identified with PPM = %d, GSC-PPM = %d\n", stats.countDist, stats.countGSC);
+    logPrintf("Available Brisbane stars = %d\n", countBri);
+    logPrintf("Stars from Brisbane identified with PPM = %d, GSC-PPM = %d\n", stats.countDist, stats.countGSC);
     printRSMEDist(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -838,8 +948,8 @@ void readBrisbane() {
 void readTaylor() {
     char buffer[1024], cell[256], catName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Taylor and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Taylor and PPM...\n");
 
     FILE *crossPPMStream, *crossSAOStream, *crossHDStream;
     openCrossSet("taylor", &crossPPMStream, &crossSAOStream, &crossHDStream);
@@ -906,7 +1016,7 @@ void readTaylor() {
 
         if (!ppmFound && !gscFound && nearestPPMDistance > MAX_DIST_PPM_FAR) {
             warnAlonePPMGSC(&stats.errors, catName, catName,
-                RAs, Decl1875, Decls, PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                RAs, Decl1875, Decls, ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
         }
 
         /* lee referencia numerica y referencia a catalogo (que queda en "cell") */
@@ -926,8 +1036,7 @@ void readTaylor() {
             int i = stTayRef[taylorRef];
             double dist = 3600.0 * calcAngularDistance(x, y, z, stX[i], stY[i], stZ[i]);
             if (dist > MAX_DIST_CROSS) {
-                printf("%d) Warning: T %d is FAR from St %d (dist = %.1f arcsec).\n",
-                    ++stats.errors,
+                logWarning(&stats.errors, "Warning: T %d is FAR from St %d (dist = %.1f arcsec).\n",
                     taylorRef,
                     stRef[i],
                     dist);
@@ -940,17 +1049,17 @@ void readTaylor() {
     }
     fclose(stream2);
     fclose(stream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Available Taylor stars = %d\n", countTaylor);
-    printf("Taylor stars properly identified with Lacaille = %d\n", checkLac);
-    printf("Taylor stars properly identified with Brisbane = %d\n", checkBri);
-    printf("Taylor stars properly identified with GC = %d\n", checkGC);
-    printf("Taylor stars properly identified with Stone = %d\n", checkSt);
-    printf("Stars from Taylor identified with PPM = %d, GSC-PPM = %d\n", stats.countDist, stats.countGSC);
+    logPrintf("Available Taylor stars = %d\n", countTaylor);
+    logPrintf("Taylor stars properly identified with Lacaille = %d\n", checkLac);
+    logPrintf("Taylor stars properly identified with Brisbane = %d\n", checkBri);
+    logPrintf("Taylor stars properly identified with GC = %d\n", checkGC);
+    logPrintf("Taylor stars properly identified with Stone = %d\n", checkSt);
+    logPrintf("Stars from Taylor identified with PPM = %d, GSC-PPM = %d\n", stats.countDist, stats.countGSC);
     printRSMEDist(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -962,8 +1071,8 @@ void readUSNO() {
     char buffer[1024], cell[256], catName[20];
     char catLine[64];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between USNO and PPM/CD/CPD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between USNO and PPM/CD/CPD...\n");
 
 	FILE *crossCDStream = openCrossFile("results/cross/cross_usno_cd.csv");
 	FILE *crossCPDStream = openCrossFile("results/cross/cross_usno_cpd.csv");
@@ -1072,7 +1181,7 @@ void readUSNO() {
             } else {
                 warnAlone(&stats.errors, catName, catName, catLine,
                     catName, RAs, Decl1875, Decls,
-                    PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                    ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
             }
         }
 
@@ -1082,25 +1191,25 @@ void readUSNO() {
     }
     fclose(stream);
     fclose(unidentifiedStream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 	fclose(crossCPDStream);
 	fclose(crossCDStream);
 
-    printf("Available USNO stars = %d\n", countUsno);
-    printf("Stars from USNO with Lacaille = %d, Brisbane = %d, Lalande = %d, Taylor = %d and OA = %d\n",
+    logPrintf("Available USNO stars = %d\n", countUsno);
+    logPrintf("Stars from USNO with Lacaille = %d, Brisbane = %d, Lalande = %d, Taylor = %d and OA = %d\n",
         checkLac, checkBri, checkLal, checkTaylor, checkOA);
-    printf("Stars from USNO identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
+    logPrintf("Stars from USNO identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
     printRSMEDist(&stats);
     printRSMEMag(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
  * readGCScanned - revisa referencias cruzadas de las páginas escaneadas de GC
  * (ya se deben haber leidos los catalogs OA, Lalande, Brisbane, Stone, Lacaille,
  *  GC, Taylor y Yarnall)
- * Lee todos los archivos scans/rnao14_page*.csv y, para cada estrella (una fila),
+ * Lee las filas de scans/rnao14_page*.csv (via loadGCScans) y, para cada estrella (una fila),
  * calcula la distancia entre la estrella GC (1a columna; la 2a columna -magnitud-
  * se ignora) y la estrella de referencia (3a columna) en los catalogs
  * Oeltzen-Argelander (OA.), Lalande (Ll.), Brisbane (B.), Stone (St.),
@@ -1109,10 +1218,10 @@ void readUSNO() {
  * Otras designaciones se ignoran.
  */
 void readGCScanned() {
-    char buffer[1024], ref[64], catgName[20];
+    char catgName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform cross-checking of scanned GC pages...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform cross-checking of scanned GC pages...\n");
 
     int errors = 0;
     int checkLac = 0, checkLal = 0, checkOA = 0, checkTaylor = 0;
@@ -1127,121 +1236,116 @@ void readGCScanned() {
      * poder identificar las estrellas ZC referidas en las páginas escaneadas */
     preparePPM(1875.0, false);
 
-    /* recorremos las páginas escaneadas */
-    for (int page = 1; page <= 616; page++) {
-        char filename[64];
-        snprintf(filename, 64, "scans/rnao14_page%d.csv", page);
-        FILE *stream = fopen(filename, "rt");
-        if (stream == NULL) continue;
-
-        while (fgets(buffer, 1023, stream) != NULL) {
-            int gcRef;
-            if (!parseGCScanLine(buffer, &gcRef, ref)) continue;
-
-            snprintf(catgName, 20, "GC %d", gcRef);
-
-            /* coordenadas (1875.0) de la estrella GC */
-            double x, y, z;
-            int gcIndex = -1;
-            if (!getGCStarData(gcRef, &gcIndex, &x, &y, &z)) continue;
-            countStars++;
-
-            /* despachamos según el catálogo referido en la 3a columna */
-            if (!strncmp(ref, "Ll.", 3)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "Lal", x, y, z, atoi(&ref[3]), &lalList, false, gcIndex, &checkLal, &errors);
-            } else if (!strncmp(ref, "OA.", 3)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "OA", x, y, z, atoi(&ref[3]), &oaList, false, gcIndex, &checkOA, &errors);
-            } else if (!strncmp(ref, "St.", 3)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "St", x, y, z, atoi(&ref[3]), &stList, false, gcIndex, &checkSt, &errors);
-            } else if (!strncmp(ref, "L.", 2)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "L", x, y, z, atoi(&ref[2]), &lacList, false, gcIndex, &checkLac, &errors);
-            } else if (!strncmp(ref, "B.", 2)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "B", x, y, z, atoi(&ref[2]), &briList, true, gcIndex, &checkBri, &errors);
-            } else if (!strncmp(ref, "T.", 2)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "T", x, y, z, atoi(&ref[2]), &tayList, false, gcIndex, &checkTaylor, &errors);
-            } else if (!strncmp(ref, "Y.", 2)) {
-                countRefs++;
-                checkYarnallRef(catgName, NULL, atoi(&ref[2]), x, y, z, true, gcIndex, &usnoList, &checkUSNO, &errors);
-            } else if (!strncmp(ref, "CL.", 3)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "CL", x, y, z, atoi(&ref[3]), &clList, false, gcIndex, &checkCL, &errors);
-            } else if (!strncmp(ref, "G.", 2)) {
-                countRefs++;
-                checkCrossRef(catgName, NULL, "G", x, y, z, atoi(&ref[2]), &gi1963List, false, gcIndex, &checkGi1963, &errors);
-            } else if (!strncmp(ref, "ZC.", 3)) {
-                /* guardamos la estrella en el Zone Catalog de Gould. */
-                int numRefCat = atoi(&ref[3]);
-                int RAh = GCstar[gcIndex].RAh;
-                int RAs = GCstar[gcIndex].RAs;
-                int Decls = GCstar[gcIndex].Decls;
-                double Decl1875 = GCstar[gcIndex].Decl1875;
-
-                /* busca la PPM mas cercana (a 1875.0) */
-                bool ppmFound = false;
-                int ppmIndex = -1;
-                double minDistance = HUGE_NUMBER;
-                findPPMByCoordinates(x, y, z, Decl1875, &ppmIndex, &minDistance);
-                double nearestPPMDistance = minDistance;
-                if (minDistance < MAX_DIST_PPM) ppmFound = true;
-
-                /* si no hay PPM cercana, prueba con GSC */
-                bool gscFound = false;
-                const char *gscId = NULL;
-                double nearestGSCDistance = HUGE_NUMBER;
-                if (!ppmFound) {
-                    gscFound = findGSCStar(GCstar[gcIndex].RA1875, Decl1875, 1875.0, MAX_DIST_GSC);
-                    if (gscFound) {
-                        gscId = getGSCId();
-                        nearestGSCDistance = getDist();
-                    }
-                }
+    /* recorremos las filas de las páginas escaneadas (ya parseadas) */
+    int scans = 0;
+    const struct GCScan_struct *scan = loadGCScans(&scans);
+    for (int k = 0; k < scans; k++) {
+        int gcRef = scan[k].gcRef;
+        const char *tag = scan[k].tag;
+        int numRef = scan[k].numRef;
 
-                /* busca la CPD mas cercana (solo dentro de la faja CPD, Decl <= -18) */
-                bool cpdFound = false;
-                int cpdIndex = -1;
-                double nearestCPDDistance = HUGE_NUMBER;
-                if (GCstar[gcIndex].Decld >= 18) {
-                    minDistance = HUGE_NUMBER;
-                    findCPDByCoordinates(x, y, z, Decl1875, &cpdIndex, &minDistance);
-                    nearestCPDDistance = minDistance;
-                    if (minDistance < MAX_DIST_CPD) cpdFound = true;
-                }
+        snprintf(catgName, 20, "GC %d", gcRef);
 
-                /* busca la CD mas cercana (solo dentro de la faja CD, Decl <= -22) */
-                bool cdFound = false;
-                int cdIndex = -1;
-                double nearestCDDistance = HUGE_NUMBER;
-                if (GCstar[gcIndex].Decld >= 22) {
-                    minDistance = HUGE_NUMBER;
-                    findDMByCoordinates(x, y, z, Decl1875, &cdIndex, &minDistance);
-                    nearestCDDistance = minDistance;
-                    if (minDistance < MAX_DIST_CD) cdFound = true;
+        /* coordenadas (1875.0) de la estrella GC */
+        double x, y, z;
+        int gcIndex = -1;
+        if (!getGCStarData(gcRef, &gcIndex, &x, &y, &z)) continue;
+        countStars++;
+
+        /* despachamos según el catálogo referido en la 3a columna */
+        if (!strcmp(tag, "Ll.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "Lal", x, y, z, numRef, &lalList, false, gcIndex, &checkLal, &errors);
+        } else if (!strcmp(tag, "OA.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "OA", x, y, z, numRef, &oaList, false, gcIndex, &checkOA, &errors);
+        } else if (!strcmp(tag, "St.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "St", x, y, z, numRef, &stList, false, gcIndex, &checkSt, &errors);
+        } else if (!strcmp(tag, "L.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "L", x, y, z, numRef, &lacList, false, gcIndex, &checkLac, &errors);
+        } else if (!strcmp(tag, "B.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "B", x, y, z, numRef, &briList, true, gcIndex, &checkBri, &errors);
+        } else if (!strcmp(tag, "T.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "T", x, y, z, numRef, &tayList, false, gcIndex, &checkTaylor, &errors);
+        } else if (!strcmp(tag, "Y.")) {
+            countRefs++;
+            checkYarnallRef(catgName, NULL, numRef, x, y, z, true, gcIndex, &usnoList, &checkUSNO, &errors);
+        } else if (!strcmp(tag, "CL.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "CL", x, y, z, numRef, &clList, false, gcIndex, &checkCL, &errors);
+        } else if (!strcmp(tag, "G.")) {
+            countRefs++;
+            checkCrossRef(catgName, NULL, "G", x, y, z, numRef, &gi1963List, false, gcIndex, &checkGi1963, &errors);
+        } else if (!strcmp(tag, "ZC.")) {
+            /* guardamos la estrella en el Zone Catalog de Gould. */
+            int numRefCat = numRef;
+            int RAh = GCstar[gcIndex].RAh;
+            int RAs = GCstar[gcIndex].RAs;
+            int Decls = GCstar[gcIndex].Decls;
+            double Decl1875 = GCstar[gcIndex].Decl1875;
+
+            /* busca la PPM mas cercana (a 1875.0) */
+            bool ppmFound = false;
+            int ppmIndex = -1;
+            double minDistance = HUGE_NUMBER;
+            findPPMByCoordinates(x, y, z, Decl1875, &ppmIndex, &minDistance);
+            double nearestPPMDistance = minDistance;
+            if (minDistance < MAX_DIST_PPM) ppmFound = true;
+
+            /* si no hay PPM cercana, prueba con GSC */
+            bool gscFound = false;
+            const char *gscId = NULL;
+            double nearestGSCDistance = HUGE_NUMBER;
+            if (!ppmFound) {
+                gscFound = findGSCStar(GCstar[gcIndex].RA1875, Decl1875, 1875.0, MAX_DIST_GSC);
+                if (gscFound) {
+                    gscId = getGSCId();
+                    nearestGSCDistance = getDist();
                 }
+            }
 
-                saveZC(RAh, RAs, Decls, numRefCat, x, y, z,
-                    ppmFound, ppmIndex, nearestPPMDistance,
-                    gscFound, gscId, nearestGSCDistance,
-                    cdFound, cdIndex, nearestCDDistance,
-                    cpdFound, cpdIndex, nearestCPDDistance);
-                countZCsaved++;
+            /* busca la CPD mas cercana (solo dentro de la faja CPD, Decl <= -18) */
+            bool cpdFound = false;
+            int cpdIndex = -1;
+            double nearestCPDDistance = HUGE_NUMBER;
+            if (GCstar[gcIndex].Decld >= 18) {
+                minDistance = HUGE_NUMBER;
+                findCPDByCoordinates(x, y, z, Decl1875, &cpdIndex, &minDistance);
+                nearestCPDDistance = minDistance;
+                if (minDistance < MAX_DIST_CPD) cpdFound = true;
             }
-            /* otras designaciones (WB, UA, F, P, M, Melb.I, nombres, ...) se ignoran */
+
+            /* busca la CD mas cercana (solo dentro de la faja CD, Decl <= -22) */
+            bool cdFound = false;
+            int cdIndex = -1;
+            double nearestCDDistance = HUGE_NUMBER;
+            if (GCstar[gcIndex].Decld >= 22) {
+                minDistance = HUGE_NUMBER;
+                findDMByCoordinates(x, y, z, Decl1875, &cdIndex, &minDistance);
+                nearestCDDistance = minDistance;
+                if (minDistance < MAX_DIST_CD) cdFound = true;
+            }
+
+            saveZC(RAh, RAs, Decls, numRefCat, x, y, z,
+                ppmFound, ppmIndex, nearestPPMDistance,
+                gscFound, gscId, nearestGSCDistance,
+                cdFound, cdIndex, nearestCDDistance,
+                cpdFound, cpdIndex, nearestCPDDistance);
+            countZCsaved++;
         }
-        fclose(stream);
+        /* otras designaciones (WB, UA, F, P, M, Melb.I, nombres, ...) se ignoran */
     }
 
-    printf("Scanned GC rows with a reference = %d; references to checked catalogs (OA/Ll/B/St/L/T/Y/CL/G) = %d\n",
+    logPrintf("Scanned GC rows with a reference = %d; references to checked catalogs (OA/Ll/B/St/L/T/Y/CL/G) = %d\n",
         countStars, countRefs);
-    printf("Cross-checks OK: Lacaille = %d, Brisbane = %d, Lalande = %d, Taylor = %d, OA = %d, Stone = %d, USNO = %d, CL = %d, Gilliss = %d\n",
+    logPrintf("Cross-checks OK: Lacaille = %d, Brisbane = %d, Lalande = %d, Taylor = %d, OA = %d, Stone = %d, USNO = %d, CL = %d, Gilliss = %d\n",
         checkLac, checkBri, checkLal, checkTaylor, checkOA, checkSt, checkUSNO, checkCL, checkGi1963);
-    printf("ZC (Gould's Zone Catalog) stars saved = %d\n", countZCsaved);
-    printf("Errors logged = %d\n", errors);
+    logPrintf("ZC (Gould's Zone Catalog) stars saved = %d\n", countZCsaved);
+    logPrintf("Errors logged = %d\n", errors);
 }
 
 /*
@@ -1256,8 +1360,8 @@ void readGil1963() {
     char buffer[1024], cell[256], catName[20];
     char catLine[64];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Gilliss (1963 stars) and PPM...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Gilliss (1963 stars) and PPM...\n");
 
     FILE *crossPPMStream, *crossSAOStream, *crossHDStream;
     openCrossSet("gil1963", &crossPPMStream, &crossSAOStream, &crossHDStream);
@@ -1333,7 +1437,7 @@ void readGil1963() {
 
         if (!ppmFound && !gscFound && nearestPPMDistance > MAX_DIST_PPM_FAR) {
             warnAlonePPMGSC(&stats.errors, catName, catName,
-                RAs, Decl1875, Decls, PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                RAs, Decl1875, Decls, ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
         }
 
         /* lee referencia numerica y referencia a catalogo (que queda en "cell");
@@ -1353,15 +1457,15 @@ void readGil1963() {
         writeCatalogFile(catalogStream, catName, x, y, z, vmag);
     }
     fclose(stream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 
-    printf("Available Gilliss = %d\n", countGi1963);
-    printf("Stars from Gilliss with Lacaille = %d and Brisbane = %d\n", checkLac, checkBri);
-    printf("Stars from Gilliss identified with PPM = %d and GSC-PPM = %d\n", stats.countDist, stats.countGSC);
+    logPrintf("Available Gilliss = %d\n", countGi1963);
+    logPrintf("Stars from Gilliss with Lacaille = %d and Brisbane = %d\n", checkLac, checkBri);
+    logPrintf("Stars from Gilliss identified with PPM = %d and GSC-PPM = %d\n", stats.countDist, stats.countGSC);
     printRSMEDist(&stats);
     printRSMEMag(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -1383,15 +1487,14 @@ static void checkUACatalogRef(char *buffer, int col, bool isHD, char *catName, d
 
     bool mismatch = false;
     if (refFromUA < catRef - 1 || refFromUA > catRef + 1) {
-        printf("%d) Warning: %s references mismatch for %s: %d != %d.\n",
-            ++(*errors),
+        logWarning(errors, "Warning: %s references mismatch for %s: %d != %d.\n",
             label,
             catName,
             catRef,
             refFromUA);
         mismatch = true;
     } else if (refFromUA != catRef) {
-        printf("**) Note: %s references mismatch for %s: %d != %d.\n",
+        logPrintf("**) Note: %s references mismatch for %s: %d != %d.\n",
             label,
             catName,
             catRef,
@@ -1406,7 +1509,7 @@ static void checkUACatalogRef(char *buffer, int col, bool isHD, char *catName, d
             int otherRef = isHD ? PPMstar[i].hdRef : PPMstar[i].saoRef;
             if (otherRef == refFromUA) {
                 double dist = 3600.0 * calcAngularDistance(x, y, z, PPMstar[i].x, PPMstar[i].y, PPMstar[i].z);
-                printf("     Match suggested by UA (vmag=%.1f): PPM %d (vmag=%.1f) at distance %.1f arcsec, instead of %s (vmag=%.1f) at %.1f arcsec\n",
+                logPrintf("     Match suggested by UA (vmag=%.1f): PPM %d (vmag=%.1f) at distance %.1f arcsec, instead of %s (vmag=%.1f) at %.1f arcsec\n",
                     vmag,
                     PPMstar[i].ppmRef,
                     PPMstar[i].vmag,
@@ -1419,7 +1522,7 @@ static void checkUACatalogRef(char *buffer, int col, bool isHD, char *catName, d
             }
         }
         if (!foundInPPM) {
-            printf("     No match found in PPM for %s %d referenced by UA.\n", label, refFromUA);
+            logPrintf("     No match found in PPM for %s %d referenced by UA.\n", label, refFromUA);
         }
     }
 
@@ -1438,8 +1541,8 @@ static void checkUACatalogRef(char *buffer, int col, bool isHD, char *catName, d
 void readUA() {
     char buffer[1024], cell[256], catName[20], ppmName[20];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between UA and PPM/CD/CPD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between UA and PPM/CD/CPD...\n");
 
 	FILE *crossCDStream = openCrossFile("results/cross/cross_ua_cd.csv");
 	FILE *crossCPDStream = openCrossFile("results/cross/cross_ua_cpd.csv");
@@ -1576,16 +1679,15 @@ void readUA() {
         }
 
         if (!ppmFound && !cdFound && !cpdFound) {
-            printf("%d) Warning: %s is ALONE (no PPM / CD / CPD star near it).\n",
-                ++stats.errors,
+            logWarning(&stats.errors, "Warning: %s is ALONE (no PPM / CD / CPD star near it).\n",
                 ua.catgName);
-            printf("     Register %s: %s\n", ua.catgName, ua.catLine);
+            logPrintf("     Register %s: %s\n", ua.catgName, ua.catLine);
             readField(buffer, cell, 132, 3);
             bool cumulus = !strncmp(cell, "cum", 3);
             bool nebula = !strncmp(cell, "neb", 3);
             logCauses(catName, true,
                 cumulus, nebula, ua.RAs, ua.Decl, 1,
-                PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
         }
 
         if (ua.existsRef) {
@@ -1594,17 +1696,17 @@ void readUA() {
         }
     }
     fclose(stream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 	fclose(crossCPDStream);
 	fclose(crossCDStream);
 
-    printf("Available UA stars = %d\n", countUA);
-    printf("Stars from UA with Lacaille = %d, Brisbane = %d, Lalande = %d, Taylor = %d, OA = %d, USNO = %d and Gilliss = %d\n",
+    logPrintf("Available UA stars = %d\n", countUA);
+    logPrintf("Stars from UA with Lacaille = %d, Brisbane = %d, Lalande = %d, Taylor = %d, OA = %d, USNO = %d and Gilliss = %d\n",
         checkLac, checkBri, checkLal, checkTaylor, checkOA, checkUSNO, checkGi1963);
-    printf("Stars from UA identified with PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countCD, stats.countCPD);
+    logPrintf("Stars from UA identified with PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countCD, stats.countCPD);
     printRSMEDist(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -1615,8 +1717,8 @@ void readUA() {
 void readCL() {
     char buffer[1024], name[32], magStr[16];
 
-    printf("\n***************************************\n");
-    printf("Read RNAO2 Circumpolar List (CL)...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Read RNAO2 Circumpolar List (CL)...\n");
 
     FILE *stream = fopen("cat/CL.csv", "rt");
     if (stream == NULL) {
@@ -1652,7 +1754,7 @@ void readCL() {
     }
     fclose(stream);
 
-    printf("Available CL stars = %d\n", countCL);
+    logPrintf("Available CL stars = %d\n", countCL);
 }
 
 /*
@@ -1667,8 +1769,8 @@ void readThome(double epoch, const char *filename, int correction) {
     char buffer[1024], cell[256], srcName[24];
     char catLine[64];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Thome (Resultados ONA 15) and PPM/CD/CPD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Thome (Resultados ONA 15) and PPM/CD/CPD...\n");
 
     CrossStats stats;
     int checkLac = 0;
@@ -1774,7 +1876,7 @@ void readThome(double epoch, const char *filename, int correction) {
         if (!ppmFound && !cdFound && !cpdFound && !gscFound) {
             warnAlone(&stats.errors, srcName, srcName, catLine,
                 NULL, RAs, Decl1875, Decls,
-                PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
         }
 
         /* lee referencia numerica y referencia a catalogo (que queda en "cell") */
@@ -1815,12 +1917,12 @@ void readThome(double epoch, const char *filename, int correction) {
     }
     fclose(stream);
 
-    printf("Stars from Thome %.0f identified with PPM = %d, CD = %d and CPD = %d\n", epoch, stats.countDist, stats.countCD, stats.countCPD);
-    printf("Stars from Thome %.0f with Lacaille = %d, Lalande = %d, OA = %d, Taylor = %d, Stone = %d, GC = %d, USNO = %d, Brisbane = %d, CL = %d and Gilliss = %d\n",
+    logPrintf("Stars from Thome %.0f identified with PPM = %d, CD = %d and CPD = %d\n", epoch, stats.countDist, stats.countCD, stats.countCPD);
+    logPrintf("Stars from Thome %.0f with Lacaille = %d, Lalande = %d, OA = %d, Taylor = %d, Stone = %d, GC = %d, USNO = %d, Brisbane = %d, CL = %d and Gilliss = %d\n",
         epoch, checkLac, checkLal, checkOA, checkTaylor, checkStone, checkGC, checkUSNO, checkBri, checkCL, checkGi1963);
     printRSMEDist(&stats);
     printRSMEMag(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
@@ -1833,8 +1935,8 @@ void readGilliss() {
     char buffer[1024], cell[256], catName[20];
     char catLine[64];
 
-    printf("\n***************************************\n");
-    printf("Perform comparison between Gilliss and PPM/CD/CPD...\n");
+    logPrintf("\n***************************************\n");
+    logPrintf("Perform comparison between Gilliss and PPM/CD/CPD...\n");
 
 	FILE *crossCDStream = openCrossFile("results/cross/cross_gilliss_cd.csv");
 	FILE *crossCPDStream = openCrossFile("results/cross/cross_gilliss_cpd.csv");
@@ -1934,7 +2036,7 @@ void readGilliss() {
             } else {
                 warnAlone(&stats.errors, catName, catName, catLine,
                     catName, RAs, Decl1875, Decls,
-                    PPMstar[ppmIndex].ppmRef, nearestPPMDistance);
+                    ppmIndex >= 0 ? PPMstar[ppmIndex].ppmRef : -1, nearestPPMDistance);
             }
         }
 
@@ -1958,8 +2060,7 @@ void readGilliss() {
             int zcRAh = atoi(cell);
             int originalRAh = (int) floor(RA1875/15.0 + __FLT_EPSILON__);
             if (zcRAh != originalRAh) {
-                printf("%d) Warning: G %d has a different RA zone (%d) than identified ZC (%d).\n",
-                    ++stats.errors,
+                logWarning(&stats.errors, "Warning: G %d has a different RA zone (%d) than identified ZC (%d).\n",
                     giRef,
                     zcRAh,
                     originalRAh);
@@ -1973,68 +2074,107 @@ void readGilliss() {
     }
     fclose(stream);
     fclose(unidentifiedStream);
-    fclose(catalogStream);
+    closeCatalogFile(catalogStream);
     closeCrossSet(crossPPMStream, crossSAOStream, crossHDStream);
 	fclose(crossCPDStream);
 	fclose(crossCDStream);
 
-    printf("Stars from Gilliss identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
-    printf("Stars from Gilliss with Lacaille = %d, Stone = %d, GC = %d and Brisbane = %d\n",
+    logPrintf("Stars from Gilliss identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", stats.countDist, stats.countGSC, stats.countCD, stats.countCPD);
+    logPrintf("Stars from Gilliss with Lacaille = %d, Stone = %d, GC = %d and Brisbane = %d\n",
         checkLac, checkStone, checkGC, checkBri);
     printRSMEDist(&stats);
     printRSMEMag(&stats);
-    printf("Errors logged = %d\n", stats.errors);
+    logPrintf("Errors logged = %d\n", stats.errors);
 }
 
 /*
  * main - comienzo de la aplicacion
  */
-int main(int argc, char** argv)
-{
-    printf("CROSS_SOUTH - Compare several catalogs.\n");
-    printf("Made in 2025 by Daniel Severin.\n");
-
-    /* leemos catalogo CD */
-    readDM(CURATED ? "cat/cd_curated.txt" : "cat/cd.txt");
-
-    /* leemos catalogo CPD */
-    readCPD(false, false);
-
-    /* leemos y cruzamos segundo catálogo argentino */
-    readGC2();
-
-    /* leemos y cruzamos Weiss / OA */
+/* etapas con argumentos o pasos adicionales */
+static void stageWeiss() {
     readWeiss();
     makeDoubles(countOA, oaRef, oaX, oaY, oaZ, oaMag, "OA", "results/doubles/oa.csv");
+}
+
+static void stageTaylor() {
+    readTaylor();
+    makeDoubles(countTaylor, tayRef, tayX, tayY, tayZ, tayMag, "T", "results/doubles/taylor.csv");
+}
 
-    /* leemos y cruzamos Lalande (solo contra PPM) */
-    readLalande();
+static void stageUSNO() {
+    readUSNO();
+    makeDoubles(countUsno, usnoRef, usnoX, usnoY, usnoZ, usnoMag, "U", "results/doubles/usno.csv");
+}
 
-    /* revisamos las referencias a Lalande de los Standards of Magnitude */
-    readSOM();
+static void stageThome1881() { readThome(1881.0, "cat/thome1881.txt", 0); }
+static void stageThome1882() { readThome(1882.0, "cat/thome1882.txt", 0); }
+static void stageThome1883() { readThome(1883.0, "cat/thome1883.txt", -1); }
+static void stageThome1884() { readThome(1884.0, "cat/thome1884.txt", -1); }
 
-    /* leemos y cruzamos Brisbane */
-    readBrisbane();
+static void stageGilliss() {
+    readGilliss();
+    makeDoubles(countGil, gilRef, gilX, gilY, gilZ, gilMag, "G", "results/doubles/gilliss.csv");
+}
 
-    /* leemos y cruzamos Stone / Lacaille */
-    readStone();
+/* Etapas en el orden de la ejecucion serial; cada una depende de las etapas que
+ * llenan las listas que consulta (la faja de Gould's Zone Catalog se arma en
+ * el orden Thome, Gilliss, GC escaneado, por lo que esas etapas van en cadena) */
+static struct CrossStage stages[] = {
+    /* segundo catálogo argentino */
+    {"GC2", readGC2, NULL},
+    /* Weiss / OA */
+    {"OA", stageWeiss, NULL},
+    /* Lalande (solo contra PPM) y las referencias a Lalande de los Standards of Magnitude */
+    {"Lalande", readLalande, NULL},
+    {"SOM", readSOM, "Lalande"},
+    /* Brisbane y Stone / Lacaille */
+    {"Brisbane", readBrisbane, NULL},
+    {"Stone", readStone, "Brisbane"},
+    /* catalogo GC */
+    {"GC", readGC, NULL},
+    /* Taylor */
+    {"Taylor", stageTaylor, "Brisbane Stone GC"},
+    /* identificaciones de Yarnall */
+    {"USNO", stageUSNO, "OA Lalande Brisbane Stone Taylor"},
+    /* catalogo de 1963 estrellas de Gilliss */
+    {"Gil1963", readGil1963, "Brisbane Stone"},
+    /* Uranometria Argentina */
+    {"UA", readUA, "OA Lalande Brisbane Stone Taylor USNO Gil1963"},
+    /* lista de estrellas circumpolares (Circumpolar List) */
+    {"CL", readCL, NULL},
+    /* Thome y Gilliss, que tambien generan identificaciones de Gould's Zone Catalog */
+    {"Thome1881", stageThome1881, "OA Lalande Brisbane Stone GC Taylor USNO Gil1963 CL"},
+    {"Thome1882", stageThome1882, "Thome1881"},
+    {"Thome1883", stageThome1883, "Thome1882"},
+    {"Thome1884", stageThome1884, "Thome1883"},
+    {"Gilliss", stageGilliss, "Thome1884"},
+    /* cross-checkings de páginas escaneadas de GC (tambien Gould's Zone Catalog) */
+    {"GCScanned", readGCScanned, "Gilliss"},
+};
 
-    /* leemos catalogo GC */
-	readGC();
+/*
+ * lecturas iniciales (CD y CPD solo se consultan en las etapas)
+ */
+static void loadCD() {
+    readDM(CURATED ? "cat/cd_curated.txt" : "cat/cd.txt");
+}
 
-    /* leemos y cruzamos Taylor */
-    readTaylor();
-    makeDoubles(countTaylor, tayRef, tayX, tayY, tayZ, tayMag, "T", "results/doubles/taylor.csv");
+static void loadCPDOnly() {
+    readCPD(false, false);
+}
 
-    /* leemos, cruzamos y revisamos identificaciones de Yarnall */
-    readUSNO();
-    makeDoubles(countUsno, usnoRef, usnoX, usnoY, usnoZ, usnoMag, "U", "results/doubles/usno.csv");
+static struct CrossStage loads[] = {
+    {"CD", loadCD, NULL},
+    {"CPD", loadCPDOnly, NULL},
+};
 
-    /* leemos y cruzamos el catalogo de 1963 estrellas de Gilliss */
-    readGil1963();
+int main(int argc, char** argv)
+{
+    logPrintf("CROSS_SOUTH - Compare several catalogs.\n");
+    logPrintf("Made in 2025 by Daniel Severin.\n");
 
-    /* leemos, cruzamos y revisamos Uranometria Argentina */
-    readUA();
+    /* leemos catalogos CD y CPD (en paralelo: no se cruzan entre si) */
+    runCatalogLoads(loads, sizeof(loads) / sizeof(loads[0]));
 
     crossPPMZCStream = openCrossFile("results/cross/cross_zc_ppm.csv");
     crossCDZCStream = openCrossFile("results/cross/cross_zc_cd.csv");
@@ -2043,30 +2183,14 @@ int main(int argc, char** argv)
     crossHDZCStream = openCrossFile("results/cross/cross_zc_hd.csv");
     unidentifiedZCStream = openUnidentifiedFile("results/cross/zc_unidentified.csv");
 
-    /* leemos la lista de estrellas circumpolares (Circumpolar List) */
-    readCL();
-
-    /* leemos, cruzamos y revisamos identificaciones de Thome */
-    /* tambien generamos identificaciones de Gould's Zone Catalog */
-    readThome(1881.0, "cat/thome1881.txt", 0);
-    readThome(1882.0, "cat/thome1882.txt", 0);
-    readThome(1883.0, "cat/thome1883.txt", -1);
-    readThome(1884.0, "cat/thome1884.txt", -1);
-
-    /* leemos, cruzamos y revisamos identificaciones de Gilliss */
-    /* tambien generamos identificaciones de Gould's Zone Catalog */
-    readGilliss();
-    makeDoubles(countGil, gilRef, gilX, gilY, gilZ, gilMag, "G", "results/doubles/gilliss.csv");
-
-    /* hacemos cross-checkings de páginas escaneadas de GC
-     * tambien generamos identificaciones de Gould's Zone Catalog */
-    readGCScanned();
+    /* leemos y cruzamos el resto de los catalogos (CD y CPD ya no se modifican) */
+    runCrossStages(stages, sizeof(stages) / sizeof(stages[0]));
 
     fclose(unidentifiedZCStream);
 	fclose(crossPPMZCStream);
 	fclose(crossCPDZCStream);
 	fclose(crossCDZCStream);
-    printf("\nNumber of ZC stars registered = %d\n", countZC);
-    printf("Stars from ZC identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", countPPMZC, countGSCZC, countCDZC, countCPDZC);
+    logPrintf("\nNumber of ZC stars registered = %d\n", countZC);
+    logPrintf("Stars from ZC identified with PPM = %d, GSC-PPM = %d, CD = %d and CPD = %d\n", countPPMZC, countGSCZC, countCDZC, countCPDZC);
     return 0;
 }
@@ -63,6 +63,19 @@
  *    present, these override the PPM catalog magnitudes for the control and
  *    sequence stars so that the fit is derived from user-supplied values
  *    instead.
+ *
+ * 4) --fit-cd [tableFile]
+ *    Fits the magnitude scales of the five CD volumes at once. The files
+ *    results/cross/cross_cd_vol1..5_ppm.csv are read in parallel, each row once
+ *    and with the same filters as --csv mode, accumulating per CD zone a
+ *    histogram (as in --csv mode) and the sums of the normal equations of an
+ *    unweighted per-star quadratic fit. Zones are merged into volumes, and for
+ *    each volume it reports the constant, linear and quadratic CD -> V fits
+ *    with RMSE and MAPE and the V -> CD quadratic fit. The chosen coefficients
+ *    (quadratic only if it lowers RMSE by FIT_QUAD_GAIN over linear) are
+ *    written to tableFile (default CD_MAG_SCALE_FILE), which compCDmagToVmag
+ *    and compVmagToCDmag load at startup. Residuals of each zone against its
+ *    volume scale are listed, to spot zones that need revision.
  */
 
 #include <stdio.h>
@@ -70,7 +83,10 @@
 #include <string.h>
 #include <math.h>
 #include "trig.h"
+#include "misc.h"
 #include "read_ppm.h"
+#include "read_cross.h"
+#include "parallel.h"
 
 #define STRING_SIZE 14
 #define MAX_CUSTOM_STARS 200
@@ -78,6 +94,8 @@
 #define THRESHOLD_MAG 1.5
 #define ZEROPOINT_IMAG 17.37
 #define CROSS_OLD_CATALOGS false
+#define CD_ZONES 90
+#define FIT_QUAD_GAIN 0.005 // quadratic scale only if RMSE improves at least this
 
 /* Structure to store custom star data (histogram).
  * Note: instrumental magnitudes are given by indices,
@@ -101,41 +119,429 @@ struct StarRecord {
  */
 void readCrossFile(
         const char *ppm_file, struct PPMstar_struct *PPMstar, int PPMstars) {
-    char buffer[1024], targetRef[STRING_SIZE], code[4];
-    int ppmRef, cdDeclRef, cdNumRef, cpdDeclRef, cpdNumRef;
-    float vmag, minDistance;
+    char buffer[1024];
+    struct CrossFile_struct crossFile;
 
     /* read cross file between PPM and target */
     printf("Reading cross file %s... ", ppm_file);
-    FILE *stream = fopen(ppm_file, "rt");
-    if (stream == NULL) {
+    if (!readCrossCSV(ppm_file, &crossFile)) {
         snprintf(buffer, 1024, "Cannot read %s", ppm_file);
         perror(buffer);
         exit(1);
     }
-    bool first_line = true;
-    while (fgets(buffer, 1023, stream) != NULL) {
-        if (first_line) {
-            // omit first line (header)
-            first_line = false;
+    for (int e = 0; e < crossFile.entries; e++) {
+        struct CrossEntry_struct *entry = &crossFile.entry[e];
+        if (entry->catalog2 != CROSS_PPM) continue;
+        // printf("Cross: %s, PPM %d, dist = %.1f arcsec.\n", entry->index1, entry->numRef2, entry->dist);
+        if (entry->dist < __FLT_EPSILON__ || entry->dist > THRESHOLD_PPM) {
+            // omit identifications with zero distance (bug) or too far away
             continue;
         }
-        sscanf(buffer, "%13[^,],%3s %d,%f,%f\n", targetRef, code, &ppmRef, &vmag, &minDistance);
-        if (strcmp(code, "PPM") != 0) continue;
-        // printf("Cross: %s, PPM %d, dist = %.1f arcsec.\n", targetRef, ppmRef, minDistance);
-        if (minDistance < __FLT_EPSILON__ || minDistance > THRESHOLD_PPM) {
-            // omit identifications with zero distance (bug) or too far away
+        int i = getPPMindex(entry->numRef2);
+        if (i != -1) {
+            char name[STRING_SIZE];
+            strncpy(name, entry->index1, STRING_SIZE - 1);
+            name[STRING_SIZE - 1] = 0;
+            PPMstar[i].dmName = internDesignation(name);
+        }
+    }
+    freeCrossCSV(&crossFile);
+    printf("done!\n");
+}
+
+/* Constant, linear and quadratic fits of PPM V magnitude against instrumental
+ * magnitude over a histogram, with their RMSE and MAPE (among bins) */
+struct MagFit_struct {
+    double constZP, constRMSE, constMAPE;
+    double linZP, linSlope, linRMSE, linMAPE;
+    bool quadOK; /* false if the quadratic system is ill-conditioned */
+    double quadZP, quadSlope, quadCurve, quadRMSE, quadMAPE;
+};
+
+/*
+ * fitHistogram - performs the regression fits over a histogram whose bins hold
+ * average PPM V magnitudes, each bin weighted by log10(count)
+ */
+static void fitHistogram(const struct CustomStars *customStars, int customStarCount, struct MagFit_struct *fit) {
+    /* Calculate constant fit: Vmag = zeroPoint + imag */
+    double sum_vmag = 0.0, sum_imag = 0.0;
+    double sum_weights = 0.0;
+    for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+        if (customStars[i].count == 0) {
+            continue;
+        }
+        double ppm_vmag = customStars[i].ppmVmag;
+        double imag = i / 10.0;
+        double weight = log10(customStars[i].count);
+        sum_vmag += ppm_vmag * weight;
+        sum_imag += imag * weight;
+        sum_weights += weight;
+    }
+    double zeroPoint = (sum_vmag - sum_imag) / sum_weights;
+    fit->constZP = zeroPoint;
+
+    /* Calculate calibrated magnitudes, RMSE, and MAPE for constant fit */
+    double sum_sq_error = 0.0;
+    double sum_abs_percentage_error = 0.0;
+    for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+        if (customStars[i].count == 0) {
+            continue;
+        }
+        double ppm_vmag = customStars[i].ppmVmag;
+        double imag = i / 10.0;
+        double calibrated_vmag = zeroPoint + imag;
+        double error = fabs(calibrated_vmag - ppm_vmag);
+        sum_sq_error += error * error;
+        sum_abs_percentage_error += error / ppm_vmag * 100.0;
+    }
+    fit->constRMSE = sqrt(sum_sq_error / customStarCount);
+    fit->constMAPE = sum_abs_percentage_error / customStarCount;
+
+    /* Calculate means for least squares linear fit */
+    double sum_imag_lin = 0.0, sum_vmag_lin = 0.0;
+    double sum_imag_vmag = 0.0, sum_imag_sq = 0.0;
+    double sum_weights_lin = 0.0;
+    for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+        if (customStars[i].count == 0) {
+            continue;
+        }
+        double imag = i / 10.0;
+        double ppm_vmag = customStars[i].ppmVmag;
+        double weight = log10(customStars[i].count);
+        sum_imag_lin += imag * weight;
+        sum_vmag_lin += ppm_vmag * weight;
+        sum_imag_vmag += imag * ppm_vmag * weight;
+        sum_imag_sq += imag * imag * weight;
+        sum_weights_lin += weight;
+    }
+    double mean_imag = sum_imag_lin / sum_weights_lin;
+    double mean_vmag = sum_vmag_lin / sum_weights_lin;
+
+    /* Calculate slope and intercept */
+    double denominator = sum_imag_sq - sum_weights_lin * mean_imag * mean_imag;
+    double factor = (sum_imag_vmag - sum_weights_lin * mean_imag * mean_vmag) / denominator;
+    double linearZeroPoint = mean_vmag - factor * mean_imag;
+    fit->linZP = linearZeroPoint;
+    fit->linSlope = factor;
+
+    /* Calculate calibrated magnitudes, RMSE, and MAPE for linear fit */
+    sum_sq_error = 0.0;
+    sum_abs_percentage_error = 0.0;
+    for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+        if (customStars[i].count == 0) {
+            continue;
+        }
+        double imag = i / 10.0;
+        double ppm_vmag = customStars[i].ppmVmag;
+        double calibrated_vmag = linearZeroPoint + factor * imag;
+        double error = fabs(calibrated_vmag - ppm_vmag);
+        sum_sq_error += error * error;
+        sum_abs_percentage_error += error / ppm_vmag * 100.0;
+    }
+    fit->linRMSE = sqrt(sum_sq_error / customStarCount);
+    fit->linMAPE = sum_abs_percentage_error / customStarCount;
+
+    /* Quadratic fit (centered to improve conditioning, solved stably) */
+    double xmean = mean_imag;
+    double S0 = 0.0;
+    double Sx = 0.0, Sx2 = 0.0, Sx3 = 0.0, Sx4 = 0.0;
+    double Sy = 0.0, Sxy = 0.0, Sx2y = 0.0;
+    for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+        if (customStars[i].count == 0) {
+            continue;
+        }
+        double imag = i / 10.0;
+        double x = imag - xmean;
+        double y = customStars[i].ppmVmag;
+        double weight = log10(customStars[i].count);
+        double x2 = x * x;
+        S0   += weight;
+        Sx   += x * weight;
+        Sx2  += x2 * weight;
+        Sx3  += x2 * x * weight;
+        Sx4  += x2 * x2 * weight;
+        Sy   += y * weight;
+        Sxy  += x * y * weight;
+        Sx2y += x2 * y * weight;
+    }
+
+    /* Normal equations in centered basis: y = a + b*x + c*x^2 */
+    double A[3][3] = {
+        { S0,  Sx,  Sx2 },
+        { Sx,  Sx2, Sx3 },
+        { Sx2, Sx3, Sx4 }
+    };
+    double bvec[3] = { Sy, Sxy, Sx2y };
+    double sol[3];
+    fit->quadOK = solve3x3(A, bvec, sol);
+    if (!fit->quadOK) return;
+
+    /* Convert centered coefficients to original variable imag */
+    double a_c = sol[0];
+    double b_c = sol[1];
+    double c_c = sol[2];
+    double quadZeroPoint = a_c - b_c * xmean + c_c * xmean * xmean;
+    double quadFactor    = b_c - 2.0 * c_c * xmean;
+    double quad          = c_c;
+    fit->quadZP = quadZeroPoint;
+    fit->quadSlope = quadFactor;
+    fit->quadCurve = quad;
+
+    /* Calculate calibrated magnitudes, RMSE, and MAPE for quadratic fit */
+    sum_sq_error = 0.0;
+    sum_abs_percentage_error = 0.0;
+    for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+        if (customStars[i].count == 0) {
+            continue;
+        }
+        double imag = i / 10.0;
+        double trueV = customStars[i].ppmVmag;
+        double yhat = quadZeroPoint + quadFactor * imag + quad * imag * imag;
+        double err = fabs(yhat - trueV);
+        sum_sq_error += err * err;
+        sum_abs_percentage_error += err / trueV * 100.0;
+    }
+    fit->quadRMSE = sqrt(sum_sq_error / customStarCount);
+    fit->quadMAPE = sum_abs_percentage_error / customStarCount;
+}
+
+/* Unweighted per-star moments of (x, y), enough for a quadratic least-squares
+ * fit y = a + b*x + c*x^2 and for the residuals of any such curve */
+struct Moments_struct {
+    double x[5]; /* sum of x^k, k = 0..4 */
+    double y, xy, x2y, yy;
+};
+
+/* Sums of a CD zone for --fit-cd: histogram of CD magnitudes (as in --csv mode)
+ * and moments for CD -> V (x = CD mag) and V -> CD (x = PPM V) */
+struct ZoneSums_struct {
+    struct CustomStars bins[MAX_CUSTOM_STARS];
+    int matches;
+    struct Moments_struct toV, toCD;
+};
+
+/* One task of --fit-cd: reads a volume file into its own zone sums */
+struct FitCDTask_struct {
+    struct ZoneSums_struct zone[CD_ZONES];
+    int rows, skipped;
+};
+
+static void addMoments(struct Moments_struct *m, double x, double y) {
+    double p = 1.0;
+    for (int k = 0; k < 5; k++) {
+        m->x[k] += p;
+        p *= x;
+    }
+    m->y += y;
+    m->xy += x * y;
+    m->x2y += x * x * y;
+    m->yy += y * y;
+}
+
+static void sumMoments(struct Moments_struct *total, const struct Moments_struct *part) {
+    for (int k = 0; k < 5; k++) total->x[k] += part->x[k];
+    total->y += part->y;
+    total->xy += part->xy;
+    total->x2y += part->x2y;
+    total->yy += part->yy;
+}
+
+/*
+ * fitMoments - unweighted quadratic fit y = c[0] + c[1]*x + c[2]*x^2
+ */
+static bool fitMoments(const struct Moments_struct *m, double c[3]) {
+    if (m->x[0] < 3.0) return false;
+    double A[3][3] = {
+        { m->x[0], m->x[1], m->x[2] },
+        { m->x[1], m->x[2], m->x[3] },
+        { m->x[2], m->x[3], m->x[4] }
+    };
+    double bvec[3] = { m->y, m->xy, m->x2y };
+    return solve3x3(A, bvec, c);
+}
+
+/*
+ * residualMoments - mean and RMS of y - (c[0] + c[1]*x + c[2]*x^2), from the moments alone
+ */
+static void residualMoments(const struct Moments_struct *m, const double c[3], double *bias, double *rmse) {
+    double a = c[0], b = c[1], q = c[2];
+    double sum = m->y - a * m->x[0] - b * m->x[1] - q * m->x[2];
+    double sq = m->yy - 2.0 * (a * m->y + b * m->xy + q * m->x2y)
+        + a * a * m->x[0] + 2.0 * a * b * m->x[1] + (b * b + 2.0 * a * q) * m->x[2]
+        + 2.0 * b * q * m->x[3] + q * q * m->x[4];
+    *bias = sum / m->x[0];
+    *rmse = sqrt(fmax(sq, 0.0) / m->x[0]);
+}
+
+/*
+ * readCDVolume - task of --fit-cd: streams the rows of one cross_cd_vol*_ppm.csv
+ * file once, with the same filters as --csv mode
+ */
+static void readCDVolume(int index, void *context) {
+    struct FitCDTask_struct *task = &((struct FitCDTask_struct *) context)[index];
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+    char filename[64];
+
+    snprintf(filename, sizeof(filename), "results/cross/cross_cd_vol%d_ppm.csv", index + 1);
+    struct CrossFile_struct crossFile;
+    if (!readCrossCSV(filename, &crossFile)) {
+        perror(filename);
+        exit(1);
+    }
+    for (int e = 0; e < crossFile.entries; e++) {
+        struct CrossEntry_struct *entry = &crossFile.entry[e];
+        if (entry->catalog2 != CROSS_PPM) continue;
+        task->rows++;
+        int zone = -entry->declRef1;
+        int ppmIndex = getPPMindex(entry->numRef2);
+        int bin = (int)(10.0 * entry->mag + 0.5);
+        if (entry->catalog1 != CROSS_CD || zone < 0 || zone >= CD_ZONES
+                || entry->dist < __FLT_EPSILON__ || entry->dist > THRESHOLD_PPM || entry->mag < __FLT_EPSILON__
+                || ppmIndex == -1 || PPMstar[ppmIndex].vmag <= 1.0 || bin < 0 || bin >= MAX_CUSTOM_STARS) {
+            task->skipped++;
             continue;
         }
-        for (int i = 0; i < PPMstars; i++) {
-            if (PPMstar[i].ppmRef == ppmRef) {
-                strncpy(PPMstar[i].dmString, targetRef, STRING_SIZE);
-                break;
+        struct ZoneSums_struct *sums = &task->zone[zone];
+        double cdVmag = entry->mag;
+        double ppmVmag = PPMstar[ppmIndex].vmag;
+        sums->bins[bin].ppmVmag += ppmVmag;
+        sums->bins[bin].count++;
+        sums->matches++;
+        addMoments(&sums->toV, cdVmag, ppmVmag);
+        addMoments(&sums->toCD, ppmVmag, cdVmag);
+    }
+    freeCrossCSV(&crossFile);
+}
+
+/*
+ * fitCDScales - --fit-cd mode: fits the magnitude scales of the five CD volumes in a
+ * single pass over the cross identifications and writes the table read by
+ * compCDmagToVmag and compVmagToCDmag (see trig.h)
+ */
+static int fitCDScales(const char *tableFile) {
+    printf("Fitting magnitude scales of CD volumes from results/cross/cross_cd_vol*_ppm.csv\n");
+    printf("Reading PPM catalog...\n");
+    readPPM(false, true, false, false, 2000.0);
+    sortPPM();
+
+    /* one task per volume file; the sums are merged by zone afterwards */
+    struct FitCDTask_struct *task = (struct FitCDTask_struct *) calloc(CD_MAG_VOLUMES, sizeof(struct FitCDTask_struct));
+    struct ZoneSums_struct *zone = (struct ZoneSums_struct *) calloc(CD_ZONES, sizeof(struct ZoneSums_struct));
+    if (task == NULL || zone == NULL) bye("Out of memory!\n");
+    parallelFor(CD_MAG_VOLUMES, readCDVolume, task);
+    int rows = 0, skipped = 0;
+    for (int t = 0; t < CD_MAG_VOLUMES; t++) {
+        rows += task[t].rows;
+        skipped += task[t].skipped;
+        for (int z = 0; z < CD_ZONES; z++) {
+            const struct ZoneSums_struct *part = &task[t].zone[z];
+            for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+                zone[z].bins[i].ppmVmag += part->bins[i].ppmVmag;
+                zone[z].bins[i].count += part->bins[i].count;
+            }
+            zone[z].matches += part->matches;
+            sumMoments(&zone[z].toV, &part->toV);
+            sumMoments(&zone[z].toCD, &part->toCD);
+        }
+    }
+    free(task);
+    printf("Rows read: %d, used: %d\n", rows, rows - skipped);
+
+    FILE *stream = fopen(tableFile, "wt");
+    if (stream == NULL) {
+        perror("Cannot write CD magnitude scale table");
+        exit(1);
+    }
+    fprintf(stream, "# CD magnitude scales fitted by cross_txt --fit-cd (m' = a + b m + c m^2)\n");
+    fprintf(stream, "# CD -> V: weighted by log10(stars) over 0.1 mag bins; V -> CD: unweighted, per star\n");
+    fprintf(stream, "# vol from  to   toV_a      toV_b      toV_c      toCD_a     toCD_b     toCD_c     fit       stars rmse  mape  | stars rmse\n");
+
+    double chosen[CD_MAG_VOLUMES][3];
+    bool fitted[CD_MAG_VOLUMES];
+    for (int v = 0; v < CD_MAG_VOLUMES; v++) {
+        /* merge the zones of the volume */
+        int first = -1, last = -1;
+        struct CustomStars bins[MAX_CUSTOM_STARS];
+        memset(bins, 0, sizeof(bins));
+        struct Moments_struct toCD;
+        memset(&toCD, 0, sizeof(toCD));
+        int matches = 0;
+        for (int z = 0; z < CD_ZONES; z++) {
+            if (getCDVolume(-z) != v) continue;
+            if (first < 0) first = z;
+            last = z;
+            for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+                bins[i].ppmVmag += zone[z].bins[i].ppmVmag;
+                bins[i].count += zone[z].bins[i].count;
+            }
+            sumMoments(&toCD, &zone[z].toCD);
+            matches += zone[z].matches;
+        }
+
+        /* as in --csv mode: bins with less than 5 stars are discarded */
+        int customStarCount = 0;
+        for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
+            if (bins[i].count < 5) {
+                bins[i].ppmVmag = 0.0;
+                bins[i].count = 0;
+                continue;
             }
+            bins[i].ppmVmag /= bins[i].count;
+            customStarCount++;
+        }
+
+        printf("\nVolume %d (CD -%d to -%d): %d matches in %d magnitudes\n", v + 1, first, last, matches, customStarCount);
+        fitted[v] = false;
+        double cd[3];
+        if (customStarCount <= 5 || !fitMoments(&toCD, cd)) {
+            printf("  Not enough data, the default scales are kept\n");
+            continue;
+        }
+        struct MagFit_struct fit;
+        fitHistogram(bins, customStarCount, &fit);
+        printf("  CD -> V constant fit:  Vmag = %.3f + CDmag, RMSE = %.3f, MAPE = %.2f%%\n",
+            fit.constZP, fit.constRMSE, fit.constMAPE);
+        printf("  CD -> V linear fit:    Vmag = %.3f + %.3f * CDmag, RMSE = %.3f, MAPE = %.2f%%\n",
+            fit.linZP, fit.linSlope, fit.linRMSE, fit.linMAPE);
+        if (fit.quadOK) {
+            printf("  CD -> V quadratic fit: Vmag = %.3f + %.3f * CDmag + %.3f * CDmag^2, RMSE = %.3f, MAPE = %.2f%%\n",
+                fit.quadZP, fit.quadSlope, fit.quadCurve, fit.quadRMSE, fit.quadMAPE);
         }
+
+        /* the quadratic fit is kept only if it clearly improves the linear one */
+        bool quadratic = fit.quadOK && fit.quadRMSE < fit.linRMSE - FIT_QUAD_GAIN;
+        double *scale = chosen[v];
+        scale[0] = quadratic ? fit.quadZP : fit.linZP;
+        scale[1] = quadratic ? fit.quadSlope : fit.linSlope;
+        scale[2] = quadratic ? fit.quadCurve : 0.0;
+        double rmse = quadratic ? fit.quadRMSE : fit.linRMSE;
+        double mape = quadratic ? fit.quadMAPE : fit.linMAPE;
+        double cdBias, cdRMSE;
+        residualMoments(&toCD, cd, &cdBias, &cdRMSE);
+        printf("  V -> CD quadratic fit: CDmag = %.6f + %.6f * Vmag + %.6f * Vmag^2, RMSE = %.4f\n",
+            cd[0], cd[1], cd[2], cdRMSE);
+        printf("  Chosen CD -> V: %s\n", quadratic ? "quadratic" : "linear");
+
+        fprintf(stream, "%d  -%-2d -%-2d %10.6f %10.6f %10.6f %10.6f %10.6f %10.6f %-9s %5d %.3f %.2f  | %5.0f %.4f\n",
+            v + 1, first, last, scale[0], scale[1], scale[2], cd[0], cd[1], cd[2],
+            quadratic ? "quadratic" : "linear", matches, rmse, mape, toCD.x[0], cdRMSE);
+        fitted[v] = true;
     }
     fclose(stream);
-    printf("done!\n");
+
+    /* per zone residuals of the chosen CD -> V fit of its volume, to spot zones to revise */
+    printf("\nResiduals of chosen CD -> V fit per zone:\n");
+    printf("zone  stars   bias    RMSE\n");
+    for (int z = 0; z < CD_ZONES; z++) {
+        int v = getCDVolume(-z);
+        if (v < 0 || !fitted[v] || zone[z].matches == 0) continue;
+        double bias, rmse;
+        residualMoments(&zone[z].toV, chosen[v], &bias, &rmse);
+        printf("-%-4d %6d  %6.3f  %6.3f\n", z, zone[z].matches, bias, rmse);
+    }
+    free(zone);
+    printf("\nCD magnitude scales written to %s\n", tableFile);
+    return 0;
 }
 
 /* Join base directory and filename into out path */
@@ -165,10 +571,16 @@ int main(int argc, char** argv)
         printf("Usage: %s --var baseDir variablePPMid [controlPPMid] [sequencePPMid1] [sequencePPMid2]\n", argv[0]);
         printf("              [controlVmag] [sequenceVmag1] [sequenceVmag2]\n");
         printf("         Estimates variable star magnitude from Coord.txt/Flux.txt data.\n");
+        printf("Usage: %s --fit-cd [tableFile]\n", argv[0]);
+        printf("         It reads results/cross/cross_cd_vol*_ppm.csv once, fits the magnitude scales of\n");
+        printf("         every CD volume and writes them to tableFile (default %s).\n", CD_MAG_SCALE_FILE);
         return 1;
     }
 
     const char *mode = argv[1];
+    if (strcmp(mode, "--fit-cd") == 0) {
+        return fitCDScales(argc >= 3 ? argv[2] : CD_MAG_SCALE_FILE);
+    }
     
     /* Array to store histogram of custom stars based on instrumental magnitudes. */
     struct CustomStars customStars[MAX_CUSTOM_STARS];
@@ -185,13 +597,6 @@ int main(int argc, char** argv)
     char estimPath[256];
     estimPath[0] = '\0';
 
-    /* Fit parameters (set later if enough data) */
-    bool fitComputed = false;
-    double fit_constZP = 0.0;
-    double fit_linZP = 0.0, fit_linSlope = 0.0;
-    bool fit_quadOK = false;
-    double fit_quadZP = 0.0, fit_quadSlope = 0.0, fit_quadCurve = 0.0;
-
     if (strcmp(mode, "--csv") == 0) {
         /* Mode is --csv, read CSV file and perform magnitude fits */
         if (argc < 3) {
@@ -203,8 +608,8 @@ int main(int argc, char** argv)
         printf("Reading CSV cross-identification file: %s\n", csvFile);
         printf("(original visual magnitudes are treated as instrumental magnitudes)\n");
         
-        FILE *stream = fopen(csvFile, "rt");
-        if (stream == NULL) {
+        struct CrossFile_struct crossFile;
+        if (!readCrossCSV(csvFile, &crossFile)) {
             printf("Error: Cannot open %s file.\n", csvFile);
             return 1;
         }
@@ -215,25 +620,17 @@ int main(int argc, char** argv)
         printf("Reading PPM catalog...\n");
         readPPM(false, true, false, false, 2000.0);
         sortPPM();
-        int PPMstars = getPPMStars();
         struct PPMstar_struct *PPMstar = getPPMStruct();
         
         /* Read CSV file and populate customStars histogram */
-        char buffer[1024], targetRef[STRING_SIZE], code[4];
-        int ppmRef;
-        float vmag, minDistance;
-        bool first_line = true;
         int matches = 0;
         
-        while (fgets(buffer, 1023, stream) != NULL) {
-            if (first_line) {
-                // omit first line (header)
-                first_line = false;
-                continue;
-            }
-            
-            sscanf(buffer, "%13[^,],%3s %d,%f,%f\n", targetRef, code, &ppmRef, &vmag, &minDistance);
-            if (strcmp(code, "PPM") != 0) continue;
+        for (int e = 0; e < crossFile.entries; e++) {
+            struct CrossEntry_struct *entry = &crossFile.entry[e];
+            if (entry->catalog2 != CROSS_PPM) continue;
+            int ppmRef = entry->numRef2;
+            float vmag = entry->mag;
+            float minDistance = entry->dist;
             
             // Ignore if distance is too far of magnitude is absent
             if (minDistance < __FLT_EPSILON__ || minDistance > THRESHOLD_PPM || vmag < __FLT_EPSILON__) {
@@ -241,13 +638,7 @@ int main(int argc, char** argv)
             }
             
             // Find PPM star by ppmRef
-            int ppmIndex = -1;
-            for (int i = 0; i < PPMstars; i++) {
-                if (PPMstar[i].ppmRef == ppmRef) {
-                    ppmIndex = i;
-                    break;
-                }
-            }
+            int ppmIndex = getPPMindex(ppmRef);
             
             // Ignore if PPM star not found or too bright or does not report magnitude
             if (ppmIndex == -1 || PPMstar[ppmIndex].vmag <= 1.0) {
@@ -282,7 +673,7 @@ int main(int argc, char** argv)
             }
         }
 
-        fclose(stream);
+        freeCrossCSV(&crossFile);
 
         // Discard those bins having less than 5 stars
         for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
@@ -413,7 +804,9 @@ int main(int argc, char** argv)
             if (ppmIndex != -1
                     && minDistance < THRESHOLD_PPM
                     && !PPMstar[ppmIndex].discard) {
-                snprintf(identBuf, sizeof(identBuf), "PPM %d / %s", PPMstar[ppmIndex].ppmRef, PPMstar[ppmIndex].dmString);
+                char dmString[64];
+                formatDesignation(dmString, PPMstar[ppmIndex].dmName);
+                snprintf(identBuf, sizeof(identBuf), "PPM %d / %s", PPMstar[ppmIndex].ppmRef, dmString);
                 identStr = identBuf;
                 ppmMatch = true;
             }
@@ -592,8 +985,10 @@ int main(int argc, char** argv)
             bool ppmMatch = false;
             char identBuf[128];
             if (ppmIndex != -1 && minDistance < THRESHOLD_PPM && !PPMstar[ppmIndex].discard) {
+                char dmString[64];
+                formatDesignation(dmString, PPMstar[ppmIndex].dmName);
                 snprintf(identBuf, sizeof(identBuf), "PPM %d / %s",
-                         PPMstar[ppmIndex].ppmRef, PPMstar[ppmIndex].dmString);
+                         PPMstar[ppmIndex].ppmRef, dmString);
                 ppmMatch = true;
             }
 
@@ -782,7 +1177,7 @@ int main(int argc, char** argv)
         return 0;
 
     } else {
-        printf("Error: Invalid mode '%s'. Use --csv, --txt, or --var\n", mode);
+        printf("Error: Invalid mode '%s'. Use --csv, --txt, --var or --fit-cd\n", mode);
         return 1;
     }
 
@@ -799,176 +1194,29 @@ int main(int argc, char** argv)
         customStars[i].ppmVmag = avgPpmVmag;
     }
 
-    /* Perform constant regression fit between instrumental and PPM V magnitudes */
+    /* Perform constant, linear and quadratic regression fits between instrumental and PPM V magnitudes */
+    struct MagFit_struct fit;
+    bool fitComputed = false;
     if (customStarCount > 5) {
-        printf("\nPerforming constant regression fit (assumes perfect linearity of instrumental magnitudes)...\n");
-        
-        /* Calculate constant fit: Vmag = zeroPoint + imag */
-        double sum_vmag = 0.0, sum_imag = 0.0;
-        double sum_weights = 0.0;
-        
-        for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
-            if (customStars[i].count == 0) {
-                continue;
-            }
-            double ppm_vmag = customStars[i].ppmVmag;
-            double imag = i / 10.0;
-            double weight = log10(customStars[i].count);
-            sum_vmag += ppm_vmag * weight;
-            sum_imag += imag * weight;
-            sum_weights += weight;
-        }
-        
-        /* Calculate zero point */
-        double zeroPoint = (sum_vmag - sum_imag) / sum_weights;
-        fit_constZP = zeroPoint;
+        fitHistogram(customStars, customStarCount, &fit);
         fitComputed = true;
+        printf("\nPerforming constant regression fit (assumes perfect linearity of instrumental magnitudes)...\n");
+        printf(" 1) Constant fit: Vmag = %.3f + imag\n", fit.constZP);
+        printf("\n    Constant fit RMSE: %.3f magnitudes\n", fit.constRMSE);
+        printf("    Constant fit MAPE: %.2f%%\n", fit.constMAPE);
 
-        printf(" 1) Constant fit: Vmag = %.3f + imag\n", zeroPoint);
-        
-        /* Calculate calibrated magnitudes, RMSE, and MAPE for constant fit */
-        double sum_sq_error = 0.0;
-        double sum_abs_percentage_error = 0.0;
-        for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
-            if (customStars[i].count == 0) {
-                continue;
-            }
-            double ppm_vmag = customStars[i].ppmVmag;
-            double imag = i / 10.0;
-            double calibrated_vmag = zeroPoint + imag;
-            double error = fabs(calibrated_vmag - ppm_vmag);
-            sum_sq_error += error * error;
-            sum_abs_percentage_error += error / ppm_vmag * 100.0;
-        }
-        double rmse = sqrt(sum_sq_error / customStarCount);
-        double mape = sum_abs_percentage_error / customStarCount;
-        printf("\n    Constant fit RMSE: %.3f magnitudes\n", rmse);
-        printf("    Constant fit MAPE: %.2f%%\n", mape);
-        
-        /* Now perform linear regression fit */
         printf("\nPerforming linear regression fit...\n");
-        
-        /* Calculate means for least squares fit */
-        double sum_imag_lin = 0.0, sum_vmag_lin = 0.0;
-        double sum_imag_vmag = 0.0, sum_imag_sq = 0.0;
-        double sum_weights_lin = 0.0;
-        
-        for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
-            if (customStars[i].count == 0) {
-                continue;
-            }
-            double imag = i / 10.0;
-            double ppm_vmag = customStars[i].ppmVmag;
-            double weight = log10(customStars[i].count);
-            sum_imag_lin += imag * weight;
-            sum_vmag_lin += ppm_vmag * weight;
-            sum_imag_vmag += imag * ppm_vmag * weight;
-            sum_imag_sq += imag * imag * weight;
-            sum_weights_lin += weight;
-        }
-        
-        double mean_imag = sum_imag_lin / sum_weights_lin;
-        double mean_vmag = sum_vmag_lin / sum_weights_lin;
-        
-        /* Calculate slope and intercept */
-        double denominator = sum_imag_sq - sum_weights_lin * mean_imag * mean_imag;
-        double factor = (sum_imag_vmag - sum_weights_lin * mean_imag * mean_vmag) / denominator;
-        double linearZeroPoint = mean_vmag - factor * mean_imag;
-        fit_linZP = linearZeroPoint;
-        fit_linSlope = factor;
-
-        printf(" 2) Linear fit: Vmag = %.3f + %.3f * imag\n", linearZeroPoint, factor);
-        
-        /* Calculate calibrated magnitudes, RMSE, and MAPE for linear fit */
-        sum_sq_error = 0.0;
-        sum_abs_percentage_error = 0.0;
-        for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
-            if (customStars[i].count == 0) {
-                continue;
-            }
-            double imag = i / 10.0;
-            double ppm_vmag = customStars[i].ppmVmag;
-            double calibrated_vmag = linearZeroPoint + factor * imag;
-            double error = fabs(calibrated_vmag - ppm_vmag);
-            sum_sq_error += error * error;
-            sum_abs_percentage_error += error / ppm_vmag * 100.0;
-        }
-        rmse = sqrt(sum_sq_error / customStarCount);
-        mape = sum_abs_percentage_error / customStarCount;
-        printf("\n    Linear fit RMSE: %.3f magnitudes\n", rmse);
-        printf("    Linear fit MAPE: %.2f%%\n", mape);
-        
-        /* Now perform quadratic regression fit (centered, solved stably) */
-        printf("\nPerforming quadratic regression fit...\n");
+        printf(" 2) Linear fit: Vmag = %.3f + %.3f * imag\n", fit.linZP, fit.linSlope);
+        printf("\n    Linear fit RMSE: %.3f magnitudes\n", fit.linRMSE);
+        printf("    Linear fit MAPE: %.2f%%\n", fit.linMAPE);
 
-        /* Center x to improve conditioning */
-        double xmean = mean_imag;
-        double S0 = 0.0;
-        double Sx = 0.0, Sx2 = 0.0, Sx3 = 0.0, Sx4 = 0.0;
-        double Sy = 0.0, Sxy = 0.0, Sx2y = 0.0;
-        for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
-            if (customStars[i].count == 0) {
-                continue;
-            }
-            double imag = i / 10.0;
-            double x = imag - xmean;
-            double y = customStars[i].ppmVmag;
-            double weight = log10(customStars[i].count);
-            double x2 = x * x;
-            S0   += weight;
-            Sx   += x * weight;
-            Sx2  += x2 * weight;
-            Sx3  += x2 * x * weight;
-            Sx4  += x2 * x2 * weight;
-            Sy   += y * weight;
-            Sxy  += x * y * weight;
-            Sx2y += x2 * y * weight;
-        }
-
-        /* Normal equations in centered basis: y = a + b*x + c*x^2 */
-        double A[3][3] = {
-            { S0,  Sx,  Sx2 },
-            { Sx,  Sx2, Sx3 },
-            { Sx2, Sx3, Sx4 }
-        };
-        double bvec[3] = { Sy, Sxy, Sx2y };
-        double sol[3];
-        if (!solve3x3(A, bvec, sol)) {
+        printf("\nPerforming quadratic regression fit...\n");
+        if (!fit.quadOK) {
             printf("Error: Cannot perform quadratic regression (matrix ill-conditioned)\n");
         } else {
-            /* Convert centered coefficients to original variable imag */
-            double a_c = sol[0];
-            double b_c = sol[1];
-            double c_c = sol[2];
-            double quadZeroPoint = a_c - b_c * xmean + c_c * xmean * xmean;
-            double quadFactor    = b_c - 2.0 * c_c * xmean;
-            double quad          = c_c;
-            fit_quadZP = quadZeroPoint;
-            fit_quadSlope = quadFactor;
-            fit_quadCurve = quad;
-            fit_quadOK = true;
-
-            printf(" 3) Quadratic fit: Vmag = %.3f + %.3f * imag + %.3f * imag^2\n", quadZeroPoint, quadFactor, quad);
-
-            /* Calculate calibrated magnitudes, RMSE, and MAPE for quadratic fit */
-            sum_sq_error = 0.0;
-            sum_abs_percentage_error = 0.0;
-            for (int i = 0; i < MAX_CUSTOM_STARS; i++) {
-                if (customStars[i].count == 0) {
-                    continue;
-                }
-                double imag = i / 10.0;
-                double trueV = customStars[i].ppmVmag;
-                double yhat = quadZeroPoint + quadFactor * imag + quad * imag * imag;
-                double err = fabs(yhat - trueV);
-                sum_sq_error += err * err;
-                sum_abs_percentage_error += err / trueV * 100.0;
-            }
-
-            rmse = sqrt(sum_sq_error / customStarCount);
-            mape = sum_abs_percentage_error / customStarCount;
-            printf("\n    Quadratic fit RMSE: %.3f magnitudes\n", rmse);
-            printf("    Quadratic fit MAPE: %.2f%%\n", mape);
+            printf(" 3) Quadratic fit: Vmag = %.3f + %.3f * imag + %.3f * imag^2\n", fit.quadZP, fit.quadSlope, fit.quadCurve);
+            printf("\n    Quadratic fit RMSE: %.3f magnitudes\n", fit.quadRMSE);
+            printf("    Quadratic fit MAPE: %.2f%%\n", fit.quadMAPE);
         }
     }
 
@@ -981,8 +1229,8 @@ int main(int argc, char** argv)
             fprintf(estimFile, "   Index    Vmag  ConstEst    LinEst   QuadEst  Identification\n");
             for (int i = 0; i < starRecordCount; i++) {
                 struct StarRecord *rec = &starRecords[i];
-                double constEst = fit_constZP + rec->imag;
-                double linEst = fit_linZP + fit_linSlope * rec->imag;
+                double constEst = fit.constZP + rec->imag;
+                double linEst = fit.linZP + fit.linSlope * rec->imag;
 
                 fprintf(estimFile, "%8d", rec->index);
 
@@ -994,8 +1242,8 @@ int main(int argc, char** argv)
 
                 fprintf(estimFile, "  %8.2f  %8.2f", constEst, linEst);
 
-                if (fit_quadOK) {
-                    double quadEst = fit_quadZP + fit_quadSlope * rec->imag + fit_quadCurve * rec->imag * rec->imag;
+                if (fit.quadOK) {
+                    double quadEst = fit.quadZP + fit.quadSlope * rec->imag + fit.quadCurve * rec->imag * rec->imag;
                     fprintf(estimFile, "  %8.2f", quadEst);
                 }
 
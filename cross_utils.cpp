@@ -8,6 +8,10 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "read_ppm.h"
 #include "read_cpd.h"
 #include "read_dm.h"
@@ -15,8 +19,78 @@
 #include "trig.h"
 #include "misc.h"
 #include "find_gsc.h"
+#include "parallel.h"
+#include "sky_grid.h"
+#include "cross_match.h"
 #include "cross_utils.h"
 
+/*
+ * addCrossStats - acumula las estadisticas de una parte (excepto errors)
+ */
+void addCrossStats(struct CrossStats *total, const struct CrossStats *part) {
+    total->countDist += part->countDist;
+    total->akkuDistError += part->akkuDistError;
+    total->countDelta += part->countDelta;
+    total->akkuDeltaError += part->akkuDeltaError;
+    total->countGSC += part->countGSC;
+    total->countCD += part->countCD;
+    total->countCPD += part->countCPD;
+}
+
+/*
+ * runCrossStage - corre una etapa con un almacen PPM propio
+ */
+static void runCrossStage(void *context) {
+    struct CrossStage *stage = (struct CrossStage *) context;
+    struct PPMstore_struct *store = newPPMStore();
+    usePPMStore(store);
+    stage->run();
+    freePPMStore(store);
+}
+
+/*
+ * runCrossStages - ejecuta las etapas en paralelo segun sus dependencias
+ * (los catalogos leidos antes, como CD o CPD, solo se consultan)
+ */
+void runCrossStages(struct CrossStage *stages, int count) {
+    struct TaskNode *tasks = (struct TaskNode *) calloc(count, sizeof(struct TaskNode));
+    if (tasks == NULL) bye("Out of memory!\n");
+    for (int i = 0; i < count; i++) {
+        tasks[i].name = stages[i].name;
+        tasks[i].task = runCrossStage;
+        tasks[i].context = &stages[i];
+        tasks[i].after = stages[i].after;
+    }
+    runTaskGraph(tasks, count);
+    printTaskGraphStats(stderr, tasks, count);
+    free(tasks);
+}
+
+/*
+ * runCatalogLoad - corre una lectura inicial (en los almacenes por defecto)
+ */
+static void runCatalogLoad(void *context) {
+    struct CrossStage *load = (struct CrossStage *) context;
+    load->run();
+}
+
+/*
+ * runCatalogLoads - lee los catalogos en paralelo segun sus dependencias
+ */
+void runCatalogLoads(struct CrossStage *loads, int count) {
+    struct TaskNode *tasks = (struct TaskNode *) calloc(count, sizeof(struct TaskNode));
+    if (tasks == NULL) bye("Out of memory!\n");
+    for (int i = 0; i < count; i++) {
+        tasks[i].name = loads[i].name;
+        tasks[i].task = runCatalogLoad;
+        tasks[i].context = &loads[i];
+        tasks[i].after = loads[i].after;
+    }
+    runTaskGraph(tasks, count);
+    printTaskGraphStats(stderr, tasks, count);
+    free(tasks);
+}
+
 /*
  * preparePPM - lee PPM a la epoca dada y lo deja ordenado
  */
@@ -26,6 +100,27 @@ struct PPMstar_struct *preparePPM(double epoch, bool discardSouth) {
     return getPPMStruct();
 }
 
+/*
+ * ppmMatchSide - lado de crossMatch con el PPM del hilo actual (ya leido)
+ */
+void ppmMatchSide(struct MatchSide_struct *side) {
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+    side->count = getPPMStars();
+    side->exact = &PPMstar[0].x;
+    side->mag = &PPMstar[0].vmag;
+    side->stride = (int) (sizeof(struct PPMstar_struct) / sizeof(double));
+}
+
+/*
+ * printMatchStats - resume una identificacion por maxima verosimilitud
+ */
+void printMatchStats(const char *nameA, const char *nameB, int countA, const struct MatchResult_struct *result) {
+    logPrintf("Stars from %s identified with %s by likelihood = %d (of %d); candidate pairs = %d\n",
+        nameA, nameB, result->pairs, countA, result->edges);
+    logPrintf("Components = %d (brute force = %d, Hungarian = %d, largest Hungarian = %dx%d)\n",
+        result->components, result->brute, result->hungarian, result->largestA, result->largestB);
+}
+
 /*
  * readRAField - lee ascension recta y la devuelve en grados
  */
@@ -132,8 +227,7 @@ bool crossWithPPM(double x, double y, double z, double Decl, double vmag, double
                 stats->akkuDeltaError += delta * delta;
                 stats->countDelta++;
             } else {
-                printf("%d) Warning: %s (vmag = %.1f) has a near PPM %d star (vmag = %.1f) with a different magnitude (delta = %.1f).\n",
-                    ++stats->errors,
+                logWarning(&stats->errors, "Warning: %s (vmag = %.1f) has a near PPM %d star (vmag = %.1f) with a different magnitude (delta = %.1f).\n",
                     magWarnName,
                     vmagf,
                     PPMstar[ppmIndex].ppmRef,
@@ -184,7 +278,7 @@ bool crossWithCPD(double x, double y, double z, double Decl1875, double vmag, do
     stats->countCPD++;
     if (catName != NULL) {
         char cpdName[20];
-        snprintf(cpdName, 20, "CPD %d°%d", CPDstar[cpdIndex].declRef, CPDstar[cpdIndex].numRef);
+        formatDesignation(cpdName, zoneDesignation(DESIG_CPD, CPDstar[cpdIndex].declRef, CPDstar[cpdIndex].numRef));
         writeCrossEntry(stream, catName, cpdName, vmag, minDistance);
     }
     return true;
@@ -210,8 +304,7 @@ bool crossWithCD(double x, double y, double z, double Decl1875, double vmag,
     if (magWarnName != NULL && vmagf > __FLT_EPSILON__ && cdVmag < 29.9) {
         float delta = fabs(vmagf - cdVmag);
         if (delta >= MAX_MAGNITUDE) {
-            printf("%d) Warning: %s (vmag = %.1f) has a near CD with dif. magnitude (delta = %.1f). Check dpl.\n",
-                ++stats->errors,
+            logWarning(&stats->errors, "Warning: %s (vmag = %.1f) has a near CD with dif. magnitude (delta = %.1f). Check dpl.\n",
                 magWarnName,
                 vmagf,
                 delta);
@@ -222,7 +315,7 @@ bool crossWithCD(double x, double y, double z, double Decl1875, double vmag,
     stats->countCD++;
     if (catName != NULL) {
         char cdName[20];
-        snprintf(cdName, 20, "CD %d°%d", CDstar[cdIndex].declRef, CDstar[cdIndex].numRef);
+        formatDesignation(cdName, zoneDesignation(DESIG_CD, CDstar[cdIndex].declRef, CDstar[cdIndex].numRef));
         writeCrossEntry(stream, catName, cdName, vmag, minDistance);
     }
     return true;
@@ -234,7 +327,7 @@ bool crossWithCD(double x, double y, double z, double Decl1875, double vmag,
 int storeStar(int *count, int max, const char *name, int *ref, double *X, double *Y, double *Z,
         double *mag, int refValue, double x, double y, double z, double magValue) {
     if (*count >= max) {
-        printf("Error: too many %s stars.\n", name);
+        logPrintf("Error: too many %s stars.\n", name);
         exit(1);
     }
     int i = *count;
@@ -257,13 +350,12 @@ void checkCrossRef(const char *srcName, const char *catLine, const char *label,
         if (list->ref[i] != numRefCat) continue;
         double dist = 3600.0 * calcAngularDistance(x, y, z, list->x[i], list->y[i], list->z[i]);
         if (dist > MAX_DIST_CROSS) {
-            printf("%d) Warning: %s is FAR from %s %d (dist = %.1f arcsec).\n",
-                ++(*errors),
+            logWarning(errors, "Warning: %s is FAR from %s %d (dist = %.1f arcsec).\n",
                 srcName,
                 label,
                 numRefCat,
                 dist);
-            if (catLine != NULL) printf("     Register %s: %s\n", srcName, catLine);
+            if (catLine != NULL) logPrintf("     Register %s: %s\n", srcName, catLine);
             if (gcIndexRegister >= 0) writeRegisterGC(gcIndexRegister);
         } else (*check)++;
         if (breakAfterFirst) break;
@@ -282,14 +374,13 @@ void checkCrossRefWB(const char *srcName, const char *catLine, bool starWord,
         if (list->ref[i] != numRefCat) continue;
         double dist = 3600.0 * calcAngularDistance(x, y, z, list->x[i], list->y[i], list->z[i]);
         if (dist > MAX_DIST_CROSS) {
-            printf("%d) Warning: %s is FAR from WB %dh %d%s (dist = %.1f arcsec).\n",
-                ++(*errors),
+            logWarning(errors, "Warning: %s is FAR from WB %dh %d%s (dist = %.1f arcsec).\n",
                 srcName,
                 RARef,
                 numRefCat,
                 starWord ? " star" : "",
                 dist);
-            if (catLine != NULL) printf("     Register %s: %s\n", srcName, catLine);
+            if (catLine != NULL) logPrintf("     Register %s: %s\n", srcName, catLine);
             if (gcIndexRegister >= 0) writeRegisterGC(gcIndexRegister);
         } else (*check)++;
     }
@@ -306,7 +397,7 @@ void checkBDRef(const char *srcName, const char *catLine, bool printNotFound,
     int index = getDMindex(signRef, declRef, numRefCat);
     if (index == -1) {
         if (printNotFound) {
-            printf("DM not found for declRef = %d, numRef = %d.\n",
+            logPrintf("DM not found for declRef = %d, numRef = %d.\n",
                 declRef,
                 numRefCat);
         }
@@ -314,11 +405,10 @@ void checkBDRef(const char *srcName, const char *catLine, bool printNotFound,
     }
     double dist = 3600.0 * calcAngularDistance(x, y, z, BDstar[index].x, BDstar[index].y, BDstar[index].z);
     if (dist > MAX_DIST_CROSS) {
-        printf("%d) Warning: %s is FAR from BD star (dist = %.1f arcsec).\n",
-            ++(*errors),
+        logWarning(errors, "Warning: %s is FAR from BD star (dist = %.1f arcsec).\n",
             srcName,
             dist);
-        printf("     Register %s: %s\n", srcName, catLine);
+        logPrintf("     Register %s: %s\n", srcName, catLine);
         writeRegister(index, false);
     } else (*check)++;
 }
@@ -335,12 +425,11 @@ void checkCrossRefGCcat(const char *srcName, const char *catLine, int numRefCat,
         if (GCstar[i].gcRef != numRefCat) continue;
         double dist = 3600.0 * calcAngularDistance(x, y, z, GCstar[i].x, GCstar[i].y, GCstar[i].z);
         if (dist > MAX_DIST_CROSS) {
-            printf("%d) Warning: %s is FAR from GC %d (dist = %.1f arcsec). Check if it is a 1/2 star in GC.\n",
-                ++(*errors),
+            logWarning(errors, "Warning: %s is FAR from GC %d (dist = %.1f arcsec). Check if it is a 1/2 star in GC.\n",
                 srcName,
                 numRefCat,
                 dist);
-            if (catLine != NULL) printf("     Register %s: %s\n", srcName, catLine);
+            if (catLine != NULL) logPrintf("     Register %s: %s\n", srcName, catLine);
         } else (*check)++;
     }
 }
@@ -364,13 +453,12 @@ void checkYarnallRef(const char *srcName, const char *catLine, int numRefCat,
     }
     if (requirePositiveIndex && usnoIndex <= 0) return;
     if (minDistance > MAX_DIST_CROSS_YARNALL) {
-        printf("%d) Warning: %s is FAR from Y %d / U %d (dist = %.1f arcsec).\n",
-            ++(*errors),
+        logWarning(errors, "Warning: %s is FAR from Y %d / U %d (dist = %.1f arcsec).\n",
             srcName,
             numRefCat,
             list->ref[usnoIndex],
             minDistance);
-        if (catLine != NULL) printf("     Register %s: %s\n", srcName, catLine);
+        if (catLine != NULL) logPrintf("     Register %s: %s\n", srcName, catLine);
         if (gcIndexRegister >= 0) writeRegisterGC(gcIndexRegister);
     } else (*check)++;
 }
@@ -382,8 +470,7 @@ void warnIfAloneNorth(bool ppmFound, double minDistance, double RA, double Decl,
         const char *warnDesc, int *errors) {
     if (ppmFound || minDistance <= MAX_DIST_PPM_FAR) return;
     if (!findGSCStar(RA, Decl, epoch, MAX_DIST_GSC)) {
-        printf("%d) Warning: %s is ALONE (nearest PPM star at %.1f arcsec).\n",
-            ++(*errors),
+        logWarning(errors, "Warning: %s is ALONE (nearest PPM star at %.1f arcsec).\n",
             warnDesc,
             minDistance);
     }
@@ -394,10 +481,9 @@ void warnIfAloneNorth(bool ppmFound, double minDistance, double RA, double Decl,
  */
 void warnAlone(int *errors, const char *warnDesc, const char *registerDesc, const char *catLine,
         char *catName, int RAs, double decl, int Decls, int ppmRef, double nearestPPMDistance) {
-    printf("%d) Warning: %s is ALONE (no PPM / CD / CPD / GSC star near it).\n",
-        ++(*errors),
+    logWarning(errors, "Warning: %s is ALONE (no PPM / CD / CPD / GSC star near it).\n",
         warnDesc);
-    if (catLine != NULL) printf("     Register %s: %s\n", registerDesc, catLine);
+    if (catLine != NULL) logPrintf("     Register %s: %s\n", registerDesc, catLine);
     logCauses(catName, true,
         false, false, RAs, decl, Decls,
         ppmRef, nearestPPMDistance);
@@ -408,32 +494,24 @@ void warnAlone(int *errors, const char *warnDesc, const char *registerDesc, cons
  */
 void warnAlonePPMGSC(int *errors, const char *warnDesc, char *catName,
         int RAs, double decl, int Decls, int ppmRef, double nearestPPMDistance) {
-    printf("%d) Warning: %s is ALONE (no PPM or GSC star near it).\n",
-        ++(*errors),
+    logWarning(errors, "Warning: %s is ALONE (no PPM or GSC star near it).\n",
         warnDesc);
     logCauses(catName, false,
         false, false, RAs, decl, Decls,
         ppmRef, nearestPPMDistance);
 }
 
-/*
- * writeUnidentified - almacena una estrella no identificada (pero hallada en GSC)
- */
-void writeUnidentified(FILE *stream, const char *catName, double x, double y, double z) {
-    fprintf(stream, "%s,%.8f,%.8f,%.8f\n", catName, x, y, z);
-}
-
 /*
  * printRSMEDist / printRSMEMag - imprime los RSME acumulados
  */
 void printRSMEDist(const struct CrossStats *stats) {
-    printf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
+    logPrintf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
         sqrt(stats->akkuDistError / (double)stats->countDist),
         stats->countDist);
 }
 
 void printRSMEMag(const struct CrossStats *stats) {
-    printf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
+    logPrintf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
         sqrt(stats->akkuDeltaError / (double)stats->countDelta),
         stats->countDelta);
 }
@@ -448,13 +526,12 @@ void checkPrecessionRA(double preRA, const char *srcName, const char *catLine,
     double realPreRA = base + factor * dsin(RA) * dtan(Decl);
     double diff = fabs(preRA - realPreRA);
     if (diff > tol) {
-        printf("%d) Warning: %s reports %.3f on precession RA but it should be %.3f (diff=%.3f).\n",
-            ++(*errors),
+        logWarning(errors, "Warning: %s reports %.3f on precession RA but it should be %.3f (diff=%.3f).\n",
             srcName,
             preRA,
             realPreRA,
             diff);
-        if (catLine != NULL) printf("     Register %s: %s\n", srcName, catLine);
+        if (catLine != NULL) logPrintf("     Register %s: %s\n", srcName, catLine);
     }
 }
 
@@ -464,13 +541,12 @@ void checkPrecessionDecl(double preDecl, const char *srcName, const char *catLin
     double realPreDecl = coef * dcos(RA);
     double diff = fabs(preDecl - realPreDecl);
     if (diff > tol) {
-        printf("%d) Warning: %s reports %.2f on precession DECL but it should be %.2f (diff=%.2f).\n",
-            ++(*errors),
+        logWarning(errors, "Warning: %s reports %.2f on precession DECL but it should be %.2f (diff=%.2f).\n",
             srcName,
             preDecl,
             realPreDecl,
             diff);
-        if (catLine != NULL) printf("     Register %s: %s\n", srcName, catLine);
+        if (catLine != NULL) logPrintf("     Register %s: %s\n", srcName, catLine);
     }
 }
 
@@ -504,6 +580,146 @@ bool parseGCScanLine(char *buffer, int *gcRef, char *ref) {
     return true;
 }
 
+/* encabezado de GC_SCAN_PACK: luego siguen las filas (GCScan_struct) */
+struct GCScanHeader_struct {
+    char magic[8];
+    int count;
+    int pages;
+    long long modified[GC_SCAN_PAGES + 1]; /* fecha de cada CSV empaquetado, -1 = no existe */
+    int firstRecord[GC_SCAN_PAGES + 2]; /* primera fila de cada pagina */
+};
+
+static const char GC_SCAN_MAGIC[8] = "GCSCAN1";
+
+/*
+ * scanPageModified - devuelve la fecha de modificacion del CSV de una pagina (-1 si no existe)
+ */
+static long long scanPageModified(int page) {
+    char filename[64];
+    struct stat info;
+    snprintf(filename, 64, "scans/rnao14_page%d.csv", page);
+    if (stat(filename, &info) != 0) return -1;
+    return (long long) info.st_mtime;
+}
+
+/*
+ * packGCScans - lee todas las paginas escaneadas de GC y las guarda parseadas en GC_SCAN_PACK
+ * (los CSV siguen siendo la fuente editable; el archivo binario es solo un cache)
+ */
+int packGCScans() {
+    char buffer[1024], ref[64];
+    struct GCScanHeader_struct header;
+    int capacity = 65536;
+    struct GCScan_struct *scan = (struct GCScan_struct *) malloc(capacity * sizeof(struct GCScan_struct));
+    if (scan == NULL) bye("Out of memory!\n");
+
+    logPrintf("Packing scanned GC pages into %s... ", GC_SCAN_PACK);
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GC_SCAN_MAGIC, 8);
+    header.pages = GC_SCAN_PAGES;
+    header.count = 0;
+    header.modified[0] = -1;
+    header.firstRecord[0] = 0;
+    for (int page = 1; page <= GC_SCAN_PAGES; page++) {
+        char filename[64];
+        header.firstRecord[page] = header.count;
+        header.modified[page] = scanPageModified(page);
+        snprintf(filename, 64, "scans/rnao14_page%d.csv", page);
+        FILE *stream = fopen(filename, "rt");
+        if (stream == NULL) continue;
+
+        while (fgets(buffer, 1023, stream) != NULL) {
+            int gcRef;
+            if (!parseGCScanLine(buffer, &gcRef, ref)) continue;
+
+            if (header.count == capacity) {
+                capacity *= 2;
+                scan = (struct GCScan_struct *) realloc(scan, capacity * sizeof(struct GCScan_struct));
+                if (scan == NULL) bye("Out of memory!\n");
+            }
+            struct GCScan_struct *record = &scan[header.count++];
+            memset(record, 0, sizeof(struct GCScan_struct));
+            record->gcRef = gcRef;
+            record->page = page;
+
+            /* el catalogo referido es el prefijo hasta el primer punto (inclusive) */
+            char *dot = strchr(ref, '.');
+            int length = dot != NULL ? dot - ref + 1 : 0;
+            if (length > 0 && length < 8) {
+                memcpy(record->tag, ref, length);
+                record->numRef = atoi(&ref[length]);
+            }
+        }
+        fclose(stream);
+    }
+    header.firstRecord[GC_SCAN_PAGES + 1] = header.count;
+
+    /* se escribe en un temporal y se renombra, para no dejar un paquete a medias */
+    char tmpname[64];
+    snprintf(tmpname, 64, "%s.tmp", GC_SCAN_PACK);
+    FILE *stream = fopen(tmpname, "wb");
+    if (stream == NULL) {
+        perror("Cannot write packed GC scans");
+        exit(1);
+    }
+    if (fwrite(&header, sizeof(header), 1, stream) != 1 ||
+        (header.count > 0 && fwrite(scan, sizeof(struct GCScan_struct), header.count, stream) != (size_t) header.count)) {
+        perror("Cannot write packed GC scans");
+        exit(1);
+    }
+    fclose(stream);
+    if (rename(tmpname, GC_SCAN_PACK) != 0) {
+        perror("Cannot write packed GC scans");
+        exit(1);
+    }
+    free(scan);
+    logPrintf("done (%d rows)!\n", header.count);
+    return header.count;
+}
+
+/*
+ * mapGCScans - mapea GC_SCAN_PACK; devuelve NULL si no existe, es invalido o esta desactualizado
+ * (el mapeo se mantiene hasta el fin del programa)
+ */
+static const struct GCScanHeader_struct *mapGCScans() {
+    int fd = open(GC_SCAN_PACK, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(struct GCScanHeader_struct)) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    const struct GCScanHeader_struct *header = (const struct GCScanHeader_struct *) data;
+    bool valid = memcmp(header->magic, GC_SCAN_MAGIC, 8) == 0 && header->pages == GC_SCAN_PAGES &&
+        (size_t) info.st_size == sizeof(struct GCScanHeader_struct) + header->count * sizeof(struct GCScan_struct);
+    for (int page = 1; valid && page <= GC_SCAN_PAGES; page++) {
+        if (scanPageModified(page) != header->modified[page]) valid = false;
+    }
+    if (!valid) {
+        munmap(data, info.st_size);
+        return NULL;
+    }
+    return header;
+}
+
+/*
+ * loadGCScans - devuelve las filas de las paginas escaneadas de GC (empaquetando si hace falta)
+ */
+const struct GCScan_struct *loadGCScans(int *count) {
+    const struct GCScanHeader_struct *header = mapGCScans();
+    if (header == NULL) {
+        packGCScans();
+        header = mapGCScans();
+        if (header == NULL) bye("Cannot read packed GC scans!\n");
+    }
+    *count = header->count;
+    return (const struct GCScan_struct *) (header + 1);
+}
+
 /*
  * parseSOMLine - parsea una fila de los "Standards of Magnitude" de la UA
  */
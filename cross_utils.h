@@ -21,6 +21,10 @@ struct CrossStats {
     int errors = 0;
 };
 
+/* suma a total los contadores de part, excepto errors (en etapas procesadas por
+   partes, las advertencias se numeran al volcar cada sumidero, ver flushLogSink) */
+void addCrossStats(struct CrossStats *total, const struct CrossStats *part);
+
 /* referencia a un catalogo almacenado en memoria (arreglos paralelos) */
 struct StarList {
     int *count;
@@ -28,9 +32,33 @@ struct StarList {
     double *x, *y, *z;
 };
 
+/* etapa de cross_north / cross_south: corre con su propio almacen PPM (que
+   preparePPM carga a la epoca que necesite) y, con varios hilos, a la par de
+   las etapas de las que no depende */
+struct CrossStage {
+    const char *name;
+    void (*run)();
+    const char *after; /* etapas previas cuyas listas usa (ver TaskNode en parallel.h) */
+};
+
+/* ejecuta las etapas segun sus dependencias; la salida queda en el orden del arreglo */
+void runCrossStages(struct CrossStage *stages, int count);
+
+/* lectura inicial de catalogos (CD, CPD, PPM, GC...): como runCrossStages, pero cada
+   lectura queda en el almacen por defecto; en "after" van los cruces que la requieren
+   (p.ej. crossCPD despues de CD y CPD) */
+void runCatalogLoads(struct CrossStage *loads, int count);
+
 /* lee PPM a la epoca dada y lo deja ordenado; devuelve la estructura */
 struct PPMstar_struct *preparePPM(double epoch, bool discardSouth);
 
+/* identificacion inyectiva por maxima verosimilitud (ver cross_match.h): lado B
+   armado con el PPM del hilo actual, y resumen del resultado (por ahora solo en cross_gc) */
+struct MatchSide_struct;
+struct MatchResult_struct;
+void ppmMatchSide(struct MatchSide_struct *side);
+void printMatchStats(const char *nameA, const char *nameB, int countA, const struct MatchResult_struct *result);
+
 /* lee ascension recta en horas (col, 2), minutos (col+2, 2) y segundos
    (col+4, 4, en centesimas); devuelve grados */
 double readRAField(char *buffer, int col, int *RAh, int *RAm, int *RAs);
@@ -116,9 +144,6 @@ void warnAlone(int *errors, const char *warnDesc, const char *registerDesc, cons
 void warnAlonePPMGSC(int *errors, const char *warnDesc, char *catName,
     int RAs, double decl, int Decls, int ppmRef, double nearestPPMDistance);
 
-/* almacena una estrella no identificada (pero hallada en GSC) */
-void writeUnidentified(FILE *stream, const char *catName, double x, double y, double z);
-
 /* imprime los RSME acumulados */
 void printRSMEDist(const struct CrossStats *stats);
 void printRSMEMag(const struct CrossStats *stats);
@@ -133,6 +158,26 @@ void checkPrecessionDecl(double preDecl, const char *srcName, const char *catLin
    false si no hay referencia confiable */
 bool parseGCScanLine(char *buffer, int *gcRef, char *ref);
 
+/* paginas escaneadas de GC (scans/rnao14_page<n>.csv) y su version empaquetada */
+#define GC_SCAN_PAGES 616
+#define GC_SCAN_PACK "scans/rnao14_pages.bin"
+
+/* fila de una pagina escaneada de GC ya parseada */
+struct GCScan_struct {
+    int gcRef; /* numero GC (1a columna) */
+    int page; /* pagina del RNAO 14 */
+    char tag[8]; /* catalogo referido, p.ej. "Ll." u "OA." ("" si no se reconoce) */
+    int numRef; /* numero en el catalogo referido */
+};
+
+/* empaqueta las filas con referencia de las paginas escaneadas de GC en
+   GC_SCAN_PACK (en el orden de pagina y fila); devuelve la cantidad */
+int packGCScans();
+
+/* devuelve las filas empaquetadas (mapeadas en memoria), re-empaquetando
+   si algun CSV cambio desde que se genero GC_SCAN_PACK */
+const struct GCScan_struct *loadGCScans(int *count);
+
 /* parsea una fila de cat/UA_standards.csv:
    number,name,ra_h,ra_m,ra_s,dec_d,dec_m,mag,BD_num,BD_mag,
    Lal_num,Lal_mag,WB_num,WB_mag,ARGEL,Albany,HEIS
@@ -14,8 +14,9 @@
 
 // #define FAKE_GSC    // uncomment this line to avoid using "gsc" tool
 
-static char gscId[16];
-static double dist;
+/* resultado de la ultima busqueda (por hilo, ya que las etapas pueden correr en paralelo) */
+static thread_local char gscId[16];
+static thread_local double dist;
 
 /*
  * getGSCId - returns the last found GSC identifier
@@ -80,7 +81,7 @@ bool findGSCStar(double RA, double Decl, double epoch, double minDistanceOutput)
     // Execute GSC tool
     pipe = popen(command, "r");
     if (pipe == nullptr) {
-        printf("Warning: Could not execute GSC tool\n");
+        logPrintf("Warning: Could not execute GSC tool\n");
         return false;
     }
     
@@ -1,19 +1,22 @@
 
 /*
  * GEN_TYCHO2 - Genera una identificación cruzada entre Tycho-2 y catálogos antiguos
- * El flag isCD() determina si es para el hemiferio norte o sur (en J2000)
- * Para el hemisferio norte en J2000, primero se utiliza PPM y luego BD (pero solo,
+ * Tycho-2 se lee una sola vez y cada estrella se deriva a los "cielos" de su
+ * hemisferio (en J2000), cada uno con sus catálogos, identificaciones y salidas.
+ * Para el hemisferio norte, primero se utiliza PPM y luego BD (pero solo,
  * hasta la declinación +19, esto quiere decir que de la declinación +20 en adelante
  * solo se reportan las estrellas de BD cruzadas con PPM).
- * Para el hemisferio sur en J2000, primero se utiliza PPM y luego CD (obsérvese que
+ * Para el hemisferio sur, primero se utiliza PPM y luego CD (obsérvese que
  * no están BD/SD por lo que sólo se mencionan estos catálogos a través de la
  * identificación cruzada con PPM). Por otra parte, se utilizan las identificaciones
  * del Catálogo General Argentino (GC), Oeltzen-Argelander (OA) y las de Gilliss (G).
- * 
+ *
  * También hay una versión alternativa para el hemisferio Sur (sólo declinaciones -22
  * a -31) donde se generan tres archivos CSV, el primero con las estrellas de CD simples,
- * el segundo con las CD dobles y el tercero con las de color. 
- * 
+ * el segundo con las CD dobles y el tercero con las de color.
+ *
+ * Uso: gen_tycho2 [north] [south] [south_alt] (sin argumentos se generan los tres)
+ *
  * Made in 2024 by Daniel E. Severin
  */
 
@@ -27,6 +30,8 @@
 #include "read_ppm.h"
 #include "trig.h"
 #include "misc.h"
+#include "parallel.h"
+#include "read_cross.h"
 
 /* Para uso de la libreria WCS: */
 #define WCS_J2000 1 /* J2000(FK5) right ascension and declination */
@@ -40,132 +45,143 @@ extern "C" void wcsconp(int sys1, int sys2, double eq1, double eq2, double ep1,
 #define THRESHOLD_CPD 30.0
 #define THRESHOLD_CD 45.0
 #define DIST_PPM_TYC 10.0
-#define DIST_CPD_TYC 30.0 
+#define DIST_CPD_TYC 30.0
 #define DIST_DM_TYC 60.0
 #define DIST_UN_TYC 15.0
 
-// Nombres alternativos para BD/CD y CPD, también atributos de CD
-char dmStringDM[MAXDMSTAR][STRING_SIZE];
-bool dmIsColor[MAXDMSTAR];
-bool dmIsDouble[MAXDMSTAR];
-char dmStringCPD[MAXCPDSTAR][STRING_SIZE];
-char dmStringSD[MAXSDSTAR][STRING_SIZE];
-
-// Datos para estrellas no identificadas
-char unidentifiedName[MAXUNSTAR][STRING_SIZE];
-double unidentifiedX[MAXUNSTAR];
-double unidentifiedY[MAXUNSTAR];
-double unidentifiedZ[MAXUNSTAR];
-bool alsoUnidentifiedFromTYC[MAXUNSTAR];
-int countUnidentified = 0; 
+// Nombres alternativos para CPD y SD (designaciones empaquetadas, ver misc.h),
+// dimensionados según los catálogos leídos, en la arena namesArena
+static struct Arena_struct namesArena;
+unsigned long long *dmNameCPD;
+unsigned long long *dmNameSD;
+
+// Índice por zonas de declinación (1 grado) de las no identificadas: las de la
+// zona z son unByZone[unZone[z]..unZone[z+1]-1], en orden creciente de índice
+#define UN_ZONES 180
+
+/* Cielos que se generan en una misma lectura de Tycho-2 */
+#define SKY_NORTH 0
+#define SKY_SOUTH 1
+#define SKY_SOUTH_ALT 2
+#define SKIES 3
+
+/* Cielo: hemisferio con sus catálogos, identificaciones, salidas y log */
+struct TYCsky {
+    const char *name; /* "north", "south" o "south_alt" */
+    bool enabled;
+    bool north; /* hemisferio norte: BD en coordenadas 1855 */
+    bool alternative; /* CD simples, color y dobles (sin PPM, SD, CPD ni cat1875) */
+    struct DMstore_struct *dm;
+    const char *dmFile; /* catálogo BD/CD que se lee en dm */
+    // Nombres alternativos para BD/CD y PPM, también atributos de CD (en namesArena)
+    unsigned long long *dmNameDM;
+    bool *dmIsColor;
+    bool *dmIsDouble;
+    unsigned long long *ppmName; /* designación DM de cada PPM, o DESIG_NONE */
+    // Datos para estrellas no identificadas
+    unsigned long long unidentifiedName[MAXUNSTAR];
+    double unidentifiedX[MAXUNSTAR];
+    double unidentifiedY[MAXUNSTAR];
+    double unidentifiedZ[MAXUNSTAR];
+    bool alsoUnidentifiedFromTYC[MAXUNSTAR];
+    int countUnidentified;
+    int unZone[UN_ZONES + 1];
+    int unByZone[MAXUNSTAR];
+    // Salidas: cruzamientos (tres solo en la alternativa), cat1875 y log
+    FILE *crossStreams[3];
+    FILE *catStream;
+    FILE *log; /* se vuelca a stdout al terminar, un cielo a continuación del otro */
+    char *logText;
+    size_t logSize;
+};
+
+static struct TYCsky skies[SKIES];
 
 /*
- * readCrossFile - lee archivos de identificaciones cruzadas en formato CSV
+ * openCrossCSV - lee un archivo de identificaciones cruzadas (aborta si no puede leerse)
  */
-void readCrossFile(
-        const char *ppm_file, struct PPMstar_struct *PPMstar, int PPMstars,
-        const char *cd_file, struct DMstar_struct *DMstar, int DMstars,
-        const char *cpd_file, struct CPDstar_struct *CPDstar, int CPDstars) {
-    char buffer[1024], targetRef[STRING_SIZE], code[4];
-    int ppmRef, cdDeclRef, cdNumRef, cpdDeclRef, cpdNumRef;
-    float vmag, minDistance;
+void openCrossCSV(const char *file, struct CrossFile_struct *crossFile) {
+    char buffer[1024];
 
-    /* read cross file between PPM and target */
-    printf("Reading cross file %s... ", ppm_file);
-    FILE *stream = fopen(ppm_file, "rt");
-    if (stream == NULL) {
-        snprintf(buffer, 1024, "Cannot read %s", ppm_file);
+    printf("Reading cross file %s... ", file);
+    if (!readCrossCSV(file, crossFile)) {
+        snprintf(buffer, 1024, "Cannot read %s", file);
         perror(buffer);
         exit(1);
     }
-    bool first_line = true;
-    while (fgets(buffer, 1023, stream) != NULL) {
-        if (first_line) {
-            // omit first line (header)
-            first_line = false;
-            continue;
-        }
-        sscanf(buffer, "%13[^,],%3s %d,%f,%f\n", targetRef, code, &ppmRef, &vmag, &minDistance);
-        if (strcmp(code, "PPM") != 0) continue;
+}
+
+/*
+ * internTargetRef - interna la designación del catálogo destino (a lo sumo STRING_SIZE - 1 caracteres)
+ */
+unsigned long long internTargetRef(const char *targetRef) {
+    char name[STRING_SIZE];
+    strncpy(name, targetRef, STRING_SIZE - 1);
+    name[STRING_SIZE - 1] = 0;
+    return internDesignation(name);
+}
+
+/*
+ * readCrossFile - lee archivos de identificaciones cruzadas en formato CSV
+ * y renombra las PPM, CD y CPD del cielo (los de CD y CPD son optativos: "")
+ */
+void readCrossFile(struct TYCsky *sky, const char *ppm_file, const char *cd_file, const char *cpd_file) {
+    struct CrossFile_struct crossFile;
+    int DMstars = getDMStoreStars(sky->dm);
+
+    /* read cross file between PPM and target */
+    openCrossCSV(ppm_file, &crossFile);
+    for (int e = 0; e < crossFile.entries; e++) {
+        struct CrossEntry_struct *entry = &crossFile.entry[e];
+        if (entry->catalog2 != CROSS_PPM) continue;
 
-        // printf("Cross: %s, PPM %d, dist = %.1f arcsec.\n", targetRef, ppmRef, minDistance);
-        if (minDistance < __FLT_EPSILON__ || minDistance > THRESHOLD_PPM) {
+        // printf("Cross: %s, PPM %d, dist = %.1f arcsec.\n", entry->index1, entry->numRef2, entry->dist);
+        if (entry->dist < __FLT_EPSILON__ || entry->dist > THRESHOLD_PPM) {
             // omit identifications with zero distance (bug) or too far away
             continue;
         }
-        for (int i = 0; i < PPMstars; i++) {
-            if (PPMstar[i].ppmRef == ppmRef) {
-                strncpy(PPMstar[i].dmString, targetRef, STRING_SIZE);
-                break;
-            }
-        }
+        int i = getPPMindex(entry->numRef2);
+        if (i != -1) sky->ppmName[i] = internTargetRef(entry->index1);
     }
-    fclose(stream);
+    freeCrossCSV(&crossFile);
     printf("done!\n");
 
-    /* read cross file between CPD and target (optative) */
-    if (CPDstars != 0) {
-        printf("Reading cross file %s... ", cpd_file);
-        stream = fopen(cpd_file, "rt");
-        if (stream == NULL) {
-            snprintf(buffer, 1024, "Cannot read %s", cpd_file);
-            perror(buffer);
-            exit(1);
-        }
-        first_line = true;
-        while (fgets(buffer, 1023, stream) != NULL) {
-            if (first_line) {
-                // omit first line (header)
-                first_line = false;
-                continue;
-            }
-            sscanf(buffer, "%13[^,],CPD %d°%d,%f\n", targetRef, &cpdDeclRef, &cpdNumRef, &minDistance);
-            // printf("Cross: %s, CPD %d°%d, dist = %.1f arcsec.\n", targetRef, cpdDeclRef, cpdNumRef, minDistance);
-            if (minDistance < __FLT_EPSILON__ || minDistance > THRESHOLD_CPD) {
+    /* read cross file between CPD and target (optative)
+     * Nota: para CPD y CD el umbral se aplica sobre la 3ra columna, como se hizo siempre. */
+    if (cpd_file[0] != 0 && getCPDStars() != 0) {
+        openCrossCSV(cpd_file, &crossFile);
+        for (int e = 0; e < crossFile.entries; e++) {
+            struct CrossEntry_struct *entry = &crossFile.entry[e];
+            if (entry->catalog2 != CROSS_CPD) continue;
+
+            // printf("Cross: %s, CPD %d°%d, dist = %.1f arcsec.\n", entry->index1, entry->declRef2, entry->numRef2, entry->mag);
+            if (entry->mag < __FLT_EPSILON__ || entry->mag > THRESHOLD_CPD) {
                 // omit identifications with zero distance (bug) or too far away
                 continue;
             }
-            for (int i = 0; i < DMstars; i++) {
-                if (CPDstar[i].declRef == cpdDeclRef && CPDstar[i].numRef == cpdNumRef) {
-                    strncpy(dmStringCPD[i], targetRef, STRING_SIZE);
-                    break;
-                }
-            }
+            int i = getCPDindex(entry->declRef2, entry->numRef2);
+            if (i != -1 && i < DMstars) dmNameCPD[i] = internTargetRef(entry->index1);
         }
-        fclose(stream);
+        freeCrossCSV(&crossFile);
         printf("done!\n");
     }
 
     /* read cross file between CD and target (optative) */
-    if (DMstars != 0) {
-        printf("Reading cross file %s... ", cd_file);
-        stream = fopen(cd_file, "rt");
-        if (stream == NULL) {
-            snprintf(buffer, 1024, "Cannot read %s", cd_file);
-            perror(buffer);
-            exit(1);
-        }
-        first_line = true;
-        while (fgets(buffer, 1023, stream) != NULL) {
-            if (first_line) {
-                // omit first line (header)
-                first_line = false;
-                continue;
-            }
-            sscanf(buffer, "%13[^,],CD %d°%d,%f\n", targetRef, &cdDeclRef, &cdNumRef, &minDistance);
-            // printf("Cross: %s, CD %d°%d, dist = %.1f arcsec.\n", targetRef, cdDeclRef, cdNumRef, minDistance);
-            if (minDistance < __FLT_EPSILON__ || minDistance > THRESHOLD_CD) {
+    if (cd_file[0] != 0 && DMstars != 0) {
+        openCrossCSV(cd_file, &crossFile);
+        for (int e = 0; e < crossFile.entries; e++) {
+            struct CrossEntry_struct *entry = &crossFile.entry[e];
+            if (entry->catalog2 != CROSS_CD) continue;
+
+            // printf("Cross: %s, CD %d°%d, dist = %.1f arcsec.\n", entry->index1, entry->declRef2, entry->numRef2, entry->mag);
+            if (entry->mag < __FLT_EPSILON__ || entry->mag > THRESHOLD_CD) {
                 // omit identifications with zero distance (bug) or too far away
                 continue;
             }
-            for (int i = 0; i < DMstars; i++) {
-                if (DMstar[i].declRef == cdDeclRef && DMstar[i].numRef == cdNumRef) {
-                    strncpy(dmStringDM[i], targetRef, STRING_SIZE);
-                    break;
-                }
-            }
+            int i = getDMStoreIndex(sky->dm, true, entry->declRef2, entry->numRef2);
+            if (i != -1) sky->dmNameDM[i] = internTargetRef(entry->index1);
         }
-        fclose(stream);
+        freeCrossCSV(&crossFile);
         printf("done!\n");
     }
 }
@@ -173,7 +189,7 @@ void readCrossFile(
 /*
  * readUnidentifiedFile - lee archivos de estrellas no identificadas
  */
-void readUnidentifiedFile(const char *file) {
+void readUnidentifiedFile(struct TYCsky *sky, const char *file) {
     char buffer[1024];
     char targetRef[STRING_SIZE];
     double x, y, z;
@@ -195,62 +211,118 @@ void readUnidentifiedFile(const char *file) {
         sscanf(buffer, "%13[^,],%lf,%lf,%lf\n", targetRef, &x, &y, &z);
         // printf("Unidentified: %s -> (%.8f, %.8f, %.8f)\n", targetRef, x, y, z);
 
-        if (countUnidentified >= MAXUNSTAR) {
+        int count = sky->countUnidentified;
+        if (count >= MAXUNSTAR) {
             printf("Error: too many unidentified stars.\n");
             exit(1);
         }
-        strncpy(unidentifiedName[countUnidentified], targetRef, STRING_SIZE);
-        unidentifiedX[countUnidentified] = x;
-        unidentifiedY[countUnidentified] = y;
-        unidentifiedZ[countUnidentified] = z;
-        alsoUnidentifiedFromTYC[countUnidentified] = true;
-        countUnidentified++;
+        sky->unidentifiedName[count] = internDesignation(targetRef);
+        sky->unidentifiedX[count] = x;
+        sky->unidentifiedY[count] = y;
+        sky->unidentifiedZ[count] = z;
+        sky->alsoUnidentifiedFromTYC[count] = true;
+        sky->countUnidentified++;
     }
     fclose(stream);
     printf("done!\n");
 }
 
 /*
- * main - comienzo de la aplicacion
+ * declZone - zona de declinación (de 1 grado) a la que pertenece Decl
  */
-int main(int argc, char** argv) {
-    char buffer[1024];
-    char cell[256];
+int declZone(double Decl) {
+    int zone = (int) floor(Decl) + 90;
+    if (zone < 0) return 0;
+    if (zone >= UN_ZONES) return UN_ZONES - 1;
+    return zone;
+}
 
-    /* leemos catalogo BD/CD */
-#ifdef ALTERNATIVE
-    readDM("cat/cd_vol1_curated.txt");
-#else    
-    readDM(isCD() ? "cat/cd_curated.txt" : "cat/bd_curated.txt");
-#endif
-    struct DMstar_struct *DMstar = getDMStruct();
-    int DMstars = getDMStars();
-    bool is_north = !isCD();
+/*
+ * indexUnidentified - arma el índice por zonas de declinación de las no identificadas
+ */
+void indexUnidentified(struct TYCsky *sky) {
+    int zoneOf[MAXUNSTAR];
+
+    for (int z = 0; z <= UN_ZONES; z++) sky->unZone[z] = 0;
+    for (int i = 0; i < sky->countUnidentified; i++) {
+        double RA, Decl;
+        rec2sph(sky->unidentifiedX[i], sky->unidentifiedY[i], sky->unidentifiedZ[i], &RA, &Decl);
+        zoneOf[i] = declZone(Decl);
+        sky->unZone[zoneOf[i] + 1]++;
+    }
+    for (int z = 0; z < UN_ZONES; z++) sky->unZone[z + 1] += sky->unZone[z];
+    int next[UN_ZONES];
+    for (int z = 0; z < UN_ZONES; z++) next[z] = sky->unZone[z];
+    for (int i = 0; i < sky->countUnidentified; i++) {
+        sky->unByZone[next[zoneOf[i]]++] = i;
+    }
+}
+
+/*
+ * loadSkyDM - lee el catálogo BD/CD de un cielo (tarea de la carga inicial)
+ */
+static void loadSkyDM(void *context) {
+    struct TYCsky *sky = (struct TYCsky *) context;
+    readDMStore(sky->dm, sky->dmFile);
+}
+
+/*
+ * loadCPDTask - lee CPD sin cruzarlo con CD (tarea de la carga inicial)
+ */
+static void loadCPDTask(void *context) {
+    loadCPD(false);
+}
+
+/*
+ * loadSDTask - lee SD sin cruzarlo con CD (tarea de la carga inicial)
+ */
+static void loadSDTask(void *context) {
+    readSD(false);
+}
+
+/*
+ * loadPPMTask - lee PPM (2000 en B1950) y lo ordena (tarea de la carga inicial)
+ */
+static void loadPPMTask(void *context) {
+    readPPM(false, true, false, false, 2000.0);
+    sortPPM();
+}
+
+/*
+ * addLoad - agrega una lectura a la carga inicial (sin dependencias: ninguna se cruza con otra)
+ */
+static void addLoad(struct TaskNode *loads, int *count, const char *name, void (*task)(void *context), void *context) {
+    memset(&loads[*count], 0, sizeof(struct TaskNode));
+    loads[*count].name = name;
+    loads[*count].task = task;
+    loads[*count].context = context;
+    (*count)++;
+}
+
+/*
+ * prepareSky - genera los identificadores del catálogo BD/CD ya leído de un cielo
+ */
+void prepareSky(struct TYCsky *sky, int dmCat) {
+    struct DMstar_struct *DMstar = getDMStoreStruct(sky->dm);
+    int DMstars = getDMStoreStars(sky->dm);
 
     /* generamos identificadores de DM */
+    sky->dmNameDM = (unsigned long long *) allocArena(&namesArena, (size_t) DMstars * sizeof(unsigned long long));
+    sky->dmIsColor = (bool *) allocArena(&namesArena, (size_t) DMstars * sizeof(bool));
+    sky->dmIsDouble = (bool *) allocArena(&namesArena, (size_t) DMstars * sizeof(bool));
     for (int i = 0; i < DMstars; i++) {
-#ifdef ALTERNATIVE
-        const char *dmCat = "";
-#else       
-        const char *dmCat = isCD() ? "CD " : "BD ";
-#endif
-        snprintf(dmStringDM[i], STRING_SIZE, "%s%c%d°%d",
-                dmCat,
-                DMstar[i].signRef ? '-' : '+',
-                abs(DMstar[i].declRef),
-                DMstar[i].numRef);
-        dmIsColor[i] = false;
-        dmIsDouble[i] = false;
-    }
-
-    struct CPDstar_struct *CPDstar = nullptr;
-    int CPDstars = 0;
-    struct SDstar_struct *SDstar = nullptr;
-    int SDstars = 0;
-    struct PPMstar_struct *PPMstar = nullptr;
-    int PPMstars = 0;
-#ifdef ALTERNATIVE
-    /* leemos atributos de color y dobles */
+        sky->dmNameDM[i] = makeDesignation(dmCat, DMstar[i].signRef, abs(DMstar[i].declRef), DMstar[i].numRef, ' ');
+        sky->dmIsColor[i] = false;
+        sky->dmIsDouble[i] = false;
+    }
+}
+
+/*
+ * readColorAndDoubles - lee atributos de color y dobles de CD (cielo alternativo)
+ */
+void readColorAndDoubles(struct TYCsky *sky) {
+    char buffer[1024];
+
     for (int decl = 22; decl <= 31; decl++) {
         int cdRef;
         // Color
@@ -264,8 +336,8 @@ int main(int argc, char** argv) {
         while (fgets(buffer, 1023, stream) != NULL) {
             sscanf(buffer, "%d\n", &cdRef);
             if (cdRef == 0) continue;
-            int index = getDMindex(true, decl, cdRef);
-            dmIsColor[index] = true;
+            int index = getDMStoreIndex(sky->dm, true, decl, cdRef);
+            sky->dmIsColor[index] = true;
         }
         fclose(stream);
         // Dobles
@@ -279,403 +351,776 @@ int main(int argc, char** argv) {
         while (fgets(buffer, 1023, stream) != NULL) {
             sscanf(buffer, "%d\n", &cdRef);
             if (cdRef == 0) continue;
-            int index = getDMindex(true, decl, cdRef);
-            dmIsDouble[index] = true;
+            int index = getDMStoreIndex(sky->dm, true, decl, cdRef);
+            sky->dmIsDouble[index] = true;
         }
         fclose(stream);
     }
-#else
-    /* leemos catalogos CPD y SD (en caso de ubicarnos en el Sur) */
-    if (!is_north) {
-        readCPD(false, false);
-        CPDstar = getCPDStruct();
-        CPDstars = getCPDStars();
+}
 
-        /* generamos identificadores de CPD */
-        for (int i = 0; i < CPDstars; i++) {
-            snprintf(dmStringCPD[i], STRING_SIZE, "CPD %d°%d",
-                CPDstar[i].declRef,
-                CPDstar[i].numRef);
-        }
+/* Destino de cada estrella Tycho-2 luego de procesarla */
+#define TYC_SKIPPED 0       /* fuera del hemisferio */
+#define TYC_PPM 1           /* DM dada por PPM */
+#define TYC_OTHER 2         /* estrella no identificada de otro catalogo */
+#define TYC_DM 3
+#define TYC_SD 4
+#define TYC_CPD 5
+#define TYC_UNIDENTIFIED 6
 
-        readSD(false);
-        SDstar = getSDStruct();
-        SDstars = getSDStars();
+/* Estrella Tycho-2 convertida a las épocas de cada catálogo (etapa de transformación) */
+struct TYCcoords {
+    bool north, south; /* hemisferios generados a los que pertenece (en J2000) */
+    char tycString[20];
+    double tycVmag;
+    double x2000, y2000, z2000, decl2000; /* 2000.0 (B1950) para PPM */
+    double x, y, z, decl; /* 1875 (CD, SD, CPD, no identificadas) */
+    double xDM, yDM, zDM, declDM; /* 1855 para BD (solo hemisferio norte) */
+};
 
-        /* generamos identificadores de SD */
-        for (int i = 0; i < SDstars; i++) {
-            snprintf(dmStringSD[i], STRING_SIZE, "SD %d°%d",
-                SDstar[i].declRef,
-                SDstar[i].numRef);
-        }
-    }
+/* Resultado de una linea de Tycho-2 en un cielo (a escribir en orden) */
+struct TYCresult {
+    int kind; /* TYC_SKIPPED, TYC_PPM, ... */
+    unsigned long long crossName; /* designacion cruzada (si la hay, ver misc.h) */
+    double crossDistance;
+    int crossStream; /* 0 = principal, 1 = color, 2 = dobles (solo cielo alternativo) */
+    bool writeCatalog; /* true si se escribe registro en el archivo cat1875 */
+    int catPPMRef; /* PPM usada en el registro cat1875, o 0 si se usa TYC */
+    double catVmag; /* magnitud del registro cat1875 */
+};
 
-    /* leemos catalogo PPM (2000 en B1950) */
-    readPPM(false, true, false, false, 2000.0);
-    sortPPM();
-    PPMstar = getPPMStruct();
-    PPMstars = getPPMStars();
+/* Contadores de estrellas identificadas */
+struct TYCcounters {
+    int starsPPM;
+    int starsDM;
+    int starsCPD;
+    int starsSD;
+    int starsOther;
+    int unidentified;
+};
 
-    if (isCD()) {
-        /* leemos identificaciones cruzadas y renombramos designaciones.
-         * Order de prioridad: UA, Lal, Lac, GC, ZC, OA (South), U, G, WB
-         * Nota: para UA, Lal, Lac y WB son contra PPM (no hay identificaciones cruzadas con CD/CPD). */
-        readCrossFile(
-            "results/cross/cross_wb_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readCrossFile(
-            "results/cross/cross_gilliss_ppm.csv", PPMstar, PPMstars,
-            "results/cross/cross_gilliss_cd.csv", DMstar, DMstars,
-            "results/cross/cross_gilliss_cpd.csv", CPDstar, CPDstars);
-        readCrossFile(
-            "results/cross/cross_usno_ppm.csv", PPMstar, PPMstars,
-            "results/cross/cross_usno_cd.csv", DMstar, DMstars,
-            "results/cross/cross_usno_cpd.csv", CPDstar, CPDstars);
-        readCrossFile(
-            "results/cross/cross_oa_ppm.csv", PPMstar, PPMstars,
-            "results/cross/cross_oa_cd.csv", DMstar, DMstars,
-            "results/cross/cross_oa_cpd.csv", CPDstar, CPDstars);
-        readCrossFile(
-            "results/cross/cross_zc_ppm.csv", PPMstar, PPMstars,
-            "results/cross/cross_zc_cd.csv", DMstar, DMstars,
-            "results/cross/cross_zc_cpd.csv", CPDstar, CPDstars);
-        readCrossFile(
-            "results/cross/cross_gc_ppm.csv", PPMstar, PPMstars,
-            "results/cross/cross_gc_cd.csv", DMstar, DMstars,
-            "results/cross/cross_gc_cpd.csv", CPDstar, CPDstars);
-        readCrossFile(
-            "results/cross/cross_lalande_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readCrossFile(
-            "results/cross/cross_lacaille_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readCrossFile(
-            "results/cross/cross_ua_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        /* también leemos las no identificadas */
-        readUnidentifiedFile("results/cross/gc_unidentified.csv");
-        readUnidentifiedFile("results/cross/zc_unidentified.csv");
-        readUnidentifiedFile("results/cross/oa_unidentified.csv");
-        readUnidentifiedFile("results/cross/usno_unidentified.csv");
-        readUnidentifiedFile("results/cross/gilliss_unidentified.csv");
+/* Bloque de lineas consecutivas de un mismo archivo Tycho-2 */
+#define CHUNK_LINES 4096
+struct TYCchunk {
+    int sequence; /* posición del bloque en la lectura */
+    bool supplement; /* true si las lineas provienen de tyc2_suppl.txt */
+    bool firstOfMain; /* true si es el primer bloque de tyc2.txt */
+    int lines;
+    char *text; /* lineas concatenadas, cada una terminada en 0 */
+    int textSize, textCapacity;
+    int offset[CHUNK_LINES];
+    struct TYCcoords coords[CHUNK_LINES];
+    struct TYCresult result[SKIES][CHUNK_LINES];
+    bool touched[SKIES][MAXUNSTAR]; /* no identificadas con alguna TYC cerca */
+};
+
+/*
+ * transformTYCLine - parsea una linea de Tycho-2 y la convierte a las épocas de los catálogos
+ * Deja la designación, magnitud y coordenadas en "coords"; si la estrella no es
+ * de ningún hemisferio generado, coords->north y coords->south quedan en false.
+ */
+void transformTYCLine(char *buffer, bool readSupplement, struct TYCcoords *coords) {
+    char cell[256];
+
+    /* lee declinación y descarta tempranamente */
+    readField(buffer, cell, readSupplement ? 29 : 166, 12);
+    double Decl = atof(cell);
+    coords->north = skies[SKY_NORTH].enabled && Decl >= 0;
+    coords->south = (skies[SKY_SOUTH].enabled || skies[SKY_SOUTH_ALT].enabled) && Decl <= 0;
+    if (!coords->north && !coords->south) return;
+
+    /* lee numeración */
+    readField(buffer, cell, 1, 4);
+    int tyc1Ref = atoi(cell);
+    readField(buffer, cell, 6, 5);
+    int tyc2Ref = atoi(cell);
+    readField(buffer, cell, 12, 1);
+    int tyc3Ref = atoi(cell);
+
+    snprintf(coords->tycString, 20, "TYC %d-%d-%d", tyc1Ref, tyc2Ref, tyc3Ref);
+
+    /* lee RA y Decl (epoch) */
+    readField(buffer, cell, readSupplement ? 16 : 153, 12);
+    double RA = atof(cell);
+    double epRA, epDecl, epoch;
+    if (readSupplement) {
+        epoch = 1991.25;
+        epRA = epoch;
+        epDecl = epoch;
     } else {
-        /* leemos identificaciones cruzadas y renombramos designaciones,
-         * Order: UA, Lalande, USNO, WB y OA (North) contra PPM. */
-        readCrossFile(
-            "results/cross/cross_oarn_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readCrossFile(
-            "results/cross/cross_wb_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readCrossFile(
-            "results/cross/cross_usno_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readCrossFile(
-            "results/cross/cross_lalande_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readCrossFile(
-            "results/cross/cross_ua_ppm.csv", PPMstar, PPMstars,
-            "", nullptr, 0,
-            "", nullptr, 0);
-        readUnidentifiedFile("results/cross/usno_unidentified.csv");
-    }
-#endif
-
-    FILE *stream = fopen("cat/tyc2.txt", "rt");
-    if (stream == NULL) {
-        perror("Cannot read tyc2.txt");
-        exit(1);
+        readField(buffer, cell, 179, 4);
+        epRA = atof(cell);
+        readField(buffer, cell, 184, 4);
+        epDecl = atof(cell);
+        /* la época es un promedio de las de RA y Decl */
+        epoch = 1990.0 + (epRA + epDecl) / 2.0;
     }
+    /* lee mov. propios, si los tiene */
+    double pmRA = 0.0;
+    double pmDecl = 0.0;
+    readField(buffer, cell, 14, 1);
+    if (cell[0] != readSupplement ? 'T' : 'X') {
+        readField(buffer, cell, 42, 7);
+        pmRA = atof(cell);
+        readField(buffer, cell, 50, 7);
+        pmDecl = atof(cell);
 
-    FILE *stream2 = fopen("cat/tyc2_suppl.txt", "rt");
-    if (stream2 == NULL) {
-        perror("Cannot read tyc2.txt");
-        exit(1);
+        pmRA /= 1000 * 3600 * dcos(epDecl); /* conversion de mas/yr a grados/yr (juliano) */
+        pmDecl /= 1000 * 3600; /* conversion de mas/yr a grados/yr (juliano) */
     }
 
-#ifdef ALTERNATIVE
-    FILE *crossStream = openCrossFile("tycho2/cross_tyc2_south_plain.csv");
-    FILE *crossStreamColor = openCrossFile("tycho2/cross_tyc2_south_color.csv");
-    FILE *crossStreamDpl = openCrossFile("tycho2/cross_tyc2_south_dpl.csv");
-#else
-    snprintf(buffer, 1024, "tycho2/cross_tyc2_%s.csv", is_north ? "north" : "south");
-    FILE *crossStream = openCrossFile(buffer);
-
-    snprintf(buffer, 1024, "likelihood/cat1875/%s.csv", is_north ? "north" : "south");
-    FILE *catStream = openCatalogFile(buffer);
-#endif
-
-    int TYCstarsPPM = 0;
-    int TYCstarsDM = 0;
-    int TYCstarsCPD = 0;
-    int TYCstarsSD = 0;
-    int TYCstarsOther = 0;
-    int TYCunidentified = 0;
-    int entry = 0;
-
-    printf("Starting with TYC supplementary catalog...\n");
-    bool readSupplement = true;
-    for (;;) {
-        if (readSupplement) {
-            /* lee del catálogo suplemento hasta consumirlo */
-            if (fgets(buffer, 1023, stream2) == NULL) {
-                printf("Now reading main TYC catalog...\n");
-                readSupplement = false;
-                continue;
-            }
-        } else {
-            /* lee del catálogo principal */
-            if (fgets(buffer, 1023, stream) == NULL) break;
-        }
-        // if (TYCstarsPPM > 100) break;
-		entry++;
-		if (entry % 10000 == 0) {
-			printf("Progress (%.2f%%): PPM = %d, DM = %d, SD = %d, CPD = %d, other = %d, unidentified = %d\n",
-                (100.0 * (float) entry) / 2539913.0,
-                TYCstarsPPM,
-                TYCstarsDM,
-                TYCstarsSD,
-                TYCstarsCPD,
-                TYCstarsOther,
-                TYCunidentified);
-		}
-
-        /* lee declinación y descarta tempranamente */
-        readField(buffer, cell, readSupplement ? 29 : 166, 12);
-        double Decl = atof(cell);
-        if (is_north) {
-            if (Decl < 0) continue;
-        } else {
-            if (Decl > 0) continue;
-        }
+    // printf("TYC %d-%d-%d: RA = %f, Decl = %f, pmRA = %f, pmDecl = %f, epoch = %f\n", tyc1Ref, tyc2Ref, tyc3Ref, RA, Decl, pmRA, pmDecl, epoch);
 
-        /* lee numeración */
-        readField(buffer, cell, 1, 4);
-        int tyc1Ref = atoi(cell);
-        readField(buffer, cell, 6, 5);
-        int tyc2Ref = atoi(cell);
-        readField(buffer, cell, 12, 1);
-        int tyc3Ref = atoi(cell);
-
-        char tycString[20];
-        snprintf(tycString, 20, "TYC %d-%d-%d", tyc1Ref, tyc2Ref, tyc3Ref);
-
-        /* lee RA y Decl (epoch) */
-        readField(buffer, cell, readSupplement ? 16 : 153, 12);
-        double RA = atof(cell);
-        double epRA, epDecl, epoch;
-        if (readSupplement) {
-            epoch = 1991.25;
-            epRA = epoch;
-            epDecl = epoch;
-        } else {
-            readField(buffer, cell, 179, 4);
-            epRA = atof(cell);
-            readField(buffer, cell, 184, 4);
-            epDecl = atof(cell);
-            /* la época es un promedio de las de RA y Decl */
-            epoch = 1990.0 + (epRA + epDecl) / 2.0;
-        }
-        /* lee mov. propios, si los tiene */
-        double pmRA = 0.0;
-        double pmDecl = 0.0;
-        readField(buffer, cell, 14, 1);
-        if (cell[0] != readSupplement ? 'T' : 'X') {
-            readField(buffer, cell, 42, 7);
-            pmRA = atof(cell);
-            readField(buffer, cell, 50, 7);
-            pmDecl = atof(cell);
-            
-            pmRA /= 1000 * 3600 * dcos(epDecl); /* conversion de mas/yr a grados/yr (juliano) */
-            pmDecl /= 1000 * 3600; /* conversion de mas/yr a grados/yr (juliano) */
-        }
-
-        // printf("TYC %d-%d-%d: RA = %f, Decl = %f, pmRA = %f, pmDecl = %f, epoch = %f\n", tyc1Ref, tyc2Ref, tyc3Ref, RA, Decl, pmRA, pmDecl, epoch);
+    /* convertir a 2000.0 (B1950) ya que las PPM fueron también convertidas ahí */
+    double RAtarget = RA;
+    double Decltarget = Decl;
+    double pmRAtarget = pmRA;
+    double pmDecltarget = pmDecl;
+    wcsconp(WCS_J2000, WCS_B1950, 0.0, 2000.0, epoch + 0.001278, 2000.0, &RAtarget, &Decltarget, &pmRAtarget, &pmDecltarget);
+    // printf("    RA = %f, Decl = %f, pmRA = %f, pmDecl = %f, epoch = %f\n", RAtarget, Decltarget, pmRAtarget, pmDecltarget, 2000.0);
 
-        /* convertir a 2000.0 (B1950) ya que las PPM fueron también convertidas ahí */
-        double RAtarget = RA;
-        double Decltarget = Decl;
-        double pmRAtarget = pmRA;
-        double pmDecltarget = pmDecl;
-        wcsconp(WCS_J2000, WCS_B1950, 0.0, 2000.0, epoch + 0.001278, 2000.0, &RAtarget, &Decltarget, &pmRAtarget, &pmDecltarget);
-        // printf("    RA = %f, Decl = %f, pmRA = %f, pmDecl = %f, epoch = %f\n", RAtarget, Decltarget, pmRAtarget, pmDecltarget, 2000.0);
+    /* calcula coordenadas rectangulares */
+    sph2rec(RAtarget, Decltarget, &coords->x2000, &coords->y2000, &coords->z2000);
+    coords->decl2000 = Decltarget;
 
-        /* calcula coordenadas rectangulares */
-        double x, y, z;
-        sph2rec(RAtarget, Decltarget, &x, &y, &z);
-
-        /* lee magnitud: esta magnitud habitualmente es VT y a veces es Hp, pero
-         * si además viene la componente BT entonces se puede aproximar así:
-         * V = VT - 0.090 * (BT-VT) */
-        readField(buffer, cell, readSupplement ? 97 : 124, 6);
-        double tycVmag = atof(cell);
-        if (fabs(tycVmag) > __FLT_EPSILON__) {
-            readField(buffer, cell, readSupplement ? 84 : 111, 6);
-            double BTmag = atof(cell);
-            if (fabs(BTmag) > __FLT_EPSILON__) {
-                tycVmag -= 0.090 * (BTmag - tycVmag);
-            }
+    /* lee magnitud: esta magnitud habitualmente es VT y a veces es Hp, pero
+     * si además viene la componente BT entonces se puede aproximar así:
+     * V = VT - 0.090 * (BT-VT) */
+    readField(buffer, cell, readSupplement ? 97 : 124, 6);
+    double tycVmag = atof(cell);
+    if (fabs(tycVmag) > __FLT_EPSILON__) {
+        readField(buffer, cell, readSupplement ? 84 : 111, 6);
+        double BTmag = atof(cell);
+        if (fabs(BTmag) > __FLT_EPSILON__) {
+            tycVmag -= 0.090 * (BTmag - tycVmag);
         }
+    }
+    coords->tycVmag = tycVmag;
 
-        /* halla PPM más cercana, dentro de 15 arcsec */
-        int ppmIndex = -1;
-        double minDistance = HUGE_NUMBER;
-        findPPMByCoordinates(x, y, z, Decltarget, &ppmIndex, &minDistance);
-        bool matchedPPM = (ppmIndex != -1 && minDistance < DIST_PPM_TYC);
+    /* convertir a 1875 (CD, SD, CPD, no identificadas) */
+    RAtarget = RA;
+    Decltarget = Decl;
+    pmRAtarget = pmRA;
+    pmDecltarget = pmDecl;
+    wcsconp(WCS_J2000, WCS_B1950, 0.0, 1875.0, epoch, 1875.0, &RAtarget, &Decltarget, &pmRAtarget, &pmDecltarget);
 
-        /* convertir a 1875 (CD, SD, CPD, no identificadas) */
+    /* calcula coordenadas rectangulares */
+    sph2rec(RAtarget, Decltarget, &coords->x, &coords->y, &coords->z);
+    coords->decl = Decltarget;
+
+    if (coords->north) {
+        /* convertir a 1855 (solo BD) */
         RAtarget = RA;
         Decltarget = Decl;
         pmRAtarget = pmRA;
         pmDecltarget = pmDecl;
-        wcsconp(WCS_J2000, WCS_B1950, 0.0, 1875.0, epoch, 1875.0, &RAtarget, &Decltarget, &pmRAtarget, &pmDecltarget);
+        wcsconp(WCS_J2000, WCS_B1950, 0.0, 1855.0, epoch, 1855.0, &RAtarget, &Decltarget, &pmRAtarget, &pmDecltarget);
 
         /* calcula coordenadas rectangulares */
-        sph2rec(RAtarget, Decltarget, &x, &y, &z);
+        sph2rec(RAtarget, Decltarget, &coords->xDM, &coords->yDM, &coords->zDM);
+        coords->declDM = Decltarget;
+    }
+}
+
+/*
+ * matchTYCLine - busca la identificacion en un cielo de una estrella Tycho-2 ya transformada
+ * No escribe archivos ni contadores: deja todo en "result" (puede ejecutarse en paralelo).
+ * En "touched" marca las estrellas no identificadas que tienen una TYC cerca.
+ */
+void matchTYCLine(struct TYCsky *sky, struct TYCcoords *coords, bool *touched, struct TYCresult *result) {
+    bool is_north = sky->north;
+    bool is_south = !sky->north && !sky->alternative; /* el único con PPM en cat1875, SD y CPD */
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+
+    result->kind = TYC_SKIPPED;
+    result->writeCatalog = false;
+    result->crossStream = 0;
+    if (!(is_north ? coords->north : coords->south)) return;
+    result->kind = TYC_UNIDENTIFIED;
+    double tycVmag = coords->tycVmag;
+
+    /* halla PPM más cercana, dentro de 15 arcsec (no en el cielo alternativo) */
+    int ppmIndex = -1;
+    double minDistance = HUGE_NUMBER;
+    if (!sky->alternative) {
+        findPPMByCoordinates(coords->x2000, coords->y2000, coords->z2000, coords->decl2000, &ppmIndex, &minDistance);
+    }
+    bool matchedPPM = (ppmIndex != -1 && minDistance < DIST_PPM_TYC);
 
-#ifndef ALTERNATIVE
-        /* escribe registro en archivo cat1875: si hay match PPM se usa la designación
+    /* a partir de aquí se usan coordenadas 1875 (CD, SD, CPD, no identificadas) */
+    double x = coords->x;
+    double y = coords->y;
+    double z = coords->z;
+    double Decltarget = coords->decl;
+
+    if (!sky->alternative) {
+        /* registro en archivo cat1875: si hay match PPM se usa la designación
          * PPM y, si tycVmag = 0, también la magnitud PPM; caso contrario se usa TYC */
-        const char *catName = tycString;
-        double catVmag = tycVmag;
-        char ppmCatName[20];
+        result->writeCatalog = true;
+        result->catPPMRef = 0;
+        result->catVmag = tycVmag;
         if (matchedPPM) {
-            snprintf(ppmCatName, 20, "PPM %d", PPMstar[ppmIndex].ppmRef);
-            catName = ppmCatName;
+            result->catPPMRef = PPMstar[ppmIndex].ppmRef;
             if (fabs(tycVmag) < __FLT_EPSILON__) {
-                catVmag = PPMstar[ppmIndex].vmag;
+                result->catVmag = PPMstar[ppmIndex].vmag;
             }
         }
-        writeCatalogFile(catStream, catName, x, y, z, catVmag);
-#endif
+    }
 
-        if (matchedPPM) {
-            if (PPMstar[ppmIndex].dmString[0] != 0) {
-                /* se almacena la identificación cruzada con la DM dada por PPM */
-                writeCrossEntry(crossStream, tycString, PPMstar[ppmIndex].dmString, tycVmag, minDistance);
-                TYCstarsPPM++;
-                continue;
+    if (matchedPPM) {
+        if (sky->ppmName[ppmIndex] != DESIG_NONE) {
+            /* se almacena la identificación cruzada con la DM dada por PPM */
+            result->kind = TYC_PPM;
+            result->crossName = sky->ppmName[ppmIndex];
+            result->crossDistance = minDistance;
+            return;
+        }
+    }
+
+    /* Escanea las estrellas que no fueron identificadas con PPM/CD/CPD.
+     * Para poder priorizar los catálogos, si se encuentra una más cerca,
+     * debe sobrepasar un threshold de 1 arco de segundo más para elegirse. */
+    int index = -1;
+    minDistance = HUGE_NUMBER;
+    /* solo se revisan las zonas que distan menos de DIST_UN_TYC (más un
+     * margen de 1 arcmin), recorriendo los candidatos en orden de índice */
+    int candidate[MAXUNSTAR];
+    int candidates = 0;
+    double margin = (DIST_UN_TYC + 60.0) / 3600.0;
+    int lastZone = declZone(Decltarget + margin);
+    for (int zone = declZone(Decltarget - margin); zone <= lastZone; zone++) {
+        for (int k = sky->unZone[zone]; k < sky->unZone[zone + 1]; k++) {
+            int i = sky->unByZone[k];
+            int pos = candidates++;
+            while (pos > 0 && candidate[pos - 1] > i) {
+                candidate[pos] = candidate[pos - 1];
+                pos--;
             }
+            candidate[pos] = i;
+        }
+    }
+    for (int c = 0; c < candidates; c++) {
+        int i = candidate[c];
+        double dist = 3600.0 * calcAngularDistance(x, y, z, sky->unidentifiedX[i], sky->unidentifiedY[i], sky->unidentifiedZ[i]);
+        if (dist > DIST_UN_TYC) continue;
+        touched[i] = true;
+        if (minDistance - 1.0 > dist) {
+            index = i;
+            minDistance = dist;
         }
+    }
+    if (index != -1) {
+        /* se almacena la identificación cruzada con la estrella */
+        result->kind = TYC_OTHER;
+        result->crossName = sky->unidentifiedName[index];
+        result->crossDistance = minDistance;
+        return;
+    }
 
-        /* Escanea las estrellas que no fueron identificadas con PPM/CD/CPD.
-         * Para poder priorizar los catálogos, si se encuentra una más cerca,
-         * debe sobrepasar un threshold de 1 arco de segundo más para elegirse. */
-        int index = -1;
+    if (is_north) {
+        /* coordenadas 1855 (solo BD) */
+        x = coords->xDM;
+        y = coords->yDM;
+        z = coords->zDM;
+        Decltarget = coords->declDM;
+    }
+
+    /* halla la DM más cercana, dentro de 60 arcsec */
+    if (is_north || (Decltarget <= -22.0 && (!sky->alternative || Decltarget > -32.0))) {
+        int dmIndex = -1;
         minDistance = HUGE_NUMBER;
-        for (int i = 0; i < countUnidentified; i++) {
-            double dist = 3600.0 * calcAngularDistance(x, y, z, unidentifiedX[i], unidentifiedY[i], unidentifiedZ[i]);
-            if (dist > DIST_UN_TYC) continue;
-            alsoUnidentifiedFromTYC[i] = false;
-            if (minDistance - 1.0 > dist) {
-                index = i;
-                minDistance = dist;
+        findDMStoreByCoordinates(sky->dm, x, y, z, Decltarget, &dmIndex, &minDistance);
+        if (dmIndex != -1 && minDistance < DIST_DM_TYC) {
+            /* se almacena la identificación cruzada con la DM */
+            if (sky->dmIsDouble[dmIndex]) {
+                result->crossStream = 2;
+            } else if (sky->dmIsColor[dmIndex]) {
+                result->crossStream = 1;
             }
+            result->kind = TYC_DM;
+            result->crossName = sky->dmNameDM[dmIndex];
+            result->crossDistance = minDistance;
+            return;
         }
-        if (index != -1) {
-            /* se almacena la identificación cruzada con la estrella */
-            writeCrossEntry(crossStream, tycString, unidentifiedName[index], tycVmag, minDistance);
-            TYCstarsOther++;
-            continue;
+    }
+    if (!is_south) return;
+
+    /* halla la SD más cercana, dentro de 60 arcsec */
+    if (Decltarget >= -23.0 && Decltarget <= -1.0) {
+        int sdIndex = -1;
+        minDistance = HUGE_NUMBER;
+        findSDByCoordinates(x, y, z, Decltarget, &sdIndex, &minDistance);
+        if (sdIndex != -1 && minDistance < DIST_DM_TYC) {
+            /* se almacena la identificación cruzada con la SD */
+            result->kind = TYC_SD;
+            result->crossName = dmNameSD[sdIndex];
+            result->crossDistance = minDistance;
+            return;
         }
-        
-        if (!isCD()) {
-            /* convertir a 1855 (solo BD) */
-            RAtarget = RA;
-            Decltarget = Decl;
-            pmRAtarget = pmRA;
-            pmDecltarget = pmDecl;
-            wcsconp(WCS_J2000, WCS_B1950, 0.0, 1855.0, epoch, 1855.0, &RAtarget, &Decltarget, &pmRAtarget, &pmDecltarget);
-
-            /* calcula coordenadas rectangulares */
-            sph2rec(RAtarget, Decltarget, &x, &y, &z);
+    }
+
+    /* halla la CPD más cercana, dentro de 30 arcsec */
+    if (Decltarget <= -18.0) {
+        int cpdIndex = -1;
+        minDistance = HUGE_NUMBER;
+        findCPDByCoordinates(x, y, z, Decltarget, &cpdIndex, &minDistance);
+        if (cpdIndex != -1 && minDistance < DIST_CPD_TYC) {
+            /* se almacena la identificación cruzada con la CPD */
+            result->kind = TYC_CPD;
+            result->crossName = dmNameCPD[cpdIndex];
+            result->crossDistance = minDistance;
+            return;
         }
+    }
+}
 
-        /* halla la DM más cercana, dentro de 60 arcsec */
-        if (is_north || (Decltarget <= -22.0
-#ifdef ALTERNATIVE
-            && Decltarget > -32.0
-#endif
-        )) {
-            int dmIndex = -1;
-            minDistance = HUGE_NUMBER;
-            findDMByCoordinates(x, y, z, Decltarget, &dmIndex, &minDistance);
-            if (dmIndex != -1 && minDistance < DIST_DM_TYC) {
-                /* se almacena la identificación cruzada con la DM */
-                FILE *chosenStream = crossStream;
-#ifdef ALTERNATIVE
-                if (dmIsDouble[dmIndex]) {
-                    chosenStream = crossStreamDpl;
-                } else if (dmIsColor[dmIndex]) {
-                    chosenStream = crossStreamColor;
-                }
-#endif
-                writeCrossEntry(chosenStream, tycString, dmStringDM[dmIndex], tycVmag, minDistance);
-                TYCstarsDM++;
-                continue;
-            }
+/*
+ * readChunk - lee hasta CHUNK_LINES lineas de un archivo Tycho-2; devuelve cuantas leyo
+ */
+int readChunk(FILE *stream, bool supplement, struct TYCchunk *chunk) {
+    char buffer[1024];
+
+    chunk->supplement = supplement;
+    chunk->firstOfMain = false;
+    chunk->lines = 0;
+    chunk->textSize = 0;
+    while (chunk->lines < CHUNK_LINES && fgets(buffer, 1023, stream) != NULL) {
+        int length = strlen(buffer) + 1;
+        if (chunk->textSize + length > chunk->textCapacity) {
+            chunk->textCapacity = 2 * (chunk->textSize + length) + 256 * CHUNK_LINES;
+            chunk->text = (char *) realloc(chunk->text, chunk->textCapacity);
+            if (chunk->text == NULL) bye("Out of memory!\n");
         }
+        memcpy(chunk->text + chunk->textSize, buffer, length);
+        chunk->offset[chunk->lines++] = chunk->textSize;
+        chunk->textSize += length;
+    }
+    return chunk->lines;
+}
 
-        /* halla la SD más cercana, dentro de 60 arcsec */
-        if (Decltarget >= -23.0 && Decltarget <= -1.0) {
-            int sdIndex = -1;
-            minDistance = HUGE_NUMBER;
-            findSDByCoordinates(x, y, z, Decltarget, &sdIndex, &minDistance);
-            if (sdIndex != -1 && minDistance < DIST_DM_TYC) {
-                /* se almacena la identificación cruzada con la SD */
-                writeCrossEntry(crossStream, tycString, dmStringSD[sdIndex], tycVmag, minDistance);
-                TYCstarsSD++;
-                continue;
+/*
+ * printProgress - informa el avance (cada 10000 entradas)
+ */
+void printProgress(FILE *log, int entry, struct TYCcounters *counters) {
+    fprintf(log, "Progress (%.2f%%): PPM = %d, DM = %d, SD = %d, CPD = %d, other = %d, unidentified = %d\n",
+        (100.0 * (float) entry) / 2539913.0,
+        counters->starsPPM,
+        counters->starsDM,
+        counters->starsSD,
+        counters->starsCPD,
+        counters->starsOther,
+        counters->unidentified);
+}
+
+/*
+ * mergeChunk - escribe los resultados de un bloque en un cielo, en el orden del
+ * archivo, y actualiza sus contadores (igual que si se procesara linea por linea)
+ */
+void mergeChunk(struct TYCsky *sky, struct TYCchunk *chunk, struct TYCresult *results,
+        bool *touched, struct TYCcounters *counters, int *entry) {
+    char ppmCatName[20];
+    char crossName[64];
+
+    if (chunk->firstOfMain) fprintf(sky->log, "Now reading main TYC catalog...\n");
+    for (int i = 0; i < sky->countUnidentified; i++) {
+        if (touched[i]) sky->alsoUnidentifiedFromTYC[i] = false;
+    }
+    for (int i = 0; i < chunk->lines; i++) {
+        struct TYCcoords *coords = &chunk->coords[i];
+        struct TYCresult *result = &results[i];
+
+        (*entry)++;
+        if (*entry % 10000 == 0) printProgress(sky->log, *entry, counters);
+
+        if (result->writeCatalog) {
+            const char *catName = coords->tycString;
+            if (result->catPPMRef != 0) {
+                formatName(ppmCatName, "PPM", result->catPPMRef);
+                catName = ppmCatName;
             }
+            writeCatalogFile(sky->catStream, catName, coords->x, coords->y, coords->z, result->catVmag);
         }
 
-        /* halla la CPD más cercana, dentro de 30 arcsec */
-        if (Decltarget <= -18.0) {
-            int cpdIndex = -1;
-            minDistance = HUGE_NUMBER;
-            findCPDByCoordinates(x, y, z, Decltarget, &cpdIndex, &minDistance);
-            if (cpdIndex != -1 && minDistance < DIST_CPD_TYC) {
-                /* se almacena la identificación cruzada con la CPD */
-                writeCrossEntry(crossStream, tycString, dmStringCPD[cpdIndex], tycVmag, minDistance);
-                TYCstarsCPD++;
+        switch (result->kind) {
+            case TYC_SKIPPED:
+                continue;
+            case TYC_UNIDENTIFIED:
+                counters->unidentified++;
                 continue;
+            case TYC_PPM:
+                counters->starsPPM++;
+                break;
+            case TYC_OTHER:
+                counters->starsOther++;
+                break;
+            case TYC_DM:
+                counters->starsDM++;
+                break;
+            case TYC_SD:
+                counters->starsSD++;
+                break;
+            case TYC_CPD:
+                counters->starsCPD++;
+                break;
+        }
+        formatDesignation(crossName, result->crossName);
+        writeCrossEntry(sky->crossStreams[result->crossStream], coords->tycString,
+            crossName, coords->tycVmag, result->crossDistance);
+    }
+}
+
+/* Estado compartido por las etapas del pipeline de Tycho-2 */
+struct TYCpipeline {
+    FILE *stream, *stream2; /* catálogo principal y suplemento */
+    bool readSupplement, emptyMain, finished;
+    int sequence; /* próximo bloque a leer */
+    struct WorkQueue *freeChunks; /* bloques disponibles para lectura */
+    struct TYCchunk **pending; /* bloques terminados aguardando su turno */
+    int poolSize;
+    int nextSequence; /* próximo bloque a escribir */
+    struct TYCcounters counters[SKIES];
+    int entry[SKIES];
+};
+
+/*
+ * readStage - etapa de lectura: llena un bloque libre con lineas del suplemento
+ * y luego del catálogo principal; devuelve NULL al terminar ambos archivos
+ */
+void *readStage(void *item, void *context) {
+    struct TYCpipeline *pipeline = (struct TYCpipeline *) context;
+    struct TYCchunk *chunk = (struct TYCchunk *) item;
+
+    if (pipeline->finished) return NULL;
+    if (pipeline->readSupplement) {
+        /* lee del catálogo suplemento hasta consumirlo */
+        if (readChunk(pipeline->stream2, true, chunk) == 0) {
+            pipeline->readSupplement = false;
+            if (readChunk(pipeline->stream, false, chunk) == 0) {
+                /* el catálogo principal está vacío */
+                pipeline->emptyMain = true;
+                chunk = NULL;
+            } else {
+                chunk->firstOfMain = true;
             }
         }
+    } else {
+        /* lee del catálogo principal */
+        if (readChunk(pipeline->stream, false, chunk) == 0) chunk = NULL;
+    }
+    if (chunk == NULL) {
+        pipeline->finished = true;
+        return NULL;
+    }
+    chunk->sequence = pipeline->sequence++;
+    return chunk;
+}
 
-        TYCunidentified++;
-    }
-    printf("\nStars read and identified of Tycho-2 from PPM: %d\n", TYCstarsPPM);
-    printf("Stars read and identified of Tycho-2 from DM: %d\n", TYCstarsDM);
-    printf("Stars read and identified of Tycho-2 from SD: %d\n", TYCstarsSD);
-    printf("Stars read and identified of Tycho-2 from CPD: %d\n", TYCstarsCPD);
-    printf("Stars read and identified of Tycho-2 from other catalogues: %d\n", TYCstarsOther);
-    printf("Stars read and remain unidentified of Tycho-2: %d\n", TYCunidentified);
-    fclose(crossStream);
-#ifdef ALTERNATIVE
-    fclose(crossStreamColor);
-    fclose(crossStreamDpl);
-#else
-    fclose(catStream);
-#endif
-    fclose(stream2);
-    fclose(stream);
+/*
+ * transformStage - etapa de conversión: parsea y convierte de época las lineas del bloque
+ */
+void *transformStage(void *item, void *context) {
+    struct TYCchunk *chunk = (struct TYCchunk *) item;
+
+    for (int i = 0; i < chunk->lines; i++) {
+        transformTYCLine(chunk->text + chunk->offset[i], chunk->supplement, &chunk->coords[i]);
+    }
+    return chunk;
+}
+
+/*
+ * matchStage - etapa de identificación: en cada cielo generado, busca las
+ * estrellas más cercanas de cada catálogo
+ */
+void *matchStage(void *item, void *context) {
+    struct TYCchunk *chunk = (struct TYCchunk *) item;
+
+    for (int s = 0; s < SKIES; s++) {
+        struct TYCsky *sky = &skies[s];
+        if (!sky->enabled) continue;
+        for (int i = 0; i < sky->countUnidentified; i++) chunk->touched[s][i] = false;
+        for (int i = 0; i < chunk->lines; i++) {
+            matchTYCLine(sky, &chunk->coords[i], chunk->touched[s], &chunk->result[s][i]);
+        }
+    }
+    return chunk;
+}
+
+/*
+ * writeStage - etapa de escritura: los bloques pueden llegar desordenados, se
+ * retienen hasta que llegue su turno y luego se escriben en orden de lectura
+ */
+void *writeStage(void *item, void *context) {
+    struct TYCpipeline *pipeline = (struct TYCpipeline *) context;
+    struct TYCchunk *chunk = (struct TYCchunk *) item;
 
-    printf("\nStars from other catalogues yet not identified:\n");
-    for (int i = 0; i < countUnidentified; i++) {
-        if (!alsoUnidentifiedFromTYC[i]) continue;
+    pipeline->pending[chunk->sequence % pipeline->poolSize] = chunk;
+    for (;;) {
+        int slot = pipeline->nextSequence % pipeline->poolSize;
+        chunk = pipeline->pending[slot];
+        if (chunk == NULL || chunk->sequence != pipeline->nextSequence) break;
+        for (int s = 0; s < SKIES; s++) {
+            if (!skies[s].enabled) continue;
+            mergeChunk(&skies[s], chunk, chunk->result[s], chunk->touched[s],
+                &pipeline->counters[s], &pipeline->entry[s]);
+        }
+        pipeline->pending[slot] = NULL;
+        pipeline->nextSequence++;
+        pushQueue(pipeline->freeChunks, chunk);
+    }
+    return item;
+}
+
+/*
+ * openSkyOutputs - abre los archivos de salida y el log de un cielo
+ */
+void openSkyOutputs(struct TYCsky *sky) {
+    char buffer[1024];
+
+    sky->catStream = NULL;
+    if (sky->alternative) {
+        sky->crossStreams[0] = openCrossFile("tycho2/cross_tyc2_south_plain.csv");
+        sky->crossStreams[1] = openCrossFile("tycho2/cross_tyc2_south_color.csv");
+        sky->crossStreams[2] = openCrossFile("tycho2/cross_tyc2_south_dpl.csv");
+    } else {
+        snprintf(buffer, 1024, "tycho2/cross_tyc2_%s.csv", sky->name);
+        sky->crossStreams[0] = openCrossFile(buffer);
+        sky->crossStreams[1] = sky->crossStreams[0];
+        sky->crossStreams[2] = sky->crossStreams[0];
+
+        snprintf(buffer, 1024, "likelihood/cat1875/%s.csv", sky->name);
+        sky->catStream = openCatalogFile(buffer);
+    }
+    sky->log = open_memstream(&sky->logText, &sky->logSize);
+    if (sky->log == NULL) {
+        perror("Cannot create log");
+        exit(1);
+    }
+}
+
+/*
+ * closeSkyOutputs - informa los totales de un cielo, cierra sus archivos y vuelca su log
+ */
+void closeSkyOutputs(struct TYCsky *sky, struct TYCcounters *counters) {
+    FILE *log = sky->log;
+
+    fprintf(log, "\nStars read and identified of Tycho-2 from PPM: %d\n", counters->starsPPM);
+    fprintf(log, "Stars read and identified of Tycho-2 from DM: %d\n", counters->starsDM);
+    fprintf(log, "Stars read and identified of Tycho-2 from SD: %d\n", counters->starsSD);
+    fprintf(log, "Stars read and identified of Tycho-2 from CPD: %d\n", counters->starsCPD);
+    fprintf(log, "Stars read and identified of Tycho-2 from other catalogues: %d\n", counters->starsOther);
+    fprintf(log, "Stars read and remain unidentified of Tycho-2: %d\n", counters->unidentified);
+    fclose(sky->crossStreams[0]);
+    if (sky->alternative) {
+        fclose(sky->crossStreams[1]);
+        fclose(sky->crossStreams[2]);
+    } else {
+        closeCatalogFile(sky->catStream);
+    }
+
+    fprintf(log, "\nStars from other catalogues yet not identified:\n");
+    for (int i = 0; i < sky->countUnidentified; i++) {
+        if (!sky->alsoUnidentifiedFromTYC[i]) continue;
 
         double RA, Decl;
-        rec2sph(unidentifiedX[i], unidentifiedY[i], unidentifiedZ[i], &RA, &Decl);
-        printf("  %s in %s hemisphere (decl = %.2f°)\n", unidentifiedName[i],
+        char name[64];
+        rec2sph(sky->unidentifiedX[i], sky->unidentifiedY[i], sky->unidentifiedZ[i], &RA, &Decl);
+        formatDesignation(name, sky->unidentifiedName[i]);
+        fprintf(log, "  %s in %s hemisphere (decl = %.2f°)\n", name,
             Decl >= 0 ? "northern" : "southern", Decl);
     }
+    fclose(log);
+
+    printf("\n***************************************\n");
+    printf("Tycho-2 identifications (%s):\n", sky->name);
+    fwrite(sky->logText, 1, sky->logSize, stdout);
+    free(sky->logText);
+}
+
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv) {
+    struct TYCsky *north = &skies[SKY_NORTH];
+    struct TYCsky *south = &skies[SKY_SOUTH];
+    struct TYCsky *alt = &skies[SKY_SOUTH_ALT];
+    north->name = "north";
+    north->north = true;
+    south->name = "south";
+    alt->name = "south_alt";
+    alt->alternative = true;
+
+    /* cielos a generar (sin argumentos, todos) */
+    for (int s = 0; s < SKIES; s++) skies[s].enabled = (argc == 1);
+    for (int a = 1; a < argc; a++) {
+        bool known = false;
+        for (int s = 0; s < SKIES; s++) {
+            if (strcmp(argv[a], skies[s].name) != 0) continue;
+            skies[s].enabled = true;
+            known = true;
+        }
+        if (!known) {
+            printf("Usage: %s [north] [south] [south_alt]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    /* catalogos BD/CD; el CD del sur va en el almacén por defecto, que es el que usan CPD y SD */
+    south->dm = south->enabled ? getDMStore() : NULL;
+    south->dmFile = "cat/cd_curated.txt";
+    north->dm = north->enabled ? newDMStore(DM_BD) : NULL;
+    north->dmFile = "cat/bd_curated.txt";
+    alt->dm = alt->enabled ? newDMStore(DM_CD) : NULL;
+    alt->dmFile = "cat/cd_vol1_curated.txt";
+
+    /* leemos a la vez los catalogos de cada cielo y, para el Sur, CPD y SD; PPM se lee
+     * una sola vez para ambos hemisferios. Ninguna lectura se cruza con otra, de modo
+     * que todas corren en paralelo (la salida queda en el orden de la lista) */
+    struct TaskNode loads[6];
+    int loadCount = 0;
+    if (south->enabled) addLoad(loads, &loadCount, "CD", loadSkyDM, south);
+    if (north->enabled) addLoad(loads, &loadCount, "BD", loadSkyDM, north);
+    if (alt->enabled) addLoad(loads, &loadCount, "CD (vol. 1)", loadSkyDM, alt);
+    if (south->enabled) {
+        addLoad(loads, &loadCount, "CPD", loadCPDTask, NULL);
+        addLoad(loads, &loadCount, "SD", loadSDTask, NULL);
+    }
+    if (north->enabled || south->enabled) addLoad(loads, &loadCount, "PPM", loadPPMTask, NULL);
+    runTaskGraph(loads, loadCount);
+    printTaskGraphStats(stderr, loads, loadCount);
+
+    /* generamos identificadores de BD/CD (y atributos de la alternativa) */
+    if (south->enabled) prepareSky(south, DESIG_CD);
+    if (north->enabled) prepareSky(north, DESIG_BD);
+    if (alt->enabled) {
+        prepareSky(alt, DESIG_DM);
+        readColorAndDoubles(alt);
+    }
+
+    if (south->enabled) {
+        /* generamos identificadores de CPD */
+        struct CPDstar_struct *CPDstar = getCPDStruct();
+        int CPDstars = getCPDStars();
+        dmNameCPD = (unsigned long long *) allocArena(&namesArena, (size_t) CPDstars * sizeof(unsigned long long));
+        for (int i = 0; i < CPDstars; i++) {
+            dmNameCPD[i] = zoneDesignation(DESIG_CPD, CPDstar[i].declRef, CPDstar[i].numRef);
+        }
+
+        /* generamos identificadores de SD */
+        struct SDstar_struct *SDstar = getSDStruct();
+        int SDstars = getSDStars();
+        dmNameSD = (unsigned long long *) allocArena(&namesArena, (size_t) SDstars * sizeof(unsigned long long));
+        for (int i = 0; i < SDstars; i++) {
+            dmNameSD[i] = zoneDesignation(DESIG_SD, SDstar[i].declRef, SDstar[i].numRef);
+        }
+    }
+
+    /* cada hemisferio renombra sus PPM en su propia tabla de designaciones */
+    if (north->enabled || south->enabled) {
+        struct PPMstar_struct *PPMstar = getPPMStruct();
+        int PPMstars = getPPMStars();
+        for (int s = SKY_NORTH; s <= SKY_SOUTH; s++) {
+            if (!skies[s].enabled) continue;
+            skies[s].ppmName = (unsigned long long *) allocArena(&namesArena, (size_t) PPMstars * sizeof(unsigned long long));
+            for (int i = 0; i < PPMstars; i++) skies[s].ppmName[i] = PPMstar[i].dmName;
+        }
+    }
+
+    if (south->enabled) {
+        /* leemos identificaciones cruzadas y renombramos designaciones.
+         * Order de prioridad: UA, Lal, Lac, GC, ZC, OA (South), U, G, WB
+         * Nota: para UA, Lal, Lac y WB son contra PPM (no hay identificaciones cruzadas con CD/CPD). */
+        readCrossFile(south, "results/cross/cross_wb_ppm.csv", "", "");
+        readCrossFile(south, "results/cross/cross_gilliss_ppm.csv",
+            "results/cross/cross_gilliss_cd.csv", "results/cross/cross_gilliss_cpd.csv");
+        readCrossFile(south, "results/cross/cross_usno_ppm.csv",
+            "results/cross/cross_usno_cd.csv", "results/cross/cross_usno_cpd.csv");
+        readCrossFile(south, "results/cross/cross_oa_ppm.csv",
+            "results/cross/cross_oa_cd.csv", "results/cross/cross_oa_cpd.csv");
+        readCrossFile(south, "results/cross/cross_zc_ppm.csv",
+            "results/cross/cross_zc_cd.csv", "results/cross/cross_zc_cpd.csv");
+        readCrossFile(south, "results/cross/cross_gc_ppm.csv",
+            "results/cross/cross_gc_cd.csv", "results/cross/cross_gc_cpd.csv");
+        readCrossFile(south, "results/cross/cross_lalande_ppm.csv", "", "");
+        readCrossFile(south, "results/cross/cross_lacaille_ppm.csv", "", "");
+        readCrossFile(south, "results/cross/cross_ua_ppm.csv", "", "");
+        /* también leemos las no identificadas */
+        readUnidentifiedFile(south, "results/cross/gc_unidentified.csv");
+        readUnidentifiedFile(south, "results/cross/zc_unidentified.csv");
+        readUnidentifiedFile(south, "results/cross/oa_unidentified.csv");
+        readUnidentifiedFile(south, "results/cross/usno_unidentified.csv");
+        readUnidentifiedFile(south, "results/cross/gilliss_unidentified.csv");
+    }
+    if (north->enabled) {
+        /* leemos identificaciones cruzadas y renombramos designaciones,
+         * Order: UA, Lalande, USNO, WB y OA (North) contra PPM. */
+        readCrossFile(north, "results/cross/cross_oarn_ppm.csv", "", "");
+        readCrossFile(north, "results/cross/cross_wb_ppm.csv", "", "");
+        readCrossFile(north, "results/cross/cross_usno_ppm.csv", "", "");
+        readCrossFile(north, "results/cross/cross_lalande_ppm.csv", "", "");
+        readCrossFile(north, "results/cross/cross_ua_ppm.csv", "", "");
+        readUnidentifiedFile(north, "results/cross/usno_unidentified.csv");
+    }
+
+    FILE *stream = openInputFile("cat/tyc2.txt");
+    if (stream == NULL) {
+        perror("Cannot read tyc2.txt");
+        exit(1);
+    }
+
+    FILE *stream2 = openInputFile("cat/tyc2_suppl.txt");
+    if (stream2 == NULL) {
+        perror("Cannot read tyc2.txt");
+        exit(1);
+    }
+
+    for (int s = 0; s < SKIES; s++) {
+        if (!skies[s].enabled) continue;
+        openSkyOutputs(&skies[s]);
+        indexUnidentified(&skies[s]);
+        fprintf(skies[s].log, "Starting with TYC supplementary catalog...\n");
+    }
+
+    /* Pipeline: lectura -> conversión de épocas -> identificación -> escritura.
+     * Las etapas se comunican por colas acotadas de bloques de lineas; las de
+     * conversión e identificación usan varios hilos y la escritura restituye
+     * el orden original del archivo. Cada linea se convierte una sola vez y
+     * se identifica en todos los cielos de su hemisferio. */
+    int threads = getThreadCount();
+    struct TYCpipeline pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.stream = stream;
+    pipeline.stream2 = stream2;
+    pipeline.readSupplement = true;
+    pipeline.poolSize = 2 * threads + 4;
+    pipeline.freeChunks = createQueue(pipeline.poolSize, 1);
+    pipeline.pending = (struct TYCchunk **) calloc(pipeline.poolSize, sizeof(struct TYCchunk *));
+    struct TYCchunk *chunks = (struct TYCchunk *) calloc(pipeline.poolSize, sizeof(struct TYCchunk));
+    if (chunks == NULL || pipeline.pending == NULL) bye("Out of memory!\n");
+    for (int c = 0; c < pipeline.poolSize; c++) pushQueue(pipeline.freeChunks, &chunks[c]);
+
+    int transformWorkers = threads / 3 > 1 ? threads / 3 : 1;
+    int matchWorkers = threads - transformWorkers > 1 ? threads - transformWorkers : 1;
+    struct PipelineStage stages[4] = {
+        {"read", 1, readStage, &pipeline, pipeline.freeChunks},
+        {"transform", transformWorkers, transformStage, &pipeline, NULL},
+        {"match", matchWorkers, matchStage, &pipeline, NULL},
+        {"write", 1, writeStage, &pipeline, NULL}
+    };
+
+    printf("Reading Tycho-2 catalog...\n");
+    runPipeline(stages, 4, pipeline.poolSize);
+
+    for (int c = 0; c < pipeline.poolSize; c++) free(chunks[c].text);
+    free(chunks);
+    free(pipeline.pending);
+    freeQueue(pipeline.freeChunks);
+    printPipelineStats(stderr, stages, 4);
+    closeInputFile(stream2);
+    closeInputFile(stream);
+
+    for (int s = 0; s < SKIES; s++) {
+        if (!skies[s].enabled) continue;
+        if (pipeline.emptyMain) fprintf(skies[s].log, "Now reading main TYC catalog...\n");
+        closeSkyOutputs(&skies[s], &pipeline.counters[s]);
+    }
     return 0;
 }
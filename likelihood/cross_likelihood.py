@@ -47,7 +47,45 @@ def mag_unknown(m):
     return m > MAG_MISSING_SENTINEL or abs(m) < MAG_ZERO_EPSILON
 
 
+CATALOG_MAGIC = b"CAT1875\0"
+CATALOG_HEADER = np.dtype([("magic", "S8"), ("count", "<i4"), ("names_size", "<u4")])
+CATALOG_RECORD = np.dtype(
+    [("x", "<f8"), ("y", "<f8"), ("z", "<f8"), ("mag", "<f4"), ("name", "<u4")]
+)
+
+
+def load_catalog_binary(path):
+    """
+    Reads the binary companion (<name>.bin) written next to each
+    likelihood/cat1875 CSV: full-precision unit vectors, no re-normalization.
+    Returns None if it is missing or not a valid companion file.
+    """
+    try:
+        raw = np.fromfile(path, dtype=np.uint8)
+    except OSError:
+        return None
+    if raw.size < CATALOG_HEADER.itemsize:
+        return None
+    header = raw[: CATALOG_HEADER.itemsize].view(CATALOG_HEADER)[0]
+    count, names_size = int(header["count"]), int(header["names_size"])
+    records_end = CATALOG_HEADER.itemsize + count * CATALOG_RECORD.itemsize
+    if header["magic"] + b"\0" != CATALOG_MAGIC or raw.size != records_end + names_size:
+        return None
+    records = raw[CATALOG_HEADER.itemsize : records_end].view(CATALOG_RECORD)
+    table = raw[records_end:].tobytes()
+    names = np.array(
+        [table[o : table.index(b"\0", o)].decode() for o in records["name"]], dtype=object
+    )
+    xyz = np.stack([records["x"], records["y"], records["z"]], axis=1)
+    mag = records["mag"].astype(np.float64)
+    return names, xyz, mag
+
+
 def load_catalog(path):
+    if path.endswith(".csv"):
+        binary = load_catalog_binary(path[:-4] + ".bin")
+        if binary is not None:
+            return binary
     df = pd.read_csv(path)
     names = df["name"].to_numpy()
     xyz = df[["x", "y", "z"]].to_numpy(dtype=np.float64)
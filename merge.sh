@@ -1,7 +1,4 @@
-./compare_ppm cd.txt >results/log_ppm.log
-./compare_agk >results/log_agk.log
-./compare_cpd >results/log_cpd.log
-./compare_sd >results/log_sd.log
+./compare_all
 
 cd results
 cat table_pos_ppm.csv > table_pos.csv
@@ -6,14 +6,186 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <charconv>
+#include <mutex>
+#include <thread>
 #include "misc.h"
 
+/* tamaño del buffer de escritura de los archivos CSV de salida */
+#define WRITE_BUFFER_SIZE (1 << 18)
+/* tamaño de los bloques descomprimidos de los catálogos de entrada */
+#define INFLATE_BUFFER_SIZE (1 << 16)
+/* tamaño máximo de una fila formateada */
+#define LINE_BUFFER_SIZE 512
+/* cantidad máxima de archivos de catalogo abiertos a la vez */
+#define MAX_CATALOG_FILES 16
+/* tamaño de los bloques que se agregan a una arena ya llena */
+#define ARENA_BLOCK_SIZE (1 << 20)
+/* cabecera de un bloque de arena (redondeada para alinear los datos a 16) */
+#define ARENA_HEADER_SIZE ((sizeof(struct ArenaBlock_struct) + 15) & ~(size_t) 15)
+
+/* sumidero de logPrintf del hilo actual (NULL = stdout) y el usado por beginLogCapture */
+static thread_local struct LogSink_struct *logSink = NULL;
+static thread_local struct LogSink_struct captureSink;
+
+/*
+ * openLogSink - a partir de aquí, logPrintf acumula en el sumidero lo que escribe el hilo
+ * actual; si deferred = true, las advertencias quedan sin numerar (ver flushLogSink)
+ */
+static void openLogSink(struct LogSink_struct *sink, bool deferred)
+{
+    memset(sink, 0, sizeof(struct LogSink_struct));
+    sink->stream = open_memstream(&sink->buffer, &sink->size);
+    if (sink->stream == NULL) {
+        perror("Cannot capture log");
+        exit(1);
+    }
+    sink->deferred = deferred;
+    sink->previous = logSink;
+    logSink = sink;
+}
+
+/*
+ * closeLogSink - termina de acumular y vuelve al sumidero anterior del hilo
+ */
+static void closeLogSink(struct LogSink_struct *sink)
+{
+    fclose(sink->stream);
+    sink->stream = NULL;
+    logSink = sink->previous;
+}
+
+/*
+ * beginLogCapture - a partir de aquí, logPrintf acumula en memoria lo que escribe
+ * el hilo actual (p.ej. una etapa que corre en paralelo, para volcarlo en orden)
+ */
+void beginLogCapture()
+{
+    openLogSink(&captureSink, false);
+}
+
+/*
+ * endLogCapture - termina la captura y devuelve lo acumulado (a liberar con free)
+ */
+char *endLogCapture(size_t *size)
+{
+    closeLogSink(&captureSink);
+    free(captureSink.mark);
+    *size = captureSink.size;
+    return captureSink.buffer;
+}
+
+/*
+ * beginLogSink - acumula en el sumidero lo que escribe el hilo actual, incluidas las
+ * advertencias de logWarning, cuyo número se asigna recién al volcarlo con flushLogSink
+ * (así las partes de una etapa pueden procesarse en paralelo y numerarse en orden)
+ */
+void beginLogSink(struct LogSink_struct *sink)
+{
+    openLogSink(sink, true);
+}
+
+/*
+ * endLogSink - termina de acumular en el sumidero (el hilo vuelve a su salida anterior)
+ */
+void endLogSink(struct LogSink_struct *sink)
+{
+    closeLogSink(sink);
+}
+
+/*
+ * markWarning - incrementa el contador de advertencias y escribe su número, o si
+ * el hilo acumula en un sumidero diferido, recuerda dónde va
+ */
+static void markWarning(int *errors)
+{
+    ++(*errors);
+    if (logSink != NULL && logSink->deferred) {
+        if (logSink->count == logSink->capacity) {
+            logSink->capacity = logSink->capacity == 0 ? 64 : 2 * logSink->capacity;
+            logSink->mark = (long *) realloc(logSink->mark, logSink->capacity * sizeof(long));
+            if (logSink->mark == NULL) bye("Out of memory!\n");
+        }
+        logSink->mark[logSink->count++] = ftell(logSink->stream);
+    } else {
+        logPrintf("%d) ", *errors);
+    }
+}
+
+/*
+ * writeLogText - escribe en la salida actual del hilo un texto acumulado con advertencias
+ * sin numerar en las posiciones mark[], numerándolas a continuación de *errors
+ */
+void writeLogText(const char *text, size_t size, const long *mark, int marks, int *errors)
+{
+    FILE *output = logSink != NULL ? logSink->stream : stdout;
+    long from = 0;
+    for (int k = 0; k < marks; k++) {
+        fwrite(&text[from], 1, mark[k] - from, output);
+        markWarning(errors);
+        from = mark[k];
+    }
+    fwrite(&text[from], 1, size - from, output);
+}
+
+/*
+ * flushLogSink - vuelca lo acumulado en la salida actual del hilo, numerando las
+ * advertencias en orden a continuación de *errors, y libera el sumidero
+ */
+void flushLogSink(struct LogSink_struct *sink, int *errors)
+{
+    writeLogText(sink->buffer, sink->size, sink->mark, sink->count, errors);
+    free(sink->buffer);
+    free(sink->mark);
+    sink->buffer = NULL;
+    sink->mark = NULL;
+    sink->size = 0;
+    sink->count = sink->capacity = 0;
+}
+
+/*
+ * logPrintf - como printf, pero acumula en memoria si el hilo actual está
+ * capturando su salida (ver beginLogCapture y beginLogSink)
+ */
+void logPrintf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(logSink != NULL ? logSink->stream : stdout, format, args);
+    va_end(args);
+}
+
+/*
+ * logWarning - escribe una advertencia "n) ..." (con n = ++(*errors)); dentro de
+ * un sumidero diferido el número se asigna al volcarlo
+ */
+void logWarning(int *errors, const char *format, ...)
+{
+    markWarning(errors);
+    va_list args;
+    va_start(args, format);
+    vfprintf(logSink != NULL ? logSink->stream : stdout, format, args);
+    va_end(args);
+}
+
 /*
  * bye - muestra un error y aborta
  */
 void bye(const char *string)
 {
+	/* si la salida se estaba acumulando, primero se muestra lo acumulado */
+	if (logSink != NULL) {
+		fflush(logSink->stream);
+		fwrite(logSink->buffer, 1, logSink->size, stdout);
+	}
 	printf("%s", string);
 	exit(1);
 }
@@ -47,25 +219,579 @@ void readFieldSanitized(char *buffer, char *cell, int initial, int bytes) {
 }
 
 /*
- * openCrossFile - abre un archivo de identificación cruzada
+ * sendAll - envía "bytes" bytes al socket; devuelve false si el lector cerró su extremo
  */
-FILE *openCrossFile(const char *name)
+static bool sendAll(int fd, const char *buffer, int bytes)
+{
+    while (bytes > 0) {
+        ssize_t sent = send(fd, buffer, bytes, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buffer += sent;
+        bytes -= sent;
+    }
+    return true;
+}
+
+/* cantidad máxima de catálogos comprimidos abiertos a la vez */
+#define MAX_INFLATE_STREAMS 16
+
+/* descompresiones en curso: el hilo deja su error y closeInputFile lo reporta */
+struct InflateStream_struct {
+    bool used;
+    int fd; /* extremo de lectura */
+    long long size; /* tamaño descomprimido según el pie del .gz */
+    std::thread *thread;
+    char error[256];
+};
+static struct InflateStream_struct inflateStream[MAX_INFLATE_STREAMS];
+static std::mutex inflateMutex;
+
+/*
+ * inflateGzip - hilo que descomprime un archivo .gz y lo envía al lector
+ * Ante un error lo deja en "error" y cierra su extremo: el lector ve el fin del archivo
+ * y closeInputFile termina el programa desde su hilo.
+ */
+static void inflateGzip(gzFile input, int fd, char *error)
+{
+    char *buffer = (char *) malloc(INFLATE_BUFFER_SIZE);
+    if (buffer == NULL) {
+        snprintf(error, 256, "Out of memory!\n");
+    } else {
+        int bytes;
+        while ((bytes = gzread(input, buffer, INFLATE_BUFFER_SIZE)) > 0) {
+            if (!sendAll(fd, buffer, bytes)) break;
+        }
+        /* un archivo truncado termina con Z_BUF_ERROR (gzread devuelve 0) */
+        int code;
+        const char *message = gzerror(input, &code);
+        if (bytes < 0 || (bytes == 0 && code != Z_OK)) {
+            snprintf(error, 256, "Cannot decompress input file: %s\n", message);
+        }
+        free(buffer);
+    }
+    gzclose(input);
+    close(fd);
+}
+
+/*
+ * openInputFile - abre un catálogo de entrada para lectura
+ * Si no existe "name" pero sí "name.gz", un hilo lo descomprime en segundo plano y
+ * se devuelve el extremo de lectura, de modo que el llamador lo lee como un archivo
+ * común (y lo cierra con closeInputFile).
+ * Devuelve NULL (con errno del archivo original) si no existe ninguna variante.
+ */
+FILE *openInputFile(const char *name)
+{
+    FILE *stream = fopen(name, "rt");
+    if (stream != NULL) return stream;
+    int error = errno;
+
+    char compressed[1024];
+    int fds[2];
+    snprintf(compressed, 1024, "%s.gz", name);
+    gzFile gzInput = gzopen(compressed, "rb");
+    if (gzInput != NULL) {
+        gzbuffer(gzInput, INFLATE_BUFFER_SIZE);
+        /* el pie del .gz guarda el tamaño descomprimido (módulo 2^32) */
+        long long size = 0;
+        FILE *trailer = fopen(compressed, "rb");
+        if (trailer != NULL) {
+            unsigned char isize[4];
+            if (fseek(trailer, -4, SEEK_END) == 0 && fread(isize, 1, 4, trailer) == 4) {
+                size = isize[0] | (isize[1] << 8) | (isize[2] << 16) | ((long long) isize[3] << 24);
+            }
+            fclose(trailer);
+        }
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            perror("Cannot create decompression stream");
+            exit(1);
+        }
+        std::lock_guard<std::mutex> lock(inflateMutex);
+        int slot = 0;
+        while (slot < MAX_INFLATE_STREAMS && inflateStream[slot].used) slot++;
+        if (slot == MAX_INFLATE_STREAMS) bye("Too many compressed input files!\n");
+        struct InflateStream_struct *entry = &inflateStream[slot];
+        entry->used = true;
+        entry->fd = fds[0];
+        entry->size = size;
+        entry->error[0] = 0;
+        entry->thread = new std::thread(inflateGzip, gzInput, fds[1], entry->error);
+        return fdopen(fds[0], "rt");
+    }
+    errno = error;
+    return NULL;
+}
+
+/*
+ * closeInputFile - cierra un catálogo abierto con openInputFile; si venía comprimido,
+ * espera al hilo que lo descomprimía y termina el programa si este falló
+ */
+void closeInputFile(FILE *stream)
+{
+    struct InflateStream_struct *entry = NULL;
+    {
+        std::lock_guard<std::mutex> lock(inflateMutex);
+        int fd = fileno(stream);
+        for (int slot = 0; slot < MAX_INFLATE_STREAMS; slot++) {
+            if (inflateStream[slot].used && inflateStream[slot].fd == fd) entry = &inflateStream[slot];
+        }
+    }
+    /* al cerrar el lector, un hilo que siga enviando falla y termina */
+    fclose(stream);
+    if (entry == NULL) return;
+
+    entry->thread->join();
+    delete entry->thread;
+    char error[256];
+    memcpy(error, entry->error, sizeof(error));
+    {
+        std::lock_guard<std::mutex> lock(inflateMutex);
+        entry->used = false;
+    }
+    if (error[0] != 0) bye(error);
+}
+
+/*
+ * estimateLines - estima las filas de un catálogo abierto con openInputFile a partir de
+ * su tamaño (o del tamaño descomprimido, si es un .gz) y del largo de sus registros,
+ * sin leerlo; el lector agranda sus arreglos con growArenaArray si no alcanza
+ */
+int estimateLines(FILE *stream, int lineBytes)
+{
+    long long size = 0;
+    struct stat info;
+    int fd = fileno(stream);
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        size = info.st_size;
+    } else {
+        std::lock_guard<std::mutex> lock(inflateMutex);
+        for (int slot = 0; slot < MAX_INFLATE_STREAMS; slot++) {
+            if (inflateStream[slot].used && inflateStream[slot].fd == fd) size = inflateStream[slot].size;
+        }
+    }
+    long long lines = size / lineBytes + 1;
+    return lines < 1024 ? 1024 : (lines > (1 << 28) ? 1 << 28 : (int) lines);
+}
+
+/*
+ * newArenaBlock - reserva un bloque de arena con "size" bytes utiles
+ */
+static struct ArenaBlock_struct *newArenaBlock(size_t size)
+{
+    struct ArenaBlock_struct *block = (struct ArenaBlock_struct *) malloc(ARENA_HEADER_SIZE + size);
+    if (block == NULL) bye("Out of memory!\n");
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+/*
+ * resetArena - vacia la arena dejando al menos "size" bytes contiguos disponibles
+ * Si el primer bloque alcanza se conserva (y con él las direcciones de lo que se
+ * reparta en el mismo orden), sino se reserva uno nuevo; el resto se libera.
+ */
+void resetArena(struct Arena_struct *arena, size_t size)
+{
+    size = (size + 15) & ~(size_t) 15;
+    struct ArenaBlock_struct *keep = arena->first;
+    if (keep != NULL && keep->size < size) keep = NULL;
+
+    struct ArenaBlock_struct *block = arena->first;
+    while (block != NULL) {
+        struct ArenaBlock_struct *next = block->next;
+        if (block != keep) free(block);
+        block = next;
+    }
+    if (keep == NULL) keep = newArenaBlock(size);
+    keep->next = NULL;
+    keep->used = 0;
+    arena->first = keep;
+    arena->current = keep;
+}
+
+/*
+ * allocArena - reparte "bytes" bytes de la arena (alineados a 16), agregando un bloque si no alcanza
+ */
+void *allocArena(struct Arena_struct *arena, size_t bytes)
+{
+    bytes = (bytes + 15) & ~(size_t) 15;
+    struct ArenaBlock_struct *block = arena->current;
+    if (block == NULL || block->used + bytes > block->size) {
+        struct ArenaBlock_struct *added = newArenaBlock(bytes > ARENA_BLOCK_SIZE ? bytes : ARENA_BLOCK_SIZE);
+        if (block == NULL) arena->first = added;
+        else block->next = added;
+        arena->current = added;
+        block = added;
+    }
+    void *ptr = (char *) block + ARENA_HEADER_SIZE + block->used;
+    block->used += bytes;
+    return ptr;
+}
+
+/*
+ * growArenaArray - muda un arreglo lleno de "count" elementos a uno nuevo de la arena
+ * con "capacity" elementos (el anterior queda sin uso hasta el próximo resetArena)
+ */
+void *growArenaArray(struct Arena_struct *arena, const void *array, int count, int capacity, size_t size)
+{
+    void *grown = allocArena(arena, (size_t) capacity * size);
+    memcpy(grown, array, (size_t) count * size);
+    return grown;
+}
+
+/*
+ * freeArena - libera todos los bloques de la arena
+ */
+void freeArena(struct Arena_struct *arena)
+{
+    struct ArenaBlock_struct *block = arena->first;
+    while (block != NULL) {
+        struct ArenaBlock_struct *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+/*
+ * initDesignationIndex - prepara un indice de designaciones para "capacity" entradas
+ * repartidas en "zones" zonas (la columna y los desplazamientos van en la arena)
+ */
+void initDesignationIndex(struct DesignationIndex_struct *index, struct Arena_struct *arena, int zones, int capacity)
+{
+    index->zones = zones;
+    index->count = 0;
+    index->capacity = capacity;
+    index->zoneStart = (int *) allocArena(arena, (size_t) (zones + 1) * sizeof(int));
+    index->column = (struct Designation_struct *) allocArena(arena, (size_t) capacity * sizeof(struct Designation_struct));
+    for (int z = 0; z <= zones; z++) index->zoneStart[z] = 0;
+    index->pendingZone = (int *) malloc((size_t) (capacity > 0 ? capacity : 1) * sizeof(int));
+    if (index->pendingZone == NULL) bye("Out of memory!\n");
+}
+
+/*
+ * addDesignation - agrega la estrella "starIndex" con designacion (zona, numero, suplementario)
+ */
+void addDesignation(struct DesignationIndex_struct *index, int zone, int numRef, char supplRef, int starIndex)
+{
+    if (index->count == index->capacity) bye("Maximum amount reached!\n");
+    if (zone < 0 || zone >= index->zones) bye("Declination error!");
+    if (numRef < 0) bye("Number error!");
+    index->column[index->count].key = (numRef << 8) | (unsigned char) supplRef;
+    index->column[index->count].index = starIndex;
+    index->pendingZone[index->count] = zone;
+    index->zoneStart[zone + 1]++;
+    index->count++;
+}
+
+/*
+ * compareDesignation - orden por (numero, suplementario) y luego por indice (orden del archivo)
+ */
+static int compareDesignation(const void *a, const void *b)
+{
+    const struct Designation_struct *d1 = (const struct Designation_struct *) a;
+    const struct Designation_struct *d2 = (const struct Designation_struct *) b;
+    if (d1->key != d2->key) return d1->key < d2->key ? -1 : 1;
+    return d1->index - d2->index;
+}
+
+/*
+ * sortDesignationIndex - agrupa las entradas por zona (estable) y ordena cada zona
+ */
+void sortDesignationIndex(struct DesignationIndex_struct *index)
+{
+    int count = index->count;
+    for (int z = 0; z < index->zones; z++) index->zoneStart[z + 1] += index->zoneStart[z];
+
+    struct Designation_struct *sorted = (struct Designation_struct *) malloc((size_t) (count > 0 ? count : 1) * sizeof(struct Designation_struct));
+    int *fill = (int *) malloc((size_t) (index->zones + 1) * sizeof(int));
+    if (sorted == NULL || fill == NULL) bye("Out of memory!\n");
+    for (int z = 0; z < index->zones; z++) fill[z] = index->zoneStart[z];
+    for (int k = 0; k < count; k++) sorted[fill[index->pendingZone[k]]++] = index->column[k];
+    memcpy(index->column, sorted, (size_t) count * sizeof(struct Designation_struct));
+    free(sorted);
+    free(fill);
+    free(index->pendingZone);
+    index->pendingZone = NULL;
+
+    for (int z = 0; z < index->zones; z++) {
+        int first = index->zoneStart[z];
+        int size = index->zoneStart[z + 1] - first;
+        if (size > 1) qsort(&index->column[first], size, sizeof(struct Designation_struct), compareDesignation);
+    }
+}
+
+/*
+ * findDesignation - busca (busqueda binaria) las entradas de la zona con ese numero;
+ * devuelve la primera (o NULL) y en *count la cantidad de componentes contiguas
+ */
+const struct Designation_struct *findDesignation(const struct DesignationIndex_struct *index, int zone, int numRef, int *count)
 {
-    FILE *stream = fopen(name, "wt");
+    *count = 0;
+    if (zone < 0 || zone >= index->zones || numRef < 0 || index->column == NULL) return NULL;
+    int low = index->zoneStart[zone];
+    int high = index->zoneStart[zone + 1];
+    int key = numRef << 8;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (index->column[mid].key < key) low = mid + 1;
+        else high = mid;
+    }
+    int last = low;
+    while (last < index->zoneStart[zone + 1] && (index->column[last].key >> 8) == numRef) last++;
+    *count = last - low;
+    return *count > 0 ? &index->column[low] : NULL;
+}
+
+/*
+ * openOutputFile - abre un archivo de salida ("wt" o "wb") con un buffer de escritura grande
+ * (el buffer no se libera: se abren pocos archivos por ejecución)
+ */
+static FILE *openOutputFile(const char *name, const char *mode, const char *error)
+{
+    FILE *stream = fopen(name, mode);
     if (stream == NULL) {
-        perror("Cannot write in cross file");
+        perror(error);
         exit(1);
     }
+    char *buffer = (char *) malloc(WRITE_BUFFER_SIZE);
+    if (buffer != NULL) setvbuf(stream, buffer, _IOFBF, WRITE_BUFFER_SIZE);
+    return stream;
+}
+
+/*
+ * appendString - copia "string" en "ptr" y devuelve el puntero al final
+ */
+char *appendString(char *ptr, const char *string)
+{
+    while (*string != 0) *ptr++ = *string++;
+    return ptr;
+}
+
+/*
+ * magKnown - dice si una magnitud está informada (0 = sin magnitud, > 29.9 = variable)
+ */
+bool magKnown(double mag)
+{
+    return fabs(mag) >= 0.0001 && mag <= 29.9;
+}
+
+/*
+ * fitsFixed - indica si "value" puede escribirse con appendFixed (hasta 64 caracteres)
+ */
+bool fitsFixed(double value)
+{
+    return !(fabs(value) >= 1e20);
+}
+
+/*
+ * appendFixed - escribe "value" con "precision" decimales (hasta 8) en "ptr", igual
+ * que %.Nf de printf, y devuelve el puntero al final; requiere fitsFixed(value)
+ */
+char *appendFixed(char *ptr, double value, int precision)
+{
+    return std::to_chars(ptr, ptr + 64, value, std::chars_format::fixed, precision).ptr;
+}
+
+/*
+ * formatName - escribe en "dest" una designación del tipo "prefijo número" (p.ej. "PPM 123")
+ */
+void formatName(char *dest, const char *prefix, int number)
+{
+    char *ptr = appendString(dest, prefix);
+    *ptr++ = ' ';
+    ptr = std::to_chars(ptr, ptr + 12, number).ptr;
+    *ptr = 0;
+}
+
+/* tabla de nombres internados: cadenas terminadas en 0 y hash (abierto) de sus desplazamientos */
+static char *internNames = NULL;
+static size_t internSize = 0, internCapacity = 0;
+static unsigned int *internHash = NULL; /* desplazamiento + 1, o 0 = libre */
+static size_t internHashSize = 0, internCount = 0;
+static std::mutex internMutex; /* internDesignation agranda la tabla (realloc) mientras otras etapas la leen */
+
+/*
+ * makeDesignation - empaqueta una designacion de catalogo (zona = declinacion absoluta)
+ */
+unsigned long long makeDesignation(int catalog, bool signRef, int zone, int number, char supplRef)
+{
+    return ((unsigned long long) catalog << 56) |
+        ((unsigned long long) (signRef ? 1 : 0) << 55) |
+        ((unsigned long long) (zone & 0x7f) << 48) |
+        ((unsigned long long) (unsigned int) number << 16) |
+        (unsigned char) (supplRef == ' ' ? 0 : supplRef);
+}
+
+/*
+ * zoneDesignation - designacion de catalogo a partir de la zona con signo (sin suplementario)
+ */
+unsigned long long zoneDesignation(int catalog, int declRef, int numRef)
+{
+    return makeDesignation(catalog, declRef < 0, abs(declRef), numRef, ' ');
+}
+
+/*
+ * hashName - hash FNV-1a de un nombre
+ */
+static size_t hashName(const char *name)
+{
+    size_t hash = 2166136261u;
+    while (*name != 0) hash = (hash ^ (unsigned char) *name++) * 16777619u;
+    return hash;
+}
+
+/*
+ * internDesignation - devuelve la designacion de un nombre libre, guardandolo una sola vez
+ * (la cadena vacia es DESIG_NONE)
+ */
+unsigned long long internDesignation(const char *name)
+{
+    if (name[0] == 0) return DESIG_NONE;
+    std::lock_guard<std::mutex> lock(internMutex);
+    if (2 * (internCount + 1) > internHashSize) {
+        /* agranda el hash y reubica los nombres ya guardados */
+        size_t size = internHashSize == 0 ? 1024 : 2 * internHashSize;
+        unsigned int *hash = (unsigned int *) calloc(size, sizeof(unsigned int));
+        if (hash == NULL) bye("Out of memory!\n");
+        for (size_t k = 0; k < internHashSize; k++) {
+            if (internHash[k] == 0) continue;
+            size_t h = hashName(internNames + internHash[k] - 1) & (size - 1);
+            while (hash[h] != 0) h = (h + 1) & (size - 1);
+            hash[h] = internHash[k];
+        }
+        free(internHash);
+        internHash = hash;
+        internHashSize = size;
+    }
+    size_t h = hashName(name) & (internHashSize - 1);
+    while (internHash[h] != 0) {
+        if (strcmp(internNames + internHash[h] - 1, name) == 0) break;
+        h = (h + 1) & (internHashSize - 1);
+    }
+    if (internHash[h] == 0) {
+        size_t length = strlen(name) + 1;
+        if (internSize + length > internCapacity) {
+            internCapacity = 2 * (internSize + length) + 65536;
+            internNames = (char *) realloc(internNames, internCapacity);
+            if (internNames == NULL) bye("Out of memory!\n");
+        }
+        memcpy(internNames + internSize, name, length);
+        internHash[h] = (unsigned int) internSize + 1;
+        internSize += length;
+        internCount++;
+    }
+    return ((unsigned long long) DESIG_NAME << 56) | ((unsigned long long) (internHash[h] - 1) << 16);
+}
+
+/*
+ * formatDesignation - escribe la designacion en "dest" y devuelve el puntero al 0 final
+ */
+char *formatDesignation(char *dest, unsigned long long designation)
+{
+    int catalog = (int) (designation >> 56);
+    bool signRef = ((designation >> 55) & 1) != 0;
+    int zone = (int) ((designation >> 48) & 0x7f);
+    int number = (int) (unsigned int) (designation >> 16);
+    char supplRef = (char) (designation & 0xff);
+    char *ptr = dest;
+
+    switch (catalog) {
+        case DESIG_NONE:
+            break;
+        case DESIG_NAME: {
+            std::lock_guard<std::mutex> lock(internMutex);
+            ptr = appendString(ptr, internNames + (unsigned int) number);
+            break;
+        }
+        case DESIG_PPM:
+            ptr = appendString(ptr, "PPM ");
+            ptr = std::to_chars(ptr, ptr + 12, number).ptr;
+            break;
+        default:
+            if (catalog == DESIG_CD) ptr = appendString(ptr, "CD ");
+            if (catalog == DESIG_BD) ptr = appendString(ptr, "BD ");
+            if (catalog == DESIG_SD) ptr = appendString(ptr, "SD ");
+            if (catalog == DESIG_CPD) ptr = appendString(ptr, "CPD ");
+            /* en DM la zona lleva siempre signo (para distinguir +00 de -00); en CPD solo si es negativa */
+            if (signRef) *ptr++ = '-';
+            else if (catalog != DESIG_CPD) *ptr++ = '+';
+            ptr = std::to_chars(ptr, ptr + 12, zone).ptr;
+            ptr = appendString(ptr, "°");
+            ptr = std::to_chars(ptr, ptr + 12, number).ptr;
+            if (supplRef != 0) *ptr++ = supplRef;
+            break;
+    }
+    *ptr = 0;
+    return ptr;
+}
+
+/*
+ * openCrossFile - abre un archivo de identificación cruzada
+ */
+FILE *openCrossFile(const char *name)
+{
+    FILE *stream = openOutputFile(name, "wt", "Cannot write in cross file");
     fprintf(stream, "index1,index2,mag,dist\n");
     return stream;
 }
 
 /*
  * writeCrossEntry - escribe una entrada en un archivo de identificación cruzada
+ * Equivale a fprintf(stream, "%s,%s,%.1f,%.2f\n", ...) pero sin el costo de fprintf.
  */
 void writeCrossEntry(FILE *stream, char *index1, char *index2, double mag, double dist)
 {
-    fprintf(stream, "%s,%s,%.1f,%.2f\n", index1, index2, mag, dist);
+    char line[LINE_BUFFER_SIZE];
+    if (strlen(index1) + strlen(index2) > LINE_BUFFER_SIZE - 160 || !fitsFixed(mag) || !fitsFixed(dist)) {
+        fprintf(stream, "%s,%s,%.1f,%.2f\n", index1, index2, mag, dist);
+        return;
+    }
+    char *ptr = appendString(line, index1);
+    *ptr++ = ',';
+    ptr = appendString(ptr, index2);
+    *ptr++ = ',';
+    ptr = appendFixed(ptr, mag, 1);
+    *ptr++ = ',';
+    ptr = appendFixed(ptr, dist, 2);
+    *ptr++ = '\n';
+    fwrite(line, 1, ptr - line, stream);
+}
+
+/*
+ * writePositionRow - escribe la fila "name,x,y,z" (y ",mag" si mag != NULL) de los
+ * archivos de no identificadas y de catalogo
+ */
+static void writePositionRow(FILE *stream, const char *name, double x, double y, double z, const double *mag)
+{
+    char line[LINE_BUFFER_SIZE];
+    if (strlen(name) > LINE_BUFFER_SIZE - 280 || !fitsFixed(x) || !fitsFixed(y) || !fitsFixed(z)
+            || (mag != NULL && !fitsFixed(*mag))) {
+        if (mag != NULL) {
+            fprintf(stream, "%s,%.8f,%.8f,%.8f,%.1f\n", name, x, y, z, *mag);
+        } else {
+            fprintf(stream, "%s,%.8f,%.8f,%.8f\n", name, x, y, z);
+        }
+        return;
+    }
+    char *ptr = appendString(line, name);
+    *ptr++ = ',';
+    ptr = appendFixed(ptr, x, 8);
+    *ptr++ = ',';
+    ptr = appendFixed(ptr, y, 8);
+    *ptr++ = ',';
+    ptr = appendFixed(ptr, z, 8);
+    if (mag != NULL) {
+        *ptr++ = ',';
+        ptr = appendFixed(ptr, *mag, 1);
+    }
+    *ptr++ = '\n';
+    fwrite(line, 1, ptr - line, stream);
 }
 
 /*
@@ -73,26 +799,91 @@ void writeCrossEntry(FILE *stream, char *index1, char *index2, double mag, doubl
  */
 FILE *openUnidentifiedFile(const char *name)
 {
-    FILE *stream = fopen(name, "wt");
-    if (stream == NULL) {
-        perror("Cannot write in unidentified file");
-        exit(1);
-    }
+    FILE *stream = openOutputFile(name, "wt", "Cannot write in unidentified file");
     fprintf(stream, "name,x,y,z\n");
     return stream;
 }
 
+/*
+ * writeUnidentified - almacena una estrella no identificada (pero hallada en GSC)
+ */
+void writeUnidentified(FILE *stream, const char *name, double x, double y, double z)
+{
+    writePositionRow(stream, name, x, y, z, NULL);
+}
+
+/* archivo de catalogo abierto (CSV y su compañero binario) */
+struct CatalogFile_struct {
+    FILE *stream; /* CSV (NULL si la entrada esta libre) */
+    FILE *binary; /* compañero binario */
+    int count; /* filas escritas */
+    char *names; /* tabla de designaciones (terminadas en 0) */
+    unsigned int namesSize, namesCapacity;
+};
+
+static struct CatalogFile_struct catalogFile[MAX_CATALOG_FILES];
+static std::mutex catalogFileMutex; /* la tabla se comparte entre etapas concurrentes */
+
+/*
+ * findCatalogFile - devuelve la entrada asociada a un CSV de catalogo (NULL si no existe)
+ * (llamar con catalogFileMutex tomado)
+ */
+static struct CatalogFile_struct *findCatalogFile(FILE *stream)
+{
+    for (int i = 0; i < MAX_CATALOG_FILES; i++) {
+        if (catalogFile[i].stream == stream) return &catalogFile[i];
+    }
+    return NULL;
+}
+
+/*
+ * lookupCatalogFile - idem, tomando catalogFileMutex (la entrada es solo de quien abrió el CSV)
+ */
+static struct CatalogFile_struct *lookupCatalogFile(FILE *stream)
+{
+    std::lock_guard<std::mutex> lock(catalogFileMutex);
+    return findCatalogFile(stream);
+}
+
+/*
+ * catalogBinaryName - nombre del compañero binario de un archivo de catalogo (.csv -> .bin)
+ */
+static void catalogBinaryName(char *binaryName, size_t size, const char *name)
+{
+    int length = strlen(name);
+    if (length > 4 && !strcmp(&name[length - 4], ".csv")) length -= 4;
+    snprintf(binaryName, size, "%.*s.bin", length, name);
+}
+
 /*
  * openCatalogFile - abre un archivo de catalogo con coordenadas rectangulares 1875 y magnitud
+ * Junto al CSV se escribe su compañero binario (mismo nombre, extension .bin): cabecera
+ * CatalogHeader_struct, una CatalogRecord_struct por fila y la tabla de designaciones.
+ * Se debe cerrar con closeCatalogFile.
  */
 FILE *openCatalogFile(const char *name)
 {
-    FILE *stream = fopen(name, "wt");
-    if (stream == NULL) {
-        perror("Cannot write in catalog file");
-        exit(1);
-    }
+    char binaryName[1024];
+    catalogBinaryName(binaryName, sizeof(binaryName), name);
+
+    FILE *stream = openOutputFile(name, "wt", "Cannot write in catalog file");
     fprintf(stream, "name,x,y,z,mag\n");
+
+    /* la cabecera se reescribe al cerrar, con las cantidades definitivas */
+    struct CatalogHeader_struct header;
+    memset(&header, 0, sizeof(header));
+    FILE *binary = openOutputFile(binaryName, "wb", "Cannot write in catalog file");
+    fwrite(&header, sizeof(header), 1, binary);
+
+    std::lock_guard<std::mutex> lock(catalogFileMutex);
+    struct CatalogFile_struct *entry = findCatalogFile(NULL);
+    if (entry == NULL) bye("Too many catalog files open!\n");
+    entry->binary = binary;
+    entry->stream = stream;
+    entry->count = 0;
+    entry->names = NULL;
+    entry->namesSize = 0;
+    entry->namesCapacity = 0;
     return stream;
 }
 
@@ -101,7 +892,92 @@ FILE *openCatalogFile(const char *name)
  */
 void writeCatalogFile(FILE *stream, const char *name, double x, double y, double z, double mag)
 {
-    fprintf(stream, "%s,%.8f,%.8f,%.8f,%.1f\n", name, x, y, z, mag);
+    struct CatalogFile_struct *entry = lookupCatalogFile(stream);
+    if (entry != NULL) {
+        /* fila binaria (precision completa) y su designacion */
+        unsigned int nameLength = strlen(name) + 1;
+        if (entry->namesSize + nameLength > entry->namesCapacity) {
+            entry->namesCapacity = entry->namesCapacity == 0 ? (1 << 16) : 2 * entry->namesCapacity;
+            while (entry->namesSize + nameLength > entry->namesCapacity) entry->namesCapacity *= 2;
+            entry->names = (char *) realloc(entry->names, entry->namesCapacity);
+            if (entry->names == NULL) bye("Out of memory!\n");
+        }
+        struct CatalogRecord_struct record;
+        record.x = x;
+        record.y = y;
+        record.z = z;
+        record.mag = (float) mag;
+        record.name = entry->namesSize;
+        fwrite(&record, sizeof(record), 1, entry->binary);
+        memcpy(&entry->names[entry->namesSize], name, nameLength);
+        entry->namesSize += nameLength;
+        entry->count++;
+    }
+
+    writePositionRow(stream, name, x, y, z, &mag);
+}
+
+/*
+ * closeCatalogFile - cierra un archivo de catalogo completando su compañero binario
+ */
+void closeCatalogFile(FILE *stream)
+{
+    struct CatalogFile_struct *entry = lookupCatalogFile(stream);
+    if (entry != NULL) {
+        struct CatalogHeader_struct header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+        header.count = entry->count;
+        header.namesSize = entry->namesSize;
+        if (entry->namesSize > 0) fwrite(entry->names, 1, entry->namesSize, entry->binary);
+        fseek(entry->binary, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, entry->binary);
+        if (fclose(entry->binary) != 0) {
+            perror("Cannot write in catalog file");
+            exit(1);
+        }
+        free(entry->names);
+        std::lock_guard<std::mutex> lock(catalogFileMutex);
+        entry->stream = NULL;
+        entry->binary = NULL;
+        entry->names = NULL;
+    }
+    fclose(stream);
+}
+
+/*
+ * readCatalogFile - lee el compañero binario de un archivo de catalogo (ver openCatalogFile)
+ * Devuelve las filas y en *names la tabla de designaciones (ambas se liberan con free).
+ */
+struct CatalogRecord_struct *readCatalogFile(const char *name, int *count, char **names)
+{
+    char binaryName[1024];
+    catalogBinaryName(binaryName, sizeof(binaryName), name);
+
+    FILE *stream = fopen(binaryName, "rb");
+    if (stream == NULL) {
+        snprintf(binaryName, sizeof(binaryName), "Cannot read %.1000s", name);
+        perror(binaryName);
+        exit(1);
+    }
+    struct CatalogHeader_struct header;
+    if (fread(&header, sizeof(header), 1, stream) != 1 || memcmp(header.magic, CATALOG_MAGIC, sizeof(header.magic))
+            || header.count < 0) {
+        printf("Bad catalog file %s.\n", binaryName);
+        exit(1);
+    }
+    struct CatalogRecord_struct *record = (struct CatalogRecord_struct *)
+        malloc((size_t) (header.count > 0 ? header.count : 1) * sizeof(struct CatalogRecord_struct));
+    *names = (char *) malloc(header.namesSize > 0 ? header.namesSize : 1);
+    if (record == NULL || *names == NULL) bye("Out of memory!\n");
+    if (fread(record, sizeof(struct CatalogRecord_struct), header.count, stream) != (size_t) header.count
+            || fread(*names, 1, header.namesSize, stream) != header.namesSize) {
+        printf("Bad catalog file %s.\n", binaryName);
+        exit(1);
+    }
+    fclose(stream);
+    *count = header.count;
+    return record;
 }
 
 /*
@@ -116,25 +992,25 @@ void logCauses(char *name, bool durchCoverage,
         int RAs, double Decl, int Decls,
         int ppmRef, double nearestPPMDistance) {
     if (cumulus) {
-        printf("  Possible cause: cumulus.\n");
+        logPrintf("  Possible cause: cumulus.\n");
     }
     if (nebula) {
-        printf("  Possible cause: nebula.\n");
+        logPrintf("  Possible cause: nebula.\n");
     }
     if (RAs == 0) {
-        printf("  Possible cause: lack of RA (s).\n");
+        logPrintf("  Possible cause: lack of RA (s).\n");
     }
     if (Decls == 0) {
-        printf("  Possible cause: lack of Decl (s).\n");
+        logPrintf("  Possible cause: lack of Decl (s).\n");
     }
     if (ppmRef != -1) {
-        printf("  Note: nearest PPM %d at %.1f arcsec.\n", ppmRef, nearestPPMDistance);
+        logPrintf("  Note: nearest PPM %d at %.1f arcsec.\n", ppmRef, nearestPPMDistance);
     }
     if (Decl > -18.0 && durchCoverage) {
-        printf("  Note: no CD/CPD coverage for stars below 18°.\n");
+        logPrintf("  Note: no CD/CPD coverage for stars below 18°.\n");
     }
     if (Decl < -61.0 && durchCoverage) {
-        printf("  Note: poor CD coverage for stars above 61°.\n");
+        logPrintf("  Note: poor CD coverage for stars above 61°.\n");
     }
 }
 
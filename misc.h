@@ -3,14 +3,111 @@
  * MISC - Header
  */
 
+/* compañero binario de los archivos de catalogo (likelihood/cat1875/<nombre>.bin):
+   cabecera, "count" filas y tabla de designaciones de "namesSize" bytes
+   (en el orden de bytes de la maquina, little-endian en la practica) */
+#define CATALOG_MAGIC "CAT1875"
+
+struct CatalogHeader_struct {
+    char magic[8]; /* CATALOG_MAGIC */
+    int count; /* cantidad de filas */
+    unsigned int namesSize; /* tamaño de la tabla de designaciones */
+};
+
+struct CatalogRecord_struct {
+    double x, y, z; /* coordenadas rectangulares 1875.0 */
+    float mag; /* magnitud visual */
+    unsigned int name; /* desplazamiento de la designacion en la tabla */
+};
+
+/* arena de un catalogo: bloques de los que se reparten sus arreglos, liberados todos juntos */
+struct ArenaBlock_struct {
+    struct ArenaBlock_struct *next;
+    size_t size, used; /* bytes utiles y repartidos (los datos siguen a la cabecera) */
+};
+
+struct Arena_struct {
+    struct ArenaBlock_struct *first, *current;
+};
+
+/* designacion empaquetada en 64 bits (unsigned long long), formateada recien al escribirla:
+   catalogo (bits 56-63) | signo de zona (55) | zona (48-54) | numero (16-47) | suplementario (0-7).
+   Con DESIG_NAME es un nombre libre internado y el numero es su desplazamiento en la tabla.
+   La designacion 0 (DESIG_NONE) indica que no hay designacion. */
+#define DESIG_NONE 0
+#define DESIG_NAME 1
+#define DESIG_PPM 2 /* "PPM 123" */
+#define DESIG_CD 3 /* "CD -22°123" */
+#define DESIG_BD 4 /* "BD +5°123" */
+#define DESIG_SD 5 /* "SD -5°123" */
+#define DESIG_CPD 6 /* "CPD -22°123" */
+#define DESIG_DM 7 /* "-22°123" (DM sin prefijo) */
+
+/* indice compacto de designaciones (CSR): cada zona es un rango contiguo de una
+   columna ordenada por (numero, suplementario), asi las componentes a/b/c quedan seguidas */
+struct Designation_struct {
+    int key; /* numero << 8 | suplementario */
+    int index; /* indice de la estrella en su catalogo */
+};
+
+struct DesignationIndex_struct {
+    int zones, count, capacity;
+    int *zoneStart; /* la zona z ocupa column[zoneStart[z]] .. column[zoneStart[z + 1] - 1] */
+    struct Designation_struct *column;
+    int *pendingZone; /* zona de cada entrada, hasta que se ordena */
+};
+
+/* sumidero de la salida de logPrintf: texto acumulado y, si es diferido, la
+   posicion de cada advertencia de logWarning (su numero se pone al volcarlo) */
+struct LogSink_struct {
+    FILE *stream;
+    char *buffer;
+    size_t size;
+    bool deferred;
+    int count, capacity;
+    long *mark;
+    struct LogSink_struct *previous; /* sumidero del hilo antes de este */
+};
+
 void bye(const char *string);
+void beginLogCapture();
+char *endLogCapture(size_t *size);
+void beginLogSink(struct LogSink_struct *sink);
+void endLogSink(struct LogSink_struct *sink);
+void flushLogSink(struct LogSink_struct *sink, int *errors);
+void writeLogText(const char *text, size_t size, const long *mark, int marks, int *errors);
+void logPrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void logWarning(int *errors, const char *format, ...) __attribute__((format(printf, 2, 3)));
 void readField(char *buffer, char *cell, int initial, int bytes);
 void readFieldSanitized(char *buffer, char *cell, int initial, int bytes);
+char *appendString(char *ptr, const char *string);
+bool magKnown(double mag);
+bool fitsFixed(double value);
+char *appendFixed(char *ptr, double value, int precision);
+void formatName(char *dest, const char *prefix, int number);
+unsigned long long makeDesignation(int catalog, bool signRef, int zone, int number, char supplRef);
+unsigned long long zoneDesignation(int catalog, int declRef, int numRef);
+unsigned long long internDesignation(const char *name);
+char *formatDesignation(char *dest, unsigned long long designation);
+FILE *openInputFile(const char *name);
+void closeInputFile(FILE *stream);
+int estimateLines(FILE *stream, int lineBytes);
+void resetArena(struct Arena_struct *arena, size_t size);
+void *allocArena(struct Arena_struct *arena, size_t bytes);
+void *growArenaArray(struct Arena_struct *arena, const void *array, int count, int capacity, size_t size);
+void freeArena(struct Arena_struct *arena);
+void initDesignationIndex(struct DesignationIndex_struct *index, struct Arena_struct *arena, int zones, int capacity);
+void addDesignation(struct DesignationIndex_struct *index, int zone, int numRef, char supplRef, int starIndex);
+void sortDesignationIndex(struct DesignationIndex_struct *index);
+const struct Designation_struct *findDesignation(const struct DesignationIndex_struct *index, int zone, int numRef, int *count);
 FILE *openCrossFile(const char *name);
 void writeCrossEntry(FILE *stream, char *index1, char *index2, double mag, double dist);
 FILE *openUnidentifiedFile(const char *name);
+void writeUnidentified(FILE *stream, const char *name, double x, double y, double z);
 FILE *openCatalogFile(const char *name);
 void writeCatalogFile(FILE *stream, const char *name, double x, double y, double z, double mag);
+void closeCatalogFile(FILE *stream);
+struct CatalogRecord_struct *readCatalogFile(const char *name, int *count, char **names);
 void logCauses(char *name, bool durchCoverage,
     bool cumulus, bool nebula,
     int RAs, double Decl, int Decls,
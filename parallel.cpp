@@ -0,0 +1,347 @@
+/*
+ * PARALLEL - Ejecucion de tareas independientes en varios hilos
+ * Made in 2025 by Daniel E. Severin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+#include "misc.h"
+
+/*
+ * getThreadCount - devuelve la cantidad de hilos a utilizar
+ * Por defecto es la cantidad de nucleos, pero puede fijarse con la
+ * variable de entorno CAT_THREADS (CAT_THREADS=1 equivale a la version serial).
+ */
+int getThreadCount()
+{
+    static int threads = 0;
+    if (threads == 0) {
+        const char *env = getenv("CAT_THREADS");
+        if (env != NULL) threads = atoi(env);
+        if (threads <= 0) threads = (int) std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+    }
+    return threads;
+}
+
+/*
+ * parallelFor - ejecuta task(index, context) para index = 0..count-1
+ * repartiendo los indices entre los hilos disponibles; retorna cuando
+ * terminaron todas las tareas. Las tareas no deben compartir escrituras.
+ */
+void parallelFor(int count, void (*task)(int index, void *context), void *context)
+{
+    int threads = getThreadCount();
+    if (threads > count) threads = count;
+    if (threads <= 1) {
+        for (int i = 0; i < count; i++) task(i, context);
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (;;) {
+            int i = next.fetch_add(1);
+            if (i >= count) break;
+            task(i, context);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool) thread.join();
+}
+
+/* cola acotada (buffer circular) protegida por mutex */
+struct WorkQueue {
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    std::vector<void *> items;
+    int head, size;
+    int producers; /* productores que aun no cerraron la cola */
+};
+
+/*
+ * createQueue - crea una cola con la capacidad dada; se cierra cuando
+ * los "producers" productores llamaron a closeQueue
+ */
+struct WorkQueue *createQueue(int capacity, int producers)
+{
+    struct WorkQueue *queue = new WorkQueue;
+    queue->items.resize(capacity < 1 ? 1 : capacity);
+    queue->head = 0;
+    queue->size = 0;
+    queue->producers = producers;
+    return queue;
+}
+
+/*
+ * pushQueue - agrega un item; bloquea mientras la cola esta llena
+ */
+void pushQueue(struct WorkQueue *queue, void *item)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    int capacity = queue->items.size();
+    queue->notFull.wait(lock, [&]() { return queue->size < capacity; });
+    queue->items[(queue->head + queue->size) % capacity] = item;
+    queue->size++;
+    queue->notEmpty.notify_one();
+}
+
+/*
+ * popQueue - extrae un item; bloquea mientras la cola esta vacia
+ * Devuelve NULL si la cola esta vacia y cerrada.
+ */
+void *popQueue(struct WorkQueue *queue)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    queue->notEmpty.wait(lock, [&]() { return queue->size > 0 || queue->producers == 0; });
+    if (queue->size == 0) return NULL;
+    void *item = queue->items[queue->head];
+    queue->head = (queue->head + 1) % (int) queue->items.size();
+    queue->size--;
+    queue->notFull.notify_one();
+    return item;
+}
+
+/*
+ * closeQueue - indica que un productor no agregara mas items
+ */
+void closeQueue(struct WorkQueue *queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (--queue->producers <= 0) {
+        queue->producers = 0;
+        queue->notEmpty.notify_all();
+    }
+}
+
+void freeQueue(struct WorkQueue *queue)
+{
+    delete queue;
+}
+
+/* segundos transcurridos desde un instante dado */
+static double elapsed(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double>(to - from).count();
+}
+
+/*
+ * stageWorker - ciclo de un hilo de una etapa: toma un item, lo procesa y lo pasa
+ * a la siguiente etapa, acumulando tiempo de trabajo y de espera en las colas
+ */
+static void stageWorker(struct PipelineStage *stage, bool isSource, struct WorkQueue *input, struct WorkQueue *output, std::mutex *statsMutex)
+{
+    long items = 0;
+    double busyTime = 0.0, waitTime = 0.0;
+    for (;;) {
+        auto t0 = std::chrono::steady_clock::now();
+        void *item = NULL;
+        if (input != NULL) {
+            item = popQueue(input);
+            if (item == NULL) break;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        void *result = stage->task(item, stage->context);
+        auto t2 = std::chrono::steady_clock::now();
+        busyTime += elapsed(t1, t2);
+        waitTime += elapsed(t0, t1);
+        if (isSource && result == NULL) break;
+        items++;
+        if (output != NULL && result != NULL) {
+            pushQueue(output, result);
+            waitTime += elapsed(t2, std::chrono::steady_clock::now());
+        }
+    }
+    if (output != NULL) closeQueue(output);
+
+    std::lock_guard<std::mutex> lock(*statsMutex);
+    stage->items += items;
+    stage->busyTime += busyTime;
+    stage->waitTime += waitTime;
+}
+
+/*
+ * runPipeline - ejecuta las etapas concurrentemente, unidas por colas de la
+ * capacidad dada; retorna cuando la ultima etapa consumio todos los items
+ */
+void runPipeline(struct PipelineStage *stages, int count, int capacity)
+{
+    std::mutex statsMutex;
+    std::vector<struct WorkQueue *> queues;
+    for (int s = 0; s < count; s++) {
+        if (stages[s].workers < 1 || s == 0) stages[s].workers = 1; /* la fuente es secuencial */
+        stages[s].items = 0;
+        stages[s].busyTime = 0.0;
+        stages[s].waitTime = 0.0;
+        if (s + 1 < count) queues.push_back(createQueue(capacity, stages[s].workers));
+    }
+
+    std::vector<std::thread> pool;
+    for (int s = 0; s < count; s++) {
+        struct WorkQueue *input = s > 0 ? queues[s - 1] : stages[s].source;
+        struct WorkQueue *output = s + 1 < count ? queues[s] : NULL;
+        for (int w = 0; w < stages[s].workers; w++) {
+            pool.emplace_back(stageWorker, &stages[s], s == 0, input, output, &statsMutex);
+        }
+    }
+    for (auto &thread : pool) thread.join();
+    for (auto queue : queues) freeQueue(queue);
+}
+
+/*
+ * printPipelineStats - informa los contadores de cada etapa: items procesados,
+ * tiempo de trabajo y de espera (sumados sobre sus hilos) y items por segundo
+ * de trabajo; la etapa con mayor ocupacion es el cuello de botella
+ */
+void printPipelineStats(FILE *stream, struct PipelineStage *stages, int count)
+{
+    fprintf(stream, "Pipeline stages:\n");
+    for (int s = 0; s < count; s++) {
+        struct PipelineStage *stage = &stages[s];
+        double total = stage->busyTime + stage->waitTime;
+        fprintf(stream, "  %-10s workers = %2d, items = %7ld, busy = %8.3fs, wait = %8.3fs, %9.1f items/s, load = %5.1f%%\n",
+            stage->name, stage->workers, stage->items, stage->busyTime, stage->waitTime,
+            stage->busyTime > 0.0 ? stage->items / stage->busyTime : 0.0,
+            total > 0.0 ? 100.0 * stage->busyTime / total : 0.0);
+    }
+}
+
+/*
+ * resolveTaskDeps - traduce los nombres de "after" de cada tarea a indices;
+ * aborta si alguno no corresponde a una tarea anterior del arreglo
+ */
+static void resolveTaskDeps(struct TaskNode *tasks, int count, std::vector<std::vector<int>> &dependents, std::vector<int> &pending)
+{
+    dependents.assign(count, std::vector<int>());
+    pending.assign(count, 0);
+    for (int i = 0; i < count; i++) {
+        const char *ptr = tasks[i].after;
+        while (ptr != NULL && *ptr != 0) {
+            while (*ptr == ' ') ptr++;
+            int length = strcspn(ptr, " ");
+            if (length == 0) break;
+            int j = 0;
+            while (j < i && (strlen(tasks[j].name) != (size_t) length || strncmp(tasks[j].name, ptr, length))) j++;
+            if (j == i) {
+                fprintf(stderr, "Task %s: unknown or later dependency %.*s\n", tasks[i].name, length, ptr);
+                exit(1);
+            }
+            dependents[j].push_back(i);
+            pending[i]++;
+            ptr += length;
+        }
+    }
+}
+
+/*
+ * runTaskGraph - ejecuta las tareas en un pool de getThreadCount() hilos, cada
+ * una apenas terminaron sus dependencias (entre las listas, la primera del
+ * arreglo); retorna cuando terminaron todas. Con un solo hilo las ejecuta en el
+ * orden del arreglo, escribiendo directamente en stdout.
+ */
+void runTaskGraph(struct TaskNode *tasks, int count)
+{
+    std::vector<std::vector<int>> dependents;
+    std::vector<int> pending;
+    resolveTaskDeps(tasks, count, dependents, pending);
+    auto origin = std::chrono::steady_clock::now();
+
+    int threads = getThreadCount();
+    if (threads > count) threads = count;
+    if (threads <= 1) {
+        for (int i = 0; i < count; i++) {
+            tasks[i].startTime = elapsed(origin, std::chrono::steady_clock::now());
+            tasks[i].task(tasks[i].context);
+            tasks[i].finishTime = elapsed(origin, std::chrono::steady_clock::now());
+        }
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<bool> ready(count, false), done(count, false);
+    std::vector<char *> output(count, NULL);
+    std::vector<size_t> outputSize(count, 0);
+    int running = 0, finished = 0, flushed = 0;
+    for (int i = 0; i < count; i++) ready[i] = (pending[i] == 0);
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            int i = 0;
+            while (i < count && !ready[i]) i++;
+            if (i == count) {
+                /* nada listo: termina si tampoco queda nada por liberar */
+                if (running == 0) break;
+                changed.wait(lock);
+                continue;
+            }
+            ready[i] = false;
+            running++;
+            lock.unlock();
+
+            /* corre la tarea acumulando su salida */
+            tasks[i].startTime = elapsed(origin, std::chrono::steady_clock::now());
+            beginLogCapture();
+            tasks[i].task(tasks[i].context);
+            size_t size;
+            char *buffer = endLogCapture(&size);
+            tasks[i].finishTime = elapsed(origin, std::chrono::steady_clock::now());
+
+            lock.lock();
+            running--;
+            finished++;
+            done[i] = true;
+            output[i] = buffer;
+            outputSize[i] = size;
+            for (int j : dependents[i]) {
+                if (--pending[j] == 0) ready[j] = true;
+            }
+
+            /* vuelca en orden la salida de las tareas ya terminadas */
+            while (flushed < count && done[flushed]) {
+                fwrite(output[flushed], 1, outputSize[flushed], stdout);
+                free(output[flushed]);
+                output[flushed] = NULL;
+                flushed++;
+            }
+            changed.notify_all();
+        }
+        changed.notify_all();
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool) thread.join();
+    if (finished < count) {
+        fprintf(stderr, "Task graph stopped with %d of %d tasks finished\n", finished, count);
+        exit(1);
+    }
+}
+
+/*
+ * printTaskGraphStats - informa inicio, fin y duracion de cada tarea, y el total
+ */
+void printTaskGraphStats(FILE *stream, struct TaskNode *tasks, int count)
+{
+    double total = 0.0, busy = 0.0;
+    fprintf(stream, "Tasks:\n");
+    for (int i = 0; i < count; i++) {
+        double duration = tasks[i].finishTime - tasks[i].startTime;
+        fprintf(stream, "  %-12s start = %8.3fs, finish = %8.3fs, elapsed = %8.3fs\n",
+            tasks[i].name, tasks[i].startTime, tasks[i].finishTime, duration);
+        if (tasks[i].finishTime > total) total = tasks[i].finishTime;
+        busy += duration;
+    }
+    fprintf(stream, "  total = %.3fs (%.3fs of work, %d threads)\n", total, busy, getThreadCount());
+}
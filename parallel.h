@@ -0,0 +1,51 @@
+
+/*
+ * PARALLEL - Header
+ */
+
+#include <stdio.h>
+
+int getThreadCount();
+void parallelFor(int count, void (*task)(int index, void *context), void *context);
+
+/* Cola acotada de punteros entre etapas de un pipeline */
+struct WorkQueue;
+struct WorkQueue *createQueue(int capacity, int producers);
+void pushQueue(struct WorkQueue *queue, void *item);
+void *popQueue(struct WorkQueue *queue);
+void closeQueue(struct WorkQueue *queue);
+void freeQueue(struct WorkQueue *queue);
+
+/* Etapa de un pipeline: la primera etapa produce items (recibe NULL, o un item
+ * de la cola "source" si se indica, y devuelve NULL al terminar), las siguientes
+ * reciben el item de la etapa anterior y devuelven el item a pasar a la siguiente */
+struct PipelineStage {
+    const char *name;
+    int workers;
+    void *(*task)(void *item, void *context);
+    void *context;
+    struct WorkQueue *source; /* solo primera etapa: p.ej. bloques libres a reutilizar */
+    /* contadores (se completan al ejecutar el pipeline) */
+    long items;
+    double busyTime, waitTime;
+};
+
+void runPipeline(struct PipelineStage *stages, int count, int capacity);
+void printPipelineStats(FILE *stream, struct PipelineStage *stages, int count);
+
+/* Tarea de un grafo de dependencias: corre cuando terminaron las tareas nombradas
+ * en "after" (separadas por espacios, NULL si no depende de ninguna), que deben
+ * figurar antes en el arreglo; asi el orden del arreglo es un orden serial valido.
+ * Lo que la tarea escribe con logPrintf se acumula y se vuelca a stdout en el
+ * orden del arreglo, de modo que la salida coincide con la ejecucion serial */
+struct TaskNode {
+    const char *name;
+    void (*task)(void *context);
+    void *context;
+    const char *after;
+    /* tiempos en segundos desde el inicio del grafo (se completan al ejecutarlo) */
+    double startTime, finishTime;
+};
+
+void runTaskGraph(struct TaskNode *tasks, int count);
+void printTaskGraphStats(FILE *stream, struct TaskNode *tasks, int count);
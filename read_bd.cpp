@@ -4,62 +4,42 @@
  * Made in 2024 by Daniel E. Severin
  */
 
+/* Nota: el almacén está en read_dm.cpp; aquí se define el almacén por defecto
+   (BD) usado por las funciones sin almacén explícito */
+
 #include <stdio.h>
-#include <math.h>
 #include "read_dm.h"
-#include "misc.h"
-#include "trig.h"
-
-#define MAX_DECL_NORTH 90
-#define MAX_DECL_SOUTH 2
-#define MAX_NUM 7000
-
-static struct DMstar_struct BDstar[MAXDMSTAR];
-static int BDstars = 0;
-static int reindexByIndex[MAXDMSTAR];
 
-/* Mapa para acceder rápido según signo, declinación y num:
-   el índice devuelto es la estrella DM decl num, pero de haber
-   más de una (por suppl) se utiliza la lista enlazada */
-static int mapBDNorthIndex[MAX_DECL_NORTH][MAX_NUM];
-static int mapBDSouthIndex[MAX_DECL_SOUTH][MAX_NUM];
+/*
+ * getDMStore - devuelve el almacén BD por defecto
+ */
+struct DMstore_struct *getDMStore()
+{
+    /* se crea en la primera llamada, una sola vez aunque la hagan varios hilos a la vez */
+    static struct DMstore_struct *BDstore = newDMStore(DM_BD);
+    return BDstore;
+}
 
 /*
- * getBDStars - devuelve la cantidad de estrellas de BD leidas
+ * getDMStars - devuelve la cantidad de estrellas de BD leidas
  */
 int getDMStars()
 {
-    return BDstars;
+    return getDMStoreStars(getDMStore());
 }
 
 /*
  * getDMindex - devuelve el índice a partir del signo, declinación y num
  */
 int getDMindex(bool signRef, int declRef, int numRef) {
-    if (numRef >= MAX_NUM) bye("Number error!");
-    declRef = abs(declRef);
-    if (!signRef) {
-        if (declRef >= MAX_DECL_NORTH) bye("Declination error!");
-        return mapBDNorthIndex[declRef][numRef];
-    }
-    if (declRef >= MAX_DECL_SOUTH) bye("Declination error!");
-    return mapBDSouthIndex[declRef][numRef];
+    return getDMStoreIndex(getDMStore(), signRef, declRef, numRef);
 }
-    
 
 /*
- * setDMindex - asigna el índice a partir del signo, declinación y num
+ * getDMComponents - devuelve las componentes (a/b/c) contiguas de la estrella y su cantidad
  */
-void setDMindex(bool signRef, int declRef, int numRef, int index) {
-    if (numRef >= MAX_NUM) bye("Number error!");
-    declRef = abs(declRef);
-    if (!signRef) {
-        if (declRef >= MAX_DECL_NORTH) bye("Declination error!");
-        mapBDNorthIndex[declRef][numRef] = index;
-        return;
-    }
-    if (declRef >= MAX_DECL_SOUTH) bye("Declination error!");
-    mapBDSouthIndex[declRef][numRef] = index;
+const struct Designation_struct *getDMComponents(bool signRef, int declRef, int numRef, int *count) {
+    return getDMStoreComponents(getDMStore(), signRef, declRef, numRef, count);
 }
 
 /*
@@ -71,226 +51,43 @@ bool isCD()
 }
 
 /*
- * getDMStruct - devuelve la estructura CD
+ * getDMStruct - devuelve la estructura BD
  */
 struct DMstar_struct *getDMStruct()
 {
-    return &BDstar[0];
+    return getDMStoreStruct(getDMStore());
 }
 
 /*
- * writeRegister - escribe en pantalla un registro de BD en su formato
- * Warning: ONLY WORKS FOR THE FIRST VOLUME!
+ * getDMRegisterStruct - devuelve los datos de registro de BD (mismo índice que getDMStruct)
  */
-void writeRegister(int bdIndex, bool neighbors)
+struct DMregister_struct *getDMRegisterStruct()
 {
-    struct DMstar_struct *s = &BDstar[bdIndex];
-
-    int declAbsRef = abs(s->declRef);
-    int numRef = s->numRef;
-    int page = 1 + 378 * reindexByIndex[bdIndex] / BDstars;
-    printf("     Register BD %c%d°%d (en %.0fh):  %.1f | %.0fm%.1fs | %.1f'     (pag. %d)\n",
-                s->signRef ? '-' : '+',
-                declAbsRef,
-                numRef,
-                s->rah,
-                s->vmag,
-                s->ramin,
-                s->raseg,
-                s->declmin,
-                page);
-    if (neighbors) {
-        printf("   Neighbors:\n");
-        writeRegister(bdIndex - 1, false);
-        writeRegister(bdIndex + 1, false);
-    }
+    return getDMStoreRegister(getDMStore());
 }
 
 /*
- * read_bd - lee base de datos del Durchmusterung
-   Bytes      Format   Units    Label       Explanations
+ * writeRegister - escribe en pantalla un registro de BD en su formato
+ */
+void writeRegister(int dmIndex, bool neighbors)
+{
+    writeDMStoreRegister(getDMStore(), dmIndex, neighbors);
+}
 
-    1- 2        A2      ---      ---        [BD] The catalog prefix
-       3        A1      ---      zonesign   [+-]The sign of the declination zone
-    4- 5        I2      deg      zone       The declination zone
-    6-10        I5      ---      num        The number of the star within the zone
-      11        A1      ---      suppl     *[a-c D*?M] Note
-   12-15      F4.1      mag      mag       *Estimated visual magnitude
-   16-17        I2      h        RAh        Right Ascension 1855 (hours)
-   18-19        I2      min      RAm        Right Ascension 1855 (minutes)
-   20-23      F4.1      s        RAs        Right Ascension, 1855 (seconds)
-   24-24        A1      ---      DE-        [+-]Sign of declination
-   25-26        I2      deg      DEd        Declination 1855 (degrees)
-   27-30      F4.1      arcmin   DEm        Declination 1855 (minutes)
- *
- * Nota: se descartan estrellas variables y objetos nebulares
+/*
+ * readDM - lee base de datos del Durchmusterung (ver formato en read_dm.cpp)
  */
 void readDM(const char *filename)
 {
-    FILE *stream;
-    char buffer[1024];
-    char cell[256];
-
-    stream = fopen(filename, "rt");
-    if (stream == NULL) {
-        snprintf(buffer, 1024, "Cannot read %s", filename);
-        perror(buffer);
-        exit(1);
-    }
-
-    for (int decl = 0; decl < MAX_DECL_NORTH; decl++) {
-        for (int num = 0; num < MAX_NUM; num++) {
-            mapBDNorthIndex[decl][num] = -1;
-        }
-    }
-    for (int decl = 0; decl < MAX_DECL_SOUTH; decl++) {
-        for (int num = 0; num < MAX_NUM; num++) {
-            mapBDSouthIndex[decl][num] = -1;
-        }
-    }
- 
-    BDstars = 0;
-    while (fgets(buffer, 1023, stream) != NULL) {
-        /* lee la zona de declinacion (es necesario también conocer el signo para
-         * diferenciar la declinación +00 de la -00). */
-        readField(buffer, cell, 3, 1);
-        bool zoneSign = (cell[0] == '-');
-        readField(buffer, cell, 4, 2);
-        int declRef = atoi(cell);
-        if (zoneSign) declRef = -declRef;
-
-        /* lee numeracion y caracter suplementario */
-        readField(buffer, cell, 6, 5);
-        int numRef = atoi(cell);
-        readField(buffer, cell, 11, 1);
-        char supplRef = cell[0];
-        if (supplRef == 'D') continue;
-        if (supplRef == '*') {
-            printf("Star already corrected (BD %d°%d)\n", declRef, numRef);
-            continue;
-        }
-        
-        /* lee magnitud visual */
-        readField(buffer, cell, 12, 4);
-        double vmag = atof(cell);
-        if (vmag > 12.1) {
-            /* vmag no es una magnitud, si no un codigo:
-             * 20.0 = neb
-             * 30.0 = var
-             * 40.0 = nova or nova?
-             * 50.0 = cluster */
-            if ((vmag > 19.9 && vmag < 20.1) || (vmag > 39.9 && vmag < 40.1) || (vmag > 49.9 && vmag < 50.1)) continue;
-            if (vmag > 29.9 && vmag < 30.1) {
-                /* estrella variable */
-            } else {
-                printf("Unknown code: %f, BD %d°%d\n", vmag, declRef, numRef);
-                exit(1);
-            }
-        }
-
-        /* lee ascension recta B1855.0 */
-        readField(buffer, cell, 16, 2);
-        float rah = atof(cell);
-        double RA = rah;
-        readField(buffer, cell, 18, 2);
-        float ramin = atof(cell);
-        RA += ramin/60.0;
-        readField(buffer, cell, 20, 4);
-        float raseg = atof(cell);
-        RA += raseg/3600.0;
-        RA *= 15.0; /* conversion horas a grados */
-
-        /* lee declinacion B1855.0 */
-        readField(buffer, cell, 24, 1);
-        bool sign = (cell[0] == '-');
-        readField(buffer, cell, 25, 2);
-        float decldeg = atof(cell);
-        double Decl = decldeg;
-        readField(buffer, cell, 27, 4);
-        float declmin = atof(cell);
-        Decl += declmin/60.0;
-        if (sign) Decl = -Decl; /* incorpora signo negativo solo si es necesario */
-
-        /* calcula coordenadas rectangulares */
-        double x, y, z;
-        sph2rec(RA, Decl, &x, &y, &z);
-
-        /* la almacena en memoria */
-		if (BDstars == MAXDMSTAR) bye("Maximum amount reached!\n");
-        BDstar[BDstars].signRef = zoneSign;
-        BDstar[BDstars].declRef = declRef;
-        BDstar[BDstars].numRef = numRef;
-        BDstar[BDstars].supplRef = supplRef;
-        BDstar[BDstars].rah = rah;
-        BDstar[BDstars].ramin = ramin;
-        BDstar[BDstars].raseg = raseg;
-        BDstar[BDstars].decldeg = decldeg;
-        BDstar[BDstars].declmin = declmin;
-        BDstar[BDstars].RA1855 = RA;
-        BDstar[BDstars].Decl1855 = Decl;
-        BDstar[BDstars].vmag = vmag;
-        BDstar[BDstars].catIndex = -1; // se rellenará luego
-        BDstar[BDstars].x = x;
-        BDstar[BDstars].y = y;
-        BDstar[BDstars].z = z;
-        BDstar[BDstars].next = -1;
-
-        /* si ya hay otra de misma identificación, la enlaza */
-        int index = getDMindex(zoneSign, declRef, numRef);
-        if (index == -1) {
-            setDMindex(zoneSign, declRef, numRef, BDstars);
-        } else {
-            while (BDstar[index].next != -1) index = BDstar[index].next;
-            BDstar[index].next = BDstars;
-        }
-
-        /* proxima estrella */
-        BDstars++;
-    }
-    printf("Stars read from Bonner Durchmusterung: %d\n", BDstars);
-
-    /* Ahora calculamos el indice pero con declinaciones ascendentes, aquí decl = -2 es declinación -01, decl = 1 es -00
-       y para decl >= 0 ya es la declinación positiva. */
-    int reindex = 0;
-    for (int decl = -2; decl <= 89; decl++) {
-        for (int i = 0; i < BDstars; i++) {
-            if (decl == -2) {
-                if (BDstar[i].declRef != -1 || !BDstar[i].signRef) continue;
-            } else {
-                if (decl == -1) {
-                    if (BDstar[i].declRef != 0 || !BDstar[i].signRef) continue;
-                } else {
-                    if (BDstar[i].declRef != decl || BDstar[i].signRef) continue;
-                }
-            }
-            reindexByIndex[i] = reindex;
-            reindex++;
-        }
-    }
-    if (reindex != BDstars) {
-        printf("Some star is missing or duplicated :(\n");
-        exit(1);
-    }
-    fclose(stream);
+    readDMStore(getDMStore(), filename);
 }
 
 /* 
  * findDMByCoordinates - busca la estrella BD más cercana
  * Aquí (x, y, z) son las coord rectangulares en 1855.
- * (aquí "decl" aun no está implementado y no se utiliza)
  * minDistanceOutput debe ser una cota de la distancia a buscar.
- * El resultado se almacena en (bdIndexOutput, minDistanceOutput).
+ * El resultado se almacena en (dmIndexOutput, minDistanceOutput).
 */
-void findDMByCoordinates(double x, double y, double z, double decl, int *bdIndexOutput, double *minDistanceOutput) {
-    int bdIndex = -1;
-    double minDistance = *minDistanceOutput;
-	for (int i = 0; i < BDstars; i++) {
-        double dist = 3600.0 * calcAngularDistance(x, y, z, BDstar[i].x, BDstar[i].y, BDstar[i].z);
-        if (minDistance > dist) {
-        	bdIndex = i;
-        	minDistance = dist;
-        }
-    }
-    *bdIndexOutput = bdIndex;
-    *minDistanceOutput = minDistance;
+void findDMByCoordinates(double x, double y, double z, double decl, int *dmIndexOutput, double *minDistanceOutput) {
+    findDMStoreByCoordinates(getDMStore(), x, y, z, decl, dmIndexOutput, minDistanceOutput);
 }
@@ -14,15 +14,16 @@
 #include "trig.h"
 
 #define MAX_DECL 90
-#define MAX_NUM 12500
+#define CPD_STRIDE ((int) (sizeof(struct CPDstar_struct) / sizeof(double)))
 
-static struct CPDstar_struct CPDstar[MAXCPDSTAR];
+static struct Arena_struct CPDarena;
+static struct CPDstar_struct *CPDstar = NULL;
+static struct UnitCopy_struct CPDunit; /* copia float32 de (x, y, z) para filtrar búsquedas */
 static int CPDstars = 0;
 
-/* Mapa para acceder rápido según declinación y num:
-   el índice devuelto es la estrella DM decl num, pero de haber
-   más de una (por suppl) se utiliza la lista enlazada */
-static int mapCPDindex[MAX_DECL][MAX_NUM];
+/* Índice de designaciones por declinación (zona) y num: de haber varias estrellas
+   CPD decl num se devuelve la última leída (las suplementarias se omiten) */
+static struct DesignationIndex_struct CPDdesignation;
 
 /*
  * getCPDStars - devuelve la cantidad de estrellas de CPD leidas
@@ -38,21 +39,25 @@ int getCPDStars()
 int getCPDindex(int declRef, int numRef) {
     declRef = abs(declRef);
     if (declRef >= MAX_DECL) bye("Declination error!");
-    if (numRef >= MAX_NUM) bye("Number error!");
-    return mapCPDindex[declRef][numRef];
+    int count;
+    const struct Designation_struct *d = findDesignation(&CPDdesignation, declRef, numRef, &count);
+    return d != NULL ? d[count - 1].index : -1;
 }
 
 /*
- * setCPDindex - asigna el índice a partir de la declinación y num
+ * buildCPDindex - arma el índice de designaciones por declinación y num
  */
-void setCPDindex(int declRef, int numRef, int index) {
-    declRef = abs(declRef);
-    if (declRef >= MAX_DECL) {
-        printf("Num: %d %d\n", declRef, numRef);
-        bye("Declination error!");
+static void buildCPDindex() {
+    initDesignationIndex(&CPDdesignation, &CPDarena, MAX_DECL, CPDstars);
+    for (int i = 0; i < CPDstars; i++) {
+        int declRef = abs(CPDstar[i].declRef);
+        if (declRef >= MAX_DECL) {
+            logPrintf("Num: %d %d\n", declRef, CPDstar[i].numRef);
+            bye("Declination error!");
+        }
+        addDesignation(&CPDdesignation, declRef, CPDstar[i].numRef, ' ', i);
     }
-    if (numRef >= MAX_NUM) bye("Number error!");
-    mapCPDindex[declRef][numRef] = index;
+    sortDesignationIndex(&CPDdesignation);
 }
 
 /*
@@ -89,26 +94,33 @@ struct CPDstar_struct *getCPDStruct()
  * false = utiliza catálogo 4005
  */
 void readCPD(bool cross, bool catalog)
+{
+    loadCPD(cross);
+    if (cross) crossCPD(catalog);
+}
+
+/*
+ * loadCPD - primera fase de readCPD: lee CPD (no depende de CD, así que puede
+ * correr a la par de su lectura; si "cross" es true, desde la declinación -22)
+ */
+void loadCPD(bool cross)
 {
     FILE *stream;
     char buffer[1024];
     char cell[256];
 
-    int CDstars = getDMStars();
-    struct DMstar_struct *CDstar = getDMStruct();
-
-    stream = fopen("cat/cpd.txt", "rt");
+    stream = openInputFile("cat/cpd.txt");
     if (stream == NULL) {
         perror("Cannot read cpd.txt");
         exit(1);
     }
 
-    for (int decl = 0; decl < MAX_DECL; decl++) {
-        for (int num = 0; num < MAX_NUM; num++) {
-            mapCPDindex[decl][num] = -1;
-        }
-    }
- 
+    /* el catálogo se dimensiona según su tamaño (registros de 32 caracteres y salto de línea) */
+    int capacity = estimateLines(stream, 33);
+    resetArena(&CPDarena, (size_t) capacity * (sizeof(struct CPDstar_struct) + sizeof(struct Designation_struct)));
+    CPDstar = (struct CPDstar_struct *) allocArena(&CPDarena, (size_t) capacity * sizeof(struct CPDstar_struct));
+    CPDdesignation.column = NULL;
+
     CPDstars = 0;
     while (fgets(buffer, 1023, stream) != NULL) {
         /* lee la zona de declinacion */
@@ -122,7 +134,7 @@ void readCPD(bool cross, bool catalog)
         char supplRef = buffer[11-1];
         if (supplRef == 'D') continue;
         if (supplRef != ' ') {
-            printf("Ommitting star CPD %d°%d%c\n", declRef, numRef, supplRef);
+            logPrintf("Ommitting star CPD %d°%d%c\n", declRef, numRef, supplRef);
             continue;
         }
 
@@ -132,7 +144,7 @@ void readCPD(bool cross, bool catalog)
         if (pmag > 11.4) {
             /* vmag no es una magnitud, si no un codigo */
             if ((pmag > 19.9 && pmag < 20.1) || (pmag > 29.9 && pmag < 30.1)) continue;
-            printf("Unknown code: %f, CPD %d°%d\n", pmag, declRef, numRef);
+            logPrintf("Unknown code: %f, CPD %d°%d\n", pmag, declRef, numRef);
             exit(1);
         }
 
@@ -162,7 +174,10 @@ void readCPD(bool cross, bool catalog)
         sph2rec(RA, Decl, &x, &y, &z);
 
         /* la almacena en memoria */
-		if (CPDstars == MAXCPDSTAR) bye("Maximum amount reached!\n");
+		if (CPDstars == capacity) {
+			capacity *= 2;
+			CPDstar = (struct CPDstar_struct *) growArenaArray(&CPDarena, CPDstar, CPDstars, capacity, sizeof(struct CPDstar_struct));
+		}
         CPDstar[CPDstars].discard = true; /* todas comienzan descartadas a menos que se cruce */
         CPDstar[CPDstars].declRef = declRef;
         CPDstar[CPDstars].numRef = numRef;
@@ -177,25 +192,36 @@ void readCPD(bool cross, bool catalog)
         CPDstar[CPDstars].declRef2 = -1; /* idem */
         CPDstar[CPDstars].numRef2 = -1; /* idem */
 
-        setCPDindex(declRef, numRef, CPDstars);
-
         CPDstars++;
     }
-    printf("Stars read from Cape Photographic Durchmusterung: %d\n", CPDstars);
-    fclose(stream);
+    buildCPDindex();
+    buildUnitCopy(&CPDunit, &CPDarena, &CPDstar[0].x, CPD_STRIDE, CPDstars);
+    logPrintf("Stars read from Cape Photographic Durchmusterung: %d\n", CPDstars);
+    closeInputFile(stream);
+}
+
+/*
+ * crossCPD - segunda fase de readCPD: asocia CPD con CD (ya leido) según el
+ * catálogo 4011 (catalog = true) o 4005, y luego revisa con el 4019
+ */
+void crossCPD(bool catalog)
+{
+    FILE *stream;
+    char buffer[1024];
+    char cell[256];
 
-    if (!cross) return;
+    struct DMstar_struct *CDstar = getDMStruct();
 
     if (catalog) {
         /* siguiente fase: leer identificación cruzada del catálogo 4011 (Bonnet) */
-        stream = fopen("cat/4011.txt", "rt");
+        stream = openInputFile("cat/4011.txt");
         if (stream == NULL) {
             perror("Cannot read 4011.txt");
             exit(1);
         }
     } else {
         /* siguiente fase: leer identificación cruzada del catálogo 4005 */
-        stream = fopen("cat/4005.txt", "rt");
+        stream = openInputFile("cat/4005.txt");
         if (stream == NULL) {
             perror("Cannot read 4005.txt");
             exit(1);
@@ -216,7 +242,7 @@ void readCPD(bool cross, bool catalog)
             if (numRefCP == 0) continue;
             readField(buffer, cell, 14, 1);
             if (cell[0] != ' ') {
-                printf("Something different from space in col 14 for CPD %d°%d\n", declRefCP, numRefCP);
+                logPrintf("Something different from space in col 14 for CPD %d°%d\n", declRefCP, numRefCP);
                 exit(1);
             }
 
@@ -232,7 +258,7 @@ void readCPD(bool cross, bool catalog)
             if (numRefCD == 0) continue;
             readField(buffer, cell, 26, 1);
             if (cell[0] != ' ') {
-                printf("Something different from space in col 26 for CD %d°%d\n", declRefCD, numRefCD);
+                logPrintf("Something different from space in col 26 for CD %d°%d\n", declRefCD, numRefCD);
                 exit(1);
             }
         } else { /* CATALOGO 4005 */
@@ -284,17 +310,18 @@ void readCPD(bool cross, bool catalog)
          * de una, escoger la de menor distancia */
         int dmIndex = -1;
         double minDistance = 9999999999;
-        int i = getDMindex(true, declRefCD, numRefCD);
-        while (i != -1) {
+        int count;
+        const struct Designation_struct *d = getDMComponents(true, declRefCD, numRefCD, &count);
+        for (int c = 0; c < count; c++) {
+          int i = d[c].index;
           double dist = 3600.0 * calcAngularDistance(x, y, z, CDstar[i].x, CDstar[i].y, CDstar[i].z);
           if (minDistance > dist) {
             dmIndex = i;
             minDistance = dist;
           }
-          i = CDstar[i].next;
         }
         if (dmIndex == -1) {
-          printf("CD %d°%d not found (corresponding to CPD %d°%d). Discarding CPD star.\n",
+          logPrintf("CD %d°%d not found (corresponding to CPD %d°%d). Discarding CPD star.\n",
             declRefCD, numRefCD, declRefCP, numRefCP);
           continue;
         }
@@ -304,7 +331,7 @@ void readCPD(bool cross, bool catalog)
           if (declRefCD == declRefCP) {
             if (abs(numRefCD - numRefCDprevious) > 50) {
               if (declRefCD == declRefCP && numRefCP > 2) {
-                printf("Warning: CPD %d°%d asoociated to CD %d, but previous one was CD %d.\n",
+                logPrintf("Warning: CPD %d°%d asoociated to CD %d, but previous one was CD %d.\n",
                     declRefCP, numRefCP, numRefCD, numRefCDprevious);
               } 
             }
@@ -316,14 +343,13 @@ void readCPD(bool cross, bool catalog)
         CPDstar[catIndex].discard = false;
         CPDstar[catIndex].dmIndex = dmIndex;
         CPDstar[catIndex].dist = minDistance;
-        CDstar[dmIndex].catIndex = catIndex;
         crossed++;
     }
-    printf("Number of CPD stars cross-identified with CD stars: %d\n", crossed);
-    fclose(stream);
+    logPrintf("Number of CPD stars cross-identified with CD stars: %d\n", crossed);
+    closeInputFile(stream);
 
     /*  leer identificación cruzada del catálogo 4019 (Rappaport) */
-    stream = fopen("cat/4019.txt", "rt");
+    stream = openInputFile("cat/4019.txt");
     if (stream == NULL) {
         perror("Cannot read 4019.txt");
         exit(1);
@@ -348,13 +374,13 @@ void readCPD(bool cross, bool catalog)
         int dmIndex = CPDstar[index].dmIndex;
         if (declRefCD != CDstar[dmIndex].declRef || numRefCD != CDstar[dmIndex].numRef) {
             /* las diferencias son almacenadas */
-            printf("Warning: cross-identifications differ for CPD %d°%d: CD %d°%d vs %d°%d\n",
+            logPrintf("Warning: cross-identifications differ for CPD %d°%d: CD %d°%d vs %d°%d\n",
                 declRefCP, numRefCP, declRefCD, numRefCD, CDstar[dmIndex].declRef, CDstar[dmIndex].numRef);
             CPDstar[index].declRef2 = declRefCD;
             CPDstar[index].numRef2 = numRefCD;
         }
     }
-    fclose(stream);
+    closeInputFile(stream);
 }
 
 /* 
@@ -383,13 +409,8 @@ void findCPDByCoordinates(double x, double y, double z, double decl, int *cpdInd
             if (lastIndex != -1) secondIndex = lastIndex;
         }
 
-        for (int i = firstIndex; i < secondIndex; i++) {
-            double dist = 3600.0 * calcAngularDistance(x, y, z, CPDstar[i].x, CPDstar[i].y, CPDstar[i].z);
-            if (minDistance > dist) {
-                cpdIndex = i;
-                minDistance = dist;
-            }
-        }
+        findNearestUnit(&CPDunit, &CPDstar[0].x, CPD_STRIDE, firstIndex, secondIndex,
+            x, y, z, &cpdIndex, &minDistance);
     }
     *cpdIndexOutput = cpdIndex;
     *minDistanceOutput = minDistance;
@@ -3,8 +3,6 @@
  * READ_CPD - Header
  */
 
-#define MAXCPDSTAR 454812
-
 struct CPDstar_struct {
     bool discard; /* true if should not be considered */
     int declRef, numRef; /* identificador con declinacion y numero */
@@ -16,6 +14,9 @@ struct CPDstar_struct {
 };
 
 int getCPDStars();
+int getCPDindex(int declRef, int numRef);
 struct CPDstar_struct *getCPDStruct();
 void readCPD(bool cross, bool catalog);
+void loadCPD(bool cross);
+void crossCPD(bool catalog);
 void findCPDByCoordinates(double x, double y, double z, double decl, int *cpdIndexOutput, double *minDistanceOutput);
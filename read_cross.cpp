@@ -0,0 +1,194 @@
+/*
+ * READ_CROSS - Lee archivos de identificaciones cruzadas (results/cross/<name>.csv)
+ * Made in 2025 by Daniel E. Severin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <charconv>
+#include "read_cross.h"
+#include "misc.h"
+
+/*
+ * parseInt - lee un entero (con signo opcional) de [ptr, end); devuelve el puntero al final o NULL
+ */
+static const char *parseInt(const char *ptr, const char *end, int *value)
+{
+    if (ptr < end && *ptr == '+') ptr++;
+    std::from_chars_result result = std::from_chars(ptr, end, *value);
+    if (result.ec != std::errc()) return NULL;
+    return result.ptr;
+}
+
+/*
+ * parseDesignation - convierte designaciones del tipo "PPM n", "CD -dd°n", "CPD -dd°n",
+ * "BD +dd°n" o "SD -dd°n" en una clave entera (catálogo, zona, número)
+ * Devuelve false (y catalog = CROSS_OTHER) si no es una designación reconocida.
+ */
+bool parseDesignation(const char *name, int *catalog, int *declRef, int *numRef)
+{
+    const char *end = name + strlen(name);
+    const char *ptr;
+    bool zone = true;
+
+    *catalog = CROSS_OTHER;
+    *declRef = 0;
+    *numRef = 0;
+    if (strncmp(name, "PPM ", 4) == 0) {
+        *catalog = CROSS_PPM;
+        ptr = name + 4;
+        zone = false;
+    } else if (strncmp(name, "CD ", 3) == 0) {
+        *catalog = CROSS_CD;
+        ptr = name + 3;
+    } else if (strncmp(name, "CPD ", 4) == 0) {
+        *catalog = CROSS_CPD;
+        ptr = name + 4;
+    } else if (strncmp(name, "BD ", 3) == 0) {
+        *catalog = CROSS_BD;
+        ptr = name + 3;
+    } else if (strncmp(name, "SD ", 3) == 0) {
+        *catalog = CROSS_SD;
+        ptr = name + 3;
+    } else {
+        return false;
+    }
+
+    if (zone) {
+        ptr = parseInt(ptr, end, declRef);
+        /* separador "°" (UTF-8) */
+        if (ptr == NULL || end - ptr < 2 || strncmp(ptr, "°", 2) != 0) {
+            *catalog = CROSS_OTHER;
+            return false;
+        }
+        ptr += 2;
+    }
+    ptr = parseInt(ptr, end, numRef);
+    if (ptr == NULL) {
+        *catalog = CROSS_OTHER;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * parseFloat - lee un real de [ptr, end) (admite espacios previos); devuelve 0 si no hay número
+ */
+static float parseFloat(const char *ptr, const char *end)
+{
+    float value = 0.0;
+    while (ptr < end && *ptr == ' ') ptr++;
+    if (ptr < end && *ptr == '+') ptr++;
+    std::from_chars(ptr, end, value);
+    return value;
+}
+
+/*
+ * readCrossCSV - lee un archivo "index1,index2,mag,dist" (la primera linea es el encabezado)
+ * El archivo se mapea en memoria y los campos se separan en el mismo buffer.
+ * Devuelve false si no se pudo abrir (errno queda con la causa).
+ */
+bool readCrossCSV(const char *filename, struct CrossFile_struct *file)
+{
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = false;
+    file->entries = 0;
+    file->entry = NULL;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    file->size = info.st_size;
+    if (file->size > 0) {
+        /* copia privada: los separadores se reemplazan por ceros */
+        void *data = mmap(NULL, file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            file->data = (char *) data;
+            file->mapped = true;
+            madvise(data, file->size, MADV_SEQUENTIAL);
+        } else {
+            /* no se puede mapear: se lee completo */
+            file->data = (char *) malloc(file->size);
+            if (file->data == NULL) bye("Out of memory!\n");
+            size_t bytes = 0;
+            while (bytes < file->size) {
+                ssize_t n = read(fd, file->data + bytes, file->size - bytes);
+                if (n <= 0) break;
+                bytes += n;
+            }
+            file->size = bytes;
+        }
+    }
+    close(fd);
+
+    char *ptr = file->data;
+    char *end = file->data + file->size;
+
+    /* cuenta las lineas para dimensionar las entradas */
+    int lines = 1;
+    for (char *p = ptr; p < end && (p = (char *) memchr(p, '\n', end - p)) != NULL; p++) lines++;
+    file->entry = (struct CrossEntry_struct *) malloc(lines * sizeof(struct CrossEntry_struct));
+    if (file->entry == NULL) bye("Out of memory!\n");
+
+    bool first_line = true;
+    while (ptr < end) {
+        char *eol = (char *) memchr(ptr, '\n', end - ptr);
+        char *lineEnd = eol != NULL ? eol : end;
+        char *next = eol != NULL ? eol + 1 : end;
+        if (lineEnd > ptr && lineEnd[-1] == '\r') lineEnd--;
+        if (first_line) {
+            // omit first line (header)
+            first_line = false;
+            ptr = next;
+            continue;
+        }
+
+        /* separa los cuatro campos */
+        char *field[4];
+        int fields = 0;
+        field[fields++] = ptr;
+        for (char *p = ptr; p < lineEnd && fields < 4; p++) {
+            if (*p == ',') {
+                *p = 0;
+                field[fields++] = p + 1;
+            }
+        }
+        if (fields == 4 && field[0][0] != 0 && field[1][0] != 0) {
+            struct CrossEntry_struct *entry = &file->entry[file->entries++];
+            entry->index1 = field[0];
+            entry->index2 = field[1];
+            entry->mag = parseFloat(field[2], field[3] - 1);
+            entry->dist = parseFloat(field[3], lineEnd);
+            parseDesignation(entry->index1, &entry->catalog1, &entry->declRef1, &entry->numRef1);
+            parseDesignation(entry->index2, &entry->catalog2, &entry->declRef2, &entry->numRef2);
+        }
+        ptr = next;
+    }
+    return true;
+}
+
+/*
+ * freeCrossCSV - libera la memoria de un archivo leido con readCrossCSV
+ */
+void freeCrossCSV(struct CrossFile_struct *file)
+{
+    if (file->mapped) {
+        munmap(file->data, file->size);
+    } else {
+        free(file->data);
+    }
+    free(file->entry);
+    file->data = NULL;
+    file->entry = NULL;
+    file->entries = 0;
+}
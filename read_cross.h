@@ -0,0 +1,34 @@
+
+/*
+ * READ_CROSS - Header
+ */
+
+#include <stddef.h>
+
+/* catálogos reconocidos en las designaciones */
+#define CROSS_OTHER 0
+#define CROSS_PPM 1
+#define CROSS_CD 2
+#define CROSS_CPD 3
+#define CROSS_BD 4
+#define CROSS_SD 5
+
+/* Fila "index1,index2,mag,dist" de un archivo de identificaciones cruzadas */
+struct CrossEntry_struct {
+    char *index1, *index2; /* designaciones (apuntan dentro del archivo leído) */
+    int catalog1, declRef1, numRef1; /* clave de index1 (declRef = 0 si no tiene zona) */
+    int catalog2, declRef2, numRef2; /* clave de index2 */
+    float mag, dist;
+};
+
+struct CrossFile_struct {
+    char *data; /* contenido del archivo (mapeado en memoria) */
+    size_t size;
+    bool mapped;
+    int entries;
+    struct CrossEntry_struct *entry;
+};
+
+bool parseDesignation(const char *name, int *catalog, int *declRef, int *numRef);
+bool readCrossCSV(const char *filename, struct CrossFile_struct *file);
+void freeCrossCSV(struct CrossFile_struct *file);
@@ -0,0 +1,457 @@
+/*
+ * READ_DM - Almacén de un Durchmusterung (BD, CD o SD) que puede instanciarse
+ * varias veces, de modo que un mismo proceso tenga los tres catálogos en memoria
+ * Made in 2025 by Daniel E. Severin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "read_dm.h"
+#include "misc.h"
+#include "trig.h"
+
+#define MAX_DECL 90
+#define DM_STRIDE ((int) (sizeof(struct DMstar_struct) / sizeof(double)))
+
+/* tomos de CD: primera y última declinación y cantidad de páginas (para writeRegister) */
+#define CD_TOMOS 5
+static const int tomoFirstDecl[CD_TOMOS] = {-22, -32, -42, -52, -62};
+static const int tomoLastDecl[CD_TOMOS] = {-31, -41, -51, -61, -MAX_DECL};
+static const int tomoPages[CD_TOMOS] = {605, 539, 503, 305, 400}; // TO DO: obtener número de páginas de XXIb
+
+struct DMstore_struct {
+    int catalog; /* DM_BD, DM_CD o DM_SD */
+    struct Arena_struct arena;
+    struct DMstar_struct *star;
+    struct DMregister_struct *reg;
+    struct UnitCopy_struct unit; /* copia float32 de (x, y, z) para filtrar búsquedas */
+    int stars;
+
+    /* Índice de designaciones por zona: las zonas sur (-decl) son 0..declSouth - 1 y
+       las norte (+decl) siguen a continuación; las componentes de misma decl y num
+       (por suppl) quedan contiguas */
+    struct DesignationIndex_struct designation;
+    int declNorth, declSouth; /* cantidad de zonas de cada signo */
+
+    int *reindexByIndex; /* (BD) índice con declinaciones ascendentes, para la página */
+    int tomoStars[CD_TOMOS], tomoFirstIndex[CD_TOMOS]; /* (CD) metadata por tomo */
+};
+
+/*
+ * newDMStore - crea un almacén vacío para el catálogo dado (DM_BD, DM_CD o DM_SD)
+ */
+struct DMstore_struct *newDMStore(int catalog)
+{
+    struct DMstore_struct *store = (struct DMstore_struct *) calloc(1, sizeof(struct DMstore_struct));
+    if (store == NULL) bye("Out of memory!\n");
+    store->catalog = catalog;
+
+    /* BD tiene zonas norte +00..+89 y sur -00, -01; CD y SD solo zonas sur */
+    store->declNorth = (catalog == DM_BD) ? MAX_DECL : 0;
+    store->declSouth = (catalog == DM_BD) ? 2 : MAX_DECL;
+    return store;
+}
+
+/*
+ * freeDMStore - libera el almacén y todas sus estrellas
+ */
+void freeDMStore(struct DMstore_struct *store)
+{
+    freeArena(&store->arena);
+    free(store);
+}
+
+/*
+ * getDMStoreCatalog - devuelve el catálogo del almacén (DM_BD, DM_CD o DM_SD)
+ */
+int getDMStoreCatalog(struct DMstore_struct *store)
+{
+    return store->catalog;
+}
+
+/*
+ * getDMStoreStars - devuelve la cantidad de estrellas leidas en el almacén
+ */
+int getDMStoreStars(struct DMstore_struct *store)
+{
+    return store->stars;
+}
+
+/*
+ * getDMStoreStruct - devuelve la estructura de estrellas del almacén
+ */
+struct DMstar_struct *getDMStoreStruct(struct DMstore_struct *store)
+{
+    return store->star;
+}
+
+/*
+ * getDMStoreRegister - devuelve los datos de registro del almacén (mismo índice que getDMStoreStruct)
+ */
+struct DMregister_struct *getDMStoreRegister(struct DMstore_struct *store)
+{
+    return store->reg;
+}
+
+/*
+ * getDMStoreComponents - devuelve las componentes (a/b/c) de la estrella de signo,
+ * declinación y num, contiguas y en orden de suppl, y su cantidad en *count
+ */
+const struct Designation_struct *getDMStoreComponents(struct DMstore_struct *store, bool signRef, int declRef, int numRef, int *count)
+{
+    int zones = signRef ? store->declSouth : store->declNorth;
+    if (zones == 0) bye("Sign error!");
+    declRef = abs(declRef);
+    if (declRef >= zones) bye("Declination error!");
+    int zone = signRef ? declRef : store->declSouth + declRef;
+    return findDesignation(&store->designation, zone, numRef, count);
+}
+
+/*
+ * getDMStoreIndex - devuelve el índice a partir del signo, declinación y num
+ * (la primera componente en orden de archivo, o -1 si no existe)
+ */
+int getDMStoreIndex(struct DMstore_struct *store, bool signRef, int declRef, int numRef)
+{
+    int count;
+    const struct Designation_struct *d = getDMStoreComponents(store, signRef, declRef, numRef, &count);
+    if (d == NULL) return -1;
+    /* las componentes vienen ordenadas por suppl: la primera del archivo es la de menor índice */
+    int first = d[0].index;
+    for (int k = 1; k < count; k++) if (d[k].index < first) first = d[k].index;
+    return first;
+}
+
+/*
+ * buildDMindex - arma el índice de designaciones por signo, declinación y num
+ */
+static void buildDMindex(struct DMstore_struct *store)
+{
+    struct DMstar_struct *star = store->star;
+    struct DMregister_struct *reg = store->reg;
+    initDesignationIndex(&store->designation, &store->arena, store->declSouth + store->declNorth, store->stars);
+    for (int i = 0; i < store->stars; i++) {
+        int declRef = abs(star[i].declRef);
+        if (declRef >= (star[i].signRef ? store->declSouth : store->declNorth)) bye("Declination error!");
+        int zone = star[i].signRef ? declRef : store->declSouth + declRef;
+        addDesignation(&store->designation, zone, star[i].numRef, reg[i].supplRef, i);
+    }
+    sortDesignationIndex(&store->designation);
+}
+
+/*
+ * buildReindex - (BD) calcula el indice pero con declinaciones ascendentes, aquí decl = -2
+ * es declinación -01, decl = -1 es -00 y para decl >= 0 ya es la declinación positiva.
+ */
+static void buildReindex(struct DMstore_struct *store)
+{
+    struct DMstar_struct *star = store->star;
+    int reindex = 0;
+    for (int decl = -2; decl <= 89; decl++) {
+        for (int i = 0; i < store->stars; i++) {
+            if (decl == -2) {
+                if (star[i].declRef != -1 || !star[i].signRef) continue;
+            } else {
+                if (decl == -1) {
+                    if (star[i].declRef != 0 || !star[i].signRef) continue;
+                } else {
+                    if (star[i].declRef != decl || star[i].signRef) continue;
+                }
+            }
+            store->reindexByIndex[i] = reindex;
+            reindex++;
+        }
+    }
+    if (reindex != store->stars) {
+        logPrintf("Some star is missing or duplicated :(\n");
+        exit(1);
+    }
+}
+
+/*
+ * writeDMStoreRegister - escribe en pantalla un registro del almacén en el formato de su catálogo
+ * (BD: solo funciona para el primer volumen; SD: solo si se leyó únicamente la declinación -22)
+ */
+void writeDMStoreRegister(struct DMstore_struct *store, int dmIndex, bool neighbors)
+{
+    struct DMstar_struct *s = &store->star[dmIndex];
+    struct DMregister_struct *r = &store->reg[dmIndex];
+
+    int declRef = s->declRef;
+    int numRef = s->numRef;
+    int page = 0;
+    switch (store->catalog) {
+        case DM_CD:
+            for (int t = 0; t < CD_TOMOS; t++) {
+                if (declRef > tomoFirstDecl[t] || declRef < tomoLastDecl[t]) continue;
+                page = tomoPages[t] * (dmIndex - store->tomoFirstIndex[t]) / store->tomoStars[t];
+            }
+            logPrintf("     Register CD %d°%d (en %.0fh):  %.1f | %.0fm%.1fs | %.1f'     (pag. %d)\n",
+                        declRef, numRef, r->rah, s->vmag, r->ramin, r->raseg, r->declmin, page);
+            break;
+        case DM_BD:
+            page = 1 + 378 * store->reindexByIndex[dmIndex] / store->stars;
+            logPrintf("     Register BD %c%d°%d (en %.0fh):  %.1f | %.0fm%.1fs | %.1f'     (pag. %d)\n",
+                        s->signRef ? '-' : '+', abs(declRef), numRef, r->rah, s->vmag, r->ramin, r->raseg, r->declmin, page);
+            break;
+        default:
+            page = 438 + 22 * dmIndex / store->stars;
+            logPrintf("     Register SD %d°%d (en %.0fh):  %.1f | %.0fm%.1fs | %.1f'     (pag. %d)\n",
+                        declRef, numRef, r->rah, s->vmag, r->ramin, r->raseg, r->declmin, page);
+            break;
+    }
+    if (neighbors) {
+        logPrintf("   Neighbors:\n");
+        writeDMStoreRegister(store, dmIndex - 1, false);
+        writeDMStoreRegister(store, dmIndex + 1, false);
+    }
+}
+
+/*
+ * readDMStore - lee base de datos del Durchmusterung en el almacén
+ *
+ * CD (coordenadas 1875):
+   Bytes Format   Units    Label       Explanations
+    1-  2  A2      ---      ---         [CD] The catalog prefix
+    3-  5  I3      deg      zone        [-22/-89] The declination zone
+    6- 10  I5      ---      num         The number of the star within the zone
+       11  A1      ---      suppl      *[a-c D] star in corrigenda
+   12- 15  F4.1    mag      mag        *Estimated visual magnitude
+   16- 17  I2      h        RAh         Hours of right ascension, 1875
+   18- 19  I2      min      RAm         Minutes of right ascension, 1875
+   20- 23  F4.1    s        RAs        *Seconds of right ascension, 1875
+       24  A1      ---      DE-         [-] Sign of declination
+   25- 26  I2      deg      DEd         Degree of declination, 1875
+   27- 30  F4.1    arcmin   DEm         Minutes of declination, 1875
+ *
+ * BD (coordenadas 1855):
+   Bytes      Format   Units    Label       Explanations
+    1- 2        A2      ---      ---        [BD] The catalog prefix
+       3        A1      ---      zonesign   [+-]The sign of the declination zone
+    4- 5        I2      deg      zone       The declination zone
+    6-10        I5      ---      num        The number of the star within the zone
+      11        A1      ---      suppl     *[a-c D*?M] Note
+   12-15      F4.1      mag      mag       *Estimated visual magnitude
+   16-17        I2      h        RAh        Right Ascension 1855 (hours)
+   18-19        I2      min      RAm        Right Ascension 1855 (minutes)
+   20-23      F4.1      s        RAs        Right Ascension, 1855 (seconds)
+   24-24        A1      ---      DE-        [+-]Sign of declination
+   25-26        I2      deg      DEd        Declination 1855 (degrees)
+   27-30      F4.1      arcmin   DEm        Declination 1855 (minutes)
+ *
+ * SD: mismo formato que BD (minutos de declinación en bytes 27-32), pero las
+ * coordenadas rectangulares se llevan a 1875 para poder cruzarlo con CD.
+ *
+ * Nota: se descartan estrellas variables y objetos nebulares
+ */
+void readDMStore(struct DMstore_struct *store, const char *filename)
+{
+    FILE *stream;
+    char buffer[1024];
+    char cell[256];
+    int catalog = store->catalog;
+
+    stream = openInputFile(filename);
+    if (stream == NULL) {
+        snprintf(buffer, 1024, "Cannot read %s", filename);
+        perror(buffer);
+        exit(1);
+    }
+
+    /* el catálogo se dimensiona según su tamaño (registros de 30 caracteres y salto de línea) */
+    int capacity = estimateLines(stream, 31);
+    size_t bytes = (size_t) capacity * (sizeof(struct DMstar_struct) + sizeof(struct DMregister_struct) + sizeof(struct Designation_struct));
+    if (catalog == DM_BD) bytes += (size_t) capacity * sizeof(int);
+    resetArena(&store->arena, bytes);
+    store->star = (struct DMstar_struct *) allocArena(&store->arena, (size_t) capacity * sizeof(struct DMstar_struct));
+    store->reg = (struct DMregister_struct *) allocArena(&store->arena, (size_t) capacity * sizeof(struct DMregister_struct));
+    store->reindexByIndex = NULL;
+    store->designation.column = NULL;
+    for (int t = 0; t < CD_TOMOS; t++) {
+        store->tomoStars[t] = 0;
+        store->tomoFirstIndex[t] = -1;
+    }
+
+    struct DMstar_struct *star = store->star;
+    struct DMregister_struct *reg = store->reg;
+    int stars = 0;
+    while (fgets(buffer, 1023, stream) != NULL) {
+        /* lee la zona de declinacion (en BD es necesario también conocer el signo para
+         * diferenciar la declinación +00 de la -00). */
+        bool zoneSign = true;
+        int declRef;
+        if (catalog == DM_BD) {
+            readField(buffer, cell, 3, 1);
+            zoneSign = (cell[0] == '-');
+            readField(buffer, cell, 4, 2);
+            declRef = atoi(cell);
+            if (zoneSign) declRef = -declRef;
+        } else {
+            readField(buffer, cell, 3, 3);
+            declRef = atoi(cell);
+        }
+
+        /* lee numeracion y caracter suplementario */
+        readField(buffer, cell, 6, 5);
+        int numRef = atoi(cell);
+        readField(buffer, cell, 11, 1);
+        char supplRef = cell[0];
+        if (supplRef == 'D') continue;
+        if (catalog == DM_BD && supplRef == '*') {
+            logPrintf("Star already corrected (BD %d°%d)\n", declRef, numRef);
+            continue;
+        }
+        if (catalog == DM_SD && supplRef != ' ') {
+            logPrintf("Ommitting star SD %d°%d%c\n", declRef, numRef, supplRef);
+            continue;
+        }
+
+        /* lee magnitud visual */
+        readField(buffer, cell, 12, 4);
+        double vmag = atof(cell);
+        if (vmag > 12.1) {
+            /* vmag no es una magnitud, si no un codigo:
+             * 20.0 = neb
+             * 30.0 = var
+             * 40.0 = nova or nova? (en CD: M4)
+             * 50.0 = cluster (en CD: 47 Tuc) */
+            if ((vmag > 19.9 && vmag < 20.1) || (vmag > 39.9 && vmag < 40.1) || (vmag > 49.9 && vmag < 50.1)) continue;
+            if (vmag > 29.9 && vmag < 30.1) {
+                /* estrella variable */
+            } else if (catalog == DM_CD) {
+                logPrintf("Unknown code: %f for CD %d°%d. Setting as variable.\n", vmag, declRef, numRef);
+                vmag = 30.0;
+                continue;
+            } else {
+                logPrintf("Unknown code: %f, %s %d°%d\n", vmag, catalog == DM_BD ? "BD" : "SD", declRef, numRef);
+                exit(1);
+            }
+        }
+
+        /* lee ascension recta (B1875.0 en CD, B1855.0 en BD y SD) */
+        readField(buffer, cell, 16, 2);
+        float rah = atof(cell);
+        double RA = rah;
+        readField(buffer, cell, 18, 2);
+        float ramin = atof(cell);
+        RA += ramin/60.0;
+        readField(buffer, cell, 20, 4);
+        float raseg = atof(cell);
+        RA += raseg/3600.0;
+        RA *= 15.0; /* conversion horas a grados */
+
+        /* lee declinacion; en CD y SD el signo es siempre negativo */
+        bool sign = true;
+        if (catalog == DM_BD) {
+            readField(buffer, cell, 24, 1);
+            sign = (cell[0] == '-');
+        }
+        readField(buffer, cell, 25, 2);
+        float decldeg = atof(cell);
+        double Decl = decldeg;
+        readField(buffer, cell, 27, catalog == DM_SD ? 6 : 4);
+        float declmin = atof(cell);
+        Decl += declmin/60.0;
+        if (sign) Decl = -Decl;
+
+        /* calcula coordenadas rectangulares (SD: de 1875.0) */
+        double RA1875 = RA;
+        double Decl1875 = Decl;
+        if (catalog == DM_SD) transform(1855.0, 1875.0, &RA1875, &Decl1875);
+        double x, y, z;
+        if (catalog == DM_BD) sph2rec(RA, Decl, &x, &y, &z);
+        else sph2rec(RA1875, Decl1875, &x, &y, &z);
+
+        /* la almacena en memoria */
+        if (stars == capacity) {
+            capacity *= 2;
+            star = store->star = (struct DMstar_struct *) growArenaArray(&store->arena, star, stars, capacity, sizeof(struct DMstar_struct));
+            reg = store->reg = (struct DMregister_struct *) growArenaArray(&store->arena, reg, stars, capacity, sizeof(struct DMregister_struct));
+        }
+        star[stars].signRef = zoneSign;
+        star[stars].declRef = declRef;
+        star[stars].numRef = numRef;
+        star[stars].vmag = vmag;
+        star[stars].x = x;
+        star[stars].y = y;
+        star[stars].z = z;
+        reg[stars].supplRef = supplRef;
+        reg[stars].rah = rah;
+        reg[stars].ramin = ramin;
+        reg[stars].raseg = raseg;
+        reg[stars].decldeg = decldeg;
+        reg[stars].declmin = declmin;
+        reg[stars].RA1855 = (catalog == DM_CD) ? 0.0 : RA;
+        reg[stars].Decl1855 = (catalog == DM_CD) ? 0.0 : Decl;
+        reg[stars].RA1875 = (catalog == DM_BD) ? 0.0 : RA1875;
+        reg[stars].Decl1875 = (catalog == DM_BD) ? 0.0 : Decl1875;
+
+        /* (CD) crea metadata para conocer el número de página en el Tomo */
+        if (catalog == DM_CD) {
+            for (int t = 0; t < CD_TOMOS; t++) {
+                if (declRef > tomoFirstDecl[t] || declRef < tomoLastDecl[t]) continue;
+                if (store->tomoFirstIndex[t] == -1) store->tomoFirstIndex[t] = stars;
+                store->tomoStars[t]++;
+            }
+        }
+
+        /* proxima estrella */
+        stars++;
+    }
+    store->stars = stars;
+    buildDMindex(store);
+    buildUnitCopy(&store->unit, &store->arena, &star[0].x, DM_STRIDE, stars);
+    switch (catalog) {
+        case DM_CD:
+            logPrintf("Stars read from Cordoba Durchmusterung: %d\n", stars);
+            logPrintf("   Tomo XVI: %d, Tomo XVII: %d, Tomo XVIII: %d, Tomo XXIa: %d, Tomo XXIb: %d\n",
+                        store->tomoStars[0], store->tomoStars[1], store->tomoStars[2], store->tomoStars[3], store->tomoStars[4]);
+            break;
+        case DM_BD:
+            logPrintf("Stars read from Bonner Durchmusterung: %d\n", stars);
+            store->reindexByIndex = (int *) allocArena(&store->arena, (size_t) stars * sizeof(int));
+            buildReindex(store);
+            break;
+        default:
+            logPrintf("Stars read from Southern Durchmusterung: %d\n", stars);
+            break;
+    }
+    closeInputFile(stream);
+}
+
+/*
+ * findDMStoreByCoordinates - busca la estrella más cercana del almacén
+ * Aquí (x, y, z) son las coord rectangulares en 1875 (CD y SD) o 1855 (BD).
+ * En CD también se pasa la declinación target para acelerar la búsqueda
+ * (nota: se asume que las estrellas vienen ordenadas por declinación);
+ * en BD y SD "decl" aun no está implementado y no se utiliza.
+ * minDistanceOutput debe ser una cota de la distancia a buscar.
+ * El resultado se almacena en (indexOutput, minDistanceOutput).
+*/
+void findDMStoreByCoordinates(struct DMstore_struct *store, double x, double y, double z, double decl, int *indexOutput, double *minDistanceOutput)
+{
+    int index = -1;
+    double minDistance = *minDistanceOutput;
+    int firstIndex = 0;
+    int secondIndex = store->stars;
+
+    if (store->stars > 0) {
+        if (store->catalog == DM_CD) {
+            decl = fabs(decl);
+            int firstDecl = (int) floor(decl - 0.2);
+            if (firstDecl < 22) firstDecl = 22;
+            firstIndex = getDMStoreIndex(store, true, firstDecl, 1);
+            int secondDecl = (int) ceil(decl + 0.2);
+            if (secondDecl < 23) secondDecl = 23;
+            if (secondDecl < MAX_DECL) {
+                int lastIndex = getDMStoreIndex(store, true, secondDecl, 1);
+                if (lastIndex != -1) secondIndex = lastIndex;
+            }
+        }
+        findNearestUnit(&store->unit, &store->star[0].x, DM_STRIDE, firstIndex, secondIndex,
+            x, y, z, &index, &minDistance);
+    }
+    *indexOutput = index;
+    *minDistanceOutput = minDistance;
+}
@@ -1,29 +1,56 @@
 
 /*
- * READ_DM - Header (CD y BD)
+ * READ_DM - Header (BD, CD y SD)
  */
 
-#define MAXDMSTAR 613959
-
 /* Nota: una estrella se distingue con los 4 identificadores:
-     signRef, declRef, numRef y supplRef */
+     signRef, declRef, numRef y supplRef (este último en DMregister_struct).
+   El almacén se divide en dos arreglos indexados por el mismo índice:
+   DMstar_struct con lo que usan búsquedas y cruzamientos, y
+   DMregister_struct con los datos del registro (solo para mostrarlo o compararlo) */
 struct DMstar_struct {
-    bool signRef; /* true if sign of declRef is negative */
+    double x, y, z; /* coordenadas rectangulares en circulo unidad */
+    double vmag; /* magnitud visual */
     int declRef, numRef; /* identificador con declinacion y numero */
+    bool signRef; /* true if sign of declRef is negative */
+};
+
+struct DMregister_struct {
     char supplRef; /* identificador suplementario (a,b,c) */
     float rah, ramin, raseg, decldeg, declmin; /* Ascension recta y declinacion, en partes */
     double RA1855, Decl1855; /* coordenadas (BD) */
     double RA1875, Decl1875; /* coordenadas (CD) */
-    double vmag; /* magnitud visual */
-    int catIndex; /* Indice al indice del otro catálogo en caso de existir, o -1 sino */
-    double x, y, z; /* coordenadas rectangulares en circulo unidad */
-    int next; /* lista a la siguiente estrella de misma decl y num, o -1 = última */
 };
 
+struct Designation_struct; /* ver misc.h */
+
+/* Almacén instanciable: un mismo proceso puede tener BD, CD y SD a la vez */
+#define DM_BD 0
+#define DM_CD 1
+#define DM_SD 2
+
+struct DMstore_struct;
+
+struct DMstore_struct *newDMStore(int catalog);
+void freeDMStore(struct DMstore_struct *store);
+int getDMStoreCatalog(struct DMstore_struct *store);
+int getDMStoreStars(struct DMstore_struct *store);
+struct DMstar_struct *getDMStoreStruct(struct DMstore_struct *store);
+struct DMregister_struct *getDMStoreRegister(struct DMstore_struct *store);
+int getDMStoreIndex(struct DMstore_struct *store, bool signRef, int declRef, int numRef);
+const struct Designation_struct *getDMStoreComponents(struct DMstore_struct *store, bool signRef, int declRef, int numRef, int *count);
+void writeDMStoreRegister(struct DMstore_struct *store, int dmIndex, bool neighbors);
+void readDMStore(struct DMstore_struct *store, const char *filename);
+void findDMStoreByCoordinates(struct DMstore_struct *store, double x, double y, double z, double decl, int *index, double *minDistance);
+
+/* Almacén por defecto: read_cd.cpp (CD) o read_bd.cpp (BD) según con cuál se enlace */
+struct DMstore_struct *getDMStore();
 int getDMStars();
 int getDMindex(bool signRef, int declRef, int numRef);
+const struct Designation_struct *getDMComponents(bool signRef, int declRef, int numRef, int *count);
 bool isCD();
 struct DMstar_struct *getDMStruct();
+struct DMregister_struct *getDMRegisterStruct();
 void writeRegister(int dmIndex, bool neighbors);
 void readDM(const char *filename);
 void findDMByCoordinates(double x, double y, double z, double decl, int *index, double *minDistance);
@@ -5,13 +5,15 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include "trig.h"
 #include "misc.h"
 #include "read_gc.h"
 
-struct GCstar_struct GCstar[MAXGCSTAR];
+static struct Arena_struct GCarena;
+static struct GCstar_struct *GCstar = NULL;
 
 int GCstars;
 
@@ -35,7 +37,7 @@ struct GCstar_struct *getGCStruct()
  * writeRegister - escribe en pantalla un registro de GC
  */
 void writeRegisterGC(int index) {
-	printf("     Register GC %d: mag = %.1f, RA = %02dh%02dm%02ds%02d, DE = %02d°%02d'%02d''%01d (pag %d) %s%s%s\n",
+	logPrintf("     Register GC %d: mag = %.1f, RA = %02dh%02dm%02ds%02d, DE = %02d°%02d'%02d''%01d (pag %d) %s%s%s\n",
 		GCstar[index].gcRef,
 		GCstar[index].vmag,
 		GCstar[index].RAh,
@@ -90,12 +92,17 @@ void readGC()
     GCstars = 0;
 	
 	// Lee Catálogo General Argentino
-	stream = fopen("cat/gc.txt", "rt");
+	stream = openInputFile("cat/gc.txt");
 	if (stream == NULL) {
 		perror("Cannot read gc.txt");
 		exit(1);
 	}
 
+	/* el catálogo se dimensiona según su tamaño (registros de 80 caracteres y salto de línea) */
+	int capacity = estimateLines(stream, 81);
+	resetArena(&GCarena, (size_t) capacity * sizeof(struct GCstar_struct));
+	GCstar = (struct GCstar_struct *) allocArena(&GCarena, (size_t) capacity * sizeof(struct GCstar_struct));
+
 	vmag = 0.0;
 	while (fgets(buffer, 1023, stream) != NULL) {
 		entry++;
@@ -174,9 +181,9 @@ void readGC()
 		double x, y, z;
 		sph2rec(RA, Decl, &x, &y, &z);
 
-		if (GCstars == MAXGCSTAR) {
-			printf("Max amount reached!\n");
-			exit(1);
+		if (GCstars == capacity) {
+			capacity *= 2;
+			GCstar = (struct GCstar_struct *) growArenaArray(&GCarena, GCstar, GCstars, capacity, sizeof(struct GCstar_struct));
 		}
 
 		/* almacena la estrella */
@@ -204,7 +211,8 @@ void readGC()
 		GCstars++;
 		//printf("Pos %d: id=%d RA=%.4f Decl=%.4f (%.2f) Vmag=%.1f\n", GCstars, gcRef, RA, Decl, epoch, vmag);
 	}
-	printf("Stars read from Catalogo General Argentino: %d\n", GCstars);
+	closeInputFile(stream);
+	logPrintf("Stars read from Catalogo General Argentino: %d\n", GCstars);
 
 	/* Ahora vamos a identificar las dobles */
 	for (int i = 0; i < GCstars - 1; i++) {
@@ -220,7 +228,7 @@ void readGC()
 	for (int i = 0; i < GCstars; i++) {
 		if (GCstar[i].dpl) countDpl++;
 	}
-	printf("   Doubles: %d, Cumulus: %d, Nebulae: %d, Variables: %d\n",
+	logPrintf("   Doubles: %d, Cumulus: %d, Nebulae: %d, Variables: %d\n",
 		countDpl,
 		cumulus,
 		nebulae,
@@ -16,6 +16,7 @@
 /* Para uso de la libreria WCS: */
 #define WCS_J2000 1 /* J2000(FK5) right ascension and declination */
 #define WCS_B1950 2 /* B1950(FK4) right ascension and declination */
+#define PPM_STRIDE ((int) (sizeof(struct PPMstar_struct) / sizeof(double)))
 extern "C" void wcsconp(int sys1, int sys2, double eq1, double eq2, double ep1, double ep2,
              double *dtheta, double *dphi, double *ptheta, double *pphi);
 //SYNOPSIS:   wcsconp(sys1, sys2, eq1, eq2, ep1, ep2, dtheta, dphi, ptheta, pphi)
@@ -30,17 +31,66 @@ extern "C" void wcsconp(int sys1, int sys2, double eq1, double eq2, double ep1,
 //  double  *ptheta; /* Right ascension proper motion in RA degrees/year: Input in sys1, returned in sys2 */
 //  double  *pphi;  /* Declination proper motion in Dec degrees/year: Input in sys1, returned in sys2 */
 
-static struct PPMstar_struct PPMstar[MAXPPMSTAR];
-static int PPMstars = 0;
+/* Almacén PPM: cada hilo usa el almacén seleccionado con usePPMStore (por defecto
+   uno estático), de modo que etapas concurrentes lean PPM a distintas épocas */
+struct PPMstore_struct {
+    struct Arena_struct arena;
+    struct PPMstar_struct *star;
+    struct UnitCopy_struct unit; /* copia float32 de (x, y, z) para filtrar búsquedas */
+    int stars;
+    int polarDistByIndex[181];
 
-static int polarDistByIndex[181];
+    /* Mapa ppmRef -> índice (se construye a demanda, ver getPPMindex) */
+    int *mapIndex;
+    int mapSize;
+};
+
+static struct PPMstore_struct defaultPPM;
+static thread_local struct PPMstore_struct *currentPPM = &defaultPPM;
+
+/*
+ * newPPMStore - crea un almacén PPM vacío
+ */
+struct PPMstore_struct *newPPMStore()
+{
+    struct PPMstore_struct *store = (struct PPMstore_struct *) calloc(1, sizeof(struct PPMstore_struct));
+    if (store == NULL) bye("Out of memory!\n");
+    return store;
+}
+
+/*
+ * freePPMStore - libera el almacén y todas sus estrellas
+ */
+void freePPMStore(struct PPMstore_struct *store)
+{
+    if (store == currentPPM) currentPPM = &defaultPPM;
+    free(store->mapIndex);
+    freeArena(&store->arena);
+    free(store);
+}
+
+/*
+ * usePPMStore - selecciona el almacén PPM del hilo actual (NULL = el almacén por defecto)
+ */
+void usePPMStore(struct PPMstore_struct *store)
+{
+    currentPPM = (store != NULL) ? store : &defaultPPM;
+}
+
+/*
+ * getPPMStore - devuelve el almacén PPM del hilo actual (p.ej. para que lo usen hilos auxiliares)
+ */
+struct PPMstore_struct *getPPMStore()
+{
+    return currentPPM;
+}
 
 /*
  * getPPMstars - devuelve la cantidad de estrellas de PPM leidas
  */
 int getPPMStars()
 {
-    return PPMstars;
+    return currentPPM->stars;
 }
 
 /*
@@ -48,22 +98,67 @@ int getPPMStars()
  */
 struct PPMstar_struct *getPPMStruct()
 {
-    return &PPMstar[0];
+    return &currentPPM->star[0];
+}
+
+/*
+ * resetPPMindex - invalida el mapa ppmRef -> índice (al leer u ordenar PPM)
+ */
+static void resetPPMindex(struct PPMstore_struct *store)
+{
+    free(store->mapIndex);
+    store->mapIndex = NULL;
+    store->mapSize = 0;
+}
+
+/*
+ * buildPPMindex - arma el mapa ppmRef -> índice del almacén
+ */
+static void buildPPMindex(struct PPMstore_struct *store)
+{
+    struct PPMstar_struct *PPMstar = store->star;
+    int maxRef = 0;
+    for (int i = 0; i < store->stars; i++) {
+        if (PPMstar[i].ppmRef > maxRef) maxRef = PPMstar[i].ppmRef;
+    }
+    store->mapSize = maxRef + 1;
+    store->mapIndex = (int *) malloc(store->mapSize * sizeof(int));
+    if (store->mapIndex == NULL) bye("Out of memory!\n");
+    for (int ref = 0; ref < store->mapSize; ref++) store->mapIndex[ref] = -1;
+    for (int i = store->stars - 1; i >= 0; i--) {
+        if (PPMstar[i].ppmRef >= 0) store->mapIndex[PPMstar[i].ppmRef] = i;
+    }
+}
+
+/*
+ * getPPMindex - devuelve el índice de la estrella PPM con identificador ppmRef, o -1 si no está
+ * (de haber más de una, la primera, igual que una búsqueda lineal)
+ * sortPPM deja el mapa armado, así que tras ordenar puede consultarse desde varios hilos;
+ * sin ordenar se arma aquí a demanda (solo desde un hilo).
+ */
+int getPPMindex(int ppmRef)
+{
+    struct PPMstore_struct *store = currentPPM;
+    if (store->mapIndex == NULL) buildPPMindex(store);
+    if (ppmRef < 0 || ppmRef >= store->mapSize) return -1;
+    return store->mapIndex[ppmRef];
 }
 
 /*
  * revise - revisa si mas de una estrella PPM se condice con una de DM
  */
 bool revise(int ppmIndex) {
+    struct PPMstar_struct *PPMstar = currentPPM->star;
+    int PPMstars = currentPPM->stars;
     int dmIndex = PPMstar[ppmIndex].dmIndex;
     bool warning = false;
     for (int i = 0; i < PPMstars; i++) {
       if (i == ppmIndex) continue;
       if (PPMstar[i].dmIndex == dmIndex) {
         if (PPMstar[i].discard) {
-          printf("     Note: Also associated to discarded PPM %d (dist = %.1f arcsec).\n", PPMstar[i].ppmRef, PPMstar[i].dist);
+          logPrintf("     Note: Also associated to discarded PPM %d (dist = %.1f arcsec).\n", PPMstar[i].ppmRef, PPMstar[i].dist);
         } else {
-          printf("     Warning: Also associated to PPM %d (dist = %.1f arcsec).\n", PPMstar[i].ppmRef, PPMstar[i].dist);
+          logPrintf("     Warning: Also associated to PPM %d (dist = %.1f arcsec).\n", PPMstar[i].ppmRef, PPMstar[i].dist);
           warning = true;
         }
       }
@@ -169,20 +264,39 @@ void readPPM(bool useDurch, bool allSky, bool discard_north, bool discard_south,
     FILE *stream;
     char buffer[1024];
     char cell[256];
-    char dmString[14];
-
-    int DMstars = getDMStars();
-    struct DMstar_struct *DMstar = getDMStruct();
+    char dmString[32];
+
+    /* tabla lateral DM -> PPM asociada (o -1): el almacén DM no se modifica
+       y puede compartirse con otras comparaciones concurrentes. Sin useDurch
+       no se consulta el almacén DM, que puede estar leyéndose en otra tarea */
+    int DMstars = 0;
+    struct DMstar_struct *DMstar = NULL;
+    int *dmToPPM = NULL;
+    if (useDurch) {
+        DMstars = getDMStars();
+        DMstar = getDMStruct();
+        dmToPPM = (int *) malloc((size_t) (DMstars > 0 ? DMstars : 1) * sizeof(int));
+        if (dmToPPM == NULL) bye("Out of memory!\n");
+        for (int i = 0; i < DMstars; i++) dmToPPM[i] = -1;
+    }
 
-    stream = fopen("cat/ppm.txt", "rt");
+    stream = openInputFile("cat/ppm.txt");
     if (stream == NULL) {
         perror("Cannot read ppm.txt");
         exit(1);
     }
 
-    PPMstars = 0;
+    /* el catálogo se dimensiona según su tamaño (registros de 131 caracteres y salto de línea) */
+    struct PPMstore_struct *store = currentPPM;
+    int capacity = estimateLines(stream, 132);
+    resetArena(&store->arena, (size_t) capacity * sizeof(struct PPMstar_struct));
+    struct PPMstar_struct *PPMstar = (struct PPMstar_struct *) allocArena(&store->arena, (size_t) capacity * sizeof(struct PPMstar_struct));
+    store->star = PPMstar;
+
+    resetPPMindex(store);
+    int PPMstars = 0;
     while (fgets(buffer, 1023, stream) != NULL) {
-      dmString[0] = 0;
+      unsigned long long dmName = DESIG_NONE;
 
       readField(buffer, cell, 42, 1);
       bool signPPM = (cell[0] == '-');
@@ -205,14 +319,13 @@ void readPPM(bool useDurch, bool allSky, bool discard_north, bool discard_south,
         if (numRef == 0) {
           bye("Error in DM numRef!");
         }
-        char durchCatalog = 'B';
+        int durchCatalog = DESIG_BD;
         if (zoneSign) {
           // South hemisphere
-          if (declRefAbs > 22) durchCatalog = 'C';
-          else if (declRefAbs > 1) durchCatalog = 'S';
+          if (declRefAbs > 22) durchCatalog = DESIG_CD;
+          else if (declRefAbs > 1) durchCatalog = DESIG_SD;
         }
-
-        snprintf(dmString, 14, "%cD %s%d°%d", durchCatalog, zoneSign ? "-" : "+", declRefAbs, numRef);
+        dmName = makeDesignation(durchCatalog, zoneSign, declRefAbs, numRef, ' ');
 
         if (useDurch) {
           if (isCD()) {
@@ -294,30 +407,32 @@ void readPPM(bool useDurch, bool allSky, bool discard_north, bool discard_south,
       if (useDurch) {
         /* lee el numero DM y busca la estrella asociada en DM
         * en caso de haber más de una, escoger la de menor distancia */
-        int i = getDMindex(zoneSign, declRef, numRef);
-        while (i != -1) {
+        int count;
+        const struct Designation_struct *d = getDMComponents(zoneSign, declRef, numRef, &count);
+        for (int c = 0; c < count; c++) {
+          int i = d[c].index;
           double dist = 3600.0 * calcAngularDistance(x, y, z, DMstar[i].x, DMstar[i].y, DMstar[i].z);
           if (minDistance > dist) {
             dmIndex = i;
             minDistance = dist;
           }
-          i = DMstar[i].next;
         }
         if (dmIndex == -1) {
-          printf("Star %s not found (corresponding to PPM %d). Discarding PPM star.\n", dmString, ppmRef);
+          formatDesignation(dmString, dmName);
+          logPrintf("Star %s not found (corresponding to PPM %d). Discarding PPM star.\n", dmString, ppmRef);
           continue;
         }
 
         /* asocia la DM a la PPM mas cercana */
-        if (DMstar[dmIndex].catIndex == -1) {
-          DMstar[dmIndex].catIndex = PPMstars;
+        if (dmToPPM[dmIndex] == -1) {
+          dmToPPM[dmIndex] = PPMstars;
         } else {
           /* ya hay otra PPM con misma DM asociada */
-          int previousPPMIndex = DMstar[dmIndex].catIndex;
+          int previousPPMIndex = dmToPPM[dmIndex];
           if (minDistance < PPMstar[previousPPMIndex].dist) {
             //printf("PPM %d is removed because PPM %d is nearer to same %s\n", PPMstar[previousPPMIndex].ppmRef, ppmRef, dmString);
             PPMstar[previousPPMIndex].discard = true;
-            DMstar[dmIndex].catIndex = PPMstars;
+            dmToPPM[dmIndex] = PPMstars;
           } else {
             //printf("PPM %d is removed because PPM %d is nearer to same %s\n", ppmRef, PPMstar[previousPPMIndex].ppmRef, dmString);
             continue;
@@ -332,14 +447,17 @@ void readPPM(bool useDurch, bool allSky, bool discard_north, bool discard_south,
       int hdRef = atoi(cell);
 
       /* la almacena en memoria */
-      if (PPMstars == MAXPPMSTAR) bye("Maximum amount reached!\n");
+      if (PPMstars == capacity) {
+        capacity *= 2;
+        PPMstar = store->star = (struct PPMstar_struct *) growArenaArray(&store->arena, PPMstar, PPMstars, capacity, sizeof(struct PPMstar_struct));
+      }
       PPMstar[PPMstars].ppmRef = ppmRef;
       PPMstar[PPMstars].discard = false;
       PPMstar[PPMstars].polarDist = Decltarget + 90.0;
       PPMstar[PPMstars].vmag = vmag;
       PPMstar[PPMstars].problem = problem;
       PPMstar[PPMstars].dmIndex = dmIndex;
-      strncpy(PPMstar[PPMstars].dmString, dmString, 14);
+      PPMstar[PPMstars].dmName = dmName;
       PPMstar[PPMstars].x = x;
       PPMstar[PPMstars].y = y;
       PPMstar[PPMstars].z = z;
@@ -350,8 +468,11 @@ void readPPM(bool useDurch, bool allSky, bool discard_north, bool discard_south,
       /* proxima estrella */
       PPMstars++;
     }
-    printf("Stars read from PPM: %d\n", PPMstars);
-    fclose(stream);
+    store->stars = PPMstars;
+    buildUnitCopy(&store->unit, &store->arena, &PPMstar[0].x, PPM_STRIDE, PPMstars);
+    logPrintf("Stars read from PPM: %d\n", PPMstars);
+    closeInputFile(stream);
+    free(dmToPPM);
 }
 
 int comp(const void *a, const void *b) {
@@ -369,20 +490,27 @@ int comp(const void *a, const void *b) {
  * Nota: leer PPM en ambos hemisferios (discard_north = discard_south = false).
  */
 void sortPPM() {
+  struct PPMstore_struct *store = currentPPM;
+  struct PPMstar_struct *PPMstar = store->star;
+  int PPMstars = store->stars;
+  int *polarDistByIndex = store->polarDistByIndex;
+  resetPPMindex(store);
+
   /* ordenas las estrellas */
   qsort(PPMstar, PPMstars, sizeof(PPMstar_struct), comp);
-
-  /* genera indices */
-  int currentPolarDist = -1;
-  for (int i = 0; i < PPMstars; i++) {
-    int polarDist = (int) floor(PPMstar[i].polarDist);
-    if (polarDist > currentPolarDist) {
-      currentPolarDist = polarDist;
-      polarDistByIndex[polarDist] = i;
-      //printf("Polar dist = %d, index = %d\n", polarDist, i);
-    }
+  fillUnitCopy(&store->unit, &PPMstar[0].x, PPM_STRIDE, PPMstars);
+
+  /* genera indices: la primera estrella con distancia polar >= polarDist
+     (una faja sin estrellas apunta a la siguiente, no a un valor de otra lectura) */
+  int i = 0;
+  for (int polarDist = 0; polarDist < 180; polarDist++) {
+    while (i < PPMstars && PPMstar[i].polarDist < polarDist) i++;
+    polarDistByIndex[polarDist] = i;
   }
   polarDistByIndex[180] = PPMstars;
+
+  /* el mapa ppmRef -> índice se arma aquí y no a demanda: las búsquedas pueden ser concurrentes */
+  buildPPMindex(store);
 }
 
 /* 
@@ -393,28 +521,24 @@ void sortPPM() {
  * El resultado se almacena en (ppmIndexOutput, minDistanceOutput).
  */
 void findPPMByCoordinates(double x, double y, double z, double decl, int *ppmIndexOutput, double *minDistanceOutput) {
+  struct PPMstore_struct *store = currentPPM;
   int ppmIndex = -1;
   double minDistance = *minDistanceOutput;
   
-  if (PPMstars > 0) {
+  if (store->stars > 0) {
     decl += 90.0; // convertimos a distancia polar
 
     int firstPolar = (int) floor(decl - 0.2);
     if (firstPolar < 0) firstPolar = 0;
-    int firstIndex = polarDistByIndex[firstPolar];
+    int firstIndex = store->polarDistByIndex[firstPolar];
     int secondPolar = (int) ceil(decl + 0.2);
     if (secondPolar > 180) secondPolar = 180;
-    int secondIndex = polarDistByIndex[secondPolar];
+    int secondIndex = store->polarDistByIndex[secondPolar];
 
     //printf("Polar = %.2f (decl = %.2f), firstIndex = %d, secondIndex = %d\n", decl, decl-90.0, firstIndex, secondIndex);
 
-    for (int i = firstIndex; i < secondIndex; i++) {
-      double dist = 3600.0 * calcAngularDistance(x, y, z, PPMstar[i].x, PPMstar[i].y, PPMstar[i].z);
-      if (minDistance > dist) {
-        ppmIndex = i;
-        minDistance = dist;
-      }
-    }
+    findNearestUnit(&store->unit, &store->star[0].x, PPM_STRIDE, firstIndex, secondIndex,
+      x, y, z, &ppmIndex, &minDistance);
   }
   *ppmIndexOutput = ppmIndex;
   *minDistanceOutput = minDistance;
@@ -426,14 +550,14 @@ void findPPMByCoordinates(double x, double y, double z, double decl, int *ppmInd
 void writePPMCrossEntry(FILE *crossPPMStream, FILE *crossSAOStream, FILE *crossHDStream,
         char *catName, struct PPMstar_struct *star, double vmag, double minDistance) {
     char name[20];
-    snprintf(name, 20, "PPM %d", star->ppmRef);
+    formatName(name, "PPM", star->ppmRef);
     writeCrossEntry(crossPPMStream, catName, name, vmag, minDistance);
     if (star->saoRef > 0) {
-        snprintf(name, 20, "SAO %d", star->saoRef);
+        formatName(name, "SAO", star->saoRef);
         writeCrossEntry(crossSAOStream, catName, name, vmag, minDistance);
     }
     if (star->hdRef > 0) {
-        snprintf(name, 20, "HD %d", star->hdRef);
+        formatName(name, "HD", star->hdRef);
         writeCrossEntry(crossHDStream, catName, name, vmag, minDistance);
     }
 }
@@ -3,8 +3,6 @@
  * READ_PPM - Header
  */
 
-#define MAXPPMSTAR 468861
-
 struct PPMstar_struct {
     int ppmRef; /* identificador PPM */
     bool discard; /* true if should not be considered (e.g. other PPM star nearer to the same CD record) */
@@ -12,14 +10,23 @@ struct PPMstar_struct {
     double vmag; /* Magnitud Johnson V. Si vmag = 0.0 la magnitud original era fotografica y no la consideramos */
     char problem; /* = 1 solo si la estrella esta marcada como doble o "problematica" */
     int dmIndex; /* Indice a BD o CD */
-    char dmString[14]; /* String con la identificación */
+    unsigned long long dmName; /* designación DM (ver misc.h), o DESIG_NONE */
     double x, y, z; /* coordenadas rectangulares en circulo unidad */
     double dist; /* distancia angular a su CD asociada (en arcsec) */
     int saoRef, hdRef; /* other designations, 0 = none */
 };
 
+/* Almacén PPM: las funciones siguientes operan sobre el almacén del hilo actual */
+struct PPMstore_struct;
+
+struct PPMstore_struct *newPPMStore();
+void freePPMStore(struct PPMstore_struct *store);
+void usePPMStore(struct PPMstore_struct *store);
+struct PPMstore_struct *getPPMStore();
+
 int getPPMStars();
 struct PPMstar_struct *getPPMStruct();
+int getPPMindex(int ppmRef);
 bool revise(int ppmIndex);
 void readPPM(bool useDurch, bool allSky, bool discard_north, bool discard_south, double targetYear);
 void sortPPM();
@@ -12,7 +12,11 @@
 #include "trig.h"
 #include "misc.h"
 
-static struct SDstar_struct SDstar[MAXSDSTAR];
+#define SD_STRIDE ((int) (sizeof(struct SDstar_struct) / sizeof(double)))
+
+static struct Arena_struct SDarena;
+static struct SDstar_struct *SDstar = NULL;
+static struct UnitCopy_struct SDunit; /* copia float32 de (x, y, z) para filtrar búsquedas */
 static int SDstars = 0;
 
 /*
@@ -42,7 +46,7 @@ void writeRegisterSD(int sdIndex)
 
     int numRef = s->numRef;
     int page = 438 + 22 * sdIndex / SDstars;
-    printf("     Register SD %d°%d (en %.0fh):  %.1f | %.0fm%.1fs | %.1f'     (pag. %d)\n",
+    logPrintf("     Register SD %d°%d (en %.0fh):  %.1f | %.0fm%.1fs | %.1f'     (pag. %d)\n",
                 s->declRef,
                 numRef,
                 s->rah,
@@ -72,12 +76,17 @@ void readSD(bool onlyDecl22) {
         CDstar = getDMStruct();
     }
 
-    stream = fopen("cat/sd.txt", "rt");
+    stream = openInputFile("cat/sd.txt");
     if (stream == NULL) {
         perror("Cannot read sd.txt");
         exit(1);
     }
 
+    /* el catálogo se dimensiona según su tamaño (registros de 32 caracteres y salto de línea) */
+    int capacity = estimateLines(stream, 33);
+    resetArena(&SDarena, (size_t) capacity * sizeof(struct SDstar_struct));
+    SDstar = (struct SDstar_struct *) allocArena(&SDarena, (size_t) capacity * sizeof(struct SDstar_struct));
+
     SDstars = 0;
     while (fgets(buffer, 1023, stream) != NULL) {
         /* lee la zona de declinacion */
@@ -91,7 +100,7 @@ void readSD(bool onlyDecl22) {
         char supplRef = buffer[11-1];
         if (supplRef == 'D') continue;
         if (supplRef != ' ') {
-            printf("Ommitting star SD %d°%d%c\n", declRef, numRef, supplRef);
+            logPrintf("Ommitting star SD %d°%d%c\n", declRef, numRef, supplRef);
             continue;
         }
 
@@ -108,7 +117,7 @@ void readSD(bool onlyDecl22) {
             if (vmag > 29.9 && vmag < 30.1) {
                 /* estrella variable */
             } else {
-                printf("Unknown code: %f, SD %d°%d\n", vmag, declRef, numRef);
+                logPrintf("Unknown code: %f, SD %d°%d\n", vmag, declRef, numRef);
                 exit(1);
             }
         }
@@ -142,7 +151,10 @@ void readSD(bool onlyDecl22) {
         sph2rec(RA1875, Decl1875, &x, &y, &z);
 
         /* la almacena en memoria */
-		if (SDstars == MAXSDSTAR) bye("Maximum amount reached!\n");
+		if (SDstars == capacity) {
+			capacity *= 2;
+			SDstar = (struct SDstar_struct *) growArenaArray(&SDarena, SDstar, SDstars, capacity, sizeof(struct SDstar_struct));
+		}
         SDstar[SDstars].discard = true; /* todas comienzan descartadas a menos que se cruce */
         SDstar[SDstars].declRef = declRef;
         SDstar[SDstars].numRef = numRef;
@@ -163,12 +175,13 @@ void readSD(bool onlyDecl22) {
         SDstar[SDstars].dist = 0.0; /* a ser rellenado en la siguiente fase */
         SDstars++;
     }
-    printf("Stars read from Southern Durchmusterung: %d\n", SDstars);
-    fclose(stream);
+    buildUnitCopy(&SDunit, &SDarena, &SDstar[0].x, SD_STRIDE, SDstars);
+    logPrintf("Stars read from Southern Durchmusterung: %d\n", SDstars);
+    closeInputFile(stream);
 
     if (onlyDecl22) {
         /* siguiente fase: leer identificación cruzada del catálogo 4005 */
-        stream = fopen("cat/4005.txt", "rt");
+        stream = openInputFile("cat/4005.txt");
         if (stream == NULL) {
             perror("Cannot read 4005.txt");
             exit(1);
@@ -220,7 +233,7 @@ void readSD(bool onlyDecl22) {
                 }
             }
             if (catIndex == -1) {
-                printf("Warning: Star SD %d°%d not found\n", declRefSD, numRefSD);
+                logPrintf("Warning: Star SD %d°%d not found\n", declRefSD, numRefSD);
                 continue;
             }
 
@@ -233,17 +246,18 @@ void readSD(bool onlyDecl22) {
             * de una, escoger la de menor distancia */
             int cdIndex = -1;
             double minDistance = 9999999999;
-            int i = getDMindex(true, declRefCD, numRefCD);
-            while (i != -1) {
+            int count;
+            const struct Designation_struct *d = getDMComponents(true, declRefCD, numRefCD, &count);
+            for (int c = 0; c < count; c++) {
+                int i = d[c].index;
                 double dist = 3600.0 * calcAngularDistance(x, y, z, CDstar[i].x, CDstar[i].y, CDstar[i].z);
                 if (minDistance > dist) {
                     cdIndex = i;
                     minDistance = dist;
                 }
-                i = CDstar[i].next;
             }
             if (cdIndex == -1) {
-            printf("CD %d°%d not found (corresponding to SD %d°%d). Discarding SD star.\n",
+            logPrintf("CD %d°%d not found (corresponding to SD %d°%d). Discarding SD star.\n",
                 declRefCD, numRefCD, declRefSD, numRefSD);
             continue;
             }
@@ -252,11 +266,10 @@ void readSD(bool onlyDecl22) {
             SDstar[catIndex].discard = false;
             SDstar[catIndex].cdIndex = cdIndex;
             SDstar[catIndex].dist = minDistance;
-            CDstar[cdIndex].catIndex = catIndex;
             crossed++;
         }
-        printf("Number of SD stars cross-identified with CD stars: %d\n", crossed);
-        fclose(stream);
+        logPrintf("Number of SD stars cross-identified with CD stars: %d\n", crossed);
+        closeInputFile(stream);
     }
 }
 
@@ -270,13 +283,7 @@ void readSD(bool onlyDecl22) {
 void findSDByCoordinates(double x, double y, double z, double decl, int *sdIndexOutput, double *minDistanceOutput) {
     int sdIndex = -1;
     double minDistance = *minDistanceOutput;
-    for (int i = 0; i < SDstars; i++) {
-        double dist = 3600.0 * calcAngularDistance(x, y, z, SDstar[i].x, SDstar[i].y, SDstar[i].z);
-        if (minDistance > dist) {
-            sdIndex = i;
-            minDistance = dist;
-        }
-    }
+    findNearestUnit(&SDunit, &SDstar[0].x, SD_STRIDE, 0, SDstars, x, y, z, &sdIndex, &minDistance);
     *sdIndexOutput = sdIndex;
     *minDistanceOutput = minDistance;
 } 
\ No newline at end of file
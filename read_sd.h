@@ -2,8 +2,6 @@
  * READ_SD - Header
  */
 
-#define MAXSDSTAR 150000
-
 struct SDstar_struct {
     bool discard; /* true if should not be considered */
     int declRef; /* declinacion */
@@ -0,0 +1,496 @@
+/*
+ * SCAN_DM - Revisa todos los registros de CD y BD contra PPM y Tycho-2
+ * Made in 2025 by Daniel E. Severin
+ *
+ * A diferencia de compare_ppm / compare_ppm_bd, que solo visitan las estrellas PPM
+ * con identificacion DM impresa, aqui se busca para cada registro DM la estrella
+ * PPM o Tycho-2 mas cercana en un indice espacial (sky_grid). Se informan los
+ * registros sin contraparte dentro del umbral y aquellos cuya contraparte mas
+ * cercana tiene una magnitud muy distinta. Con "typos" se buscan ademas, para esos
+ * registros, errores de transcripcion de un digito que los lleven a una estrella libre
+ * (ver typo_search.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "read_dm.h"
+#include "read_ppm.h"
+#include "trig.h"
+#include "misc.h"
+#include "parallel.h"
+#include "sky_grid.h"
+#include "typo_search.h"
+
+#define SCAN_CHUNK 4096 // registros DM por tarea
+#define SCAN_GRID_CELL 0.25 // lado de las celdas de los indices, en grados
+
+/* Tycho-2 a 1875.0, tal como lo deja gen_tycho2 (se lee el compañero .bin) */
+#define TYC_NORTH_FILE "likelihood/cat1875/north.csv"
+#define TYC_SOUTH_FILE "likelihood/cat1875/south.csv"
+
+/* estado de un registro DM tras la revision */
+#define SCAN_OK 0
+#define SCAN_ALONE 1 /* sin contraparte dentro del umbral */
+#define SCAN_MAG 2 /* la contraparte mas cercana tiene otra magnitud */
+#define SCAN_NO_MAG 3 /* contraparte sin magnitud comparable */
+
+/* contraparte mas cercana de un registro DM */
+struct ScanResult_struct {
+    int index; /* indice en PPM o en Tycho-2, -1 si no hay dentro del umbral */
+    bool tycho; /* true si la contraparte es de Tycho-2 */
+    double dist; /* distancia en arcsec */
+    int ppmIndex, tycIndex; /* mas cercanas de cada referencia (-1 si no hay) */
+    double ppmDist, tycDist;
+    int typo; /* indice en las hipotesis de errores, -1 si no se buscaron */
+};
+
+/* Durchmusterung a revisar (umbrales de compare_ppm y compare_ppm_bd, resp.) */
+struct ScanDM_struct {
+    const char *name; /* argumento: "cd" o "bd" */
+    const char *label;
+    const char *file;
+    int catalog; /* DM_CD o DM_BD */
+    int desig; /* DESIG_CD o DESIG_BD */
+    double maxDistance; /* arcsec */
+    double maxMagnitude;
+    double typoRadius, typoSigma; /* busqueda de errores: radio y precision de las posiciones (arcsec) */
+    bool enabled;
+    struct DMstore_struct *store;
+    int stars;
+    double *exact; /* x, y, z en 1875.0 (BD se lleva desde 1855.0) */
+    struct ScanResult_struct *result;
+};
+
+#define SCANS 2
+static struct ScanDM_struct scans[SCANS] = {
+    {"cd", "CD", "cat/cd_curated.txt", DM_CD, DESIG_CD, 120.0, 1.5, 60.0, 20.0},
+    {"bd", "BD", "cat/bd_curated.txt", DM_BD, DESIG_BD, 180.0, 0.4, 30.0, 10.0},
+};
+
+/* catalogos de referencia e indices */
+static struct SkyGrid_struct ppmGrid;
+static struct SkyGrid_struct tycGrid;
+static struct CatalogRecord_struct *TYCstar = NULL;
+static char *TYCnames[2] = {NULL, NULL}; /* designaciones del norte y del sur */
+static int TYCstars = 0;
+static int TYCnorthStars = 0; /* las primeras estrellas son las del norte */
+static double *TYCmag = NULL; /* magnitudes de Tycho-2 (en doubles, para typo_search) */
+
+/* campos de un registro DM que se prueban en busca de errores de transcripcion */
+#define DM_TYPO_FIELDS 6
+#define DM_TYPO_MAG 5
+static const struct TypoFormat_struct dmTypoFormat[DM_TYPO_FIELDS] = {
+    {"RA h", 2, 0, 24.0},
+    {"RA m", 2, 0, 60.0},
+    {"RA s", 4, 1, 60.0},
+    {"Decl d", 2, 0, 90.0},
+    {"Decl m", 4, 1, 60.0},
+    {"mag", 4, 1, 12.2} /* las magnitudes mayores son codigos (ver readDMStore) */
+};
+static bool searchTyposEnabled = false;
+
+/*
+ * loadDM - lee un Durchmusterung y calcula sus coordenadas 1875 (tarea de la carga inicial)
+ */
+static void loadDM(void *context) {
+    struct ScanDM_struct *scan = (struct ScanDM_struct *) context;
+    scan->store = newDMStore(scan->catalog);
+    readDMStore(scan->store, scan->file);
+    scan->stars = getDMStoreStars(scan->store);
+    struct DMstar_struct *DMstar = getDMStoreStruct(scan->store);
+    struct DMregister_struct *DMreg = getDMStoreRegister(scan->store);
+
+    scan->exact = (double *) malloc((size_t) (scan->stars > 0 ? scan->stars : 1) * 3 * sizeof(double));
+    scan->result = (struct ScanResult_struct *) malloc((size_t) (scan->stars > 0 ? scan->stars : 1) * sizeof(struct ScanResult_struct));
+    if (scan->exact == NULL || scan->result == NULL) bye("Out of memory!\n");
+    for (int i = 0; i < scan->stars; i++) {
+        double *s = &scan->exact[3 * i];
+        if (scan->catalog == DM_BD) {
+            double RA = DMreg[i].RA1855;
+            double Decl = DMreg[i].Decl1855;
+            transform(1855.0, 1875.0, &RA, &Decl);
+            sph2rec(RA, Decl, &s[0], &s[1], &s[2]);
+        } else {
+            s[0] = DMstar[i].x;
+            s[1] = DMstar[i].y;
+            s[2] = DMstar[i].z;
+        }
+    }
+}
+
+/*
+ * loadPPMTask - lee PPM (todo el cielo, 1875.0) y arma su indice
+ */
+static void loadPPMTask(void *context) {
+    readPPM(false, true, false, false, 1875.0);
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+    buildSkyGrid(&ppmGrid, &PPMstar[0].x, (int) (sizeof(struct PPMstar_struct) / sizeof(double)),
+        getPPMStars(), SCAN_GRID_CELL);
+    logPrintf("PPM stars indexed = %d\n", getPPMStars());
+}
+
+/*
+ * loadTYCTask - lee Tycho-2 de ambos hemisferios (1875.0) y arma su indice
+ */
+static void loadTYCTask(void *context) {
+    int northStars, southStars;
+    struct CatalogRecord_struct *north = readCatalogFile(TYC_NORTH_FILE, &northStars, &TYCnames[0]);
+    struct CatalogRecord_struct *south = readCatalogFile(TYC_SOUTH_FILE, &southStars, &TYCnames[1]);
+
+    /* une ambos archivos (las designaciones quedan en sus tablas) */
+    TYCnorthStars = northStars;
+    TYCstars = northStars + southStars;
+    TYCstar = (struct CatalogRecord_struct *) malloc((size_t) (TYCstars > 0 ? TYCstars : 1) * sizeof(struct CatalogRecord_struct));
+    if (TYCstar == NULL) bye("Out of memory!\n");
+    memcpy(TYCstar, north, (size_t) northStars * sizeof(struct CatalogRecord_struct));
+    memcpy(&TYCstar[northStars], south, (size_t) southStars * sizeof(struct CatalogRecord_struct));
+    free(north);
+    free(south);
+    TYCmag = (double *) malloc((size_t) (TYCstars > 0 ? TYCstars : 1) * sizeof(double));
+    if (TYCmag == NULL) bye("Out of memory!\n");
+    for (int i = 0; i < TYCstars; i++) TYCmag[i] = TYCstar[i].mag;
+
+    buildSkyGrid(&tycGrid, &TYCstar[0].x, (int) (sizeof(struct CatalogRecord_struct) / sizeof(double)),
+        TYCstars, SCAN_GRID_CELL);
+    logPrintf("TYC stars indexed = %d\n", TYCstars);
+}
+
+/*
+ * nearestHit - la estrella mas cercana de una consulta (la primera en caso de empate)
+ */
+static int nearestHit(const struct SkyHits_struct *hits) {
+    int best = -1;
+    for (int h = 0; h < hits->count; h++) {
+        if (best == -1 || hits->dist[h] < hits->dist[best]) best = h;
+    }
+    return best;
+}
+
+/*
+ * scanChunk - busca la contraparte mas cercana de un tramo de registros DM
+ */
+static void scanChunk(int index, void *context) {
+    struct ScanDM_struct *scan = (struct ScanDM_struct *) context;
+    struct SkyHits_struct hits;
+    memset(&hits, 0, sizeof(hits));
+
+    int last = (index + 1) * SCAN_CHUNK;
+    if (last > scan->stars) last = scan->stars;
+    for (int i = index * SCAN_CHUNK; i < last; i++) {
+        const double *s = &scan->exact[3 * i];
+        struct ScanResult_struct *result = &scan->result[i];
+        result->index = -1;
+        result->tycho = false;
+        result->dist = HUGE_NUMBER;
+        result->typo = -1;
+
+        querySkyGrid(&ppmGrid, s[0], s[1], s[2], scan->maxDistance, &hits);
+        int h = nearestHit(&hits);
+        result->ppmIndex = h >= 0 ? hits.index[h] : -1;
+        result->ppmDist = h >= 0 ? hits.dist[h] : HUGE_NUMBER;
+        querySkyGrid(&tycGrid, s[0], s[1], s[2], scan->maxDistance, &hits);
+        h = nearestHit(&hits);
+        result->tycIndex = h >= 0 ? hits.index[h] : -1;
+        result->tycDist = h >= 0 ? hits.dist[h] : HUGE_NUMBER;
+
+        if (result->ppmIndex >= 0) {
+            result->index = result->ppmIndex;
+            result->dist = result->ppmDist;
+        }
+        if (result->tycIndex >= 0 && result->tycDist < result->dist) {
+            result->index = result->tycIndex;
+            result->tycho = true;
+            result->dist = result->tycDist;
+        }
+    }
+    freeSkyHits(&hits);
+}
+
+/*
+ * scanFlag - estado de un registro DM (ver SCAN_*); deja la magnitud de la contraparte
+ * y la diferencia con la del registro
+ */
+static int scanFlag(struct ScanDM_struct *scan, int i, double *refVmag, double *delta) {
+    struct DMstar_struct *DMstar = getDMStoreStruct(scan->store);
+    struct ScanResult_struct *result = &scan->result[i];
+    if (result->index < 0) return SCAN_ALONE;
+    *refVmag = result->tycho ? TYCmag[result->index] : getPPMStruct()[result->index].vmag;
+    double dmVmag = DMstar[i].vmag;
+    if (fabs(*refVmag) < 0.00001 || fabs(dmVmag) < 0.00001 || dmVmag > 29.9) return SCAN_NO_MAG; // se omiten magnitudes desconocidas o variables
+    *delta = fabs(dmVmag - compVmagToCDmag(DMstar[i].declRef, *refVmag));
+    return *delta >= scan->maxMagnitude ? SCAN_MAG : SCAN_OK;
+}
+
+/*
+ * dmTypoPosition - vector unitario 1875 de un registro DM con los campos dados
+ */
+static void dmTypoPosition(void *context, const struct TypoRecord_struct *record, const double *value,
+        double *x, double *y, double *z) {
+    struct ScanDM_struct *scan = (struct ScanDM_struct *) context;
+    struct DMstar_struct *DMstar = getDMStoreStruct(scan->store);
+    double RA = (value[0] + value[1] / 60.0 + value[2] / 3600.0) * 15.0;
+    double Decl = value[3] + value[4] / 60.0;
+    if (DMstar[record->owner].signRef) Decl = -Decl;
+    if (scan->catalog == DM_BD) transform(1855.0, 1875.0, &RA, &Decl);
+    sph2rec(RA, Decl, x, y, z);
+}
+
+/*
+ * dmTypoMag - magnitud V de referencia en la escala del registro DM
+ */
+static double dmTypoMag(void *context, const struct TypoRecord_struct *record, double refMag) {
+    struct ScanDM_struct *scan = (struct ScanDM_struct *) context;
+    return compVmagToCDmag(getDMStoreStruct(scan->store)[record->owner].declRef, refMag);
+}
+
+/*
+ * searchScanTypos - busca errores de transcripcion en los registros señalados de un
+ * Durchmusterung; una estrella de referencia queda reclamada por el registro no señalado
+ * (SCAN_OK o SCAN_NO_MAG) mas cercano de los que la tienen como la mas cercana a menos
+ * de typoRadius (a igual distancia, el de menor indice)
+ */
+static struct TypoResult_struct *searchScanTypos(struct ScanDM_struct *scan) {
+    struct DMstar_struct *DMstar = getDMStoreStruct(scan->store);
+    struct DMregister_struct *DMreg = getDMStoreRegister(scan->store);
+    int PPMstars = getPPMStars();
+
+    int *ppmClaim = (int *) malloc((size_t) (PPMstars > 0 ? PPMstars : 1) * sizeof(int));
+    int *tycClaim = (int *) malloc((size_t) (TYCstars > 0 ? TYCstars : 1) * sizeof(int));
+    double *ppmClaimDist = (double *) malloc((size_t) (PPMstars > 0 ? PPMstars : 1) * sizeof(double));
+    double *tycClaimDist = (double *) malloc((size_t) (TYCstars > 0 ? TYCstars : 1) * sizeof(double));
+    struct TypoRecord_struct *records = (struct TypoRecord_struct *) malloc((size_t) (scan->stars > 0 ? scan->stars : 1) * sizeof(struct TypoRecord_struct));
+    if (ppmClaim == NULL || tycClaim == NULL || ppmClaimDist == NULL || tycClaimDist == NULL || records == NULL) bye("Out of memory!\n");
+    for (int i = 0; i < PPMstars; i++) ppmClaim[i] = -1;
+    for (int i = 0; i < TYCstars; i++) tycClaim[i] = -1;
+
+    int count = 0;
+    for (int i = 0; i < scan->stars; i++) {
+        struct ScanResult_struct *result = &scan->result[i];
+        double refVmag, delta;
+        int flag = scanFlag(scan, i, &refVmag, &delta);
+        if (flag == SCAN_OK || flag == SCAN_NO_MAG) {
+            /* solo reclaman los registros no señalados: gana el mas cercano (los indices
+               crecen, asi que en un empate queda el primero) */
+            int p = result->ppmIndex;
+            if (p >= 0 && result->ppmDist <= scan->typoRadius && (ppmClaim[p] < 0 || result->ppmDist < ppmClaimDist[p])) {
+                ppmClaim[p] = i;
+                ppmClaimDist[p] = result->ppmDist;
+            }
+            int t = result->tycIndex;
+            if (t >= 0 && result->tycDist <= scan->typoRadius && (tycClaim[t] < 0 || result->tycDist < tycClaimDist[t])) {
+                tycClaim[t] = i;
+                tycClaimDist[t] = result->tycDist;
+            }
+            continue;
+        }
+        result->typo = count;
+        struct TypoRecord_struct *record = &records[count++];
+        memset(record, 0, sizeof(struct TypoRecord_struct));
+        record->owner = i;
+        record->value[0] = DMreg[i].rah;
+        record->value[1] = DMreg[i].ramin;
+        record->value[2] = DMreg[i].raseg;
+        record->value[3] = DMreg[i].decldeg;
+        record->value[4] = DMreg[i].declmin;
+        record->value[DM_TYPO_MAG] = DMstar[i].vmag;
+    }
+
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+    struct TypoReference_struct refs[2] = {
+        {&ppmGrid, &PPMstar[0].vmag, (int) (sizeof(struct PPMstar_struct) / sizeof(double)), ppmClaim},
+        {&tycGrid, TYCmag, 1, tycClaim}
+    };
+    struct TypoSearch_struct search = {DM_TYPO_FIELDS, dmTypoFormat, DM_TYPO_MAG,
+        scan->typoRadius, scan->typoSigma, scan, dmTypoPosition, dmTypoMag, refs, 2};
+    struct TypoResult_struct *typos = (struct TypoResult_struct *) malloc((size_t) (count > 0 ? count : 1) * sizeof(struct TypoResult_struct));
+    if (typos == NULL) bye("Out of memory!\n");
+    int hypotheses = searchTypos(&search, records, count, typos);
+    int solved = 0;
+    for (int k = 0; k < count; k++) {
+        if (typos[k].count > 0) solved++;
+    }
+    printf("%s typo hypotheses tested = %d for %d flagged records; records with some hypothesis = %d\n",
+        scan->label, hypotheses, count, solved);
+
+    free(ppmClaim);
+    free(tycClaim);
+    free(ppmClaimDist);
+    free(tycClaimDist);
+    free(records);
+    return typos;
+}
+
+/*
+ * writeTypos - escribe las hipotesis de error de un registro DM
+ */
+static void writeTypos(struct ScanDM_struct *scan, int i, const struct TypoResult_struct *typos) {
+    if (typos == NULL || scan->result[i].typo < 0) return;
+    const struct TypoResult_struct *result = &typos[scan->result[i].typo];
+    struct DMstar_struct *DMstar = getDMStoreStruct(scan->store);
+    struct DMregister_struct *DMreg = getDMStoreRegister(scan->store);
+    double value[DM_TYPO_FIELDS] = {DMreg[i].rah, DMreg[i].ramin, DMreg[i].raseg,
+        DMreg[i].decldeg, DMreg[i].declmin, DMstar[i].vmag};
+    char refString[64];
+    for (int k = 0; k < result->count; k++) {
+        const struct TypoHypothesis_struct *h = &result->best[k];
+        const struct TypoFormat_struct *format = &dmTypoFormat[h->field];
+        double refVmag;
+        if (h->ref == 1) {
+            const char *names = TYCnames[h->star < TYCnorthStars ? 0 : 1];
+            snprintf(refString, 64, "%s", &names[TYCstar[h->star].name]);
+            refVmag = TYCmag[h->star];
+        } else {
+            snprintf(refString, 64, "PPM %d", getPPMStruct()[h->star].ppmRef);
+            refVmag = getPPMStruct()[h->star].vmag;
+        }
+        logPrintf("     Typo? %s %0*.*f -> %0*.*f (%s): %s at %.1f arcsec, Vmag=%.1f (cost = %.2f)\n",
+            format->name, format->width, format->decimals, value[h->field],
+            format->width, format->decimals, h->value, typoKindName(h->kind),
+            refString, h->dist, refVmag, h->cost);
+    }
+}
+
+/*
+ * reportScan - informa (en el orden del catalogo) los registros sospechosos de un Durchmusterung
+ */
+static void reportScan(struct ScanDM_struct *scan) {
+    struct DMstar_struct *DMstar = getDMStoreStruct(scan->store);
+    struct DMregister_struct *DMreg = getDMStoreRegister(scan->store);
+    struct PPMstar_struct *PPMstar = getPPMStruct();
+    char dmString[32], refString[64];
+
+    printf("\n***************************************\n");
+    printf("Scan %s records against PPM and TYC...\n", scan->label);
+    struct TypoResult_struct *typos = searchTyposEnabled ? searchScanTypos(scan) : NULL;
+
+    int errors = 0;
+    int distErrors = 0;
+    int magErrors = 0;
+    int goodStarsPosition = 0;
+    double akkuDistError = 0.0;
+    int goodStarsMagnitude = 0;
+    double akkuDeltaError = 0.0;
+    for (int i = 0; i < scan->stars; i++) {
+        struct ScanResult_struct *result = &scan->result[i];
+        formatDesignation(dmString, makeDesignation(scan->desig, DMstar[i].signRef,
+            abs(DMstar[i].declRef), DMstar[i].numRef, DMreg[i].supplRef));
+        bool neighbors = i > 0 && i < scan->stars - 1;
+        double refVmag, delta;
+        int flag = scanFlag(scan, i, &refVmag, &delta);
+        if (flag == SCAN_ALONE) {
+            // no hay estrellas PPM ni TYC dentro del umbral
+            distErrors++;
+            logWarning(&errors, "Warning: %s has no PPM or TYC star within %.0f arcsec.\n",
+                dmString, scan->maxDistance);
+            writeDMStoreRegister(scan->store, i, neighbors);
+            writeTypos(scan, i, typos);
+            continue;
+        }
+        goodStarsPosition++;
+        akkuDistError += result->dist * result->dist;
+        if (flag == SCAN_NO_MAG) continue;
+
+        if (result->tycho) {
+            const char *names = TYCnames[result->index < TYCnorthStars ? 0 : 1];
+            snprintf(refString, 64, "%s", &names[TYCstar[result->index].name]);
+        } else {
+            snprintf(refString, 64, "PPM %d", PPMstar[result->index].ppmRef);
+        }
+        if (flag == SCAN_MAG) {
+            // la contraparte mas cercana tiene otra magnitud
+            magErrors++;
+            logWarning(&errors, "Warning: %s reports mag=%.1f but nearest %s (%.1f arcsec) has Vmag=%.1f: Delta = %.1f.\n",
+                dmString, DMstar[i].vmag, refString, result->dist, refVmag, delta);
+            writeDMStoreRegister(scan->store, i, false);
+            writeTypos(scan, i, typos);
+            continue;
+        }
+        goodStarsMagnitude++;
+        akkuDeltaError += delta * delta;
+    }
+
+    printf("%s records scanned = %d; errors = %d (no counterpart: %d, mag: %d)\n",
+        scan->label, scan->stars, errors, distErrors, magErrors);
+    printf("RSME of distance (arcsec) = %.2f  among a total of %d stars\n",
+        sqrt(akkuDistError / (double)goodStarsPosition),
+        goodStarsPosition);
+    printf("RSME of visual magnitude = %.5f  among a total of %d stars\n",
+        sqrt(akkuDeltaError / (double)goodStarsMagnitude),
+        goodStarsMagnitude);
+    free(typos);
+}
+
+/*
+ * addLoad - agrega una lectura al grafo de la carga inicial
+ */
+static void addLoad(struct TaskNode *loads, int *count, const char *name, void (*task)(void *), void *context) {
+    memset(&loads[*count], 0, sizeof(struct TaskNode));
+    loads[*count].name = name;
+    loads[*count].task = task;
+    loads[*count].context = context;
+    (*count)++;
+}
+
+/*
+ * main - comienzo de la aplicacion
+ */
+int main(int argc, char** argv) {
+    printf("SCAN_DM - Scan all CD/BD records against PPM and Tycho-2.\n");
+    printf("Made in 2025 by Daniel Severin.\n");
+
+    /* catalogos a revisar (si no se nombra ninguno, ambos) y busqueda de errores */
+    bool anyCatalog = false;
+    for (int a = 1; a < argc; a++) {
+        for (int s = 0; s < SCANS; s++) {
+            if (!strcmp(argv[a], scans[s].name)) anyCatalog = true;
+        }
+    }
+    for (int s = 0; s < SCANS; s++) scans[s].enabled = !anyCatalog;
+    for (int a = 1; a < argc; a++) {
+        bool known = false;
+        for (int s = 0; s < SCANS; s++) {
+            if (strcmp(argv[a], scans[s].name) != 0) continue;
+            scans[s].enabled = true;
+            known = true;
+        }
+        if (!strcmp(argv[a], "typos")) {
+            searchTyposEnabled = true;
+            known = true;
+        }
+        if (!known) {
+            printf("Usage: %s [cd] [bd] [typos]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    /* leemos a la vez los Durchmusterung, PPM y Tycho-2 (ninguna lectura depende de otra) */
+    struct TaskNode loads[SCANS + 2];
+    int loadCount = 0;
+    for (int s = 0; s < SCANS; s++) {
+        if (scans[s].enabled) addLoad(loads, &loadCount, scans[s].label, loadDM, &scans[s]);
+    }
+    addLoad(loads, &loadCount, "PPM", loadPPMTask, NULL);
+    addLoad(loads, &loadCount, "TYC", loadTYCTask, NULL);
+    runTaskGraph(loads, loadCount);
+    printTaskGraphStats(stderr, loads, loadCount);
+
+    /* una pasada en paralelo por cada catalogo y luego el informe, en orden */
+    for (int s = 0; s < SCANS; s++) {
+        if (!scans[s].enabled) continue;
+        parallelFor((scans[s].stars + SCAN_CHUNK - 1) / SCAN_CHUNK, scanChunk, &scans[s]);
+        reportScan(&scans[s]);
+        free(scans[s].exact);
+        free(scans[s].result);
+        freeDMStore(scans[s].store);
+    }
+
+    freeSkyGrid(&ppmGrid);
+    freeSkyGrid(&tycGrid);
+    free(TYCstar);
+    free(TYCmag);
+    free(TYCnames[0]);
+    free(TYCnames[1]);
+    return 0;
+}
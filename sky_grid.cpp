@@ -0,0 +1,229 @@
+/*
+ * SKY_GRID - Indice espacial por fajas de declinacion y celdas de ascension recta
+ * Made in 2025 by Daniel E. Severin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "trig.h"
+#include "misc.h"
+#include "sky_grid.h"
+
+/*
+ * gridZone - faja de una declinacion (en grados)
+ */
+static int gridZone(const struct SkyGrid_struct *grid, double decl)
+{
+    int zone = (int) floor((decl + 90.0) / grid->cell);
+    if (zone < 0) zone = 0;
+    if (zone >= grid->zones) zone = grid->zones - 1;
+    return zone;
+}
+
+/*
+ * gridCell - celda (global) de una ascension recta en [0, 360) dentro de una faja
+ */
+static int gridCell(const struct SkyGrid_struct *grid, int zone, double ra)
+{
+    int cells = grid->zoneFirst[zone + 1] - grid->zoneFirst[zone];
+    int cell = (int) floor(ra / 360.0 * cells);
+    if (cell < 0) cell = 0;
+    if (cell >= cells) cell = cells - 1;
+    return grid->zoneFirst[zone] + cell;
+}
+
+/*
+ * unitToSph - ascension recta en [0, 360) y declinacion (grados) de un vector unitario
+ */
+static void unitToSph(double x, double y, double z, double *ra, double *decl)
+{
+    if (z > 1.0) z = 1.0;
+    if (z < -1.0) z = -1.0;
+    *decl = asin(z) * 180.0 / PI;
+    *ra = atan2(y, x) * 180.0 / PI;
+    if (*ra < 0.0) *ra += 360.0;
+    if (*ra >= 360.0) *ra -= 360.0;
+}
+
+/*
+ * chordToArcsec - distancia angular (arcsec) dada la cuerda entre dos vectores unitarios
+ * (2 asin(c/2) es estable para distancias chicas, a diferencia de acos del producto escalar)
+ */
+double chordToArcsec(double chord)
+{
+    double half = chord * 0.5;
+    if (half > 1.0) half = 1.0;
+    return 2.0 * asin(half) * 180.0 / PI * 3600.0;
+}
+
+/*
+ * buildSkyGrid - arma el indice de "count" estrellas con celdas de "cell" grados
+ * (grid debe estar en cero o haber sido armado antes: se reutiliza su arena)
+ */
+void buildSkyGrid(struct SkyGrid_struct *grid, const double *exact, int stride, int count, double cell)
+{
+    grid->cell = cell;
+    grid->zones = (int) ceil(180.0 / cell);
+    grid->count = count;
+
+    /* celdas por faja: tantas como quepan a lo ancho en su borde mas cercano al polo */
+    int *zoneCells = (int *) malloc((size_t) grid->zones * sizeof(int));
+    if (zoneCells == NULL) bye("Out of memory!\n");
+    int cells = 0;
+    for (int z = 0; z < grid->zones; z++) {
+        double lo = -90.0 + z * cell;
+        double hi = lo + cell > 90.0 ? 90.0 : lo + cell;
+        double edge = fabs(lo) > fabs(hi) ? fabs(lo) : fabs(hi);
+        int n = (int) floor(360.0 * cos(edge * PI / 180.0) / cell);
+        zoneCells[z] = n < 1 ? 1 : n;
+        cells += zoneCells[z];
+    }
+
+    resetArena(&grid->arena, (size_t) (grid->zones + 1 + cells + 1 + 2 * count) * sizeof(int)
+        + (size_t) 3 * count * sizeof(double) + 64);
+    grid->zoneFirst = (int *) allocArena(&grid->arena, (size_t) (grid->zones + 1) * sizeof(int));
+    grid->cellStart = (int *) allocArena(&grid->arena, (size_t) (cells + 1) * sizeof(int));
+    grid->order = (int *) allocArena(&grid->arena, (size_t) (count > 0 ? count : 1) * sizeof(int));
+    grid->x = (double *) allocArena(&grid->arena, (size_t) (count > 0 ? count : 1) * sizeof(double));
+    grid->y = (double *) allocArena(&grid->arena, (size_t) (count > 0 ? count : 1) * sizeof(double));
+    grid->z = (double *) allocArena(&grid->arena, (size_t) (count > 0 ? count : 1) * sizeof(double));
+    grid->zoneFirst[0] = 0;
+    for (int z = 0; z < grid->zones; z++) grid->zoneFirst[z + 1] = grid->zoneFirst[z] + zoneCells[z];
+    free(zoneCells);
+
+    /* ordenamiento por conteo: celda de cada estrella, tamaños y posiciones */
+    int *cellOf = (int *) malloc((size_t) (count > 0 ? count : 1) * sizeof(int));
+    if (cellOf == NULL) bye("Out of memory!\n");
+    memset(grid->cellStart, 0, (size_t) (cells + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        const double *s = exact + (size_t) i * stride;
+        double ra, decl;
+        unitToSph(s[0], s[1], s[2], &ra, &decl);
+        cellOf[i] = gridCell(grid, gridZone(grid, decl), ra);
+        grid->cellStart[cellOf[i] + 1]++;
+    }
+    for (int c = 0; c < cells; c++) grid->cellStart[c + 1] += grid->cellStart[c];
+    for (int i = 0; i < count; i++) {
+        /* cellStart[c] avanza mientras se llena la celda y luego se restituye */
+        int p = grid->cellStart[cellOf[i]]++;
+        const double *s = exact + (size_t) i * stride;
+        grid->order[p] = i;
+        grid->x[p] = s[0];
+        grid->y[p] = s[1];
+        grid->z[p] = s[2];
+    }
+    for (int c = cells; c > 0; c--) grid->cellStart[c] = grid->cellStart[c - 1];
+    grid->cellStart[0] = 0;
+    free(cellOf);
+}
+
+/*
+ * freeSkyGrid - libera el indice
+ */
+void freeSkyGrid(struct SkyGrid_struct *grid)
+{
+    freeArena(&grid->arena);
+    grid->count = 0;
+}
+
+/*
+ * addHit - agrega una estrella al resultado de una consulta
+ */
+static void addHit(struct SkyHits_struct *hits, int index, double dist)
+{
+    if (hits->count == hits->capacity) {
+        hits->capacity = hits->capacity == 0 ? 64 : 2 * hits->capacity;
+        hits->index = (int *) realloc(hits->index, (size_t) hits->capacity * sizeof(int));
+        hits->dist = (double *) realloc(hits->dist, (size_t) hits->capacity * sizeof(double));
+        if (hits->index == NULL || hits->dist == NULL) bye("Out of memory!\n");
+    }
+    hits->index[hits->count] = index;
+    hits->dist[hits->count] = dist;
+    hits->count++;
+}
+
+/*
+ * scanCell - agrega las estrellas de una celda cuya cuerda no supera limit2 (al cuadrado)
+ */
+static void scanCell(const struct SkyGrid_struct *grid, int cell, double x, double y, double z,
+        double limit2, double radius, struct SkyHits_struct *hits)
+{
+    for (int p = grid->cellStart[cell]; p < grid->cellStart[cell + 1]; p++) {
+        double dx = grid->x[p] - x;
+        double dy = grid->y[p] - y;
+        double dz = grid->z[p] - z;
+        double chord2 = dx*dx + dy*dy + dz*dz;
+        if (chord2 > limit2) continue;
+        double dist = chordToArcsec(sqrt(chord2));
+        if (dist <= radius) addHit(hits, grid->order[p], dist);
+    }
+}
+
+/*
+ * querySkyGrid - deja en hits (vaciado antes) las estrellas a no más de "radius"
+ * arcsec de (x, y, z), ordenadas por indice; devuelve cuántas son
+ */
+int querySkyGrid(const struct SkyGrid_struct *grid, double x, double y, double z, double radius,
+        struct SkyHits_struct *hits)
+{
+    hits->count = 0;
+    if (grid->count == 0) return 0;
+
+    double ra, decl;
+    unitToSph(x, y, z, &ra, &decl);
+    double r = radius / 3600.0;
+    double chord = 2.0 * sin(r * PI / 360.0);
+    double limit2 = chord * chord * (1.0 + 1E-9) + 1E-18;
+
+    /* ancho en AR del casquete (todo el circulo si alcanza un polo) */
+    bool allRA = fabs(decl) + r >= 90.0;
+    double dRA = 180.0;
+    if (!allRA) {
+        double s = sin(r * PI / 180.0) / cos(decl * PI / 180.0);
+        dRA = s >= 1.0 ? 180.0 : asin(s) * 180.0 / PI + 1E-9;
+    }
+
+    int zoneLast = gridZone(grid, decl + r > 90.0 ? 90.0 : decl + r);
+    for (int zone = gridZone(grid, decl - r < -90.0 ? -90.0 : decl - r); zone <= zoneLast; zone++) {
+        int first = grid->zoneFirst[zone];
+        int cells = grid->zoneFirst[zone + 1] - first;
+        int c0 = (int) floor((ra - dRA) / 360.0 * cells);
+        int c1 = (int) floor((ra + dRA) / 360.0 * cells);
+        if (allRA || dRA >= 180.0 || c1 - c0 + 1 >= cells) {
+            for (int c = 0; c < cells; c++) scanCell(grid, first + c, x, y, z, limit2, radius, hits);
+        } else {
+            for (int c = c0; c <= c1; c++) {
+                scanCell(grid, first + ((c % cells) + cells) % cells, x, y, z, limit2, radius, hits);
+            }
+        }
+    }
+
+    /* orden por indice (pocas estrellas: insercion) para que no dependa de las celdas */
+    for (int i = 1; i < hits->count; i++) {
+        int index = hits->index[i];
+        double dist = hits->dist[i];
+        int j = i - 1;
+        while (j >= 0 && hits->index[j] > index) {
+            hits->index[j + 1] = hits->index[j];
+            hits->dist[j + 1] = hits->dist[j];
+            j--;
+        }
+        hits->index[j + 1] = index;
+        hits->dist[j + 1] = dist;
+    }
+    return hits->count;
+}
+
+/*
+ * freeSkyHits - libera el resultado de las consultas
+ */
+void freeSkyHits(struct SkyHits_struct *hits)
+{
+    free(hits->index);
+    free(hits->dist);
+    hits->index = NULL;
+    hits->dist = NULL;
+    hits->count = hits->capacity = 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * SKY_GRID - Header
+ * Indice espacial de un catalogo en memoria: fajas de declinacion divididas en
+ * celdas de ascension recta (aproximadamente cuadradas), para consultas por radio
+ * (incluir despues de misc.h)
+ */
+
+/* indice de un catalogo; las coordenadas se copian en el orden de las celdas */
+struct SkyGrid_struct {
+    double cell; /* lado de las celdas en grados */
+    int zones; /* fajas de declinacion, desde -90 */
+    int *zoneFirst; /* la faja z ocupa las celdas zoneFirst[z] .. zoneFirst[z + 1] - 1 */
+    int *cellStart; /* la celda c ocupa las posiciones cellStart[c] .. cellStart[c + 1] - 1 */
+    int count;
+    int *order; /* indice en el catalogo de cada posicion */
+    double *x, *y, *z; /* coordenadas de cada posicion */
+    struct Arena_struct arena;
+};
+
+/* resultado de una consulta: estrellas dentro del radio, por indice ascendente */
+struct SkyHits_struct {
+    int count, capacity;
+    int *index; /* indice en el catalogo */
+    double *dist; /* distancia en arcsec */
+};
+
+/* "exact" apunta al campo x de la estrella 0 y "stride" es el tamaño de la
+   estructura en doubles (como en buildUnitCopy) */
+void buildSkyGrid(struct SkyGrid_struct *grid, const double *exact, int stride, int count, double cell);
+void freeSkyGrid(struct SkyGrid_struct *grid);
+int querySkyGrid(const struct SkyGrid_struct *grid, double x, double y, double z, double radius,
+    struct SkyHits_struct *hits);
+void freeSkyHits(struct SkyHits_struct *hits);
+double chordToArcsec(double chord);
@@ -7,13 +7,20 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <mutex>
 #include "trig.h"
+#include "misc.h"
 
 /* Para uso de la libreria WCS: */
 #define WCS_B1950 2 /* B1950(FK4) right ascension and declination */
 extern "C" void wcsconp(int sys1, int sys2, double eq1, double eq2, double ep1, double ep2,
              double *dtheta, double *dphi, double *ptheta, double *pphi);
 
+/* Constantes para findNearestUnit: candidatos por bloque y margen (en cuerda) que
+   cubre el redondeo a float32 de ambos vectores y el de acos en doble precisión */
+#define UNIT_FILTER_BLOCK 256
+#define UNIT_FILTER_TOL 1E-6
+
 /* Constantes para makeDoubles */
 static const double MAX_DIST_DOUBLE = 60.0;     // arcsec
 static const double MIN_DIST_NODOUBLE = 300.0;  // arcsec
@@ -103,6 +110,84 @@ double calcAngularDistance(double x1, double y1, double z1, double x2, double y2
 	return acos(cosdist) * 180.0 / PI;
 }
 
+/*
+ * buildUnitCopy - reserva (en la arena) y llena la copia float32 de "count" vectores unitarios
+ */
+void buildUnitCopy(struct UnitCopy_struct *unit, struct Arena_struct *arena,
+        const double *exact, int stride, int count)
+{
+    unit->x = (float *) allocArena(arena, (size_t) count * sizeof(float));
+    unit->y = (float *) allocArena(arena, (size_t) count * sizeof(float));
+    unit->z = (float *) allocArena(arena, (size_t) count * sizeof(float));
+    fillUnitCopy(unit, exact, stride, count);
+}
+
+/*
+ * fillUnitCopy - vuelve a llenar la copia float32 (p.ej. luego de reordenar el catálogo)
+ */
+void fillUnitCopy(struct UnitCopy_struct *unit, const double *exact, int stride, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const double *s = exact + (size_t) i * stride;
+        unit->x[i] = (float) s[0];
+        unit->y[i] = (float) s[1];
+        unit->z[i] = (float) s[2];
+    }
+}
+
+/*
+ * unitFilterLimit - cota (conservadora) del cuadrado de la cuerda en float32 para
+ * que una estrella pueda estar a menos de minDistance (en arcsec)
+ */
+static float unitFilterLimit(double minDistance)
+{
+    double angle = minDistance / 3600.0 * PI / 180.0;
+    if (!(angle < PI)) return 16.0f; /* no se filtra nada */
+    double chord = 2.0 * sin(angle / 2.0) + UNIT_FILTER_TOL;
+    return (float) (chord * chord * (1.0 + 1E-5));
+}
+
+/*
+ * findNearestUnit - busca entre [first, last) la estrella más cercana a (x, y, z)
+ * Primero descarta por bloques, en float32, las que no pueden mejorar minDistance;
+ * las que sobreviven se evalúan en doble precisión exactamente como un recorrido
+ * completo con calcAngularDistance, de modo que índice y distancia no cambian.
+ * Solo actualiza (index, minDistance) si halla una estrella más cercana.
+ * (x, y, z) debe ser unitario, como los que devuelve sph2rec.
+ */
+void findNearestUnit(const struct UnitCopy_struct *unit, const double *exact, int stride,
+        int first, int last, double x, double y, double z, int *index, double *minDistance)
+{
+    float qx = (float) x, qy = (float) y, qz = (float) z;
+    float chord2[UNIT_FILTER_BLOCK];
+
+    for (int start = first; start < last; start += UNIT_FILTER_BLOCK) {
+        int end = last - start < UNIT_FILTER_BLOCK ? last : start + UNIT_FILTER_BLOCK;
+        float limit = unitFilterLimit(*minDistance);
+
+        /* primera pasada: cuadrado de la cuerda en float32 (vectorizable) */
+        const float *ux = unit->x + start, *uy = unit->y + start, *uz = unit->z + start;
+        for (int k = 0; k < end - start; k++) {
+            float dx = ux[k] - qx;
+            float dy = uy[k] - qy;
+            float dz = uz[k] - qz;
+            chord2[k] = dx*dx + dy*dy + dz*dz;
+        }
+
+        /* segunda pasada: refinamiento exacto de las sobrevivientes, en orden */
+        for (int k = 0; k < end - start; k++) {
+            if (chord2[k] > limit) continue;
+            const double *s = exact + (size_t) (start + k) * stride;
+            double dist = 3600.0 * calcAngularDistance(x, y, z, s[0], s[1], s[2]);
+            if (*minDistance > dist) {
+                *index = start + k;
+                *minDistance = dist;
+                limit = unitFilterLimit(dist);
+            }
+        }
+    }
+}
+
 /*
  * solve3x3 - small 3x3 linear system solver with partial pivoting.
  * Returns true on success, false on singular.
@@ -148,30 +233,104 @@ bool solve3x3(double A[3][3], double b[3], double x[3]) {
     return true;
 }
 
+/* coeficientes (a, b, c) de m' = a + b m + c m^2 para un tomo de CD */
+struct CDMagScale_struct {
+    double toV[3]; /* magnitud CD -> Johnson V */
+    double toCD[3]; /* Johnson V -> magnitud CD */
+};
+
+/*
+ * Valores por defecto, reemplazados por CD_MAG_SCALE_FILE si existe.
+ * V -> CD: ajuste cuadratico sin pesos de mag_cd (ver results/README.md).
+ * CD -> V: ajuste pesado de cross_txt, se obtuvo con la herramienta:
+ * > ./cross_txt --csv results/cross/cross_cd_vol1_ppm.csv
+ * > ./cross_txt --csv results/cross/cross_cd_vol2_ppm.csv
+ * > ./cross_txt --csv results/cross/cross_cd_vol3_ppm.csv
+ * > ./cross_txt --csv results/cross/cross_cd_vol4_ppm.csv
+ * > ./cross_txt --csv results/cross/cross_cd_vol5_ppm.csv
+ * (ahora basta con ./cross_txt --fit-cd)
+ */
+static struct CDMagScale_struct cdMagScale[CD_MAG_VOLUMES] = {
+    // Vol. 1: weighted quadratic fit of 15187 stars, RSME = 0.075, MAPE = 0.78%
+    //         quadratic fit of 11659 stars, RSME = 0.3004
+    {{-8.955, 3.221, -0.132}, {-0.157169, 1.188316, -0.022130}},
+    // Vol. 2: weighted quadratic fit of 15038 stars, RSME = 0.085, MAPE = 0.94%
+    //         quadratic fit of 11796 stars, RSME = 0.3013
+    {{-4.874, 2.084, -0.055}, {-1.517044, 1.595675, -0.050674}},
+    // Vol. 3: weighted linear fit of 25597 stars, RSME = 0.092, MAPE = 1.03%
+    //         quadratic fit of 9620 stars, RSME = 0.2714
+    {{-1.302, 1.163, 0.0}, {-4.903298, 2.435433, -0.098302}},
+    // Vol. 4: weighted quadratic fit of 12980 stars, RSME = 0.149, MAPE = 1.34%
+    //         quadratic fit of 7672 stars, RSME = 0.3834
+    {{-5.647, 2.384, -0.083}, {-1.347719, 1.513742, -0.040125}},
+    // Vol. 5: weighted linear fit of 12218 stars, RSME = 0.052, MAPE = 0.55%
+    //         quadratic fit of 7372 stars, RSME = 0.3239
+    {{0.154, 0.981, 0.0}, {-4.814060, 2.342925, -0.087990}}
+};
+static std::once_flag cdMagScaleOnce;
+
+/*
+ * loadCDMagScale - lee CD_MAG_SCALE_FILE, si existe (se llama una sola vez)
+ */
+static void loadCDMagScale()
+{
+    FILE *stream = fopen(CD_MAG_SCALE_FILE, "rt");
+    if (stream == NULL) return;
+
+    char buffer[1024];
+    int volumes = 0;
+    while (fgets(buffer, 1024, stream) != NULL) {
+        if (buffer[0] == '#' || buffer[0] == '\n' || buffer[0] == '\r') continue;
+        int volume;
+        struct CDMagScale_struct scale;
+        if (sscanf(buffer, "%d %*d %*d %lf %lf %lf %lf %lf %lf", &volume,
+                &scale.toV[0], &scale.toV[1], &scale.toV[2],
+                &scale.toCD[0], &scale.toCD[1], &scale.toCD[2]) != 7
+                || volume < 1 || volume > CD_MAG_VOLUMES) {
+            fprintf(stderr, "Invalid line in %s: %s", CD_MAG_SCALE_FILE, buffer);
+            exit(1);
+        }
+        cdMagScale[volume - 1] = scale;
+        volumes++;
+    }
+    fclose(stream);
+    fprintf(stderr, "CD magnitude scales of %d volumes read from %s\n", volumes, CD_MAG_SCALE_FILE);
+}
+
+/*
+ * getCDMagScaleTable - coeficientes en uso (leyendo CD_MAG_SCALE_FILE si hace falta),
+ * para incluirlos en el hash de resultados que dependen de ellos
+ */
+const void *getCDMagScaleTable(size_t *bytes)
+{
+    std::call_once(cdMagScaleOnce, loadCDMagScale);
+    *bytes = sizeof(cdMagScale);
+    return cdMagScale;
+}
+
+/*
+ * getCDVolume - tomo de CD (0 a CD_MAG_VOLUMES - 1) de una zona, o -1 si no es de CD
+ */
+int getCDVolume(int decl_ref)
+{
+    if (decl_ref <= -22 && decl_ref >= -31) return 0;
+    if (decl_ref <= -32 && decl_ref >= -41) return 1;
+    if (decl_ref <= -42 && decl_ref >= -51) return 2;
+    if (decl_ref <= -52 && decl_ref >= -61) return 3;
+    if (decl_ref <= -62) return 4;
+    return -1;
+}
+
 /*
  * compVmagToCDmag - dada una magnitud en Johnson V la convierte a la escala usada en CD
  */
 double compVmagToCDmag(int decl_ref, double vmag)
 {
-    if (decl_ref <= -22 && decl_ref >= -31) {
-        // Quadratic fit of 11659 stars, RSME = 0.3004
-        return -0.157169 + 1.188316*vmag -0.022130*vmag*vmag;
-    }
-    if (decl_ref <= -32 && decl_ref >= -41) {
-        // Quadratic fit of 11796 stars, RSME = 0.3013 
-        return -1.517044 + 1.595675*vmag -0.050674*vmag*vmag;
-    }
-    if (decl_ref <= -42 && decl_ref >= -51) {
-        // Quadratic fit of 9620 stars, RSME = 0.2714
-        return -4.903298 + 2.435433*vmag -0.098302*vmag*vmag;
-    }
-    if (decl_ref <= -52 && decl_ref >= -61) {
-        // Quadratic fit of 7672 stars, RSME = 0.3834
-        return -1.347719 + 1.513742*vmag -0.040125*vmag*vmag;
-    }
-    if (decl_ref <= -62) {
-        // Quadratic fit of 7372 stars, RSME = 0.3239
-        return -4.814060 + 2.342925*vmag -0.087990*vmag*vmag;
+    int volume = getCDVolume(decl_ref);
+    if (volume >= 0) {
+        std::call_once(cdMagScaleOnce, loadCDMagScale);
+        const double *c = cdMagScale[volume].toCD;
+        return c[0] + c[1]*vmag + c[2]*vmag*vmag;
     }
 
     // If we reach here, BD scale should be used
@@ -184,37 +343,13 @@ double compVmagToCDmag(int decl_ref, double vmag)
 
 /**
  * compCDmagToVmag - dada una magnitud en la escala usada en CD la convierte a Johnson V
- * se obtuvo con la herramienta:
- * > ./cross_txt --csv results/cross/cross_cd_vol1_ppm.csv
- * > ./cross_txt --csv results/cross/cross_cd_vol2_ppm.csv
- * > ./cross_txt --csv results/cross/cross_cd_vol3_ppm.csv
- * > ./cross_txt --csv results/cross/cross_cd_vol4_ppm.csv
- * > ./cross_txt --csv results/cross/cross_cd_vol5_ppm.csv
  */
 double compCDmagToVmag(int decl_ref, double cdVmag) {
-    if (decl_ref <= -22 && decl_ref >= -31) {
-        // Weighted quadratic fit of 15187 stars, RSME = 0.075, MAPE = 0.78%
-        return -8.955 + 3.221 * cdVmag - 0.132 * cdVmag * cdVmag;
-    }
-    if (decl_ref <= -32 && decl_ref >= -41) {
-        // Weighted quadratic fit of 15038 stars, RSME = 0.085, MAPE = 0.94%
-        return -4.874 + 2.084 * cdVmag - 0.055 * cdVmag * cdVmag;
-    }
-    if (decl_ref <= -42 && decl_ref >= -51) {
-        // Weighted linear fit of 25597 stars, RSME = 0.092, MAPE = 1.03%
-        return -1.302 + 1.163 * cdVmag;
-    }
-    if (decl_ref <= -52 && decl_ref >= -61) {
-        // Weighted quadratic fit of 12980 stars, RSME = 0.149, MAPE = 1.34%
-        return -5.647 + 2.384 * cdVmag - 0.083 * cdVmag * cdVmag;
-    }
-    if (decl_ref <= -62) {
-        // Weighted linear fit of 12218 stars, RSME = 0.052, MAPE = 0.55%
-        return 0.154 + 0.981 * cdVmag;
-    }
-
-    abort();
-    return 0;
+    int volume = getCDVolume(decl_ref);
+    if (volume < 0) abort();
+    std::call_once(cdMagScaleOnce, loadCDMagScale);
+    const double *c = cdMagScale[volume].toV;
+    return c[0] + c[1] * cdVmag + c[2] * cdVmag * cdVmag;
 }
 
 /*
@@ -317,5 +452,5 @@ void makeDoubles(int n, int *ref, double *X, double *Y, double *Z,
     free(nearIdx);
     free(nearDist);
 
-    printf("Doubles found in %s catalog: %d (saved to %s)\n", desig, count, filename);
+    logPrintf("Doubles found in %s catalog: %d (saved to %s)\n", desig, count, filename);
 }
@@ -3,6 +3,8 @@
  * TRIG - Header
  */
 
+#include <stddef.h>
+
 #define PI 3.1415926535897932384
 #define COSDISTTOL  0.999998476913288 /* cos(6 arcmin) */
 #define COSDISTDPLTOL 0.999999924785823 /* cos(80 arcsec) */
@@ -18,7 +20,33 @@ void sph2rec(double ra, double decl, double *x, double *y, double *z);
 void rec2sph(double x, double y, double z, double *ra, double *decl);
 double calcCosDistance(double x1, double y1, double z1, double x2, double y2, double z2);
 double calcAngularDistance(double x1, double y1, double z1, double x2, double y2, double z2);
+
+/* copia float32 (arreglos paralelos) de los vectores unitarios de un catálogo, usada
+   como primer filtro de candidatos; "exact" apunta al campo x de la estrella 0 y
+   "stride" es el tamaño de la estructura en doubles (x, y, z deben ser contiguos) */
+struct UnitCopy_struct {
+    float *x, *y, *z;
+};
+
+struct Arena_struct;
+void buildUnitCopy(struct UnitCopy_struct *unit, struct Arena_struct *arena,
+    const double *exact, int stride, int count);
+void fillUnitCopy(struct UnitCopy_struct *unit, const double *exact, int stride, int count);
+void findNearestUnit(const struct UnitCopy_struct *unit, const double *exact, int stride,
+    int first, int last, double x, double y, double z, int *index, double *minDistance);
 bool solve3x3(double A[3][3], double b[3], double x[3]);
+
+/* escalas de magnitud de los tomos de CD: si existe CD_MAG_SCALE_FILE (generado por
+   cross_txt --fit-cd), compVmagToCDmag y compCDmagToVmag toman de ahi los coeficientes
+   la primera vez que se llaman; cada linea (las que empiezan con # se ignoran) es
+   "tomo zona_desde zona_hasta a b c (CD -> V) a b c (V -> CD) ..." con m' = a + b m + c m^2.
+   La ruta es relativa al directorio de trabajo: si el archivo esta, cambia la salida de
+   toda herramienta que convierta magnitudes CD (compare_ppm, compare_all, scan_dm) */
+#define CD_MAG_SCALE_FILE "results/cd_mag_scale.txt"
+#define CD_MAG_VOLUMES 5
+
+int getCDVolume(int decl_ref);
+const void *getCDMagScaleTable(size_t *bytes);
 double compVmagToCDmag(int decl_ref, double vmag);
 double compCDmagToVmag(int decl_ref, double cdVmag);
 double compGCmagToVmag(double gcVmag);
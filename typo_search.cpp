@@ -0,0 +1,195 @@
+/*
+ * TYPO_SEARCH - Busqueda de errores de transcripcion en registros señalados
+ * Made in 2025 by Daniel E. Severin
+ *
+ * Para cada registro se generan todas las variantes de un solo cambio en el texto
+ * de sus campos (un digito distinto o dos digitos contiguos intercambiados). Las
+ * variantes de todos los registros se prueban juntas, en paralelo por tramos,
+ * contra los indices de las referencias; cada una se queda con la estrella libre
+ * (no reclamada por otro registro) de menor costo
+ *     dist^2 / (2 sigma_pos^2) + dm^2 / (2 sigma_m^2) + costo del cambio
+ * y a cada registro se le informan sus hipotesis mas baratas.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "misc.h"
+#include "sky_grid.h"
+#include "parallel.h"
+#include "typo_search.h"
+
+#define TYPO_CHUNK 4096 // hipotesis por tarea
+
+/* pares de digitos que se confunden al leer un impreso */
+static const char ocrPairs[][2] = {
+    {'0', '6'}, {'0', '8'}, {'0', '9'}, {'1', '7'}, {'3', '5'}, {'3', '8'}, {'5', '6'}, {'6', '8'}, {'8', '9'}
+};
+
+struct TypoBatch_struct {
+    const struct TypoSearch_struct *search;
+    const struct TypoRecord_struct *records;
+    struct TypoHypothesis_struct *hypothesis;
+    int count;
+};
+
+/*
+ * typoKindName - nombre de un tipo de cambio (para informar)
+ */
+const char *typoKindName(int kind)
+{
+    switch (kind) {
+        case TYPO_OCR: return "OCR";
+        case TYPO_DIGIT: return "digit";
+        default: return "swap";
+    }
+}
+
+/*
+ * isOCRPair - dice si dos digitos forman un par de confusion
+ */
+static bool isOCRPair(char a, char b)
+{
+    for (size_t p = 0; p < sizeof(ocrPairs) / sizeof(ocrPairs[0]); p++) {
+        if ((ocrPairs[p][0] == a && ocrPairs[p][1] == b) || (ocrPairs[p][0] == b && ocrPairs[p][1] == a)) return true;
+    }
+    return false;
+}
+
+/*
+ * addHypothesis - agrega una variante (si es valida) al arreglo de hipotesis
+ */
+static void addHypothesis(struct TypoHypothesis_struct **hypothesis, int *count, int *capacity,
+        const struct TypoFormat_struct *format, int record, int field, int kind, const char *text)
+{
+    double value = atof(text);
+    if (value >= format->limit) return;
+    if (*count == *capacity) {
+        *capacity = *capacity == 0 ? 4096 : 2 * *capacity;
+        *hypothesis = (struct TypoHypothesis_struct *) realloc(*hypothesis,
+            (size_t) *capacity * sizeof(struct TypoHypothesis_struct));
+        if (*hypothesis == NULL) bye("Out of memory!\n");
+    }
+    struct TypoHypothesis_struct *h = &(*hypothesis)[(*count)++];
+    h->record = record;
+    h->field = field;
+    h->kind = kind;
+    h->value = value;
+    h->ref = -1;
+    h->star = -1;
+    h->dist = 0.0;
+    h->cost = HUGE_VAL;
+}
+
+/*
+ * testHypotheses - prueba un tramo de hipotesis contra las referencias
+ */
+static void testHypotheses(int index, void *context)
+{
+    struct TypoBatch_struct *batch = (struct TypoBatch_struct *) context;
+    const struct TypoSearch_struct *search = batch->search;
+    struct SkyHits_struct hits;
+    memset(&hits, 0, sizeof(hits));
+
+    int last = (index + 1) * TYPO_CHUNK;
+    if (last > batch->count) last = batch->count;
+    for (int i = index * TYPO_CHUNK; i < last; i++) {
+        struct TypoHypothesis_struct *h = &batch->hypothesis[i];
+        const struct TypoRecord_struct *record = &batch->records[h->record];
+        double value[TYPO_MAX_FIELDS];
+        memcpy(value, record->value, sizeof(value));
+        value[h->field] = h->value;
+
+        double x, y, z;
+        search->position(search->context, record, value, &x, &y, &z);
+        double mag = search->magField >= 0 ? value[search->magField] : 0.0;
+        double changeCost = h->kind == TYPO_OCR ? TYPO_OCR_COST : (h->kind == TYPO_DIGIT ? TYPO_DIGIT_COST : TYPO_SWAP_COST);
+
+        for (int r = 0; r < search->refs; r++) {
+            const struct TypoReference_struct *ref = &search->ref[r];
+            querySkyGrid(ref->grid, x, y, z, search->radius, &hits);
+            for (int k = 0; k < hits.count; k++) {
+                int star = hits.index[k];
+                int owner = ref->claimedBy[star];
+                if (owner >= 0 && owner != record->owner) continue;
+                double cost = hits.dist[k] * hits.dist[k] / (2.0 * search->sigmaPos * search->sigmaPos) + changeCost;
+                double refMag = ref->mag[(size_t) star * ref->stride];
+                if (magKnown(mag) && magKnown(refMag)) {
+                    double delta = mag - search->convertMag(search->context, record, refMag);
+                    cost += delta * delta / (2.0 * TYPO_SIGMA_MAG * TYPO_SIGMA_MAG);
+                }
+                if (cost < h->cost) {
+                    h->cost = cost;
+                    h->ref = r;
+                    h->star = star;
+                    h->dist = hits.dist[k];
+                }
+            }
+        }
+    }
+    freeSkyHits(&hits);
+}
+
+/*
+ * searchTypos - busca, para cada registro, las hipotesis de un solo cambio que caen en
+ * una estrella libre; deja las mejores en results[] y devuelve cuántas se probaron
+ */
+int searchTypos(const struct TypoSearch_struct *search, const struct TypoRecord_struct *records,
+        int count, struct TypoResult_struct *results)
+{
+    /* 1) variantes de cada campo (quedan agrupadas por registro) */
+    struct TypoHypothesis_struct *hypothesis = NULL;
+    int hypotheses = 0, capacity = 0;
+    char text[32], variant[32];
+    for (int i = 0; i < count; i++) {
+        for (int f = 0; f < search->fields; f++) {
+            const struct TypoFormat_struct *format = &search->format[f];
+            double value = records[i].value[f];
+            if (f == search->magField && !magKnown(value)) continue;
+            snprintf(text, sizeof(text), "%0*.*f", format->width, format->decimals, value);
+            int length = strlen(text);
+            for (int p = 0; p < length; p++) {
+                if (text[p] < '0' || text[p] > '9') continue;
+                /* un digito distinto */
+                for (char d = '0'; d <= '9'; d++) {
+                    if (d == text[p]) continue;
+                    strcpy(variant, text);
+                    variant[p] = d;
+                    addHypothesis(&hypothesis, &hypotheses, &capacity, format, i, f,
+                        isOCRPair(text[p], d) ? TYPO_OCR : TYPO_DIGIT, variant);
+                }
+                /* intercambio con el siguiente digito (salteando el punto decimal) */
+                int q = p + 1;
+                if (q < length && text[q] == '.') q++;
+                if (q < length && text[q] >= '0' && text[q] <= '9' && text[q] != text[p]) {
+                    strcpy(variant, text);
+                    variant[p] = text[q];
+                    variant[q] = text[p];
+                    addHypothesis(&hypothesis, &hypotheses, &capacity, format, i, f, TYPO_SWAP, variant);
+                }
+            }
+        }
+    }
+
+    /* 2) consultas en lote, en paralelo por tramos */
+    struct TypoBatch_struct batch = {search, records, hypothesis, hypotheses};
+    parallelFor((hypotheses + TYPO_CHUNK - 1) / TYPO_CHUNK, testHypotheses, &batch);
+
+    /* 3) las mejores de cada registro (insercion: son pocas) */
+    for (int i = 0; i < count; i++) results[i].count = 0;
+    for (int k = 0; k < hypotheses; k++) {
+        struct TypoHypothesis_struct *h = &hypothesis[k];
+        if (h->ref < 0) continue;
+        struct TypoResult_struct *result = &results[h->record];
+        int pos = result->count;
+        while (pos > 0 && result->best[pos - 1].cost > h->cost) pos--;
+        if (pos >= TYPO_MAX_RESULTS) continue;
+        int last = result->count < TYPO_MAX_RESULTS ? result->count : TYPO_MAX_RESULTS - 1;
+        for (int j = last; j > pos; j--) result->best[j] = result->best[j - 1];
+        result->best[pos] = *h;
+        if (result->count < TYPO_MAX_RESULTS) result->count++;
+    }
+    free(hypothesis);
+    return hypotheses;
+}
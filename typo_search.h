@@ -0,0 +1,79 @@
+/*
+ * TYPO_SEARCH - Header
+ * Busqueda de errores de transcripcion en registros señalados (FAR, ALONE o con
+ * magnitud distinta): se prueban las variantes de un digito de sus campos contra
+ * catalogos de referencia indexados y se ordenan las que caen en una estrella libre
+ * (incluir despues de misc.h y sky_grid.h)
+ */
+
+#define TYPO_MAX_FIELDS 8
+#define TYPO_MAX_RESULTS 3 /* hipotesis informadas por registro */
+#define TYPO_SIGMA_MAG 0.5
+
+/* tipo de cambio (de mas a menos probable) y su costo, como -log de la probabilidad a priori */
+#define TYPO_OCR 0 /* un digito leido por otro de forma parecida (3/8, 1/7, 5/6...) */
+#define TYPO_DIGIT 1 /* un digito cualquiera */
+#define TYPO_SWAP 2 /* dos digitos contiguos intercambiados */
+#define TYPO_OCR_COST 0.0
+#define TYPO_DIGIT_COST 1.0
+#define TYPO_SWAP_COST 1.0
+
+/* formato impreso de un campo: "width" caracteres con "decimals" decimales, rellenado
+   con ceros; las variantes deben quedar por debajo de "limit" (p.ej. 60 en minutos) */
+struct TypoFormat_struct {
+    const char *name;
+    int width, decimals;
+    double limit;
+};
+
+/* registro señalado: sus campos tal como figuran en el catalogo */
+struct TypoRecord_struct {
+    int owner; /* indice en su catalogo (el mismo que en claimedBy) */
+    double value[TYPO_MAX_FIELDS];
+};
+
+/* catalogo de referencia: indice, magnitudes (stride doubles entre estrellas,
+   0 = desconocida) y, por estrella, el registro que ya la reclama (-1 si ninguno) */
+struct TypoReference_struct {
+    const struct SkyGrid_struct *grid;
+    const double *mag;
+    int stride;
+    const int *claimedBy;
+};
+
+/* configuracion de la busqueda; las funciones deben poder correr en paralelo */
+struct TypoSearch_struct {
+    int fields;
+    const struct TypoFormat_struct *format;
+    int magField; /* campo con la magnitud (-1 si no hay); 0 o > 29.9 = desconocida */
+    double radius; /* arcsec: distancia maxima entre la hipotesis y la estrella */
+    double sigmaPos; /* arcsec: precision de las posiciones del catalogo */
+    void *context; /* se pasa a las funciones siguientes */
+    /* vector unitario (1875.0) de un registro con los campos "value" */
+    void (*position)(void *context, const struct TypoRecord_struct *record, const double *value,
+        double *x, double *y, double *z);
+    /* magnitud de una estrella de referencia en la escala del registro */
+    double (*convertMag)(void *context, const struct TypoRecord_struct *record, double refMag);
+    const struct TypoReference_struct *ref;
+    int refs;
+};
+
+/* hipotesis: el campo "field" deberia valer "value"; cae en la estrella "star" de la
+   referencia "ref" a "dist" arcsec, con costo "cost" (menor es mejor) */
+struct TypoHypothesis_struct {
+    int record;
+    int field, kind;
+    double value;
+    int ref, star; /* ref = -1 si no cae en ninguna estrella libre */
+    double dist, cost;
+};
+
+/* mejores hipotesis de un registro, por costo ascendente */
+struct TypoResult_struct {
+    int count;
+    struct TypoHypothesis_struct best[TYPO_MAX_RESULTS];
+};
+
+int searchTypos(const struct TypoSearch_struct *search, const struct TypoRecord_struct *records,
+    int count, struct TypoResult_struct *results);
+const char *typoKindName(int kind);
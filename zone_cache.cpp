@@ -0,0 +1,471 @@
+/*
+ * ZONE_CACHE - Reejecuciones incrementales con hashes por zona
+ * Made in 2025 by Daniel E. Severin
+ *
+ * Uso (ver compare_ppm y cross_gc):
+ *   initZoneCache; hashCacheFile / hashCacheBytes de cada entrada;
+ *   openZoneCache; por cada elemento de una zona que no este fresca:
+ *   beginZoneEntry, logPrintf/logWarning y escrituras en zoneStream, endZoneEntry;
+ *   closeZoneCache (vuelca todo en orden de clave y guarda el manifiesto);
+ *   getZoneValues para sumar los contadores; freeZoneCache.
+ * Entre openZoneCache y closeZoneCache solo se debe escribir dentro de las entradas.
+ *
+ * Una zona esta fresca si el manifiesto tiene el mismo hash global y el mismo hash
+ * para ella y sus "spread" zonas vecinas a cada lado (resultados que miran estrellas
+ * de la zona contigua). El hash global incluye el propio ejecutable, asi que al
+ * recompilar la herramienta todo se recalcula; si el ejecutable no puede leerse,
+ * no se reutiliza ninguna zona.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "misc.h"
+#include "zone_cache.h"
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/* encabezado del manifiesto: siguen el hash de cada zona y las entradas, cada una con
+   zona, clave, advertencias y tamaño de cada canal (ints), contadores (doubles),
+   posiciones de las advertencias (longs) y el texto de cada canal */
+struct ZoneCacheHeader_struct {
+    char magic[8];
+    int zones, streams, values, entries;
+    unsigned long long global;
+};
+
+static const char ZONE_CACHE_MAGIC[8] = "ZCACHE1";
+
+/*
+ * hashBytes - hash FNV-1a 64 de "size" bytes, acumulado sobre "hash"
+ */
+static unsigned long long hashBytes(unsigned long long hash, const void *bytes, size_t size)
+{
+    const unsigned char *ptr = (const unsigned char *) bytes;
+    for (size_t k = 0; k < size; k++) hash = (hash ^ ptr[k]) * FNV_PRIME;
+    return hash;
+}
+
+/*
+ * initZoneCache - prepara el cache "name" (manifiesto ZONE_CACHE_DIR/name.bin) para
+ * "zones" zonas, con "streams" archivos de salida y "values" contadores por elemento
+ */
+void initZoneCache(struct ZoneCache_struct *cache, const char *name, int zones, int spread, int streams, int values)
+{
+    if (streams > ZONE_CACHE_MAX_STREAMS || values > ZONE_CACHE_MAX_VALUES) bye("Too many zone cache streams or values!\n");
+    memset(cache, 0, sizeof(struct ZoneCache_struct));
+    snprintf(cache->filename, sizeof(cache->filename), "%s/%s.bin", ZONE_CACHE_DIR, name);
+    cache->zones = zones;
+    cache->spread = spread;
+    cache->streams = streams;
+    cache->values = values;
+    cache->hash = (unsigned long long *) malloc(zones * sizeof(unsigned long long));
+    cache->fresh = (bool *) calloc(zones, sizeof(bool));
+    if (cache->hash == NULL || cache->fresh == NULL) bye("Out of memory!\n");
+    for (int z = 0; z < zones; z++) cache->hash[z] = FNV_OFFSET;
+    cache->global = hashBytes(FNV_OFFSET, name, strlen(name));
+
+    /* el ejecutable: al cambiar el codigo (o sus constantes) todo se recalcula */
+    FILE *stream = fopen("/proc/self/exe", "rb");
+    bool hashed = false;
+    if (stream != NULL) {
+        char buffer[65536];
+        size_t bytes;
+        while ((bytes = fread(buffer, 1, sizeof(buffer), stream)) > 0) {
+            cache->global = hashBytes(cache->global, buffer, bytes);
+        }
+        hashed = !ferror(stream);
+        fclose(stream);
+    }
+    if (!hashed) {
+        /* sin su hash no se sabe si el manifiesto es de este ejecutable: todo se recalcula */
+        fprintf(stderr, "Zone cache %s: cannot read the executable, every zone will be recomputed\n", cache->filename);
+        cache->unhashed = true;
+    }
+}
+
+/*
+ * hashCacheBytes - suma "size" bytes al hash de una zona (o al global si zone < 0)
+ */
+void hashCacheBytes(struct ZoneCache_struct *cache, int zone, const void *bytes, size_t size)
+{
+    if (zone < 0 || zone >= cache->zones) {
+        cache->global = hashBytes(cache->global, bytes, size);
+    } else {
+        cache->hash[zone] = hashBytes(cache->hash[zone], bytes, size);
+    }
+}
+
+/*
+ * hashCacheFile - suma cada linea del archivo (con su numero de linea) al hash de la
+ * zona que indique zoneOf (NULL o zona < 0 = global). La cantidad de lineas de cada
+ * zona va al hash global: agregar o quitar registros mueve indices y paginas, y
+ * entonces todo se recalcula; corregir un registro solo afecta a su zona.
+ */
+void hashCacheFile(struct ZoneCache_struct *cache, const char *filename, int (*zoneOf)(const char *line))
+{
+    char buffer[1024];
+
+    FILE *stream = openInputFile(filename);
+    if (stream == NULL) {
+        snprintf(buffer, 1024, "Cannot read %s", filename);
+        perror(buffer);
+        exit(1);
+    }
+    int *lines = (int *) calloc(cache->zones + 1, sizeof(int));
+    if (lines == NULL) bye("Out of memory!\n");
+    int line = 0;
+    while (fgets(buffer, 1023, stream) != NULL) {
+        int zone = zoneOf != NULL ? zoneOf(buffer) : -1;
+        if (zone < 0 || zone >= cache->zones) zone = -1;
+        hashCacheBytes(cache, zone, &line, sizeof(int));
+        hashCacheBytes(cache, zone, buffer, strlen(buffer));
+        lines[zone + 1]++;
+        line++;
+    }
+    closeInputFile(stream);
+    hashCacheBytes(cache, -1, filename, strlen(filename));
+    hashCacheBytes(cache, -1, lines, (cache->zones + 1) * sizeof(int));
+    free(lines);
+}
+
+/*
+ * zoneOfDMLine - zona de una linea de BD, CD o CPD (columnas 3-5 sin signo, p.ej. "-22" = 22),
+ * para usar con hashCacheFile
+ */
+int zoneOfDMLine(const char *line)
+{
+    if (strlen(line) < 5) return -1;
+    char cell[4] = {line[2], line[3], line[4], 0};
+    return abs(atoi(cell));
+}
+
+/*
+ * addEntry - agrega una entrada vacia y devuelve su indice
+ */
+static int addEntry(struct ZoneCache_struct *cache, int zone, int key, bool stored)
+{
+    if (cache->entries == cache->capacity) {
+        cache->capacity = cache->capacity == 0 ? 4096 : 2 * cache->capacity;
+        cache->entry = (struct ZoneEntry_struct *) realloc(cache->entry, cache->capacity * sizeof(struct ZoneEntry_struct));
+        if (cache->entry == NULL) bye("Out of memory!\n");
+    }
+    struct ZoneEntry_struct *entry = &cache->entry[cache->entries];
+    memset(entry, 0, sizeof(struct ZoneEntry_struct));
+    entry->zone = zone;
+    entry->key = key;
+    entry->order = cache->entries;
+    entry->stored = stored;
+    entry->markFrom = cache->marks;
+    entry->valueFrom = cache->valueCount;
+    return cache->entries++;
+}
+
+/*
+ * addMark / addValues - agregan posiciones de advertencias y contadores de la ultima entrada
+ */
+static void addMark(struct ZoneCache_struct *cache, long mark)
+{
+    if (cache->marks == cache->markCapacity) {
+        cache->markCapacity = cache->markCapacity == 0 ? 1024 : 2 * cache->markCapacity;
+        cache->mark = (long *) realloc(cache->mark, cache->markCapacity * sizeof(long));
+        if (cache->mark == NULL) bye("Out of memory!\n");
+    }
+    cache->mark[cache->marks++] = mark;
+}
+
+static void addValues(struct ZoneCache_struct *cache, const double *values)
+{
+    if (cache->valueCount + cache->values > cache->valueCapacity) {
+        cache->valueCapacity = cache->valueCapacity == 0 ? 4096 * (cache->values + 1) : 2 * cache->valueCapacity;
+        cache->value = (double *) realloc(cache->value, cache->valueCapacity * sizeof(double));
+        if (cache->value == NULL) bye("Out of memory!\n");
+    }
+    for (int v = 0; v < cache->values; v++) cache->value[cache->valueCount++] = values != NULL ? values[v] : 0.0;
+}
+
+/*
+ * loadManifest - lee el manifiesto y toma sus entradas de las zonas frescas;
+ * si no existe, no corresponde o esta dañado, no hay zonas frescas
+ */
+static void loadManifest(struct ZoneCache_struct *cache)
+{
+    FILE *stream = fopen(cache->filename, "rb");
+    if (stream == NULL) return;
+    fseek(stream, 0, SEEK_END);
+    long size = ftell(stream);
+    fseek(stream, 0, SEEK_SET);
+    char *data = (char *) malloc(size > 0 ? size : 1);
+    if (data == NULL) bye("Out of memory!\n");
+    bool valid = size >= (long) sizeof(struct ZoneCacheHeader_struct) && fread(data, 1, size, stream) == (size_t) size;
+    fclose(stream);
+
+    struct ZoneCacheHeader_struct header;
+    if (valid) {
+        memcpy(&header, data, sizeof(header));
+        valid = memcmp(header.magic, ZONE_CACHE_MAGIC, 8) == 0 && header.zones == cache->zones &&
+            header.streams == cache->streams && header.values == cache->values && header.global == cache->global &&
+            size >= (long) (sizeof(header) + cache->zones * sizeof(unsigned long long));
+    }
+    if (!valid) {
+        free(data);
+        return;
+    }
+
+    /* zonas frescas: la zona y sus vecinas tienen el mismo hash */
+    const char *ptr = data + sizeof(header);
+    unsigned long long *stored = (unsigned long long *) malloc(cache->zones * sizeof(unsigned long long));
+    if (stored == NULL) bye("Out of memory!\n");
+    memcpy(stored, ptr, cache->zones * sizeof(unsigned long long));
+    ptr += cache->zones * sizeof(unsigned long long);
+    for (int z = 0; z < cache->zones; z++) {
+        cache->fresh[z] = true;
+        for (int w = z - cache->spread; w <= z + cache->spread; w++) {
+            if (w >= 0 && w < cache->zones && stored[w] != cache->hash[w]) cache->fresh[z] = false;
+        }
+    }
+    free(stored);
+
+    /* entradas de las zonas frescas (el texto queda en el manifiesto leido) */
+    const char *end = data + size;
+    int fields[3];
+    unsigned int sizes[ZONE_CACHE_MAX_STREAMS + 1];
+    double values[ZONE_CACHE_MAX_VALUES];
+    size_t fixed = sizeof(fields) + (cache->streams + 1) * sizeof(unsigned int) + cache->values * sizeof(double);
+    for (int k = 0; valid && k < header.entries; k++) {
+        if (end - ptr < (long) fixed) {
+            valid = false;
+            break;
+        }
+        memcpy(fields, ptr, sizeof(fields));
+        ptr += sizeof(fields);
+        memcpy(sizes, ptr, (cache->streams + 1) * sizeof(unsigned int));
+        ptr += (cache->streams + 1) * sizeof(unsigned int);
+        memcpy(values, ptr, cache->values * sizeof(double));
+        ptr += cache->values * sizeof(double);
+        size_t bytes = fields[2] * sizeof(long);
+        for (int s = 0; s <= cache->streams; s++) bytes += sizes[s];
+        if (fields[0] < 0 || fields[0] >= cache->zones || fields[2] < 0 || (size_t) (end - ptr) < bytes) {
+            valid = false;
+            break;
+        }
+        if (cache->fresh[fields[0]]) {
+            int e = addEntry(cache, fields[0], fields[1], true);
+            for (int m = 0; m < fields[2]; m++) {
+                long mark;
+                memcpy(&mark, ptr + m * sizeof(long), sizeof(long));
+                addMark(cache, mark);
+            }
+            cache->entry[e].marks = fields[2];
+            size_t from = ptr + fields[2] * sizeof(long) - data;
+            for (int s = 0; s <= cache->streams; s++) {
+                cache->entry[e].from[s] = from;
+                cache->entry[e].size[s] = sizes[s];
+                from += sizes[s];
+            }
+            addValues(cache, values);
+        }
+        ptr += bytes;
+    }
+    if (!valid) {
+        /* manifiesto dañado: se recalcula todo */
+        cache->entries = cache->marks = cache->valueCount = 0;
+        memset(cache->fresh, 0, cache->zones * sizeof(bool));
+        free(data);
+        return;
+    }
+    cache->stored = data;
+    cache->reused = cache->entries;
+    for (int z = 0; z < cache->zones; z++) {
+        if (cache->fresh[z]) cache->freshZones++;
+    }
+}
+
+/*
+ * openZoneCache - si reuse = true, toma del manifiesto las zonas frescas; a partir
+ * de aqui la salida del hilo se acumula para repartirla entre las entradas
+ */
+void openZoneCache(struct ZoneCache_struct *cache, bool reuse)
+{
+    if (reuse && !cache->unhashed) loadManifest(cache);
+    for (int s = 0; s < cache->streams; s++) {
+        cache->stream[s] = open_memstream(&cache->buffer[s], &cache->bufferSize[s]);
+        if (cache->stream[s] == NULL) {
+            perror("Cannot capture output");
+            exit(1);
+        }
+    }
+    beginLogSink(&cache->sink);
+}
+
+/*
+ * isZoneFresh - dice si la zona se toma del manifiesto (y no hay que procesarla)
+ */
+bool isZoneFresh(const struct ZoneCache_struct *cache, int zone)
+{
+    return zone >= 0 && zone < cache->zones && cache->fresh[zone];
+}
+
+/*
+ * beginZoneEntry - comienza la salida de un elemento de la zona dada
+ */
+void beginZoneEntry(struct ZoneCache_struct *cache, int zone, int key)
+{
+    if (zone < 0 || zone >= cache->zones) bye("Zone out of range in zone cache!\n");
+    int e = addEntry(cache, zone, key, false);
+    cache->entry[e].from[0] = ftell(cache->sink.stream);
+    for (int s = 0; s < cache->streams; s++) cache->entry[e].from[s + 1] = ftell(cache->stream[s]);
+    cache->sinkMarks = cache->sink.count;
+}
+
+/*
+ * zoneStream - archivo de salida "stream" del elemento actual
+ */
+FILE *zoneStream(struct ZoneCache_struct *cache, int stream)
+{
+    return cache->stream[stream];
+}
+
+/*
+ * endZoneEntry - termina la salida del elemento actual, con sus contadores
+ */
+void endZoneEntry(struct ZoneCache_struct *cache, const double *values)
+{
+    struct ZoneEntry_struct *entry = &cache->entry[cache->entries - 1];
+    entry->size[0] = ftell(cache->sink.stream) - entry->from[0];
+    for (int s = 0; s < cache->streams; s++) entry->size[s + 1] = ftell(cache->stream[s]) - entry->from[s + 1];
+    for (int k = cache->sinkMarks; k < cache->sink.count; k++) addMark(cache, cache->sink.mark[k] - (long) entry->from[0]);
+    entry->marks = cache->marks - entry->markFrom;
+    addValues(cache, values);
+    cache->computed++;
+}
+
+/*
+ * entryText - texto del canal s (0 = registro) de una entrada
+ */
+static const char *entryText(const struct ZoneCache_struct *cache, const struct ZoneEntry_struct *entry, int s)
+{
+    if (entry->stored) return cache->stored + entry->from[s];
+    return (s == 0 ? cache->sink.buffer : cache->buffer[s - 1]) + entry->from[s];
+}
+
+static int compareEntry(const void *a, const void *b)
+{
+    const struct ZoneEntry_struct *e1 = (const struct ZoneEntry_struct *) a;
+    const struct ZoneEntry_struct *e2 = (const struct ZoneEntry_struct *) b;
+    if (e1->key != e2->key) return e1->key < e2->key ? -1 : 1;
+    return e1->order - e2->order;
+}
+
+/*
+ * saveManifest - guarda hashes y entradas (en un temporal que luego se renombra)
+ */
+static void saveManifest(struct ZoneCache_struct *cache)
+{
+    char tmpname[300];
+
+    mkdir(ZONE_CACHE_DIR, 0755);
+    snprintf(tmpname, sizeof(tmpname), "%s.tmp", cache->filename);
+    FILE *stream = fopen(tmpname, "wb");
+    if (stream == NULL) {
+        perror("Cannot write zone cache");
+        exit(1);
+    }
+    struct ZoneCacheHeader_struct header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ZONE_CACHE_MAGIC, 8);
+    header.zones = cache->zones;
+    header.streams = cache->streams;
+    header.values = cache->values;
+    header.entries = cache->entries;
+    header.global = cache->global;
+    bool ok = fwrite(&header, sizeof(header), 1, stream) == 1 &&
+        fwrite(cache->hash, sizeof(unsigned long long), cache->zones, stream) == (size_t) cache->zones;
+    for (int k = 0; ok && k < cache->entries; k++) {
+        const struct ZoneEntry_struct *entry = &cache->entry[k];
+        int fields[3] = {entry->zone, entry->key, entry->marks};
+        unsigned int sizes[ZONE_CACHE_MAX_STREAMS + 1];
+        for (int s = 0; s <= cache->streams; s++) sizes[s] = (unsigned int) entry->size[s];
+        ok = fwrite(fields, sizeof(fields), 1, stream) == 1 &&
+            fwrite(sizes, sizeof(unsigned int), cache->streams + 1, stream) == (size_t) (cache->streams + 1) &&
+            fwrite(&cache->value[entry->valueFrom], sizeof(double), cache->values, stream) == (size_t) cache->values &&
+            fwrite(&cache->mark[entry->markFrom], sizeof(long), entry->marks, stream) == (size_t) entry->marks;
+        for (int s = 0; ok && s <= cache->streams; s++) {
+            ok = fwrite(entryText(cache, entry, s), 1, entry->size[s], stream) == entry->size[s];
+        }
+    }
+    if (fclose(stream) != 0 || !ok || rename(tmpname, cache->filename) != 0) {
+        perror("Cannot write zone cache");
+        exit(1);
+    }
+}
+
+/*
+ * closeZoneCache - deja de acumular, y escribe en orden de clave el registro de cada
+ * entrada (numerando sus advertencias a continuacion de *errors) y su parte de cada
+ * archivo de salida (outputs[s], NULL = se descarta); si save = true guarda el manifiesto
+ */
+void closeZoneCache(struct ZoneCache_struct *cache, FILE **outputs, int *errors, bool save)
+{
+    endLogSink(&cache->sink);
+    for (int s = 0; s < cache->streams; s++) fclose(cache->stream[s]);
+
+    /* sin entradas del manifiesto, el orden ya es el de la corrida completa */
+    if (cache->reused > 0) qsort(cache->entry, cache->entries, sizeof(struct ZoneEntry_struct), compareEntry);
+    for (int k = 0; k < cache->entries; k++) {
+        const struct ZoneEntry_struct *entry = &cache->entry[k];
+        writeLogText(entryText(cache, entry, 0), entry->size[0], &cache->mark[entry->markFrom], entry->marks, errors);
+        for (int s = 0; s < cache->streams; s++) {
+            if (outputs[s] != NULL) fwrite(entryText(cache, entry, s + 1), 1, entry->size[s + 1], outputs[s]);
+        }
+    }
+
+    if (save) {
+        saveManifest(cache);
+        fprintf(stderr, "Zone cache %s: %d of %d zones reused (%d entries reused, %d computed)\n",
+            cache->filename, cache->freshZones, cache->zones, cache->reused, cache->computed);
+    }
+
+    /* el texto ya no hace falta; los contadores quedan hasta freeZoneCache */
+    free(cache->sink.buffer);
+    free(cache->sink.mark);
+    cache->sink.buffer = NULL;
+    cache->sink.mark = NULL;
+    for (int s = 0; s < cache->streams; s++) {
+        free(cache->buffer[s]);
+        cache->buffer[s] = NULL;
+    }
+    free(cache->stored);
+    cache->stored = NULL;
+}
+
+/*
+ * getZoneEntries / getZoneValues - entradas (en orden de clave, despues de closeZoneCache)
+ * y los contadores de cada una
+ */
+int getZoneEntries(const struct ZoneCache_struct *cache)
+{
+    return cache->entries;
+}
+
+const double *getZoneValues(const struct ZoneCache_struct *cache, int entry, int *key)
+{
+    if (key != NULL) *key = cache->entry[entry].key;
+    return &cache->value[cache->entry[entry].valueFrom];
+}
+
+/*
+ * freeZoneCache - libera el cache
+ */
+void freeZoneCache(struct ZoneCache_struct *cache)
+{
+    free(cache->hash);
+    free(cache->fresh);
+    free(cache->entry);
+    free(cache->mark);
+    free(cache->value);
+    free(cache->stored);
+    memset(cache, 0, sizeof(struct ZoneCache_struct));
+}
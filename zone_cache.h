@@ -0,0 +1,61 @@
+/*
+ * ZONE_CACHE - Header
+ * Reejecuciones incrementales: un manifiesto guarda el hash del contenido de cada zona
+ * de las entradas y, por cada elemento procesado (p.ej. una estrella), lo que escribio
+ * en el registro y en cada archivo de salida, y sus contadores. Al volver a correr solo
+ * se recalculan las zonas cuyas entradas cambiaron; el resto se empalma del manifiesto.
+ * (incluir despues de misc.h)
+ */
+
+#define ZONE_CACHE_DIR "results/cache"
+#define ZONE_CACHE_MAX_STREAMS 8
+#define ZONE_CACHE_MAX_VALUES 16
+
+/* salida de un elemento: texto del registro (canal 0, con sus advertencias sin numerar)
+   y de cada archivo de salida (canales 1..streams), y sus contadores */
+struct ZoneEntry_struct {
+    int zone, key; /* al empalmar, las entradas se ordenan por clave */
+    int order; /* orden de llegada (desempata claves repetidas) */
+    bool stored; /* true si el texto esta en el manifiesto leido */
+    size_t from[ZONE_CACHE_MAX_STREAMS + 1], size[ZONE_CACHE_MAX_STREAMS + 1];
+    int markFrom, marks; /* advertencias, en mark[] */
+    int valueFrom; /* contadores, en value[] */
+};
+
+struct ZoneCache_struct {
+    char filename[256];
+    int zones, spread, streams, values;
+    unsigned long long global; /* hash de lo que afecta a todas las zonas */
+    bool unhashed; /* no se pudo leer el ejecutable: no se reutiliza nada */
+    unsigned long long *hash; /* hash de cada zona */
+    bool *fresh; /* zonas que se toman del manifiesto */
+    int freshZones;
+    char *stored; /* manifiesto leido */
+    struct ZoneEntry_struct *entry;
+    int entries, capacity;
+    long *mark; /* posicion de cada advertencia, relativa al texto de su entrada */
+    int marks, markCapacity;
+    double *value;
+    int valueCount, valueCapacity;
+    /* salida de los elementos recalculados */
+    struct LogSink_struct sink;
+    FILE *stream[ZONE_CACHE_MAX_STREAMS];
+    char *buffer[ZONE_CACHE_MAX_STREAMS];
+    size_t bufferSize[ZONE_CACHE_MAX_STREAMS];
+    int sinkMarks; /* advertencias del sumidero al comenzar la entrada actual */
+    int reused, computed; /* entradas tomadas del manifiesto y recalculadas */
+};
+
+void initZoneCache(struct ZoneCache_struct *cache, const char *name, int zones, int spread, int streams, int values);
+void hashCacheBytes(struct ZoneCache_struct *cache, int zone, const void *bytes, size_t size);
+void hashCacheFile(struct ZoneCache_struct *cache, const char *filename, int (*zoneOf)(const char *line));
+int zoneOfDMLine(const char *line);
+void openZoneCache(struct ZoneCache_struct *cache, bool reuse);
+bool isZoneFresh(const struct ZoneCache_struct *cache, int zone);
+void beginZoneEntry(struct ZoneCache_struct *cache, int zone, int key);
+FILE *zoneStream(struct ZoneCache_struct *cache, int stream);
+void endZoneEntry(struct ZoneCache_struct *cache, const double *values);
+void closeZoneCache(struct ZoneCache_struct *cache, FILE **outputs, int *errors, bool save);
+int getZoneEntries(const struct ZoneCache_struct *cache);
+const double *getZoneValues(const struct ZoneCache_struct *cache, int entry, int *key);
+void freeZoneCache(struct ZoneCache_struct *cache);